@@ -0,0 +1,63 @@
+/*--------------------------------------------------------------------*/
+/* allocstat.c                                                        */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include "allocstat.h"
+
+/* The real allocator, as renamed by the linker's --wrap option */
+void *__real_malloc(size_t ulSize);
+void *__real_calloc(size_t ulCount, size_t ulSize);
+void *__real_realloc(void *pvBlock, size_t ulSize);
+void __real_free(void *pvBlock);
+
+/* The wrappers the linker substitutes for the allocator */
+void *__wrap_malloc(size_t ulSize);
+void *__wrap_calloc(size_t ulCount, size_t ulSize);
+void *__wrap_realloc(void *pvBlock, size_t ulSize);
+void __wrap_free(void *pvBlock);
+
+/* The counts since the last reset */
+static struct allocStats sStats;
+
+void *__wrap_malloc(size_t ulSize) {
+   sStats.ulAllocs++;
+   sStats.ulBytes += ulSize;
+   return __real_malloc(ulSize);
+}
+
+void *__wrap_calloc(size_t ulCount, size_t ulSize) {
+   sStats.ulAllocs++;
+   sStats.ulBytes += ulCount * ulSize;
+   return __real_calloc(ulCount, ulSize);
+}
+
+void *__wrap_realloc(void *pvBlock, size_t ulSize) {
+   if(pvBlock == NULL)
+      sStats.ulAllocs++;
+   else
+      sStats.ulReallocs++;
+   sStats.ulBytes += ulSize;
+   return __real_realloc(pvBlock, ulSize);
+}
+
+void __wrap_free(void *pvBlock) {
+   if(pvBlock != NULL)
+      sStats.ulFrees++;
+   __real_free(pvBlock);
+}
+
+void AllocStat_reset(void) {
+   sStats.ulAllocs = 0;
+   sStats.ulReallocs = 0;
+   sStats.ulFrees = 0;
+   sStats.ulBytes = 0;
+}
+
+void AllocStat_get(struct allocStats *psStats) {
+   assert(psStats != NULL);
+
+   *psStats = sStats;
+}
@@ -0,0 +1,37 @@
+/*--------------------------------------------------------------------*/
+/* allocstat.h                                                        */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef ALLOCSTAT_INCLUDED
+#define ALLOCSTAT_INCLUDED
+
+#include <stddef.h>
+
+/*
+  allocstat counts the heap allocations of a program linked with
+    -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free
+  which routes every such call in the program's own objects (but not
+  those made inside the C library) through it. The counts are not
+  synchronized, so they are only exact for single-threaded programs.
+*/
+
+/* Allocation counts since the last AllocStat_reset */
+struct allocStats {
+   /* calls to malloc and calloc, and reallocs of NULL */
+   size_t ulAllocs;
+   /* reallocs of existing blocks */
+   size_t ulReallocs;
+   /* frees of blocks (frees of NULL are not counted) */
+   size_t ulFrees;
+   /* bytes requested by all of the above */
+   size_t ulBytes;
+};
+
+/* Sets every count to 0. */
+void AllocStat_reset(void);
+
+/* Copies the current counts into *psStats. */
+void AllocStat_get(struct allocStats *psStats);
+
+#endif
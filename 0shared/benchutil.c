@@ -0,0 +1,40 @@
+/*--------------------------------------------------------------------*/
+/* benchutil.c                                                        */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdint.h>
+#include <time.h>
+#include "benchutil.h"
+
+/* xorshift64*'s multiplier, 2685821657736338717, built from halves
+   so that no literal needs a long long */
+#define BENCHUTIL_MULTIPLIER \
+   (((uint64_t) 0x2545f491UL << 32) | (uint64_t) 0x4f6cdd1dUL)
+
+/*--------------------------------------------------------------------*/
+
+unsigned long BenchUtil_random(unsigned long *pulState) {
+   uint64_t uX;
+
+   assert(pulState != NULL);
+   assert(*pulState != 0);
+
+   uX = *pulState;
+   uX ^= uX >> 12;
+   uX ^= uX << 25;
+   uX ^= uX >> 27;
+   *pulState = (unsigned long) uX;
+   return (unsigned long) ((uX * BENCHUTIL_MULTIPLIER) >> 32);
+}
+
+unsigned long BenchUtil_now(void) {
+   struct timespec sNow;
+
+   (void) clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (unsigned long) sNow.tv_sec * 1000000000UL +
+      (unsigned long) sNow.tv_nsec;
+}
@@ -0,0 +1,25 @@
+/*--------------------------------------------------------------------*/
+/* benchutil.h                                                        */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef BENCHUTIL_INCLUDED
+#define BENCHUTIL_INCLUDED
+
+/*
+  benchutil holds what the benchmarks, the soak test, tree_compare,
+  tree_fuzz and the check clients share: a reproducible pseudo-random
+  sequence and a monotonic clock.
+*/
+
+/*
+  Advances the xorshift64* sequence whose state is *pulState, which
+  must not be 0, and returns its next value, of 32 bits. The same
+  state gives the same sequence on every platform with 64-bit longs.
+*/
+unsigned long BenchUtil_random(unsigned long *pulState);
+
+/* Returns a monotonic timestamp in nanoseconds. */
+unsigned long BenchUtil_now(void);
+
+#endif
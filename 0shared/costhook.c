@@ -0,0 +1,253 @@
+/*--------------------------------------------------------------------*/
+/* costhook.c                                                         */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "allocstat.h"
+#include "costhook.h"
+
+/*
+  This file must not itself be compiled with the instrumentation it
+  counts: its hooks would then call themselves.
+*/
+
+/* The instrumentation hooks the compiler calls */
+void __sanitizer_cov_trace_pc(void);
+#ifndef COST_LIBFUZZER
+void __sanitizer_cov_trace_cmp1(uint8_t uiFirst, uint8_t uiSecond);
+void __sanitizer_cov_trace_cmp2(uint16_t uiFirst, uint16_t uiSecond);
+void __sanitizer_cov_trace_cmp4(uint32_t uiFirst, uint32_t uiSecond);
+void __sanitizer_cov_trace_cmp8(uint64_t uiFirst, uint64_t uiSecond);
+void __sanitizer_cov_trace_const_cmp1(uint8_t uiFirst,
+                                      uint8_t uiSecond);
+void __sanitizer_cov_trace_const_cmp2(uint16_t uiFirst,
+                                      uint16_t uiSecond);
+void __sanitizer_cov_trace_const_cmp4(uint32_t uiFirst,
+                                      uint32_t uiSecond);
+void __sanitizer_cov_trace_const_cmp8(uint64_t uiFirst,
+                                      uint64_t uiSecond);
+void __sanitizer_cov_trace_cmpf(float fFirst, float fSecond);
+void __sanitizer_cov_trace_cmpd(double dFirst, double dSecond);
+void __sanitizer_cov_trace_switch(uint64_t uiValue, uint64_t *puiCases);
+#endif
+
+/* The real C library functions, as renamed by the linker's --wrap */
+size_t __real_strlen(const char *pcString);
+char *__real_strcpy(char *pcDest, const char *pcSrc);
+char *__real_strcat(char *pcDest, const char *pcSrc);
+int __real_strcmp(const char *pcFirst, const char *pcSecond);
+int __real_strncmp(const char *pcFirst, const char *pcSecond,
+                   size_t ulLength);
+char *__real_strchr(const char *pcString, int iChar);
+void *__real_memcpy(void *pvDest, const void *pvSrc, size_t ulLength);
+void *__real_memmove(void *pvDest, const void *pvSrc, size_t ulLength);
+void *__real_memset(void *pvDest, int iByte, size_t ulLength);
+int __real_memcmp(const void *pvFirst, const void *pvSecond,
+                  size_t ulLength);
+void *__real_memchr(const void *pvData, int iByte, size_t ulLength);
+
+/* The wrappers the linker substitutes for them */
+size_t __wrap_strlen(const char *pcString);
+char *__wrap_strcpy(char *pcDest, const char *pcSrc);
+char *__wrap_strcat(char *pcDest, const char *pcSrc);
+int __wrap_strcmp(const char *pcFirst, const char *pcSecond);
+int __wrap_strncmp(const char *pcFirst, const char *pcSecond,
+                   size_t ulLength);
+char *__wrap_strchr(const char *pcString, int iChar);
+void *__wrap_memcpy(void *pvDest, const void *pvSrc, size_t ulLength);
+void *__wrap_memmove(void *pvDest, const void *pvSrc, size_t ulLength);
+void *__wrap_memset(void *pvDest, int iByte, size_t ulLength);
+int __wrap_memcmp(const void *pvFirst, const void *pvSecond,
+                  size_t ulLength);
+void *__wrap_memchr(const void *pvData, int iByte, size_t ulLength);
+
+/* The counters, but for allocations, which allocstat keeps */
+static unsigned long aulCounts[COST_COUNTERS];
+
+/*--------------------------------------------------------------------*/
+
+void __sanitizer_cov_trace_pc(void) {
+   aulCounts[COST_BLOCKS]++;
+}
+
+#ifndef COST_LIBFUZZER
+
+void __sanitizer_cov_trace_cmp1(uint8_t uiFirst, uint8_t uiSecond) {
+   (void) uiFirst;
+   (void) uiSecond;
+   aulCounts[COST_COMPARISONS]++;
+}
+
+void __sanitizer_cov_trace_cmp2(uint16_t uiFirst, uint16_t uiSecond) {
+   (void) uiFirst;
+   (void) uiSecond;
+   aulCounts[COST_COMPARISONS]++;
+}
+
+void __sanitizer_cov_trace_cmp4(uint32_t uiFirst, uint32_t uiSecond) {
+   (void) uiFirst;
+   (void) uiSecond;
+   aulCounts[COST_COMPARISONS]++;
+}
+
+void __sanitizer_cov_trace_cmp8(uint64_t uiFirst, uint64_t uiSecond) {
+   (void) uiFirst;
+   (void) uiSecond;
+   aulCounts[COST_COMPARISONS]++;
+}
+
+void __sanitizer_cov_trace_const_cmp1(uint8_t uiFirst,
+                                      uint8_t uiSecond) {
+   __sanitizer_cov_trace_cmp1(uiFirst, uiSecond);
+}
+
+void __sanitizer_cov_trace_const_cmp2(uint16_t uiFirst,
+                                      uint16_t uiSecond) {
+   __sanitizer_cov_trace_cmp2(uiFirst, uiSecond);
+}
+
+void __sanitizer_cov_trace_const_cmp4(uint32_t uiFirst,
+                                      uint32_t uiSecond) {
+   __sanitizer_cov_trace_cmp4(uiFirst, uiSecond);
+}
+
+void __sanitizer_cov_trace_const_cmp8(uint64_t uiFirst,
+                                      uint64_t uiSecond) {
+   __sanitizer_cov_trace_cmp8(uiFirst, uiSecond);
+}
+
+void __sanitizer_cov_trace_cmpf(float fFirst, float fSecond) {
+   (void) fFirst;
+   (void) fSecond;
+   aulCounts[COST_COMPARISONS]++;
+}
+
+void __sanitizer_cov_trace_cmpd(double dFirst, double dSecond) {
+   (void) dFirst;
+   (void) dSecond;
+   aulCounts[COST_COMPARISONS]++;
+}
+
+void __sanitizer_cov_trace_switch(uint64_t uiValue,
+                                  uint64_t *puiCases) {
+   (void) uiValue;
+   (void) puiCases;
+   aulCounts[COST_COMPARISONS]++;
+}
+
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Returns how many of the first ulLength bytes of pvFirst and
+   pvSecond a comparison reads, stopping after a mismatch, and after a
+   '\0' too if bIsString. */
+static size_t Cost_scanned(const void *pvFirst, const void *pvSecond,
+                           size_t ulLength, int bIsString) {
+   const unsigned char *pucFirst = pvFirst;
+   const unsigned char *pucSecond = pvSecond;
+   size_t i;
+
+   for(i = 0; i < ulLength; i++)
+      if(pucFirst[i] != pucSecond[i] || (bIsString && pucFirst[i] == 0))
+         return i + 1;
+   return ulLength;
+}
+
+size_t __wrap_strlen(const char *pcString) {
+   size_t ulLength = __real_strlen(pcString);
+   aulCounts[COST_BYTES] += ulLength + 1;
+   return ulLength;
+}
+
+char *__wrap_strcpy(char *pcDest, const char *pcSrc) {
+   aulCounts[COST_BYTES] += __real_strlen(pcSrc) + 1;
+   return __real_strcpy(pcDest, pcSrc);
+}
+
+char *__wrap_strcat(char *pcDest, const char *pcSrc) {
+   /* finding the end of pcDest is the expensive part */
+   aulCounts[COST_BYTES] += __real_strlen(pcDest) +
+      __real_strlen(pcSrc) + 1;
+   return __real_strcat(pcDest, pcSrc);
+}
+
+int __wrap_strcmp(const char *pcFirst, const char *pcSecond) {
+   aulCounts[COST_BYTES] += Cost_scanned(pcFirst, pcSecond,
+                                         (size_t) -1, 1);
+   return __real_strcmp(pcFirst, pcSecond);
+}
+
+int __wrap_strncmp(const char *pcFirst, const char *pcSecond,
+                   size_t ulLength) {
+   aulCounts[COST_BYTES] += Cost_scanned(pcFirst, pcSecond, ulLength,
+                                         1);
+   return __real_strncmp(pcFirst, pcSecond, ulLength);
+}
+
+char *__wrap_strchr(const char *pcString, int iChar) {
+   char *pcFound = __real_strchr(pcString, iChar);
+   aulCounts[COST_BYTES] += (pcFound != NULL ?
+                             (size_t) (pcFound - pcString) :
+                             __real_strlen(pcString)) + 1;
+   return pcFound;
+}
+
+void *__wrap_memcpy(void *pvDest, const void *pvSrc, size_t ulLength) {
+   aulCounts[COST_BYTES] += ulLength;
+   return __real_memcpy(pvDest, pvSrc, ulLength);
+}
+
+void *__wrap_memmove(void *pvDest, const void *pvSrc,
+                     size_t ulLength) {
+   aulCounts[COST_BYTES] += ulLength;
+   return __real_memmove(pvDest, pvSrc, ulLength);
+}
+
+void *__wrap_memset(void *pvDest, int iByte, size_t ulLength) {
+   aulCounts[COST_BYTES] += ulLength;
+   return __real_memset(pvDest, iByte, ulLength);
+}
+
+int __wrap_memcmp(const void *pvFirst, const void *pvSecond,
+                  size_t ulLength) {
+   aulCounts[COST_BYTES] += Cost_scanned(pvFirst, pvSecond, ulLength,
+                                         0);
+   return __real_memcmp(pvFirst, pvSecond, ulLength);
+}
+
+void *__wrap_memchr(const void *pvData, int iByte, size_t ulLength) {
+   void *pvFound = __real_memchr(pvData, iByte, ulLength);
+   aulCounts[COST_BYTES] += pvFound != NULL ?
+      (size_t) ((const char *) pvFound - (const char *) pvData) + 1 :
+      ulLength;
+   return pvFound;
+}
+
+/*--------------------------------------------------------------------*/
+
+void Cost_get(struct costCounts *psCounts) {
+   struct allocStats sStats;
+   size_t c;
+
+   assert(psCounts != NULL);
+
+   AllocStat_get(&sStats);
+   for(c = 0; c < COST_COUNTERS; c++)
+      psCounts->aulCounts[c] = aulCounts[c];
+   psCounts->aulCounts[COST_ALLOCATIONS] =
+      (unsigned long) (sStats.ulAllocs + sStats.ulReallocs);
+}
+
+const char *Cost_getName(enum costCounter eCounter) {
+   static const char *apcNames[COST_COUNTERS] = {
+      "blocks", "comparisons", "bytes", "allocations"
+   };
+
+   assert((size_t) eCounter < COST_COUNTERS);
+
+   return apcNames[eCounter];
+}
@@ -0,0 +1,53 @@
+/*--------------------------------------------------------------------*/
+/* costhook.h                                                         */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef COSTHOOK_INCLUDED
+#define COSTHOOK_INCLUDED
+
+/*
+  costhook counts the work done by the objects of a program that are
+  compiled with
+    -fsanitize-coverage=trace-pc,trace-cmp -fno-builtin
+  (a compiler's instrumentation hooks, which call it on every basic
+  block and comparison) and linked with
+    -Wl,--wrap=strlen,--wrap=strcpy,--wrap=strcat,--wrap=strcmp
+    -Wl,--wrap=strncmp,--wrap=strchr,--wrap=memcpy,--wrap=memmove
+    -Wl,--wrap=memset,--wrap=memcmp,--wrap=memchr
+  and allocstat's wraps, which route the C library calls that do
+  work proportional to their arguments through it. Each counter only
+  grows, so the work of a call is the difference between the counts
+  before and after it. The counts are not synchronized, so they are
+  only exact for single-threaded programs.
+
+  Under libFuzzer (when compiled with -D COST_LIBFUZZER), libFuzzer
+  owns the comparison hooks, so comparisons are not counted; the
+  other counters work as above.
+*/
+
+/* The kinds of work counted */
+enum costCounter {
+   /* basic blocks executed in instrumented objects */
+   COST_BLOCKS,
+   /* comparisons executed in instrumented objects */
+   COST_COMPARISONS,
+   /* bytes the wrapped C library functions read or wrote */
+   COST_BYTES,
+   /* heap allocations and reallocations, as counted by allocstat */
+   COST_ALLOCATIONS,
+   COST_COUNTERS
+};
+
+/* A snapshot of every counter */
+struct costCounts {
+   unsigned long aulCounts[COST_COUNTERS];
+};
+
+/* Copies the current counts into *psCounts. */
+void Cost_get(struct costCounts *psCounts);
+
+/* Returns the name of eCounter, for reports. */
+const char *Cost_getName(enum costCounter eCounter);
+
+#endif
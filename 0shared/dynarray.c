@@ -125,6 +125,27 @@ size_t DynArray_getLength(DynArray_T oDynArray)
 
 /*--------------------------------------------------------------------*/
 
+size_t DynArray_getPhysLength(DynArray_T oDynArray)
+{
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   return oDynArray->uPhysLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t DynArray_getMemorySize(DynArray_T oDynArray)
+{
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   return sizeof(struct DynArray) +
+      oDynArray->uPhysLength * sizeof(void*);
+}
+
+/*--------------------------------------------------------------------*/
+
 void *DynArray_get(DynArray_T oDynArray, size_t uIndex)
 {
    assert(oDynArray != NULL);
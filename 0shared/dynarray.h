@@ -34,6 +34,21 @@ size_t DynArray_getLength(DynArray_T oDynArray);
 
 /*--------------------------------------------------------------------*/
 
+/* Return the number of elements oDynArray has room for before it
+   must grow, which is at least its length. */
+
+size_t DynArray_getPhysLength(DynArray_T oDynArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bytes allocated for oDynArray itself,
+   including room for elements not yet in use, but not for the
+   objects its elements point to. */
+
+size_t DynArray_getMemorySize(DynArray_T oDynArray);
+
+/*--------------------------------------------------------------------*/
+
 /* Return the uIndex'th element of oDynArray. */
 
 void *DynArray_get(DynArray_T oDynArray, size_t uIndex);
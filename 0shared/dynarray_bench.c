@@ -0,0 +1,427 @@
+/*--------------------------------------------------------------------*/
+/* dynarray_bench.c                                                   */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "a4def.h"
+#include "allocstat.h"
+#include "benchutil.h"
+#include "dynarray.h"
+
+/*
+  dynarray_bench times the DynArray_T operations at array sizes from
+  2 up to -m elements (10M by default), in steps of about 8x, and
+  reports for each the time, heap allocations and (where a comparison
+  function is used) comparisons per call or, for sort and map, per
+  element.
+
+  Usage: dynarray_bench [-m maxsize] [-t seconds] [-s seed]
+
+  Insertions and removals away from the end shift every later
+  element, so they are timed over only as many calls as keep the
+  total work reasonable. A sort that is projected, from its cost at
+  the previous size, to take longer than -t seconds (10 by default)
+  is reported as skipped rather than run: that is how quadratic
+  behavior shows up at the larger sizes.
+*/
+
+/* The sizes measured */
+static const size_t aulSizes[] = {
+   2, 16, 128, 1000, 8000, 64000, 512000, 4000000, 10000000
+};
+enum { BENCH_SIZES = sizeof(aulSizes) / sizeof(aulSizes[0]) };
+
+/* About how many element steps each measurement is repeated for */
+enum { BENCH_WORK = 4000000 };
+
+/* The input orders sorts are measured on */
+enum inputOrder { ORDER_RANDOM, ORDER_SORTED, ORDER_REVERSED,
+                  ORDER_DUPLICATES, ORDER_COUNT };
+static const char *apcOrderNames[ORDER_COUNT] = {
+   "sort/random", "sort/sorted", "sort/reversed", "sort/duplicates"
+};
+
+/* The cost of one sort at the previous size, for projections */
+struct sortHistory {
+   size_t ulSize;
+   double dSeconds;
+   double dCompares;
+};
+
+/* The state of the pseudo-random generator */
+static unsigned long ulSeed = 1;
+
+/* The number of calls to the comparison functions */
+static size_t ulCompares;
+
+/*--------------------------------------------------------------------*/
+
+/* Prints msg and exits the benchmark with status 2. */
+static void Bench_die(const char *pcMsg) {
+   fprintf(stderr, "dynarray_bench: %s\n", pcMsg);
+   exit(2);
+}
+
+/* Compares the numbers pvFirst and pvSecond point to, and counts it. */
+static int Bench_compareNumbers(const void *pvFirst,
+                                const void *pvSecond) {
+   unsigned long ulFirst = *(const unsigned long *) pvFirst;
+   unsigned long ulSecond = *(const unsigned long *) pvSecond;
+   ulCompares++;
+   return (ulFirst > ulSecond) - (ulFirst < ulSecond);
+}
+
+/* Compares strings pvFirst and pvSecond, and counts it. */
+static int Bench_compareStrings(const void *pvFirst,
+                                const void *pvSecond) {
+   ulCompares++;
+   return strcmp(pvFirst, pvSecond);
+}
+
+/* Adds the number pvElement points to into *pvSum. */
+static void Bench_sum(void *pvElement, void *pvSum) {
+   *(unsigned long *) pvSum += *(unsigned long *) pvElement;
+}
+
+/*
+  Returns how many times to repeat a measurement whose one repetition
+  costs about ulWork element steps.
+*/
+static size_t Bench_rounds(size_t ulWork) {
+   if(ulWork == 0 || ulWork >= BENCH_WORK)
+      return 1;
+   return BENCH_WORK / ulWork;
+}
+
+/*
+  Returns a new DynArray_T holding pointers to the ulSize elements of
+  pulKeys, in order.
+*/
+static DynArray_T Bench_build(unsigned long *pulKeys, size_t ulSize) {
+   DynArray_T oDArray;
+   size_t i;
+
+   oDArray = DynArray_new(ulSize);
+   if(oDArray == NULL)
+      Bench_die("out of memory");
+   for(i = 0; i < ulSize; i++)
+      (void) DynArray_set(oDArray, i, &pulKeys[i]);
+   return oDArray;
+}
+
+/*
+  Prints one report line for operation pcOp at size ulSize, over
+  ulOps calls (or elements) that took ulNs nanoseconds, made the
+  allocations in *psStats and, if bCompares, ulCompares comparisons.
+*/
+static void Bench_print(size_t ulSize, const char *pcOp, size_t ulOps,
+                        unsigned long ulNs,
+                        const struct allocStats *psStats,
+                        boolean bCompares) {
+   printf("%9lu %-18s %12.1f %10.3f", (unsigned long) ulSize, pcOp,
+          (double) ulNs / (double) ulOps,
+          (double) (psStats->ulAllocs + psStats->ulReallocs) /
+             (double) ulOps);
+   if(bCompares)
+      printf(" %10.2f\n", (double) ulCompares / (double) ulOps);
+   else
+      printf(" %10s\n", "-");
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Times DynArray_add growing an empty array to ulSize elements. */
+static void Bench_add(unsigned long *pulKeys, size_t ulSize) {
+   struct allocStats sStats;
+   size_t ulRounds = Bench_rounds(ulSize);
+   unsigned long ulNs = 0;
+   unsigned long ulStart;
+   size_t r;
+   size_t i;
+
+   AllocStat_reset();
+   for(r = 0; r < ulRounds; r++) {
+      DynArray_T oDArray = DynArray_new(0);
+      if(oDArray == NULL)
+         Bench_die("out of memory");
+      ulStart = BenchUtil_now();
+      for(i = 0; i < ulSize; i++)
+         if(!DynArray_add(oDArray, &pulKeys[i]))
+            Bench_die("out of memory");
+      ulNs += BenchUtil_now() - ulStart;
+      DynArray_free(oDArray);
+   }
+   AllocStat_get(&sStats);
+   /* the DynArray_new of each round is counted with the adds */
+   Bench_print(ulSize, "add", ulSize * ulRounds, ulNs, &sStats, FALSE);
+}
+
+/*
+  Times DynArray_addAt (if bAdd) or DynArray_removeAt at the front,
+  middle, or end (iWhere 0, 1, 2) of an array of ulSize elements.
+*/
+static void Bench_shift(unsigned long *pulKeys, size_t ulSize,
+                        boolean bAdd, int iWhere) {
+   static const char *apcNames[2][3] = {
+      {"removeAt/front", "removeAt/middle", "removeAt/end"},
+      {"addAt/front", "addAt/middle", "addAt/end"}
+   };
+   struct allocStats sStats;
+   DynArray_T oDArray;
+   size_t ulCalls;
+   size_t ulRounds;
+   unsigned long ulNs = 0;
+   unsigned long ulStart;
+   size_t r;
+   size_t i;
+
+   /* calls away from the end shift the array, so bound their work */
+   ulCalls = ulSize;
+   if(iWhere != 2 && ulCalls > BENCH_WORK / 8 / ulSize)
+      ulCalls = BENCH_WORK / 8 / ulSize;
+   if(ulCalls == 0)
+      ulCalls = 1;
+   if(!bAdd && ulCalls > ulSize)
+      ulCalls = ulSize;
+   ulRounds = Bench_rounds(iWhere == 2 ? ulCalls : ulCalls * ulSize);
+
+   memset(&sStats, 0, sizeof(sStats));
+   for(r = 0; r < ulRounds; r++) {
+      struct allocStats sRound;
+      oDArray = Bench_build(pulKeys, ulSize);
+      AllocStat_reset();
+      ulStart = BenchUtil_now();
+      for(i = 0; i < ulCalls; i++) {
+         size_t ulLength = DynArray_getLength(oDArray);
+         size_t ulIndex = iWhere == 0 ? 0 : iWhere == 1 ?
+            ulLength / 2 : bAdd ? ulLength : ulLength - 1;
+         if(bAdd) {
+            if(!DynArray_addAt(oDArray, ulIndex, &pulKeys[i]))
+               Bench_die("out of memory");
+         }
+         else
+            (void) DynArray_removeAt(oDArray, ulIndex);
+      }
+      ulNs += BenchUtil_now() - ulStart;
+      AllocStat_get(&sRound);
+      sStats.ulAllocs += sRound.ulAllocs;
+      sStats.ulReallocs += sRound.ulReallocs;
+      DynArray_free(oDArray);
+   }
+   Bench_print(ulSize, apcNames[bAdd][iWhere], ulCalls * ulRounds, ulNs,
+               &sStats, FALSE);
+}
+
+/*
+  Times DynArray_bsearch for existing keys in a sorted array of
+  ulSize fixed-width decimal strings.
+*/
+static void Bench_bsearch(size_t ulSize) {
+   struct allocStats sStats;
+   DynArray_T oDArray;
+   char *pcKeys;
+   size_t ulCalls = ulSize < 100000 ? ulSize : 100000;
+   size_t ulRounds = Bench_rounds(ulCalls * 16);
+   unsigned long ulNs;
+   unsigned long ulStart;
+   size_t ulIndex;
+   size_t r;
+   size_t i;
+
+   pcKeys = malloc(ulSize * 12);
+   oDArray = DynArray_new(ulSize);
+   if(pcKeys == NULL || oDArray == NULL)
+      Bench_die("out of memory");
+   for(i = 0; i < ulSize; i++) {
+      sprintf(pcKeys + 12 * i, "%011lu", (unsigned long) i * 7);
+      (void) DynArray_set(oDArray, i, pcKeys + 12 * i);
+   }
+
+   ulCompares = 0;
+   AllocStat_reset();
+   ulStart = BenchUtil_now();
+   for(r = 0; r < ulRounds; r++)
+      for(i = 0; i < ulCalls; i++)
+         if(!DynArray_bsearch(oDArray,
+               pcKeys + 12 * ((i * 2654435761UL) % ulSize), &ulIndex,
+               Bench_compareStrings))
+            Bench_die("DynArray_bsearch missed a key");
+   ulNs = BenchUtil_now() - ulStart;
+   AllocStat_get(&sStats);
+   Bench_print(ulSize, "bsearch/string", ulCalls * ulRounds, ulNs,
+               &sStats, TRUE);
+
+   DynArray_free(oDArray);
+   free(pcKeys);
+}
+
+/*
+  Fills the ulSize elements of pulKeys in order eOrder.
+*/
+static void Bench_fill(unsigned long *pulKeys, size_t ulSize,
+                       enum inputOrder eOrder) {
+   size_t i;
+
+   for(i = 0; i < ulSize; i++) {
+      switch(eOrder) {
+         case ORDER_RANDOM:
+            pulKeys[i] = BenchUtil_random(&ulSeed);
+            break;
+         case ORDER_SORTED: pulKeys[i] = i; break;
+         case ORDER_REVERSED: pulKeys[i] = ulSize - i; break;
+         default: pulKeys[i] = BenchUtil_random(&ulSeed) % 8; break;
+      }
+   }
+}
+
+/*
+  Times DynArray_sort of ulSize elements in order eOrder, unless
+  psHistory (the cost of the previous size) projects it to take more
+  than dBudget seconds, and then updates psHistory.
+*/
+static void Bench_sort(unsigned long *pulKeys, size_t ulSize,
+                       enum inputOrder eOrder, double dBudget,
+                       struct sortHistory *psHistory) {
+   struct allocStats sStats;
+   DynArray_T oDArray;
+   size_t ulRounds = Bench_rounds(ulSize * 16);
+   unsigned long ulNs = 0;
+   unsigned long ulStart;
+   size_t ulAllCompares = 0;
+   size_t r;
+
+   if(psHistory->ulSize > 1) {
+      /* n log n, unless the previous size was already far worse */
+      double dRatio = (double) ulSize / (double) psHistory->ulSize;
+      double dNLogN = (double) psHistory->ulSize *
+         log2((double) psHistory->ulSize);
+      double dProjected = psHistory->dSeconds * dRatio *
+         log2((double) ulSize) / log2((double) psHistory->ulSize);
+      if(psHistory->dCompares > 8.0 * dNLogN)
+         dProjected = psHistory->dSeconds * dRatio * dRatio;
+      if(dProjected > dBudget) {
+         printf("%9lu %-18s skipped: projected %.0f s\n",
+                (unsigned long) ulSize, apcOrderNames[eOrder],
+                dProjected);
+         return;
+      }
+   }
+
+   memset(&sStats, 0, sizeof(sStats));
+   for(r = 0; r < ulRounds; r++) {
+      struct allocStats sRound;
+      Bench_fill(pulKeys, ulSize, eOrder);
+      oDArray = Bench_build(pulKeys, ulSize);
+      ulCompares = 0;
+      AllocStat_reset();
+      ulStart = BenchUtil_now();
+      DynArray_sort(oDArray, Bench_compareNumbers);
+      ulNs += BenchUtil_now() - ulStart;
+      AllocStat_get(&sRound);
+      sStats.ulAllocs += sRound.ulAllocs;
+      sStats.ulReallocs += sRound.ulReallocs;
+      ulAllCompares += ulCompares;
+      DynArray_free(oDArray);
+   }
+   ulCompares = ulAllCompares;
+   Bench_print(ulSize, apcOrderNames[eOrder], ulSize * ulRounds, ulNs,
+               &sStats, TRUE);
+
+   psHistory->ulSize = ulSize;
+   psHistory->dSeconds = (double) ulNs / 1e9 / (double) ulRounds;
+   psHistory->dCompares = (double) ulAllCompares / (double) ulRounds;
+}
+
+/* Times DynArray_map over an array of ulSize elements. */
+static void Bench_map(unsigned long *pulKeys, size_t ulSize) {
+   struct allocStats sStats;
+   DynArray_T oDArray;
+   size_t ulRounds = Bench_rounds(ulSize);
+   unsigned long ulSum = 0;
+   unsigned long ulNs;
+   unsigned long ulStart;
+   size_t r;
+
+   oDArray = Bench_build(pulKeys, ulSize);
+   AllocStat_reset();
+   ulStart = BenchUtil_now();
+   for(r = 0; r < ulRounds; r++)
+      DynArray_map(oDArray, Bench_sum, &ulSum);
+   ulNs = BenchUtil_now() - ulStart;
+   AllocStat_get(&sStats);
+   Bench_print(ulSize, "map", ulSize * ulRounds, ulNs, &sStats,
+               FALSE);
+   DynArray_free(oDArray);
+
+   /* keeps the compiler from discarding the sums */
+   if(ulSum == 1)
+      printf("\n");
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Measures every operation at every size up to the maximum selected by
+  the command-line arguments argv, and prints the report to stdout.
+  Returns 0, or 2 for a usage error.
+*/
+int main(int argc, char *argv[]) {
+   struct sortHistory asHistory[ORDER_COUNT];
+   unsigned long *pulKeys;
+   size_t ulMax = 10000000;
+   double dBudget = 10.0;
+   int iSize;
+   int iWhere;
+   int eOrder;
+   int iOpt;
+
+   while((iOpt = getopt(argc, argv, "m:t:s:")) != -1) {
+      switch(iOpt) {
+         case 'm': ulMax = (size_t) strtoul(optarg, NULL, 10); break;
+         case 't': dBudget = strtod(optarg, NULL); break;
+         case 's': ulSeed = strtoul(optarg, NULL, 10); break;
+         default:
+            fprintf(stderr, "usage: %s [-m maxsize] [-t seconds] "
+                    "[-s seed]\n", argv[0]);
+            return 2;
+      }
+   }
+   if(ulSeed == 0)
+      ulSeed = 1;
+
+   pulKeys = malloc((ulMax > 2 ? ulMax : 2) * sizeof(unsigned long));
+   if(pulKeys == NULL)
+      Bench_die("out of memory");
+   memset(asHistory, 0, sizeof(asHistory));
+
+   printf("%9s %-18s %12s %10s %10s\n", "size", "op", "ns/op",
+          "allocs/op", "cmps/op");
+   for(iSize = 0; iSize < BENCH_SIZES && aulSizes[iSize] <= ulMax;
+       iSize++) {
+      size_t ulSize = aulSizes[iSize];
+
+      Bench_fill(pulKeys, ulSize, ORDER_SORTED);
+      Bench_add(pulKeys, ulSize);
+      for(iWhere = 0; iWhere < 3; iWhere++)
+         Bench_shift(pulKeys, ulSize, TRUE, iWhere);
+      for(iWhere = 0; iWhere < 3; iWhere++)
+         Bench_shift(pulKeys, ulSize, FALSE, iWhere);
+      Bench_bsearch(ulSize);
+      for(eOrder = 0; eOrder < ORDER_COUNT; eOrder++)
+         Bench_sort(pulKeys, ulSize, (enum inputOrder) eOrder, dBudget,
+                    &asHistory[eOrder]);
+      Bench_fill(pulKeys, ulSize, ORDER_SORTED);
+      Bench_map(pulKeys, ulSize);
+   }
+
+   free(pulKeys);
+   return 0;
+}
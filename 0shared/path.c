@@ -266,6 +266,20 @@ size_t Path_getStrLength(Path_T oPPath) {
    return oPPath->ulLength;
 }
 
+size_t Path_getMemorySize(Path_T oPPath) {
+   size_t ulSize;
+   size_t ulIndex;
+
+   assert(oPPath != NULL);
+
+   ulSize = sizeof(struct path) + oPPath->ulLength + 1 +
+      DynArray_getMemorySize(oPPath->oDComponents);
+   for(ulIndex = 0; ulIndex < DynArray_getLength(oPPath->oDComponents);
+       ulIndex++)
+      ulSize += strlen(DynArray_get(oPPath->oDComponents, ulIndex)) + 1;
+   return ulSize;
+}
+
 int Path_comparePath(Path_T oPPath1, Path_T oPPath2) {
    assert(oPPath1 != NULL);
    assert(oPPath2 != NULL);
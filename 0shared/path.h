@@ -55,6 +55,12 @@ const char *Path_getPathname(Path_T oPPath);
 */
 size_t Path_getStrLength(Path_T oPPath);
 
+/*
+  Returns the number of bytes allocated for oPPath: its record, its
+  pathname, and its components and their array.
+*/
+size_t Path_getMemorySize(Path_T oPPath);
+
 /*
   Compares oPPath1 and oPPath2 lexicographically based on pathname.
   Returns <0, 0, or >0 if oPPath1 is "less than", "equal to", or
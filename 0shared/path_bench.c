@@ -0,0 +1,281 @@
+/*--------------------------------------------------------------------*/
+/* path_bench.c                                                       */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "allocstat.h"
+#include "benchutil.h"
+#include "path.h"
+
+/*
+  path_bench times the Path_T operations that every tree variant
+  relies on, in isolation, over sets of paths of several depths and
+  component-length distributions, and reports for each the time and
+  heap allocations per call.
+
+  Usage: path_bench [-n paths] [-r rounds] [-s seed]
+
+  Each set holds -n paths of one depth, whose components at each level
+  are drawn from a few names of the set's length distribution, so that
+  neighbouring paths share prefixes the way siblings in a tree do.
+  Each operation is timed -r times over the whole set.
+*/
+
+/* The depths and component-length distributions measured */
+static const size_t aulDepths[] = {1, 4, 16, 64};
+enum { BENCH_DEPTHS = sizeof(aulDepths) / sizeof(aulDepths[0]) };
+/* minimum and maximum component lengths of each distribution */
+static const struct {
+   const char *pcName;
+   size_t ulMin;
+   size_t ulMax;
+} asLengths[] = {
+   {"short", 1, 3}, {"medium", 8, 8}, {"long", 32, 32},
+   {"mixed", 1, 32}
+};
+enum { BENCH_LENGTHS = sizeof(asLengths) / sizeof(asLengths[0]) };
+
+/* The number of distinct names drawn from at each level */
+enum { BENCH_NAMES = 4 };
+
+/* The state of the pseudo-random generator */
+static unsigned long ulSeed = 1;
+
+/*--------------------------------------------------------------------*/
+
+/* Prints msg and exits the benchmark with status 2. */
+static void Bench_die(const char *pcMsg) {
+   fprintf(stderr, "path_bench: %s\n", pcMsg);
+   exit(2);
+}
+
+/*
+  Returns a newly allocated array of ulCount path strings of depth
+  ulDepth, whose components are drawn, at each level, from
+  BENCH_NAMES names of length distribution iLength.
+*/
+static char **Bench_makePaths(size_t ulCount, size_t ulDepth,
+                              int iLength) {
+   char aacNames[BENCH_NAMES][40];
+   char **ppcPaths;
+   size_t ulMin = asLengths[iLength].ulMin;
+   size_t ulMax = asLengths[iLength].ulMax;
+   size_t i;
+   size_t d;
+   size_t n;
+
+   ppcPaths = malloc(ulCount * sizeof(char *));
+   if(ppcPaths == NULL)
+      Bench_die("out of memory generating paths");
+   for(i = 0; i < ulCount; i++) {
+      ppcPaths[i] = malloc(ulDepth * (ulMax + 1) + 1);
+      if(ppcPaths[i] == NULL)
+         Bench_die("out of memory generating paths");
+      ppcPaths[i][0] = '\0';
+   }
+
+   for(d = 0; d < ulDepth; d++) {
+      /* a fresh set of names for each level */
+      for(n = 0; n < BENCH_NAMES; n++) {
+         size_t ulLength = ulMin +
+            BenchUtil_random(&ulSeed) % (ulMax - ulMin + 1);
+         size_t c;
+         for(c = 0; c < ulLength; c++)
+            aacNames[n][c] =
+               (char) ('a' + BenchUtil_random(&ulSeed) % 26);
+         aacNames[n][ulLength] = '\0';
+      }
+      for(i = 0; i < ulCount; i++) {
+         if(d > 0)
+            strcat(ppcPaths[i], "/");
+         strcat(ppcPaths[i],
+                aacNames[BenchUtil_random(&ulSeed) % BENCH_NAMES]);
+      }
+   }
+   return ppcPaths;
+}
+
+/*
+  Prints one report line for operation pcOp over ulOps calls that
+  took ulNs nanoseconds and made the allocations in *psStats.
+*/
+static void Bench_print(const char *pcSet, const char *pcOp,
+                        size_t ulOps, unsigned long ulNs,
+                        const struct allocStats *psStats) {
+   printf("%-16s %-26s %10.1f %10.2f %10.1f\n", pcSet, pcOp,
+          (double) ulNs / (double) ulOps,
+          (double) (psStats->ulAllocs + psStats->ulReallocs) /
+             (double) ulOps,
+          (double) psStats->ulBytes / (double) ulOps);
+}
+
+/*
+  Times every operation over the ulCount paths ppcPaths, ulRounds
+  times each, and prints one line per operation labelled pcSet.
+*/
+static void Bench_measure(const char *pcSet, char **ppcPaths,
+                          size_t ulCount, size_t ulRounds) {
+   Path_T *poPPaths;
+   Path_T *poPResults;
+   struct allocStats sStats;
+   unsigned long ulStart;
+   unsigned long ulNs;
+   size_t ulSink = 0;
+   size_t r;
+   size_t i;
+
+   poPPaths = malloc(ulCount * sizeof(Path_T));
+   poPResults = malloc(ulCount * sizeof(Path_T));
+   if(poPPaths == NULL || poPResults == NULL)
+      Bench_die("out of memory");
+
+   /* Path_new; the paths of the last round are kept for the rest */
+   ulNs = 0;
+   AllocStat_reset();
+   for(r = 0; r < ulRounds; r++) {
+      ulStart = BenchUtil_now();
+      for(i = 0; i < ulCount; i++)
+         if(Path_new(ppcPaths[i], &poPPaths[i]) != SUCCESS)
+            Bench_die("Path_new failed");
+      ulNs += BenchUtil_now() - ulStart;
+      if(r + 1 < ulRounds)
+         for(i = 0; i < ulCount; i++)
+            Path_free(poPPaths[i]);
+   }
+   AllocStat_get(&sStats);
+   Bench_print(pcSet, "Path_new", ulCount * ulRounds, ulNs, &sStats);
+
+   /* Path_prefix, to half of each path's depth */
+   ulNs = 0;
+   memset(&sStats, 0, sizeof(sStats));
+   for(r = 0; r < ulRounds; r++) {
+      struct allocStats sRound;
+      AllocStat_reset();
+      ulStart = BenchUtil_now();
+      for(i = 0; i < ulCount; i++)
+         if(Path_prefix(poPPaths[i],
+                        (Path_getDepth(poPPaths[i]) + 1) / 2,
+                        &poPResults[i]) != SUCCESS)
+            Bench_die("Path_prefix failed");
+      ulNs += BenchUtil_now() - ulStart;
+      AllocStat_get(&sRound);
+      sStats.ulAllocs += sRound.ulAllocs;
+      sStats.ulReallocs += sRound.ulReallocs;
+      sStats.ulBytes += sRound.ulBytes;
+      for(i = 0; i < ulCount; i++)
+         Path_free(poPResults[i]);
+   }
+   Bench_print(pcSet, "Path_prefix", ulCount * ulRounds, ulNs, &sStats);
+
+   /* Path_dup */
+   ulNs = 0;
+   memset(&sStats, 0, sizeof(sStats));
+   for(r = 0; r < ulRounds; r++) {
+      struct allocStats sRound;
+      AllocStat_reset();
+      ulStart = BenchUtil_now();
+      for(i = 0; i < ulCount; i++)
+         if(Path_dup(poPPaths[i], &poPResults[i]) != SUCCESS)
+            Bench_die("Path_dup failed");
+      ulNs += BenchUtil_now() - ulStart;
+      AllocStat_get(&sRound);
+      sStats.ulAllocs += sRound.ulAllocs;
+      sStats.ulReallocs += sRound.ulReallocs;
+      sStats.ulBytes += sRound.ulBytes;
+      for(i = 0; i < ulCount; i++)
+         Path_free(poPResults[i]);
+   }
+   Bench_print(pcSet, "Path_dup", ulCount * ulRounds, ulNs, &sStats);
+
+   /* Path_comparePath, of each path with the next */
+   AllocStat_reset();
+   ulStart = BenchUtil_now();
+   for(r = 0; r < ulRounds; r++)
+      for(i = 0; i + 1 < ulCount; i++)
+         ulSink += (size_t) (Path_comparePath(poPPaths[i],
+                                              poPPaths[i + 1]) < 0);
+   ulNs = BenchUtil_now() - ulStart;
+   AllocStat_get(&sStats);
+   Bench_print(pcSet, "Path_comparePath", (ulCount - 1) * ulRounds,
+               ulNs, &sStats);
+
+   /* Path_getSharedPrefixDepth, of each path with the next */
+   AllocStat_reset();
+   ulStart = BenchUtil_now();
+   for(r = 0; r < ulRounds; r++)
+      for(i = 0; i + 1 < ulCount; i++)
+         ulSink += Path_getSharedPrefixDepth(poPPaths[i],
+                                             poPPaths[i + 1]);
+   ulNs = BenchUtil_now() - ulStart;
+   AllocStat_get(&sStats);
+   Bench_print(pcSet, "Path_getSharedPrefixDepth",
+               (ulCount - 1) * ulRounds, ulNs, &sStats);
+
+   for(i = 0; i < ulCount; i++)
+      Path_free(poPPaths[i]);
+   free(poPPaths);
+   free(poPResults);
+
+   /* keeps the compiler from discarding the comparisons */
+   if(ulSink == (size_t) -1)
+      printf("\n");
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Measures every operation over every depth and length distribution
+  selected by the command-line arguments argv and prints the report
+  to stdout. Returns 0, or 2 for a usage error.
+*/
+int main(int argc, char *argv[]) {
+   size_t ulCount = 1000;
+   size_t ulRounds = 100;
+   int iDepth;
+   int iLength;
+   int iOpt;
+
+   while((iOpt = getopt(argc, argv, "n:r:s:")) != -1) {
+      switch(iOpt) {
+         case 'n': ulCount = (size_t) strtoul(optarg, NULL, 10); break;
+         case 'r': ulRounds = (size_t) strtoul(optarg, NULL, 10); break;
+         case 's': ulSeed = strtoul(optarg, NULL, 10); break;
+         default:
+            fprintf(stderr, "usage: %s [-n paths] [-r rounds] "
+                    "[-s seed]\n", argv[0]);
+            return 2;
+      }
+   }
+   if(ulSeed == 0)
+      ulSeed = 1;
+   if(ulCount < 2 || ulRounds == 0)
+      Bench_die("-n must be at least 2 and -r positive");
+
+   printf("%-16s %-26s %10s %10s %10s\n", "set", "op", "ns/op",
+          "allocs/op", "bytes/op");
+   for(iDepth = 0; iDepth < BENCH_DEPTHS; iDepth++) {
+      for(iLength = 0; iLength < BENCH_LENGTHS; iLength++) {
+         char acSet[32];
+         char **ppcPaths;
+         size_t i;
+
+         sprintf(acSet, "depth%lu/%s",
+                 (unsigned long) aulDepths[iDepth],
+                 asLengths[iLength].pcName);
+         ppcPaths = Bench_makePaths(ulCount, aulDepths[iDepth],
+                                    iLength);
+         Bench_measure(acSet, ppcPaths, ulCount, ulRounds);
+         for(i = 0; i < ulCount; i++)
+            free(ppcPaths[i]);
+         free(ppcPaths);
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,126 @@
+/*--------------------------------------------------------------------*/
+/* perfctr.c                                                          */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perfctr.h"
+
+/* The perf_event_attr config of each counter */
+static const unsigned long aulConfigs[PERF_COUNTERS] = {
+   PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+   PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+static const char *apcNames[PERF_COUNTERS] = {
+   "cycles", "instructions", "cache-misses", "branch-misses"
+};
+
+/* Each counter's descriptor, or -1 if it is not open */
+static int aiFds[PERF_COUNTERS] = {-1, -1, -1, -1};
+/* The group leader's descriptor, or -1 if no counter is open */
+static int iLeaderFd = -1;
+/* How many counters are open */
+static size_t ulOpen;
+/* The open counters, in the order a group read returns them */
+static enum perfCounter aeOrder[PERF_COUNTERS];
+
+/*--------------------------------------------------------------------*/
+
+int PerfCtr_open(void) {
+   int eCounter;
+
+   if(iLeaderFd >= 0)
+      return ALREADY_IN_TREE;
+
+   for(eCounter = 0; eCounter < PERF_COUNTERS; eCounter++) {
+      struct perf_event_attr sAttr;
+      long lFd;
+
+      memset(&sAttr, 0, sizeof(sAttr));
+      sAttr.size = sizeof(sAttr);
+      sAttr.type = PERF_TYPE_HARDWARE;
+      sAttr.config = aulConfigs[eCounter];
+      /* the leader starts the whole group when it is enabled */
+      sAttr.disabled = iLeaderFd < 0;
+      /* user mode only, which is all an unprivileged process gets
+         when perf_event_paranoid is 2 */
+      sAttr.exclude_kernel = 1;
+      sAttr.exclude_hv = 1;
+      sAttr.read_format = PERF_FORMAT_GROUP |
+         PERF_FORMAT_TOTAL_TIME_ENABLED |
+         PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      lFd = syscall(SYS_perf_event_open, &sAttr, 0, -1, iLeaderFd, 0);
+      if(lFd < 0)
+         continue;
+      aiFds[eCounter] = (int) lFd;
+      if(iLeaderFd < 0)
+         iLeaderFd = (int) lFd;
+      aeOrder[ulOpen++] = (enum perfCounter) eCounter;
+   }
+   if(iLeaderFd < 0)
+      return IO_ERROR;
+
+   if(ioctl(iLeaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) < 0 ||
+      ioctl(iLeaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) < 0) {
+      PerfCtr_close();
+      return IO_ERROR;
+   }
+   return SUCCESS;
+}
+
+boolean PerfCtr_isOpen(enum perfCounter eCounter) {
+   assert((int) eCounter >= 0 && eCounter < PERF_COUNTERS);
+
+   return aiFds[eCounter] >= 0;
+}
+
+void PerfCtr_read(struct perfCounts *psCounts) {
+   /* nr, time_enabled, time_running, then one value per counter */
+   uint64_t auBuffer[3 + PERF_COUNTERS];
+   size_t ulExpected = (3 + ulOpen) * sizeof(uint64_t);
+   size_t i;
+
+   assert(psCounts != NULL);
+
+   memset(psCounts, 0, sizeof(*psCounts));
+   if(iLeaderFd < 0)
+      return;
+   if(read(iLeaderFd, auBuffer, ulExpected) != (ssize_t) ulExpected)
+      return;
+
+   psCounts->ulEnabledNs = (unsigned long) auBuffer[1];
+   psCounts->ulRunningNs = (unsigned long) auBuffer[2];
+   for(i = 0; i < ulOpen && i < (size_t) auBuffer[0]; i++)
+      psCounts->aulCounts[aeOrder[i]] =
+         (unsigned long) auBuffer[3 + i];
+}
+
+void PerfCtr_close(void) {
+   int eCounter;
+
+   for(eCounter = 0; eCounter < PERF_COUNTERS; eCounter++) {
+      if(aiFds[eCounter] >= 0 && aiFds[eCounter] != iLeaderFd)
+         (void) close(aiFds[eCounter]);
+      aiFds[eCounter] = -1;
+   }
+   /* the group goes with its leader, which goes last */
+   if(iLeaderFd >= 0)
+      (void) close(iLeaderFd);
+   iLeaderFd = -1;
+   ulOpen = 0;
+}
+
+const char *PerfCtr_getName(enum perfCounter eCounter) {
+   assert((int) eCounter >= 0 && eCounter < PERF_COUNTERS);
+
+   return apcNames[eCounter];
+}
@@ -0,0 +1,57 @@
+/*--------------------------------------------------------------------*/
+/* perfctr.h                                                          */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef PERFCTR_INCLUDED
+#define PERFCTR_INCLUDED
+
+#include "a4def.h"
+
+/*
+  perfctr counts hardware events in the calling thread with Linux's
+  perf_event_open, user mode only. The counters are opened as one
+  group, so that they are always counted over the same instructions;
+  a counter the processor (or a virtual machine) does not provide is
+  left out of the group, and reads as 0.
+*/
+
+/* The events counted */
+enum perfCounter {
+   PERF_CYCLES, PERF_INSTRUCTIONS, PERF_CACHE_MISSES,
+   PERF_BRANCH_MISSES, PERF_COUNTERS
+};
+
+/* The counts of every event, since the counters were opened */
+struct perfCounts {
+   unsigned long aulCounts[PERF_COUNTERS];
+   /* how long the group was enabled, and how long it was actually
+      counting; they differ when the kernel multiplexed the counters
+      with other users, and the counts are then underestimates */
+   unsigned long ulEnabledNs;
+   unsigned long ulRunningNs;
+};
+
+/*
+  Opens and starts every counter available. Returns SUCCESS if at
+  least one was opened, or IO_ERROR if none could be (the reason is
+  left in errno), or ALREADY_IN_TREE if they are already open.
+*/
+int PerfCtr_open(void);
+
+/* Returns whether counter eCounter is open and counting. */
+boolean PerfCtr_isOpen(enum perfCounter eCounter);
+
+/*
+  Copies the current counts into *psCounts: all 0 if no counter is
+  open. Takes one system call.
+*/
+void PerfCtr_read(struct perfCounts *psCounts);
+
+/* Closes every counter. */
+void PerfCtr_close(void);
+
+/* Returns the name of eCounter, as perf(1) spells it. */
+const char *PerfCtr_getName(enum perfCounter eCounter);
+
+#endif
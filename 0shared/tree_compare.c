@@ -0,0 +1,337 @@
+/*--------------------------------------------------------------------*/
+/* tree_compare.c                                                     */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "a4def.h"
+#include "benchutil.h"
+
+/*
+  tree_compare drives one implementation of a tree interface with a
+  generated workload, and prints one line: its throughput per phase,
+  its peak resident set size, and a digest of every result it
+  returned, so that lines from different implementations of the same
+  interface can be set side by side and their digests compared.
+  It is compiled for one interface, selected by defining COMPARE_BDT,
+  COMPARE_DT or COMPARE_FT, and linked with one implementation.
+
+  Usage: tree_compare [-n nodes] [-f fanout] [-s seed] [-H]
+
+  The workload is a balanced tree of -n nodes with -f children per
+  directory; for the FT, its leaves are files. It is run in phases:
+  insert every node in random order; look every node up, and as many
+  missing paths, in random order; render the tree; remove every node
+  in random order; render the tree again. -H prints only the header
+  of the table the lines form.
+*/
+
+#if defined(COMPARE_BDT)
+#include "bdt.h"
+#define Tree_init BDT_init
+#define Tree_destroy BDT_destroy
+#define Tree_insertDir BDT_insert
+#define Tree_containsDir BDT_contains
+#define Tree_rmDir BDT_rm
+#define Tree_toString BDT_toString
+#elif defined(COMPARE_DT)
+#include "dt.h"
+#define Tree_init DT_init
+#define Tree_destroy DT_destroy
+#define Tree_insertDir DT_insert
+#define Tree_containsDir DT_contains
+#define Tree_rmDir DT_rm
+#define Tree_toString DT_toString
+#elif defined(COMPARE_FT)
+#include "ft.h"
+#define Tree_init FT_init
+#define Tree_destroy FT_destroy
+#define Tree_insertDir FT_insertDir
+#define Tree_containsDir FT_containsDir
+#define Tree_rmDir FT_rmDir
+#define Tree_toString FT_toString
+#else
+#error "define COMPARE_BDT, COMPARE_DT or COMPARE_FT"
+#endif
+
+/* The phases timed, and their names in the table */
+enum comparePhase { PHASE_INSERT, PHASE_LOOKUP, PHASE_REMOVE,
+                    PHASE_TO_STRING, PHASE_COUNT };
+
+/* The workload: node paths in breadth-first order, and which are
+   leaves (files, for the FT) */
+struct workload {
+   char **ppcPaths;
+   boolean *pbIsLeaf;
+   size_t ulCount;
+};
+
+/* The state of the pseudo-random generator */
+static unsigned long ulSeed = 1;
+
+/* The running digest of every result */
+static unsigned long ulDigest = 14695981039346656037UL;
+
+#ifdef COMPARE_FT
+/* The contents given to every file */
+static char acContents[] = "tree_compare file contents";
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Prints msg and exits with status 2. */
+static void Compare_die(const char *pcMsg) {
+   fprintf(stderr, "tree_compare: %s\n", pcMsg);
+   exit(2);
+}
+
+/* Adds the ulLength bytes of pvData to the digest (FNV-1a). */
+static void Compare_digest(const void *pvData, size_t ulLength) {
+   const unsigned char *puc = pvData;
+
+   while(ulLength-- > 0) {
+      ulDigest ^= *puc++;
+      ulDigest *= 1099511628211UL;
+   }
+}
+
+/* Adds result iResult to the digest. */
+static void Compare_digestResult(int iResult) {
+   Compare_digest(&iResult, sizeof(iResult));
+}
+
+/*
+  Adds the string the tree renders (or "NULL") to the digest, and
+  frees it.
+*/
+static void Compare_digestString(char *pcString) {
+   if(pcString == NULL) {
+      Compare_digest("NULL", 4);
+      return;
+   }
+   Compare_digest(pcString, strlen(pcString) + 1);
+   free(pcString);
+}
+
+/*
+  Fills psWork with a balanced tree of ulCount nodes with ulFanout
+  children per directory.
+*/
+static void Compare_makeWorkload(struct workload *psWork,
+                                 size_t ulCount, size_t ulFanout) {
+   size_t i;
+
+   psWork->ppcPaths = malloc(ulCount * sizeof(char *));
+   psWork->pbIsLeaf = malloc(ulCount * sizeof(boolean));
+   if(psWork->ppcPaths == NULL || psWork->pbIsLeaf == NULL)
+      Compare_die("out of memory generating the workload");
+   psWork->ulCount = ulCount;
+
+   for(i = 0; i < ulCount; i++) {
+      if(i == 0) {
+         psWork->ppcPaths[i] = malloc(sizeof("root"));
+         if(psWork->ppcPaths[i] == NULL)
+            Compare_die("out of memory generating the workload");
+         strcpy(psWork->ppcPaths[i], "root");
+      }
+      else {
+         const char *pcParent = psWork->ppcPaths[(i - 1) / ulFanout];
+         psWork->ppcPaths[i] = malloc(strlen(pcParent) + 24);
+         if(psWork->ppcPaths[i] == NULL)
+            Compare_die("out of memory generating the workload");
+         sprintf(psWork->ppcPaths[i], "%s/n%lu", pcParent,
+                 (unsigned long) ((i - 1) % ulFanout));
+      }
+      /* node i's first child would be node i * ulFanout + 1 */
+      psWork->pbIsLeaf[i] = i > 0 && i * ulFanout + 1 >= ulCount;
+   }
+}
+
+/* Returns a random permutation of 0..ulCount-1. */
+static size_t *Compare_shuffle(size_t ulCount) {
+   size_t *pulOrder;
+   size_t i;
+
+   pulOrder = malloc(ulCount * sizeof(size_t));
+   if(pulOrder == NULL)
+      Compare_die("out of memory");
+   for(i = 0; i < ulCount; i++)
+      pulOrder[i] = i;
+   for(i = ulCount; i > 1; i--) {
+      size_t j = BenchUtil_random(&ulSeed) % i;
+      size_t ulSwap = pulOrder[i - 1];
+      pulOrder[i - 1] = pulOrder[j];
+      pulOrder[j] = ulSwap;
+   }
+   return pulOrder;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Inserts the node at pcPath, a leaf if bIsLeaf, and digests it. */
+static void Compare_insert(const char *pcPath, boolean bIsLeaf) {
+#ifdef COMPARE_FT
+   if(bIsLeaf) {
+      Compare_digestResult(FT_insertFile(pcPath, acContents,
+                                         sizeof(acContents)));
+      return;
+   }
+#endif
+   (void) bIsLeaf;
+   Compare_digestResult(Tree_insertDir(pcPath));
+}
+
+/* Looks up the node at pcPath, a leaf if bIsLeaf, and digests it. */
+static void Compare_lookup(const char *pcPath, boolean bIsLeaf) {
+#ifdef COMPARE_FT
+   if(bIsLeaf) {
+      Compare_digestResult((int) FT_containsFile(pcPath));
+      return;
+   }
+#endif
+   (void) bIsLeaf;
+   Compare_digestResult((int) Tree_containsDir(pcPath));
+}
+
+/* Removes the node at pcPath, a leaf if bIsLeaf, and digests it. */
+static void Compare_remove(const char *pcPath, boolean bIsLeaf) {
+#ifdef COMPARE_FT
+   if(bIsLeaf) {
+      Compare_digestResult(FT_rmFile(pcPath));
+      return;
+   }
+#endif
+   (void) bIsLeaf;
+   Compare_digestResult(Tree_rmDir(pcPath));
+}
+
+/*
+  Runs every phase of workload psWork, adding the nanoseconds and
+  operations of each phase to padNs and pulOps.
+*/
+static void Compare_run(const struct workload *psWork, double *padNs,
+                        size_t *pulOps) {
+   char acMissing[64];
+   size_t *pulOrder;
+   unsigned long ulStart;
+   size_t i;
+
+   Compare_digestResult(Tree_init());
+
+   pulOrder = Compare_shuffle(psWork->ulCount);
+   ulStart = BenchUtil_now();
+   for(i = 0; i < psWork->ulCount; i++)
+      Compare_insert(psWork->ppcPaths[pulOrder[i]],
+                     psWork->pbIsLeaf[pulOrder[i]]);
+   padNs[PHASE_INSERT] += (double) (BenchUtil_now() - ulStart);
+   pulOps[PHASE_INSERT] += psWork->ulCount;
+   free(pulOrder);
+
+   /* every node, and a missing path beside each */
+   pulOrder = Compare_shuffle(psWork->ulCount);
+   ulStart = BenchUtil_now();
+   for(i = 0; i < psWork->ulCount; i++) {
+      size_t ulNode = pulOrder[i];
+      Compare_lookup(psWork->ppcPaths[ulNode],
+                     psWork->pbIsLeaf[ulNode]);
+      sprintf(acMissing, "root/missing%lu", (unsigned long) ulNode);
+      Compare_lookup(acMissing, FALSE);
+   }
+   padNs[PHASE_LOOKUP] += (double) (BenchUtil_now() - ulStart);
+   pulOps[PHASE_LOOKUP] += 2 * psWork->ulCount;
+   free(pulOrder);
+
+   ulStart = BenchUtil_now();
+   Compare_digestString(Tree_toString());
+   padNs[PHASE_TO_STRING] += (double) (BenchUtil_now() - ulStart);
+   pulOps[PHASE_TO_STRING]++;
+
+   /* removing an ancestor first makes its descendants missing */
+   pulOrder = Compare_shuffle(psWork->ulCount);
+   ulStart = BenchUtil_now();
+   for(i = 0; i < psWork->ulCount; i++)
+      Compare_remove(psWork->ppcPaths[pulOrder[i]],
+                     psWork->pbIsLeaf[pulOrder[i]]);
+   padNs[PHASE_REMOVE] += (double) (BenchUtil_now() - ulStart);
+   pulOps[PHASE_REMOVE] += psWork->ulCount;
+   free(pulOrder);
+
+   ulStart = BenchUtil_now();
+   Compare_digestString(Tree_toString());
+   padNs[PHASE_TO_STRING] += (double) (BenchUtil_now() - ulStart);
+   pulOps[PHASE_TO_STRING]++;
+
+   Compare_digestResult(Tree_destroy());
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Runs the workload selected by the command-line arguments argv and
+  prints its line of the table, labelled with the program's name.
+  Returns 0, or 2 for a usage error.
+*/
+int main(int argc, char *argv[]) {
+   struct workload sWork;
+   struct rusage sUsage;
+   double adNs[PHASE_COUNT];
+   size_t aulOps[PHASE_COUNT];
+   const char *pcName;
+   size_t ulCount = 20000;
+   size_t ulFanout = 8;
+   long lPeakKB = 0;
+   size_t i;
+   int iOpt;
+
+   while((iOpt = getopt(argc, argv, "n:f:s:H")) != -1) {
+      switch(iOpt) {
+         case 'n': ulCount = (size_t) strtoul(optarg, NULL, 10); break;
+         case 'f': ulFanout = (size_t) strtoul(optarg, NULL, 10); break;
+         case 's': ulSeed = strtoul(optarg, NULL, 10); break;
+         case 'H':
+            printf("%-18s %8s %12s %12s %12s %12s %10s %16s\n",
+                   "implementation", "nodes", "insert/s", "lookup/s",
+                   "remove/s", "toString ms", "peak KB", "digest");
+            return 0;
+         default:
+            fprintf(stderr, "usage: %s [-n nodes] [-f fanout] "
+                    "[-s seed] [-H]\n", argv[0]);
+            return 2;
+      }
+   }
+   if(ulSeed == 0)
+      ulSeed = 1;
+   if(ulCount == 0 || ulFanout == 0)
+      Compare_die("-n and -f must be positive");
+
+   pcName = strrchr(argv[0], '/');
+   pcName = pcName == NULL ? argv[0] : pcName + 1;
+
+   memset(adNs, 0, sizeof(adNs));
+   memset(aulOps, 0, sizeof(aulOps));
+   Compare_makeWorkload(&sWork, ulCount, ulFanout);
+   Compare_run(&sWork, adNs, aulOps);
+
+   if(getrusage(RUSAGE_SELF, &sUsage) == 0)
+      lPeakKB = sUsage.ru_maxrss;
+   printf("%-18s %8lu %12.0f %12.0f %12.0f %12.2f %10ld %016lx\n",
+          pcName, (unsigned long) ulCount,
+          (double) aulOps[PHASE_INSERT] * 1e9 / adNs[PHASE_INSERT],
+          (double) aulOps[PHASE_LOOKUP] * 1e9 / adNs[PHASE_LOOKUP],
+          (double) aulOps[PHASE_REMOVE] * 1e9 / adNs[PHASE_REMOVE],
+          adNs[PHASE_TO_STRING] / 1e6 / (double) aulOps[PHASE_TO_STRING],
+          lPeakKB, ulDigest);
+
+   for(i = 0; i < sWork.ulCount; i++)
+      free(sWork.ppcPaths[i]);
+   free(sWork.ppcPaths);
+   free(sWork.pbIsLeaf);
+   return 0;
+}
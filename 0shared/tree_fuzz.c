@@ -0,0 +1,765 @@
+/*--------------------------------------------------------------------*/
+/* tree_fuzz.c                                                        */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "a4def.h"
+#include "benchutil.h"
+#include "costhook.h"
+
+/*
+  tree_fuzz looks for inputs on which an operation of a tree
+  interface does super-linear work. It is compiled for one interface,
+  selected by defining FUZZ_DT or FUZZ_FT, and linked with costhook
+  and an implementation whose objects are instrumented as costhook.h
+  describes, so that the work of every call can be counted.
+
+  An input is decoded into a workload: byte 0 sets the depth of the
+  tree (2 to 6 levels), byte 1 the share of its nodes that are put in
+  one wide directory, byte 2 the share of its leaves that are files
+  (for the FT), and every further byte (up to 16) one step of the
+  program run on it: inserting every node, looking every node up,
+  rendering the tree, removing some or all nodes, removing the root's
+  children, destroying the tree and (for the FT) reading, replacing
+  or statting every node. Every result is checked against a model of
+  the tree.
+
+  The workload is run on n and on 4n nodes, whose levels hold the
+  same shares of their nodes. An operation's work per unit is each
+  counter's total over its calls, divided by the nodes those calls
+  had to touch (1 for a lookup, the nodes created or removed for an
+  insertion or removal, every node for rendering or destroying).
+  Where that, and its mean over the calls (which one removal of a
+  large subtree cannot swamp), both grow by more than the growth
+  limit from the small run to the large one, the operation does
+  super-linear work, and the input is flagged.
+
+  Built with -D FUZZ_LIBFUZZER, this is a libFuzzer target on 256
+  nodes that aborts on a flagged input. Otherwise it is a standalone
+  driver:
+
+  Usage: tree_fuzz [-n nodes] [-g growth] [-r runs] [-s seed]
+                   [-x hex] [inputfile...]
+
+  It runs each input file, or the input given in hex by -x, or else
+  -r (by default 100) random inputs from seed -s, on -n (by default
+  256) and 4n nodes, and reports each flagged input, in hex, with the
+  operations that grew by more than -g (by default 2.0) times. Exits
+  with status 0 if no input was flagged, 1 if one was, or 2 for a
+  usage error.
+*/
+
+#if defined(FUZZ_DT)
+#include "dt.h"
+#define Tree_init DT_init
+#define Tree_destroy DT_destroy
+#define Tree_insertDir DT_insert
+#define Tree_containsDir DT_contains
+#define Tree_rmDir DT_rm
+#define Tree_toString DT_toString
+#define FUZZ_PREFIX "DT_"
+#elif defined(FUZZ_FT)
+#include "ft.h"
+#define Tree_init FT_init
+#define Tree_destroy FT_destroy
+#define Tree_insertDir FT_insertDir
+#define Tree_containsDir FT_containsDir
+#define Tree_rmDir FT_rmDir
+#define Tree_toString FT_toString
+#define FUZZ_PREFIX "FT_"
+#else
+#error "define FUZZ_DT or FUZZ_FT"
+#endif
+
+/* The interface functions whose work is counted */
+enum fuzzFunction {
+   FN_INSERT_DIR, FN_CONTAINS_DIR, FN_RM_DIR, FN_TO_STRING,
+   FN_DESTROY, FN_INSERT_FILE, FN_CONTAINS_FILE, FN_RM_FILE,
+   FN_GET_CONTENTS, FN_REPLACE_CONTENTS, FN_STAT, FN_COUNT
+};
+
+/* The steps of a program */
+enum fuzzStep {
+   STEP_INSERT, STEP_LOOKUP, STEP_TO_STRING, STEP_REMOVE,
+   STEP_REMOVE_TOP, STEP_DESTROY, STEP_CONTENTS, STEP_REPLACE,
+   STEP_STAT, STEP_COUNT
+};
+
+#ifdef FUZZ_FT
+enum { STEPS = STEP_COUNT };
+#else
+/* the DT has no files */
+enum { STEPS = STEP_CONTENTS };
+#endif
+
+/* The most steps a program runs */
+enum { MAX_STEPS = 16 };
+
+/* The most levels a tree has */
+enum { MAX_DEPTH = 6 };
+
+/* No node, in the model's links */
+#define NONE ((size_t) -1)
+
+/*
+  A workload: the nodes' paths, types and links, in an order in which
+  every parent comes before its children, and which of them are in
+  the tree, as the tree should have them
+*/
+struct workload {
+   char **ppcPaths;
+   boolean *pbIsFile;
+   size_t *pulParent;
+   size_t *pulFirstChild;
+   size_t *pulNextSibling;
+   boolean *pbIn;
+   size_t *pulOrder;
+   size_t ulCount;
+   size_t ulIn;
+};
+
+/* The work one run did, per interface function */
+struct tally {
+   /* the total of each counter, and its sum over calls of the work
+      per unit */
+   unsigned long aaulCost[FN_COUNT][COST_COUNTERS];
+   double aadCost[FN_COUNT][COST_COUNTERS];
+   size_t aulUnits[FN_COUNT];
+   size_t aulCalls[FN_COUNT];
+   /* the calls that returned something the model did not expect */
+   size_t ulWrong;
+};
+
+/* The state of the pseudo-random generator */
+static unsigned long ulSeed = 1;
+
+/* The counts when the call being measured began */
+static struct costCounts sBefore;
+
+#ifdef FUZZ_FT
+/* The contents given to every file */
+static char acContents[] = "tree_fuzz file contents";
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Prints msg and exits with status 2. */
+static void Fuzz_die(const char *pcMsg) {
+   fprintf(stderr, "tree_fuzz: %s\n", pcMsg);
+   exit(2);
+}
+
+/* Returns the name of interface function eFn. */
+static const char *Fuzz_getName(enum fuzzFunction eFn) {
+   static const char *apcNames[FN_COUNT] = {
+#ifdef FUZZ_DT
+      "DT_insert", "DT_contains", "DT_rm",
+#else
+      "FT_insertDir", "FT_containsDir", "FT_rmDir",
+#endif
+      FUZZ_PREFIX "toString", FUZZ_PREFIX "destroy",
+      "FT_insertFile", "FT_containsFile", "FT_rmFile",
+      "FT_getFileContents", "FT_replaceFileContents", "FT_stat"
+   };
+   return apcNames[eFn];
+}
+
+/* Starts measuring a call. */
+static void Fuzz_begin(void) {
+   Cost_get(&sBefore);
+}
+
+/*
+  Adds the work done since Fuzz_begin to the work of eFn in
+  *psTally, as one call that had ulUnits nodes to touch.
+*/
+static void Fuzz_end(struct tally *psTally, enum fuzzFunction eFn,
+                     size_t ulUnits) {
+   struct costCounts sAfter;
+   size_t c;
+
+   Cost_get(&sAfter);
+   for(c = 0; c < COST_COUNTERS; c++) {
+      unsigned long ulCost = sAfter.aulCounts[c] - sBefore.aulCounts[c];
+      psTally->aaulCost[eFn][c] += ulCost;
+      psTally->aadCost[eFn][c] += (double) ulCost / (double) ulUnits;
+   }
+   psTally->aulUnits[eFn] += ulUnits;
+   psTally->aulCalls[eFn]++;
+}
+
+/* Counts a result the model did not expect, if bExpected is FALSE. */
+static void Fuzz_expect(struct tally *psTally, boolean bExpected) {
+   if(!bExpected)
+      psTally->ulWrong++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Generates the workload of ulCount nodes that input pucInput (of
+  ulLength bytes) describes into *psWork, with every node out of the
+  tree.
+*/
+static void Fuzz_generate(const unsigned char *pucInput,
+                          size_t ulLength, size_t ulCount,
+                          struct workload *psWork) {
+   /* the nodes that may still have children, by level */
+   size_t *pulEligible;
+   size_t aulEligible[MAX_DEPTH + 1] = {0};
+   size_t ulLevels = 0;
+   size_t ulDepth;
+   size_t ulWide;
+   size_t ulFiles;
+   size_t *pulDepth;
+   size_t i;
+
+   ulDepth = 2 + (ulLength > 0 ? pucInput[0] : 0) % (MAX_DEPTH - 1);
+   ulWide = ulLength > 1 ? pucInput[1] : 0;
+   ulFiles = ulLength > 2 ? pucInput[2] : 128;
+
+   psWork->ulCount = ulCount;
+   psWork->ulIn = 0;
+   psWork->ppcPaths = calloc(ulCount, sizeof(char *));
+   psWork->pbIsFile = calloc(ulCount, sizeof(boolean));
+   psWork->pulParent = calloc(ulCount, sizeof(size_t));
+   psWork->pulFirstChild = calloc(ulCount, sizeof(size_t));
+   psWork->pulNextSibling = calloc(ulCount, sizeof(size_t));
+   psWork->pbIn = calloc(ulCount, sizeof(boolean));
+   psWork->pulOrder = calloc(ulCount, sizeof(size_t));
+   pulEligible = calloc(ulCount * ulDepth, sizeof(size_t));
+   pulDepth = calloc(ulCount, sizeof(size_t));
+   if(psWork->ppcPaths == NULL || psWork->pbIsFile == NULL ||
+      psWork->pulParent == NULL || psWork->pulFirstChild == NULL ||
+      psWork->pulNextSibling == NULL || psWork->pbIn == NULL ||
+      psWork->pulOrder == NULL || pulEligible == NULL ||
+      pulDepth == NULL)
+      Fuzz_die("out of memory generating a workload");
+
+   /* node 0 is the root, and node 1 the wide directory */
+   for(i = 0; i < ulCount; i++) {
+      size_t ulParent = NONE;
+      char acName[32];
+
+      if(i == 1)
+         ulParent = 0;
+      else if(i > 1 && BenchUtil_random(&ulSeed) % 256 < ulWide)
+         ulParent = 1;
+      else if(i > 1) {
+         /* a level, then a node on it, so that the share of nodes on
+            each level does not depend on ulCount */
+         size_t ulLevel = 1 + BenchUtil_random(&ulSeed) % ulLevels;
+         ulParent = pulEligible[ulLevel * ulCount - ulCount +
+                                BenchUtil_random(&ulSeed) %
+                                aulEligible[ulLevel]];
+      }
+
+      psWork->pulParent[i] = ulParent;
+      psWork->pulFirstChild[i] = NONE;
+      psWork->pulNextSibling[i] = NONE;
+      psWork->pulOrder[i] = i;
+      if(ulParent == NONE) {
+         pulDepth[i] = 1;
+         psWork->ppcPaths[i] = malloc(2);
+         if(psWork->ppcPaths[i] == NULL)
+            Fuzz_die("out of memory generating a workload");
+         strcpy(psWork->ppcPaths[i], "r");
+      }
+      else {
+         pulDepth[i] = pulDepth[ulParent] + 1;
+         psWork->pulNextSibling[i] = psWork->pulFirstChild[ulParent];
+         psWork->pulFirstChild[ulParent] = i;
+         sprintf(acName, "/n%lu", (unsigned long) i);
+         psWork->ppcPaths[i] = malloc(strlen(psWork->ppcPaths[ulParent])
+                                      + strlen(acName) + 1);
+         if(psWork->ppcPaths[i] == NULL)
+            Fuzz_die("out of memory generating a workload");
+         strcpy(psWork->ppcPaths[i], psWork->ppcPaths[ulParent]);
+         strcat(psWork->ppcPaths[i], acName);
+      }
+      if(pulDepth[i] < ulDepth) {
+         pulEligible[pulDepth[i] * ulCount - ulCount +
+                     aulEligible[pulDepth[i]]++] = i;
+         if(pulDepth[i] > ulLevels)
+            ulLevels = pulDepth[i];
+      }
+   }
+
+#ifdef FUZZ_FT
+   /* files are leaves, so only a node without children may be one */
+   for(i = 2; i < ulCount; i++)
+      psWork->pbIsFile[i] = psWork->pulFirstChild[i] == NONE &&
+         BenchUtil_random(&ulSeed) % 256 < ulFiles;
+#else
+   (void) ulFiles;
+#endif
+
+   free(pulEligible);
+   free(pulDepth);
+}
+
+/* Frees all memory allocated for workload *psWork. */
+static void Fuzz_freeWorkload(struct workload *psWork) {
+   size_t i;
+
+   for(i = 0; i < psWork->ulCount; i++)
+      free(psWork->ppcPaths[i]);
+   free(psWork->ppcPaths);
+   free(psWork->pbIsFile);
+   free(psWork->pulParent);
+   free(psWork->pulFirstChild);
+   free(psWork->pulNextSibling);
+   free(psWork->pbIn);
+   free(psWork->pulOrder);
+}
+
+/* Shuffles the order in which *psWork's nodes are visited. */
+static void Fuzz_shuffle(struct workload *psWork) {
+   size_t i;
+
+   for(i = psWork->ulCount; i > 1; i--) {
+      size_t j = BenchUtil_random(&ulSeed) % i;
+      size_t ulSwap = psWork->pulOrder[i - 1];
+      psWork->pulOrder[i - 1] = psWork->pulOrder[j];
+      psWork->pulOrder[j] = ulSwap;
+   }
+}
+
+/*
+  Marks node ulNode of *psWork, and its ancestors not yet in the
+  tree, as in it. Returns how many nodes were marked.
+*/
+static size_t Fuzz_markIn(struct workload *psWork, size_t ulNode) {
+   size_t ulMarked = 0;
+
+   for(; ulNode != NONE && !psWork->pbIn[ulNode];
+       ulNode = psWork->pulParent[ulNode]) {
+      psWork->pbIn[ulNode] = TRUE;
+      ulMarked++;
+   }
+   psWork->ulIn += ulMarked;
+   return ulMarked;
+}
+
+/*
+  Marks the subtree of *psWork rooted at ulNode as out of the tree.
+  Returns how many of its nodes were in it.
+*/
+static size_t Fuzz_markOut(struct workload *psWork, size_t ulNode) {
+   size_t ulMarked = 0;
+   size_t ulChild;
+
+   if(!psWork->pbIn[ulNode])
+      return 0;
+   for(ulChild = psWork->pulFirstChild[ulNode]; ulChild != NONE;
+       ulChild = psWork->pulNextSibling[ulChild])
+      ulMarked += Fuzz_markOut(psWork, ulChild);
+   psWork->pbIn[ulNode] = FALSE;
+   psWork->ulIn--;
+   return ulMarked + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Inserts node ulNode of *psWork, adding its work to *psTally. */
+static void Fuzz_insert(struct workload *psWork, size_t ulNode,
+                        struct tally *psTally) {
+   boolean bWasIn = psWork->pbIn[ulNode];
+   size_t ulUnits;
+   int iStatus;
+
+#ifdef FUZZ_FT
+   if(psWork->pbIsFile[ulNode]) {
+      Fuzz_begin();
+      iStatus = FT_insertFile(psWork->ppcPaths[ulNode], acContents,
+                              sizeof(acContents));
+      ulUnits = bWasIn ? 1 : Fuzz_markIn(psWork, ulNode);
+      Fuzz_end(psTally, FN_INSERT_FILE, ulUnits);
+      Fuzz_expect(psTally, iStatus == (bWasIn ? ALREADY_IN_TREE :
+                                       SUCCESS));
+      return;
+   }
+#endif
+   Fuzz_begin();
+   iStatus = Tree_insertDir(psWork->ppcPaths[ulNode]);
+   ulUnits = bWasIn ? 1 : Fuzz_markIn(psWork, ulNode);
+   Fuzz_end(psTally, FN_INSERT_DIR, ulUnits);
+   Fuzz_expect(psTally, iStatus == (bWasIn ? ALREADY_IN_TREE :
+                                    SUCCESS));
+}
+
+/* Looks node ulNode of *psWork up, adding its work to *psTally. */
+static void Fuzz_lookup(struct workload *psWork, size_t ulNode,
+                        struct tally *psTally) {
+   boolean bFound;
+
+#ifdef FUZZ_FT
+   if(psWork->pbIsFile[ulNode]) {
+      Fuzz_begin();
+      bFound = FT_containsFile(psWork->ppcPaths[ulNode]);
+      Fuzz_end(psTally, FN_CONTAINS_FILE, 1);
+      Fuzz_expect(psTally, bFound == psWork->pbIn[ulNode]);
+      return;
+   }
+#endif
+   Fuzz_begin();
+   bFound = Tree_containsDir(psWork->ppcPaths[ulNode]);
+   Fuzz_end(psTally, FN_CONTAINS_DIR, 1);
+   Fuzz_expect(psTally, bFound == psWork->pbIn[ulNode]);
+}
+
+/*
+  Removes node ulNode of *psWork, and so its subtree, adding its work
+  to *psTally.
+*/
+static void Fuzz_remove(struct workload *psWork, size_t ulNode,
+                        struct tally *psTally) {
+   boolean bWasIn = psWork->pbIn[ulNode];
+   size_t ulUnits;
+   int iStatus;
+
+#ifdef FUZZ_FT
+   if(psWork->pbIsFile[ulNode]) {
+      Fuzz_begin();
+      iStatus = FT_rmFile(psWork->ppcPaths[ulNode]);
+      ulUnits = bWasIn ? Fuzz_markOut(psWork, ulNode) : 1;
+      Fuzz_end(psTally, FN_RM_FILE, ulUnits);
+      Fuzz_expect(psTally, iStatus == (bWasIn ? SUCCESS :
+                                       NO_SUCH_PATH));
+      return;
+   }
+#endif
+   Fuzz_begin();
+   iStatus = Tree_rmDir(psWork->ppcPaths[ulNode]);
+   ulUnits = bWasIn ? Fuzz_markOut(psWork, ulNode) : 1;
+   Fuzz_end(psTally, FN_RM_DIR, ulUnits);
+   Fuzz_expect(psTally, iStatus == (bWasIn ? SUCCESS : NO_SUCH_PATH));
+}
+
+#ifdef FUZZ_FT
+/*
+  Reads, replaces (if bReplace) or stats (if bStat) node ulNode of
+  *psWork, adding the work to *psTally.
+*/
+static void Fuzz_access(struct workload *psWork, size_t ulNode,
+                        boolean bReplace, boolean bStat,
+                        struct tally *psTally) {
+   boolean bIsFileIn = psWork->pbIn[ulNode] && psWork->pbIsFile[ulNode];
+   boolean bIsFile = FALSE;
+   size_t ulSize = 0;
+   void *pvResult;
+   int iStatus;
+
+   if(bStat) {
+      Fuzz_begin();
+      iStatus = FT_stat(psWork->ppcPaths[ulNode], &bIsFile, &ulSize);
+      Fuzz_end(psTally, FN_STAT, 1);
+      Fuzz_expect(psTally, psWork->pbIn[ulNode] ?
+                  iStatus == SUCCESS &&
+                  bIsFile == psWork->pbIsFile[ulNode] :
+                  iStatus == NO_SUCH_PATH);
+      return;
+   }
+   Fuzz_begin();
+   if(bReplace)
+      pvResult = FT_replaceFileContents(psWork->ppcPaths[ulNode],
+                                        acContents, sizeof(acContents));
+   else
+      pvResult = FT_getFileContents(psWork->ppcPaths[ulNode]);
+   Fuzz_end(psTally, bReplace ? FN_REPLACE_CONTENTS : FN_GET_CONTENTS,
+            1);
+   Fuzz_expect(psTally, pvResult == (bIsFileIn ? acContents : NULL));
+}
+#endif
+
+/*
+  Runs step eStep, with parameter ulParam, on *psWork, adding the work
+  done to *psTally.
+*/
+static void Fuzz_step(enum fuzzStep eStep, size_t ulParam,
+                      struct workload *psWork, struct tally *psTally) {
+   size_t ulVisits;
+   size_t ulNode;
+   size_t i;
+   char *pcString;
+
+   Fuzz_shuffle(psWork);
+   switch(eStep) {
+      case STEP_INSERT:
+         for(i = 0; i < psWork->ulCount; i++)
+            Fuzz_insert(psWork, psWork->pulOrder[i], psTally);
+         break;
+      case STEP_LOOKUP:
+         for(i = 0; i < psWork->ulCount; i++)
+            Fuzz_lookup(psWork, psWork->pulOrder[i], psTally);
+         break;
+      case STEP_TO_STRING:
+         Fuzz_begin();
+         pcString = Tree_toString();
+         Fuzz_end(psTally, FN_TO_STRING, psWork->ulIn + 1);
+         Fuzz_expect(psTally, pcString != NULL);
+         free(pcString);
+         break;
+      case STEP_REMOVE:
+         /* a quarter, half, three quarters or all of the nodes but the
+            root and the wide directory, whose removal would leave the
+            two runs' trees with little in common */
+         ulVisits = psWork->ulCount * (ulParam % 4 + 1) / 4;
+         for(i = 0; i < ulVisits; i++)
+            if(psWork->pulOrder[i] > 1)
+               Fuzz_remove(psWork, psWork->pulOrder[i], psTally);
+         break;
+      case STEP_REMOVE_TOP:
+         for(ulNode = psWork->pulFirstChild[0]; ulNode != NONE;
+             ulNode = psWork->pulNextSibling[ulNode])
+            Fuzz_remove(psWork, ulNode, psTally);
+         break;
+      case STEP_DESTROY:
+         Fuzz_begin();
+         Fuzz_expect(psTally, Tree_destroy() == SUCCESS);
+         Fuzz_end(psTally, FN_DESTROY, psWork->ulIn + 1);
+         (void) Fuzz_markOut(psWork, 0);
+         Fuzz_expect(psTally, Tree_init() == SUCCESS);
+         break;
+#ifdef FUZZ_FT
+      case STEP_CONTENTS:
+      case STEP_REPLACE:
+      case STEP_STAT:
+         for(i = 0; i < psWork->ulCount; i++)
+            Fuzz_access(psWork, psWork->pulOrder[i],
+                        eStep == STEP_REPLACE, eStep == STEP_STAT,
+                        psTally);
+         break;
+#endif
+      default:
+         assert(FALSE);
+   }
+}
+
+/*
+  Runs the program of input pucInput (of ulLength bytes) on a
+  workload of ulCount nodes, and sets *psTally to the work it did.
+*/
+static void Fuzz_run(const unsigned char *pucInput, size_t ulLength,
+                     size_t ulCount, struct tally *psTally) {
+   /* insert, look up, render, remove the root's children, insert,
+      remove everything, insert, destroy */
+   static const unsigned char aucDefault[] = {
+      STEP_INSERT, STEP_LOOKUP, STEP_TO_STRING, STEP_REMOVE_TOP,
+      STEP_INSERT, STEP_REMOVE + 3 * STEPS, STEP_INSERT, STEP_DESTROY
+   };
+   const unsigned char *pucSteps = aucDefault;
+   size_t ulSteps = sizeof(aucDefault);
+   struct workload sWork;
+   unsigned long ulHash = 14695981039346656037UL;
+   size_t i;
+
+   /* the same input always makes the same tree of a given size */
+   for(i = 0; i < ulLength; i++) {
+      ulHash ^= pucInput[i];
+      ulHash *= 1099511628211UL;
+   }
+   ulSeed = ulHash | 1;
+
+   memset(psTally, 0, sizeof(struct tally));
+   Fuzz_generate(pucInput, ulLength, ulCount, &sWork);
+   if(ulLength > 3) {
+      pucSteps = pucInput + 3;
+      ulSteps = ulLength - 3 < MAX_STEPS ? ulLength - 3 : MAX_STEPS;
+   }
+
+   Fuzz_expect(psTally, Tree_init() == SUCCESS);
+   for(i = 0; i < ulSteps; i++)
+      Fuzz_step((enum fuzzStep) (pucSteps[i] % STEPS),
+                pucSteps[i] / STEPS, &sWork, psTally);
+   Fuzz_expect(psTally, Tree_destroy() == SUCCESS);
+   Fuzz_freeWorkload(&sWork);
+}
+
+/*
+  Writes input pucInput (of ulLength bytes) to stderr in hex, as -x
+  takes it, to head the reasons it is flagged.
+*/
+static void Fuzz_printInput(const unsigned char *pucInput,
+                            size_t ulLength) {
+   size_t i;
+
+   fprintf(stderr, "input");
+   for(i = 0; i < ulLength; i++)
+      fprintf(stderr, "%s%02x", i == 0 ? " " : "", pucInput[i]);
+   fprintf(stderr, ":\n");
+}
+
+/*
+  Runs input pucInput (of ulLength bytes) on ulNodes and 4 * ulNodes
+  nodes, and returns whether it is flagged: whether some operation's
+  work per unit grew by more than dGrowth times, or some result was
+  wrong. Describes why on stderr if so.
+*/
+static boolean Fuzz_input(const unsigned char *pucInput,
+                          size_t ulLength, size_t ulNodes,
+                          double dGrowth) {
+   static struct tally sSmall;
+   static struct tally sLarge;
+   boolean bFlagged = FALSE;
+   size_t f;
+   size_t c;
+
+   Fuzz_run(pucInput, ulLength, ulNodes, &sSmall);
+   Fuzz_run(pucInput, ulLength, 4 * ulNodes, &sLarge);
+
+   for(f = 0; f < FN_COUNT; f++) {
+      /* too few units for a per-unit figure to mean much */
+      if(sSmall.aulUnits[f] < ulNodes / 4 || sLarge.aulUnits[f] == 0)
+         continue;
+      for(c = 0; c < COST_COUNTERS; c++) {
+         double dSmall = (double) sSmall.aaulCost[f][c] /
+            (double) sSmall.aulUnits[f];
+         double dLarge = (double) sLarge.aaulCost[f][c] /
+            (double) sLarge.aulUnits[f];
+         double dSmallMean = sSmall.aadCost[f][c] /
+            (double) sSmall.aulCalls[f];
+         double dLargeMean = sLarge.aadCost[f][c] /
+            (double) sLarge.aulCalls[f];
+
+         /* a per-unit cost under 1 is noise, not work */
+         if(dLarge < 1.0 || dLarge <= dGrowth * (dSmall + 1.0) ||
+            dLargeMean < 1.0 ||
+            dLargeMean <= dGrowth * (dSmallMean + 1.0))
+            continue;
+         if(!bFlagged)
+            Fuzz_printInput(pucInput, ulLength);
+         bFlagged = TRUE;
+         fprintf(stderr, "  %-24s %-12s %12.1f -> %12.1f per unit "
+                 "(%.1fx)\n", Fuzz_getName((enum fuzzFunction) f),
+                 Cost_getName((enum costCounter) c), dSmall, dLarge,
+                 dLarge / (dSmall + 1.0));
+      }
+   }
+   if(sSmall.ulWrong + sLarge.ulWrong != 0) {
+      if(!bFlagged)
+         Fuzz_printInput(pucInput, ulLength);
+      bFlagged = TRUE;
+      fprintf(stderr, "  %lu results differ from the model\n",
+              (unsigned long) (sSmall.ulWrong + sLarge.ulWrong));
+   }
+   return bFlagged;
+}
+
+/*--------------------------------------------------------------------*/
+
+#ifdef FUZZ_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *pucData, size_t ulSize);
+
+/* Runs one input libFuzzer made, and aborts if it is flagged. */
+int LLVMFuzzerTestOneInput(const uint8_t *pucData, size_t ulSize) {
+   if(Fuzz_input(pucData, ulSize, 256, 2.0))
+      abort();
+   return 0;
+}
+
+#else
+
+/*
+  Reads file pcFile into *ppucInput, allocated for the caller, and
+  returns its length. Exits with status 2 if it cannot be read.
+*/
+static size_t Fuzz_readFile(const char *pcFile,
+                            unsigned char **ppucInput) {
+   FILE *psFile = fopen(pcFile, "rb");
+   size_t ulLength = 0;
+   size_t ulSize = 256;
+   size_t ulRead;
+
+   if(psFile == NULL)
+      Fuzz_die("cannot open an input file");
+   *ppucInput = malloc(ulSize);
+   while(*ppucInput != NULL &&
+         (ulRead = fread(*ppucInput + ulLength, 1, ulSize - ulLength,
+                         psFile)) > 0) {
+      ulLength += ulRead;
+      if(ulLength == ulSize)
+         *ppucInput = realloc(*ppucInput, ulSize *= 2);
+   }
+   if(*ppucInput == NULL)
+      Fuzz_die("out of memory reading an input file");
+   (void) fclose(psFile);
+   return ulLength;
+}
+
+/*
+  Runs the inputs the command-line arguments argv name and reports
+  the flagged ones on stderr. Returns 0 if none was flagged, 1 if one
+  was, or 2 for a usage error.
+*/
+int main(int argc, char *argv[]) {
+   unsigned char aucInput[64];
+   unsigned char *pucInput;
+   size_t ulNodes = 256;
+   size_t ulRuns = 100;
+   unsigned long ulRunSeed = 1;
+   const char *pcHex = NULL;
+   double dGrowth = 2.0;
+   size_t ulFlagged = 0;
+   size_t ulLength;
+   size_t r;
+   size_t i;
+   int iOpt;
+
+   while((iOpt = getopt(argc, argv, "n:g:r:s:x:")) != -1) {
+      switch(iOpt) {
+         case 'n': ulNodes = (size_t) strtoul(optarg, NULL, 10); break;
+         case 'g': dGrowth = strtod(optarg, NULL); break;
+         case 'r': ulRuns = (size_t) strtoul(optarg, NULL, 10); break;
+         case 's': ulRunSeed = strtoul(optarg, NULL, 10); break;
+         case 'x': pcHex = optarg; break;
+         default:
+            fprintf(stderr, "usage: %s [-n nodes] [-g growth] "
+                    "[-r runs] [-s seed] [-x hex] [inputfile...]\n",
+                    argv[0]);
+            return 2;
+      }
+   }
+   if(ulNodes < 4 || dGrowth <= 1.0)
+      Fuzz_die("need at least 4 nodes and a growth above 1");
+
+   if(pcHex != NULL) {
+      unsigned int uByte;
+      for(ulLength = 0; ulLength < sizeof(aucInput) &&
+             sscanf(pcHex + 2 * ulLength, "%2x", &uByte) == 1;
+          ulLength++)
+         aucInput[ulLength] = (unsigned char) uByte;
+      ulFlagged += Fuzz_input(aucInput, ulLength, ulNodes, dGrowth);
+   }
+   else if(optind < argc) {
+      for(i = (size_t) optind; i < (size_t) argc; i++) {
+         ulLength = Fuzz_readFile(argv[i], &pucInput);
+         ulFlagged += Fuzz_input(pucInput, ulLength, ulNodes, dGrowth);
+         free(pucInput);
+      }
+   }
+   else {
+      for(r = 0; r < ulRuns; r++) {
+         /* the generator makes the inputs too */
+         ulSeed = (ulRunSeed + r) * 2654435761UL | 1;
+         ulLength = 3 + BenchUtil_random(&ulSeed) % (MAX_STEPS + 1);
+         for(i = 0; i < ulLength; i++)
+            aucInput[i] = (unsigned char) BenchUtil_random(&ulSeed);
+         ulFlagged += Fuzz_input(aucInput, ulLength, ulNodes, dGrowth);
+      }
+   }
+
+   printf("%lu inputs flagged\n", (unsigned long) ulFlagged);
+   return ulFlagged == 0 ? 0 : 1;
+}
+
+#endif
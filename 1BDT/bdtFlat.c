@@ -0,0 +1,588 @@
+/*--------------------------------------------------------------------*/
+/* bdtFlat.c                                                          */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bdt.h"
+
+
+/*
+  A Binary Directory Tree kept in one contiguous pool of nodes. A
+  directory has at most two children, so each node holds its
+  children's indices inline, rather than in a DynArray_T, and links
+  to other nodes by index, so that the pool can grow by realloc.
+  Unused nodes form a free list through their first child slot. A
+  node's first child is always filled before its second, and the
+  second moves up when the first is removed.
+*/
+
+/* No node, as an index */
+#define NONE ((size_t) -1)
+
+/* The fewest nodes the pool grows to */
+enum { MIN_POOL = 64 };
+
+/* A node in the pool */
+struct node {
+   /* the directory's absolute path, or NULL if the node is unused */
+   char *pcPath;
+   /* the length of pcPath */
+   size_t ulLength;
+   /* the offset in pcPath of the directory's own name */
+   size_t ulName;
+   /* the index of this node's parent, or NONE for the root */
+   size_t ulParent;
+   /* the indices of this node's first and second children, or NONE;
+      for an unused node, the first is the next unused one */
+   size_t aulChildren[2];
+};
+
+
+/*
+  The BDT is represented as an AO with 7 state variables:
+*/
+
+/* 1. a flag for being in an initialized state (TRUE) or not (FALSE) */
+static boolean bIsInitialized;
+/* 2. the index of the root node in the hierarchy, or NONE */
+static size_t ulRoot = NONE;
+/* 3. a counter of the number of nodes in the hierarchy */
+static size_t ulCount;
+/* 4. the length of the string representation, without its '\0' */
+static size_t ulStrlen;
+/* 5. the pool of nodes, and how many it has room for */
+static struct node *psPool;
+static size_t ulPoolSize;
+/* 6. the first unused node, or NONE */
+static size_t ulFree = NONE;
+/* 7. how many nodes are unused */
+static size_t ulFreeCount;
+
+
+
+/* --------------------------------------------------------------------
+
+  The pool functions hand out and take back nodes.
+*/
+
+/*
+  Makes sure the pool has at least ulNeeded unused nodes, growing it
+  if not. Returns SUCCESS, or MEMORY_ERROR with the pool unchanged.
+*/
+static int BDT_reserve(size_t ulNeeded) {
+   struct node *psNew;
+   size_t ulNewSize;
+   size_t i;
+
+   if(ulFreeCount >= ulNeeded)
+      return SUCCESS;
+
+   ulNewSize = ulPoolSize < MIN_POOL ? MIN_POOL : 2 * ulPoolSize;
+   if(ulNewSize - ulPoolSize < ulNeeded - ulFreeCount)
+      ulNewSize = ulPoolSize + ulNeeded - ulFreeCount;
+   psNew = realloc(psPool, ulNewSize * sizeof(struct node));
+   if(psNew == NULL)
+      return MEMORY_ERROR;
+   psPool = psNew;
+
+   /* the new nodes go on the free list in index order */
+   for(i = ulNewSize; i > ulPoolSize; i--) {
+      psPool[i - 1].pcPath = NULL;
+      psPool[i - 1].aulChildren[0] = ulFree;
+      ulFree = i - 1;
+   }
+   ulFreeCount += ulNewSize - ulPoolSize;
+   ulPoolSize = ulNewSize;
+   return SUCCESS;
+}
+
+/*
+  Takes an unused node, which BDT_reserve must have made sure of, and
+  gives it the path made of the first ulLength characters of pcPath,
+  whose last name begins at offset ulName. Returns the node's index,
+  or NONE, with the node still unused, if its path cannot be
+  allocated.
+*/
+static size_t BDT_newNode(const char *pcPath, size_t ulLength,
+                          size_t ulName) {
+   size_t ulNode = ulFree;
+   struct node *psNode;
+
+   assert(pcPath != NULL);
+   assert(ulFree != NONE);
+
+   psNode = &psPool[ulNode];
+   psNode->pcPath = malloc(ulLength + 1);
+   if(psNode->pcPath == NULL)
+      return NONE;
+   memcpy(psNode->pcPath, pcPath, ulLength);
+   psNode->pcPath[ulLength] = '\0';
+
+   ulFree = psNode->aulChildren[0];
+   ulFreeCount--;
+   psNode->ulLength = ulLength;
+   psNode->ulName = ulName;
+   psNode->ulParent = NONE;
+   psNode->aulChildren[0] = NONE;
+   psNode->aulChildren[1] = NONE;
+   return ulNode;
+}
+
+/*
+  Unlinks node ulNode from its parent, moving a second child up to
+  be the first if ulNode was the first.
+*/
+static void BDT_unlink(size_t ulNode) {
+   size_t ulParent = psPool[ulNode].ulParent;
+   size_t *pulChildren;
+
+   if(ulParent == NONE)
+      return;
+   pulChildren = psPool[ulParent].aulChildren;
+   if(pulChildren[0] == ulNode)
+      pulChildren[0] = pulChildren[1];
+   pulChildren[1] = NONE;
+   psPool[ulNode].ulParent = NONE;
+}
+
+/*
+  Frees the subtree rooted at node ulNode, which must already be
+  unlinked from its parent, returning its nodes to the pool and
+  taking them out of ulCount and ulStrlen. Needs no stack: it walks
+  down first children and back up parents.
+*/
+static void BDT_freeSubtree(size_t ulNode) {
+   size_t ulCurr = ulNode;
+
+   for(;;) {
+      struct node *psCurr = &psPool[ulCurr];
+      size_t ulParent;
+
+      if(psCurr->aulChildren[0] != NONE) {
+         ulCurr = psCurr->aulChildren[0];
+         continue;
+      }
+
+      /* a leaf: free it and go back up, unless it is ulNode */
+      ulParent = ulCurr == ulNode ? NONE : psCurr->ulParent;
+      if(ulParent != NONE)
+         BDT_unlink(ulCurr);
+      ulCount--;
+      ulStrlen -= psCurr->ulLength + 1;
+      free(psCurr->pcPath);
+      psCurr->pcPath = NULL;
+      psCurr->aulChildren[0] = ulFree;
+      ulFree = ulCurr;
+      ulFreeCount++;
+      if(ulParent == NONE)
+         return;
+      ulCurr = ulParent;
+   }
+}
+
+
+/* --------------------------------------------------------------------
+
+  BDT_isValid checks the invariants of the representation, on every
+  operation while assertions are on.
+*/
+
+#ifndef NDEBUG
+/*
+  Returns TRUE if the BDT is in a valid state, or FALSE otherwise, in
+  which case it prints an explanation to stderr. Takes time linear in
+  the size of the pool.
+*/
+static boolean BDT_isValid(void) {
+   size_t ulUsed = 0;
+   size_t ulLength = 0;
+   size_t ulUnused = 0;
+   size_t i;
+
+   if(!bIsInitialized || ulRoot == NONE) {
+      if(ulRoot != NONE || ulCount != 0 || ulStrlen != 0) {
+         fprintf(stderr, "No root, but a nonzero count\n");
+         return FALSE;
+      }
+   }
+   else if(psPool[ulRoot].ulParent != NONE) {
+      fprintf(stderr, "The root has a parent\n");
+      return FALSE;
+   }
+
+   for(i = 0; i < ulPoolSize; i++) {
+      struct node *psNode = &psPool[i];
+      size_t c;
+
+      if(psNode->pcPath == NULL)
+         continue;
+      ulUsed++;
+      ulLength += psNode->ulLength + 1;
+      if(strlen(psNode->pcPath) != psNode->ulLength) {
+         fprintf(stderr, "A path's length is wrong\n");
+         return FALSE;
+      }
+      if(psNode->aulChildren[0] == NONE &&
+         psNode->aulChildren[1] != NONE) {
+         fprintf(stderr, "A second child has no first child\n");
+         return FALSE;
+      }
+      if(psNode->aulChildren[1] != NONE &&
+         !strcmp(psPool[psNode->aulChildren[0]].pcPath,
+                 psPool[psNode->aulChildren[1]].pcPath)) {
+         fprintf(stderr, "Two children have the same path\n");
+         return FALSE;
+      }
+      for(c = 0; c < 2; c++) {
+         struct node *psChild;
+
+         if(psNode->aulChildren[c] == NONE)
+            continue;
+         psChild = &psPool[psNode->aulChildren[c]];
+         if(psChild->pcPath == NULL || psChild->ulParent != i) {
+            fprintf(stderr, "A child does not link back to its "
+                    "parent\n");
+            return FALSE;
+         }
+         if(psChild->ulName != psNode->ulLength + 1 ||
+            strncmp(psChild->pcPath, psNode->pcPath,
+                    psNode->ulLength) != 0 ||
+            psChild->pcPath[psNode->ulLength] != '/' ||
+            strchr(psChild->pcPath + psChild->ulName, '/') != NULL) {
+            fprintf(stderr, "A child's path does not extend its "
+                    "parent's by one name\n");
+            return FALSE;
+         }
+      }
+   }
+
+   for(i = ulFree; i != NONE; i = psPool[i].aulChildren[0])
+      ulUnused++;
+   if(ulUsed != ulCount || ulLength != ulStrlen ||
+      ulUnused != ulFreeCount || ulUsed + ulUnused != ulPoolSize) {
+      fprintf(stderr, "The counts do not match the pool\n");
+      return FALSE;
+   }
+   return TRUE;
+}
+#endif
+
+
+/* --------------------------------------------------------------------
+
+  The BDT_checkPath and BDT_traversePath functions work on pcPath
+  directly, so that no operation allocates anything but the nodes it
+  adds.
+*/
+
+/*
+  Returns SUCCESS if pcPath is a well-formatted path: not empty, and
+  neither beginning nor ending with a '/' nor having two in a row.
+  Otherwise, returns BAD_PATH.
+*/
+static int BDT_checkPath(const char *pcPath) {
+   size_t i;
+
+   assert(pcPath != NULL);
+
+   if(pcPath[0] == '\0' || pcPath[0] == '/')
+      return BAD_PATH;
+   for(i = 1; pcPath[i] != '\0'; i++)
+      if(pcPath[i] == '/' && (pcPath[i - 1] == '/' ||
+                              pcPath[i + 1] == '\0'))
+         return BAD_PATH;
+   return SUCCESS;
+}
+
+/*
+  Traverses the BDT starting at the root as far as possible towards
+  well-formatted path pcPath. If able to traverse, returns an int
+  SUCCESS status, sets *pulFurthest to the furthest node reached (or
+  NONE if the root is NONE), and *pulEnd to the length of its path,
+  which is pcPath's length if the whole path was reached. Otherwise,
+  sets *pulFurthest to NONE and returns CONFLICTING_PATH, as the
+  root's path is not a prefix of pcPath.
+*/
+static int BDT_traversePath(const char *pcPath, size_t *pulFurthest,
+                            size_t *pulEnd) {
+   size_t ulCurr;
+   size_t ulEnd;
+
+   assert(pcPath != NULL);
+   assert(pulFurthest != NULL);
+   assert(pulEnd != NULL);
+
+   *pulFurthest = NONE;
+   *pulEnd = 0;
+   if(ulRoot == NONE)
+      return SUCCESS;
+
+   ulEnd = strcspn(pcPath, "/");
+   if(psPool[ulRoot].ulLength != ulEnd ||
+      memcmp(psPool[ulRoot].pcPath, pcPath, ulEnd) != 0)
+      return CONFLICTING_PATH;
+
+   ulCurr = ulRoot;
+   while(pcPath[ulEnd] == '/') {
+      size_t ulStart = ulEnd + 1;
+      size_t ulNext = ulStart + strcspn(pcPath + ulStart, "/");
+      size_t ulChild = NONE;
+      size_t c;
+
+      /* a child's path extends ulCurr's, so only its name differs */
+      for(c = 0; c < 2 && ulChild == NONE; c++) {
+         size_t ulCand = psPool[ulCurr].aulChildren[c];
+         if(ulCand != NONE && psPool[ulCand].ulLength == ulNext &&
+            memcmp(psPool[ulCand].pcPath + ulStart, pcPath + ulStart,
+                   ulNext - ulStart) == 0)
+            ulChild = ulCand;
+      }
+      if(ulChild == NONE)
+         break;
+      ulCurr = ulChild;
+      ulEnd = ulNext;
+   }
+
+   *pulFurthest = ulCurr;
+   *pulEnd = ulEnd;
+   return SUCCESS;
+}
+
+/*
+  Traverses the BDT to find the node with absolute path pcPath.
+  Returns a int SUCCESS status and sets *pulResult to be the node, if
+  found. Otherwise, sets *pulResult to NONE and returns with status:
+  * INITIALIZATION_ERROR if the BDT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if no node with pcPath exists in the hierarchy
+*/
+static int BDT_findNode(const char *pcPath, size_t *pulResult) {
+   size_t ulFound;
+   size_t ulEnd;
+   int iStatus;
+
+   assert(pcPath != NULL);
+   assert(pulResult != NULL);
+
+   *pulResult = NONE;
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   iStatus = BDT_checkPath(pcPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = BDT_traversePath(pcPath, &ulFound, &ulEnd);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   if(ulFound == NONE || pcPath[ulEnd] != '\0')
+      return NO_SUCH_PATH;
+
+   *pulResult = ulFound;
+   return SUCCESS;
+}
+/*--------------------------------------------------------------------*/
+
+
+int BDT_insert(const char *pcPath) {
+   int iStatus;
+   size_t ulCurr, ulEnd, ulStart, ulNeeded, ulFirstNew, ulPrev;
+   size_t i;
+
+   assert(pcPath != NULL);
+   assert(BDT_isValid());
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   iStatus = BDT_checkPath(pcPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   /* find the closest ancestor of pcPath already in the tree */
+   iStatus = BDT_traversePath(pcPath, &ulCurr, &ulEnd);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(ulCurr != NONE && pcPath[ulEnd] == '\0')
+      return ALREADY_IN_TREE;
+
+   /* the new directories would make a third child */
+   if(ulCurr != NONE && psPool[ulCurr].aulChildren[1] != NONE)
+      return CONFLICTING_PATH;
+
+   /* reserve a node for each new directory, so that the pool cannot
+      move while they are linked */
+   ulNeeded = ulCurr == NONE;
+   for(i = ulEnd; pcPath[i] != '\0'; i++)
+      ulNeeded += pcPath[i] == '/';
+   iStatus = BDT_reserve(ulNeeded);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   /* build the rest of the path one level at a time, linked below
+      each other but not yet into the tree */
+   ulFirstNew = NONE;
+   ulPrev = NONE;
+   ulStart = ulCurr == NONE ? 0 : ulEnd + 1;
+   do {
+      size_t ulNew;
+
+      ulEnd = ulStart + strcspn(pcPath + ulStart, "/");
+      ulNew = BDT_newNode(pcPath, ulEnd, ulStart);
+      if(ulNew == NONE) {
+         if(ulFirstNew != NONE)
+            BDT_freeSubtree(ulFirstNew);
+         assert(BDT_isValid());
+         return MEMORY_ERROR;
+      }
+      if(ulPrev == NONE)
+         ulFirstNew = ulNew;
+      else {
+         psPool[ulPrev].aulChildren[0] = ulNew;
+         psPool[ulNew].ulParent = ulPrev;
+      }
+      ulCount++;
+      ulStrlen += ulEnd + 1;
+      ulPrev = ulNew;
+      ulStart = ulEnd + 1;
+   } while(pcPath[ulEnd] != '\0');
+
+   /* link the new directories in */
+   if(ulCurr == NONE)
+      ulRoot = ulFirstNew;
+   else {
+      size_t c = psPool[ulCurr].aulChildren[0] != NONE;
+      psPool[ulCurr].aulChildren[c] = ulFirstNew;
+      psPool[ulFirstNew].ulParent = ulCurr;
+   }
+
+   assert(BDT_isValid());
+   return SUCCESS;
+}
+
+boolean BDT_contains(const char *pcPath) {
+   size_t ulFound;
+
+   assert(pcPath != NULL);
+
+   return (boolean) (BDT_findNode(pcPath, &ulFound) == SUCCESS);
+}
+
+
+int BDT_rm(const char *pcPath) {
+   int iStatus;
+   size_t ulFound;
+
+   assert(pcPath != NULL);
+   assert(BDT_isValid());
+
+   iStatus = BDT_findNode(pcPath, &ulFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   if(ulFound == ulRoot)
+      ulRoot = NONE;
+   else
+      BDT_unlink(ulFound);
+   BDT_freeSubtree(ulFound);
+
+   assert(BDT_isValid());
+   return SUCCESS;
+}
+
+int BDT_init(void) {
+   assert(BDT_isValid());
+
+   if(bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   bIsInitialized = TRUE;
+   ulRoot = NONE;
+   ulCount = 0;
+   ulStrlen = 0;
+
+   assert(BDT_isValid());
+   return SUCCESS;
+}
+
+int BDT_destroy(void) {
+   assert(BDT_isValid());
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   if(ulRoot != NONE) {
+      BDT_freeSubtree(ulRoot);
+      ulRoot = NONE;
+   }
+   free(psPool);
+   psPool = NULL;
+   ulPoolSize = 0;
+   ulFree = NONE;
+   ulFreeCount = 0;
+
+   bIsInitialized = FALSE;
+
+   assert(BDT_isValid());
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+char *BDT_toString(void) {
+   char *result;
+   char *pcEnd;
+   size_t ulCurr = ulRoot;
+
+   if(!bIsInitialized)
+      return NULL;
+
+   /* ulStrlen is kept up to date, so the string is written in one
+      pass, in pre-order, walking back up parents instead of using a
+      stack */
+   result = malloc(ulStrlen + 1);
+   if(result == NULL)
+      return NULL;
+
+   pcEnd = result;
+   while(ulCurr != NONE) {
+      struct node *psCurr = &psPool[ulCurr];
+
+      memcpy(pcEnd, psCurr->pcPath, psCurr->ulLength);
+      pcEnd[psCurr->ulLength] = '\n';
+      pcEnd += psCurr->ulLength + 1;
+
+      if(psCurr->aulChildren[0] != NONE) {
+         ulCurr = psCurr->aulChildren[0];
+         continue;
+      }
+      /* go up to the nearest ancestor with a second child not yet
+         written */
+      for(;;) {
+         size_t ulParent = psPool[ulCurr].ulParent;
+
+         if(ulParent == NONE) {
+            ulCurr = NONE;
+            break;
+         }
+         if(psPool[ulParent].aulChildren[0] == ulCurr &&
+            psPool[ulParent].aulChildren[1] != NONE) {
+            ulCurr = psPool[ulParent].aulChildren[1];
+            break;
+         }
+         ulCurr = ulParent;
+      }
+   }
+   *pcEnd = '\0';
+
+   assert((size_t) (pcEnd - result) == ulStrlen);
+   return result;
+}
@@ -0,0 +1 @@
+../0shared/benchutil.c
\ No newline at end of file
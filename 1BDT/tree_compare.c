@@ -0,0 +1 @@
+../0shared/tree_compare.c
\ No newline at end of file
@@ -3,74 +3,114 @@
 /* Authors: Thomas Zhang and Maia Abiani                              */
 /*--------------------------------------------------------------------*/
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "checkerDT.h"
 #include "dynarray.h"
 #include "path.h"
 
+#ifndef CHECKERDT_FULL_INTERVAL
+#define CHECKERDT_FULL_INTERVAL 1024
+#endif
+#ifndef CHECKERDT_SAMPLE_NODES
+#define CHECKERDT_SAMPLE_NODES 64
+#endif
+
+/* The checks' mode, and how often scoped checks check everything */
+#if defined(CHECKERDT_SAMPLED)
+static enum checkerMode eMode = CHECKER_SAMPLED;
+#elif defined(CHECKERDT_SCOPED)
+static enum checkerMode eMode = CHECKER_SCOPED;
+#else
+static enum checkerMode eMode = CHECKER_FULL;
+#endif
+static size_t ulFullInterval = CHECKERDT_FULL_INTERVAL;
+/* The scoped checks made since the last full one */
+static size_t ulSinceFull;
+
+/* How many nodes, and how many nanoseconds (0 for no limit), each
+   sampled check may spend on its sample */
+static size_t ulSampleNodes = CHECKERDT_SAMPLE_NODES;
+static unsigned long ulSampleNs = 0;
+/* The path of the node the next sample starts at, or NULL to start at
+   the root; a path rather than the node, which may be freed before
+   the next check */
+static char *pcCursor;
+
 /*
-   Performs a pre-order traversal of the subtree rooted at oNNode .
-   Returns FALSE if a broken invariant is found and
-   returns TRUE otherwise, taking into account the existence of 
-   oNHigherNode (which is oNNode or an ancestor of oNNode). 
-   Specifically, it checks if every ancestor - descendant 
-   relationship satisfies that the ancestor path is a prefix 
-   of the descendant path. 
+   Returns TRUE if oNNode's parent, if any, has a path that is the
+   longest possible proper prefix of oNNode's path, or FALSE
+   otherwise. Prints explanation to stderr in the latter case.
 */
-static boolean CheckerDT_ancestorTreeCheck(Node_T oNNode, 
-   Node_T oNHigherNode) {
-   size_t ulIndex;
-   Path_T oHNPath;
-   Path_T oNPath;
-   /*path of ancestor reference being checked against */
-   oHNPath = Node_getPath(oNHigherNode);
+static boolean CheckerDT_parentCheck(Node_T oNNode) {
+   Node_T oNParent;
+   Path_T oPNPath;
+   Path_T oPPPath;
+   size_t ulPLength;
 
-   if(oNNode!=NULL) {
-      /*retrieve path of current descendant node being checked*/
-      oNPath = Node_getPath(oNNode);
+   oNParent = Node_getParent(oNNode);
+   if(oNParent != NULL) {
+      oPNPath = Node_getPath(oNNode);
+      oPPPath = Node_getPath(oNParent);
 
-      if(Path_getSharedPrefixDepth(oHNPath, oNPath) !=
-         Path_getDepth(oHNPath)) {
-         fprintf(stderr, "Largest shared prefix depth of an Ancestor "
-            "and Child is not the depth of the ancestor: (%s) (%s)\n",
-                 Path_getPathname(oNPath), Path_getPathname(oHNPath));
+      /* one component deeper, with the parent's path as a string
+         prefix up to a '/': the same as a shared prefix depth of the
+         parent's depth, but without comparing every component */
+      ulPLength = Path_getStrLength(oPPPath);
+      if(Path_getDepth(oPNPath) != Path_getDepth(oPPPath) + 1 ||
+         strncmp(Path_getPathname(oPPPath), Path_getPathname(oPNPath),
+                 ulPLength) != 0 ||
+         Path_getPathname(oPNPath)[ulPLength] != '/') {
+         fprintf(stderr, "P-C nodes don't have P-C paths: (%s) (%s)\n",
+                 Path_getPathname(oPPPath), Path_getPathname(oPNPath));
          return FALSE;
       }
+   }
+   return TRUE;
+}
 
-      /* Recur on every child of oNNode */
-      for(ulIndex = 0; ulIndex < Node_getNumChildren(oNNode); ulIndex++)
-      {
-         Node_T oNChild = NULL;
-         int iStatus = Node_getChild(oNNode, ulIndex, &oNChild);
-
-         if(iStatus != SUCCESS) {
-            fprintf(stderr, "getNumChildren claims more children"
-               "than getChild returns\n");
-            return FALSE;
-         }
-
-         /* recursively check each child's subtree, if any call fails
-            pass failure back up immediately*/
-         if(!CheckerDT_ancestorTreeCheck(oNChild, oNHigherNode))
-            return FALSE;
+/*
+   Returns TRUE if oNNode is found by path among its parent's
+   children, or is oNRoot if it has no parent, and sets *pulChildID to
+   its identifier among its parent's children (0 for the root).
+   Returns FALSE otherwise, and prints explanation to stderr.
+*/
+static boolean CheckerDT_linkCheck(Node_T oNRoot, Node_T oNNode,
+                                   size_t *pulChildID) {
+   Node_T oNParent = Node_getParent(oNNode);
+   Node_T oNFound = NULL;
+
+   *pulChildID = 0;
+   if(oNParent == NULL) {
+      if(oNNode != oNRoot) {
+         fprintf(stderr, "A node without a parent is not the "
+                 "root: (%s)\n",
+                 Path_getPathname(Node_getPath(oNNode)));
+         return FALSE;
       }
+      return TRUE;
+   }
+   if(!Node_hasChild(oNParent, Node_getPath(oNNode), pulChildID) ||
+      Node_getChild(oNParent, *pulChildID, &oNFound) != SUCCESS ||
+      oNFound != oNNode) {
+      fprintf(stderr, "A node is not among its parent's "
+              "children: (%s)\n",
+              Path_getPathname(Node_getPath(oNNode)));
+      return FALSE;
    }
    return TRUE;
 }
 
 /* see checkerDT.h for specification */
 boolean CheckerDT_Node_isValid(Node_T oNNode) {
-   Node_T oNParent;
-   Path_T oPNPath;
-   Path_T oPPPath;
-   size_t i; 
-   size_t j;
+   size_t i;
    Node_T prevChild = NULL;
    Node_T currChild = NULL;
-   Node_T childCmp1 = NULL;
-   Node_T childCmp2 = NULL;
 
    /* Sample check: a NULL pointer is not a valid node */
    if(oNNode == NULL) {
@@ -80,74 +120,63 @@ boolean CheckerDT_Node_isValid(Node_T oNNode) {
 
    /* Sample check: parent's path must be the longest possible
       proper prefix of the node's path */
-   oNParent = Node_getParent(oNNode);
-   if(oNParent != NULL) {
-      oPNPath = Node_getPath(oNNode);
-      oPPPath = Node_getPath(oNParent);
-
-      if(Path_getSharedPrefixDepth(oPNPath, oPPPath) !=
-         Path_getDepth(oPNPath) - 1 || Path_getSharedPrefixDepth(oPNPath
-         , oPPPath) != Path_getDepth(oPPPath)) {
-         fprintf(stderr, "P-C nodes don't have P-C paths: (%s) (%s)\n",
-                 Path_getPathname(oPPPath), Path_getPathname(oPNPath));
-         return FALSE;
-      }
-   }
+   if(!CheckerDT_parentCheck(oNNode))
+      return FALSE;
 
-   /*Check that a node's children are stored in lexicographical order*/
+   /* Check that a node's children are stored in strictly increasing
+      lexicographical order; comparing each child with the one before
+      it also finds any duplicates, since equal children would be
+      adjacent */
    for(i = 1; i < Node_getNumChildren(oNNode); i++)
    {
-      Node_getChild(oNNode, i-1, &prevChild);
-      Node_getChild(oNNode, i, &currChild);
-      if(Path_comparePath(Node_getPath(prevChild), 
-      Node_getPath(currChild)) > 0)
+      int iCompare;
+
+      if(Node_getChild(oNNode, i-1, &prevChild) != SUCCESS ||
+         Node_getChild(oNNode, i, &currChild) != SUCCESS) {
+         fprintf(stderr, "getNumChildren claims more children than "
+                 "getChild returns\n");
+         return FALSE;
+      }
+      iCompare = Path_comparePath(Node_getPath(prevChild),
+                                  Node_getPath(currChild));
+      if(iCompare > 0)
       {
          fprintf(stderr, "Children not stored lexicographically\n");
          return FALSE;
       }
-   }
-   
-   /*Check that a node's children are unique*/
-   
-   for(i = 0; i < Node_getNumChildren(oNNode); i++)
-   {
-      Node_getChild(oNNode, i, &childCmp1);
-      for(j = 0; j < Node_getNumChildren(oNNode); j++)
+      if(iCompare == 0)
       {
-         Node_getChild(oNNode, j, &childCmp2);
-         if(i!=j && Path_comparePath(Node_getPath(childCmp1), 
-         Node_getPath(childCmp2)) == 0)
-         {
-            fprintf(stderr, "Duplicate children for node: (%s)\n",
+         fprintf(stderr, "Duplicate children for node: (%s)\n",
                  Path_getPathname(Node_getPath(oNNode)));
-            return FALSE;
-         }   
+         return FALSE;
       }
    }
-      
-
-   /* Now checks invariants recursively at each node from the root. */
-   if(!CheckerDT_ancestorTreeCheck(oNNode, oNNode)){
-      return FALSE;
-   };
 
    return TRUE;
 }
 
 /*
-   Performs a pre-order traversal of the tree rooted at oNNode .
-   Returns FALSE if a broken invariant is found and
+   Performs a pre-order traversal of the tree rooted at oNNode,
+   checking each node with CheckerDT_Node_isValid and each child's
+   link back to its parent, and adding the number of nodes visited to
+   *pulVisited. Returns FALSE if a broken invariant is found and
    returns TRUE otherwise.
 
-   You may want to change this function's return type or
-   parameter list to facilitate constructing your checks.
-   If you do, you should update this function comment.
+   Since every node's parent path is checked to be its longest proper
+   prefix, every ancestor's path is a prefix of its descendants' by
+   induction, so each node is visited once. The traversal stops once
+   it has visited more than ulCount nodes, which the caller reports as
+   a count mismatch, so that a cycle cannot make it run forever.
 */
-static boolean CheckerDT_treeCheck(Node_T oNNode) {
+static boolean CheckerDT_treeCheck(Node_T oNNode, size_t ulCount,
+                                   size_t *pulVisited) {
    size_t ulIndex;
 
    if(oNNode!= NULL) {
 
+      if(++*pulVisited > ulCount)
+         return TRUE;
+
       /* Sample check on each node: node must be valid */
       /* If not, pass that failure back up immediately */
       if(!CheckerDT_Node_isValid(oNNode))
@@ -175,7 +204,7 @@ static boolean CheckerDT_treeCheck(Node_T oNNode) {
 
          /* if recurring down one subtree results in a failed check
             farther down, passes the failure back up immediately */
-         if(!CheckerDT_treeCheck(oNChild))
+         if(!CheckerDT_treeCheck(oNChild, ulCount, pulVisited))
             return FALSE;
       }
    }
@@ -184,55 +213,304 @@ static boolean CheckerDT_treeCheck(Node_T oNNode) {
 
 
 /*
-   Performs a pre-order traversal of the tree rooted at oNNode and
-   returns the number of nodes in the subtree rooted at oNNode. 
+   Returns TRUE if the top-level invariants relating bIsInitialized,
+   oNRoot and ulCount hold, or FALSE otherwise. Prints explanation to
+   stderr in the latter case.
 */
-static size_t CheckerDT_subtreeSize(Node_T oNNode) {
-   size_t ulIndex;
-   size_t total;
+static boolean CheckerDT_topCheck(boolean bIsInitialized, Node_T oNRoot,
+                                  size_t ulCount) {
+   /* Sample check on a top-level data structure invariant:
+      if the DT is not initialized, its count should be 0. */
+   if(!bIsInitialized){
+      if(ulCount != 0) {
+         fprintf(stderr, "Not initialized, but count is not 0\n");
+         return FALSE;
+      }
+      if(oNRoot != NULL) {
+         fprintf(stderr, "Not initialized, but root is not NULL\n");
+         return FALSE;
+      }
+   }
 
-   if(oNNode!= NULL) {
-      total = 1;
+   if((oNRoot == NULL) != (ulCount == 0)) {
+      fprintf(stderr, "Given ulCount does not match actual number of "
+          "nodes in DT.\n");
+      return FALSE;
+   }
 
-      /* Recur on every child of oNNode */
-      for(ulIndex = 0; ulIndex < Node_getNumChildren(oNNode); ulIndex++)
-      {
-         Node_T oNChild = NULL;
-         Node_getChild(oNNode, ulIndex, &oNChild);
+   if(oNRoot != NULL && Node_getParent(oNRoot) != NULL) {
+      fprintf(stderr, "The root has a parent\n");
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+   Checks every node of the hierarchy, as CheckerDT_isValid does in
+   CHECKER_FULL mode.
+*/
+static boolean CheckerDT_fullCheck(boolean bIsInitialized,
+                                   Node_T oNRoot, size_t ulCount) {
+   size_t ulVisited = 0;
+
+   ulSinceFull = 0;
+   if(!CheckerDT_topCheck(bIsInitialized, oNRoot, ulCount))
+      return FALSE;
+
+   /* Now checks invariants recursively at each node from the root,
+      counting the nodes as it goes. */
+   if(!CheckerDT_treeCheck(oNRoot, ulCount, &ulVisited))
+      return FALSE;
+
+   if(ulCount != ulVisited){
+      fprintf(stderr, "Given ulCount does not match actual number of "
+          "nodes in DT.\n");
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
+/* Returns a monotonic timestamp in nanoseconds. */
+static unsigned long CheckerDT_now(void) {
+   struct timespec sNow;
+   (void) clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (unsigned long) sNow.tv_sec * 1000000000UL +
+      (unsigned long) sNow.tv_nsec;
+}
+
+/*
+   Sets *poNNext to the node after the subtree rooted at oNNode in
+   pre-order, or NULL if there is none. Returns FALSE, and prints
+   explanation to stderr, if a node on the way is not among its
+   parent's children, or TRUE otherwise.
+*/
+static boolean CheckerDT_nextAfter(Node_T oNRoot, Node_T oNNode,
+                                   Node_T *poNNext) {
+   Node_T oNParent;
+   size_t ulChildID;
+
+   *poNNext = NULL;
+   for(; (oNParent = Node_getParent(oNNode)) != NULL;
+       oNNode = oNParent) {
+      if(!CheckerDT_linkCheck(oNRoot, oNNode, &ulChildID))
+         return FALSE;
+      if(ulChildID + 1 < Node_getNumChildren(oNParent))
+         return Node_getChild(oNParent, ulChildID + 1, poNNext) ==
+            SUCCESS;
+   }
+   return TRUE;
+}
+
+/*
+   Returns the node the sample starts at: the node at path pcCursor,
+   or if it is no longer in the hierarchy the node that now follows
+   where it was in pre-order, or the root if there is no cursor or the
+   root has changed. May return NULL if the cursor was at the end.
+*/
+static Node_T CheckerDT_resume(Node_T oNRoot) {
+   Node_T oNCurr = oNRoot;
+   size_t ulLength;
+
+   if(pcCursor == NULL)
+      return oNRoot;
+   ulLength = Path_getStrLength(Node_getPath(oNRoot));
+   if(strncmp(pcCursor, Path_getPathname(Node_getPath(oNRoot)),
+              ulLength) != 0 ||
+      (pcCursor[ulLength] != '\0' && pcCursor[ulLength] != '/'))
+      return oNRoot;
+
+   /* descend along pcCursor one component at a time, comparing each
+      child's path with the cursor up to that component's end, so
+      that no Path_T need be made for it */
+   while(pcCursor[ulLength] != '\0') {
+      const char *pcEnd = strchr(pcCursor + ulLength + 1, '/');
+      size_t ulPrefix = pcEnd == NULL ? strlen(pcCursor) :
+         (size_t) (pcEnd - pcCursor);
+      size_t ulLow = 0;
+      size_t ulHigh = Node_getNumChildren(oNCurr);
+      Node_T oNChild = NULL;
+
+      while(ulLow < ulHigh) {
+         size_t ulMid = ulLow + (ulHigh - ulLow) / 2;
+         const char *pcChild;
+         int iCompare;
+
+         (void) Node_getChild(oNCurr, ulMid, &oNChild);
+         pcChild = Path_getPathname(Node_getPath(oNChild));
+         iCompare = strncmp(pcChild, pcCursor, ulPrefix);
+         if(iCompare == 0 && pcChild[ulPrefix] != '\0')
+            iCompare = 1;
+         if(iCompare == 0)
+            break;
+         if(iCompare < 0)
+            ulLow = ulMid + 1;
+         else
+            ulHigh = ulMid;
+      }
+      if(ulLow == ulHigh) {
+         /* the cursor's node is gone: resume at what followed it */
+         Node_T oNNext = NULL;
+
+         if(ulLow < Node_getNumChildren(oNCurr)) {
+            (void) Node_getChild(oNCurr, ulLow, &oNNext);
+            return oNNext;
+         }
+         (void) CheckerDT_nextAfter(oNRoot, oNCurr, &oNNext);
+         return oNNext;
+      }
+      oNCurr = oNChild;
+      ulLength = ulPrefix;
+   }
+   return oNCurr;
+}
+
+/*
+   Checks the next nodes of the hierarchy rooted at oNRoot in
+   pre-order, starting where the last sample stopped and wrapping
+   around to the root after the last node, until ulSampleNodes nodes
+   have been checked or ulSampleNs have passed (but at least one node)
+   or every node has been checked. Returns TRUE if they are valid, or
+   FALSE otherwise, and prints explanation to stderr in the latter
+   case.
+*/
+static boolean CheckerDT_sampleCheck(Node_T oNRoot, size_t ulCount) {
+   unsigned long ulStart = ulSampleNs == 0 ? 0 : CheckerDT_now();
+   Node_T oNCurr;
+   size_t ulChecked = 0;
+
+   if(oNRoot == NULL) {
+      free(pcCursor);
+      pcCursor = NULL;
+      return TRUE;
+   }
 
-         /* adds the subtree size of each child to the 
-         total subtree size */
-         total = total + CheckerDT_subtreeSize(oNChild);
+   oNCurr = CheckerDT_resume(oNRoot);
+   if(oNCurr == NULL)
+      oNCurr = oNRoot;
+   free(pcCursor);
+   pcCursor = NULL;
+
+   while(oNCurr != NULL && ulChecked < ulSampleNodes &&
+         ulChecked < ulCount) {
+      size_t ulChildID;
+
+      if(!CheckerDT_Node_isValid(oNCurr) ||
+         !CheckerDT_linkCheck(oNRoot, oNCurr, &ulChildID))
+         return FALSE;
+      ulChecked++;
+
+      /* on to the next node in pre-order */
+      if(Node_getNumChildren(oNCurr) > 0) {
+         if(Node_getChild(oNCurr, 0, &oNCurr) != SUCCESS)
+            return FALSE;
       }
-      return total; 
+      else if(!CheckerDT_nextAfter(oNRoot, oNCurr, &oNCurr))
+         return FALSE;
+
+      if(ulSampleNs != 0 && CheckerDT_now() - ulStart >= ulSampleNs)
+         break;
    }
-   return 0;
+
+   /* remember where to start next time; NULL restarts at the root */
+   if(oNCurr != NULL) {
+      const char *pcPath = Path_getPathname(Node_getPath(oNCurr));
+      pcCursor = malloc(strlen(pcPath) + 1);
+      if(pcCursor != NULL)
+         strcpy(pcCursor, pcPath);
+   }
+   return TRUE;
 }
 
+/*
+   Returns TRUE if a CHECKER_SCOPED or CHECKER_SAMPLED check is due to
+   check everything.
+*/
+static boolean CheckerDT_isFullDue(void) {
+   return ulFullInterval != 0 && ++ulSinceFull >= ulFullInterval;
+}
 
 /* see checkerDT.h for specification */
 boolean CheckerDT_isValid(boolean bIsInitialized, Node_T oNRoot,
                           size_t ulCount) {
+   if(eMode == CHECKER_FULL || CheckerDT_isFullDue())
+      return CheckerDT_fullCheck(bIsInitialized, oNRoot, ulCount);
+   if(!CheckerDT_topCheck(bIsInitialized, oNRoot, ulCount))
+      return FALSE;
+   return eMode != CHECKER_SAMPLED ||
+      CheckerDT_sampleCheck(oNRoot, ulCount);
+}
 
-   /* Sample check on a top-level data structure invariant:
-      if the DT is not initialized, its count should be 0. */
-   if(!bIsInitialized){
-      if(ulCount != 0) {
-         fprintf(stderr, "Not initialized, but count is not 0\n");
+/* see checkerDT.h for specification */
+boolean CheckerDT_isValidPath(boolean bIsInitialized, Node_T oNRoot,
+                              size_t ulCount, Node_T oNNode) {
+   Node_T oNCurr;
+   size_t ulSteps = 0;
+   size_t ulIndex;
+
+   if(eMode == CHECKER_FULL || CheckerDT_isFullDue())
+      return CheckerDT_fullCheck(bIsInitialized, oNRoot, ulCount);
+   if(!CheckerDT_topCheck(bIsInitialized, oNRoot, ulCount))
+      return FALSE;
+   if(oNNode == NULL)
+      return eMode != CHECKER_SAMPLED ||
+         CheckerDT_sampleCheck(oNRoot, ulCount);
+
+   /* oNNode's children must link back to it, and be its children by
+      path; their own children were not changed */
+   for(ulIndex = 0; ulIndex < Node_getNumChildren(oNNode); ulIndex++) {
+      Node_T oNChild = NULL;
+
+      if(Node_getChild(oNNode, ulIndex, &oNChild) != SUCCESS) {
+         fprintf(stderr, "getNumChildren claims more children than "
+                 "getChild returns\n");
          return FALSE;
       }
-      if(oNRoot != NULL) {
-         fprintf(stderr, "Not initialized, but root is not NULL\n");
+      if(Node_getParent(oNChild) != oNNode) {
+         fprintf(stderr, "The parent of the child of a node "
+            "(getParent of getChild of the node) didn't return the "
+            "original node.\n");
          return FALSE;
       }
+      if(!CheckerDT_parentCheck(oNChild))
+         return FALSE;
    }
 
-   if(ulCount!=CheckerDT_subtreeSize(oNRoot)){
-      fprintf(stderr, "Given ulCount does not match actual number of "
-          "nodes in DT.\n");
-      return FALSE;
+   /* every node from oNNode up to the root must be valid, and be
+      found among its parent's children by path; the walk is bounded
+      by ulCount so that a cycle cannot make it run forever */
+   for(oNCurr = oNNode; oNCurr != NULL;
+       oNCurr = Node_getParent(oNCurr)) {
+      size_t ulChildID;
+
+      if(++ulSteps > ulCount) {
+         fprintf(stderr, "Given ulCount does not match actual number "
+                 "of nodes in DT.\n");
+         return FALSE;
+      }
+      if(!CheckerDT_Node_isValid(oNCurr) ||
+         !CheckerDT_linkCheck(oNRoot, oNCurr, &ulChildID))
+         return FALSE;
    }
+   return eMode != CHECKER_SAMPLED ||
+      CheckerDT_sampleCheck(oNRoot, ulCount);
+}
+
+/* see checkerDT.h for specification */
+void CheckerDT_setMode(enum checkerMode eNewMode,
+                       size_t ulNewFullInterval) {
+   assert(eNewMode == CHECKER_FULL || eNewMode == CHECKER_SCOPED ||
+          eNewMode == CHECKER_SAMPLED);
+
+   eMode = eNewMode;
+   ulFullInterval = ulNewFullInterval;
+   ulSinceFull = 0;
+}
+
+/* see checkerDT.h for specification */
+void CheckerDT_setSampleBudget(size_t ulNodes, unsigned long ulMaxNs) {
+   assert(ulNodes > 0);
 
-   /* Now checks invariants recursively at each node from the root. */
-   return CheckerDT_treeCheck(oNRoot);
+   ulSampleNodes = ulNodes;
+   ulSampleNs = ulMaxNs;
 }
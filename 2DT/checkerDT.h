@@ -30,4 +30,53 @@ boolean CheckerDT_isValid(boolean bIsInitialized,
                           Node_T oNRoot,
                           size_t ulCount);
 
+/*
+   Returns TRUE if the hierarchy is in a valid state after an
+   operation that changed it at oNNode (a node it inserted, or the
+   parent of a subtree it removed), or FALSE otherwise. Prints
+   explanation to stderr in the latter case. In CHECKER_FULL mode this
+   is CheckerDT_isValid; in CHECKER_SCOPED mode only the top-level
+   invariants, the nodes on the path from oNRoot to oNNode and
+   oNNode's children are checked, except on the periodic full checks.
+*/
+boolean CheckerDT_isValidPath(boolean bIsInitialized,
+                              Node_T oNRoot,
+                              size_t ulCount,
+                              Node_T oNNode);
+
+/* How much of the hierarchy the checks above examine */
+enum checkerMode {
+   /* every node, on every call */
+   CHECKER_FULL,
+   /* the top-level invariants, plus the nodes an operation changed
+      for CheckerDT_isValidPath, and every node once every
+      ulFullInterval calls to either (never if ulFullInterval is 0) */
+   CHECKER_SCOPED,
+   /* as CHECKER_SCOPED, plus a sample of the nodes on every call:
+      the next few in pre-order after the last call's sample, within
+      the budget of CheckerDT_setSampleBudget, so that the samples
+      sweep the whole hierarchy again and again */
+   CHECKER_SAMPLED
+};
+
+/*
+   Sets the checks' mode to eMode, with a full check every
+   ulFullInterval calls in CHECKER_SCOPED and CHECKER_SAMPLED modes.
+   The mode is CHECKER_FULL unless checkerDT.c is compiled with
+   -D CHECKERDT_SCOPED or -D CHECKERDT_SAMPLED, which select those
+   modes, with a full check every CHECKERDT_FULL_INTERVAL (by default
+   1024) calls.
+*/
+void CheckerDT_setMode(enum checkerMode eMode, size_t ulFullInterval);
+
+/*
+   Sets each CHECKER_SAMPLED check to check at most ulNodes (> 0)
+   nodes, and to stop after ulMaxNs nanoseconds (no limit if 0) once
+   it has checked one. By default the budget is CHECKERDT_SAMPLE_NODES
+   (64) nodes and no time limit. With no time limit, every node that
+   stays in a hierarchy of at most N nodes is checked within about
+   N / ulNodes + 1 calls; with one, within N calls.
+*/
+void CheckerDT_setSampleBudget(size_t ulNodes, unsigned long ulMaxNs);
+
 #endif
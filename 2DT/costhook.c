@@ -0,0 +1 @@
+../0shared/costhook.c
\ No newline at end of file
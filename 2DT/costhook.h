@@ -0,0 +1 @@
+../0shared/costhook.h
\ No newline at end of file
@@ -255,7 +255,8 @@ int DT_insert(const char *pcPath) {
       oNRoot = oNFirstNew;
    ulCount += ulNewNodes;
 
-   assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
+   assert(CheckerDT_isValidPath(bIsInitialized, oNRoot, ulCount,
+                                oNCurr));
    return SUCCESS;
 }
 
@@ -273,6 +274,7 @@ boolean DT_contains(const char *pcPath) {
 int DT_rm(const char *pcPath) {
    int iStatus;
    Node_T oNFound = NULL;
+   Node_T oNParent;
 
    assert(pcPath != NULL);
    assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
@@ -282,11 +284,13 @@ int DT_rm(const char *pcPath) {
    if(iStatus != SUCCESS)
        return iStatus;
 
+   oNParent = Node_getParent(oNFound);
    ulCount -= Node_free(oNFound);
    if(ulCount == 0)
       oNRoot = NULL;
 
-   assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
+   assert(CheckerDT_isValidPath(bIsInitialized, oNRoot, ulCount,
+                                oNParent));
    return SUCCESS;
 }
 
@@ -366,15 +370,23 @@ static void DT_strlenAccumulate(Node_T oNNode, size_t *pulAcc) {
 
 /*
   Alternate version of strcat that inverts the typical argument
-  order, appending oNNode's path onto pcAcc, and also always adds one
-  newline at the end of the concatenated string.
+  order, appending oNNode's path and one newline at *ppcEnd, the end
+  of the string being built, and advancing *ppcEnd past them. Keeping
+  the end, rather than finding it again, keeps building the string
+  linear in its length.
 */
-static void DT_strcatAccumulate(Node_T oNNode, char *pcAcc) {
-   assert(pcAcc != NULL);
+static void DT_strcatAccumulate(Node_T oNNode, char **ppcEnd) {
+   size_t ulLength;
+
+   assert(ppcEnd != NULL);
 
    if(oNNode != NULL) {
-      strcat(pcAcc, Path_getPathname(Node_getPath(oNNode)));
-      strcat(pcAcc, "\n");
+      ulLength = Path_getStrLength(Node_getPath(oNNode));
+      memcpy(*ppcEnd, Path_getPathname(Node_getPath(oNNode)),
+             ulLength);
+      (*ppcEnd)[ulLength] = '\n';
+      *ppcEnd += ulLength + 1;
+      **ppcEnd = '\0';
    }
 }
 /*--------------------------------------------------------------------*/
@@ -383,11 +395,14 @@ char *DT_toString(void) {
    DynArray_T nodes;
    size_t totalStrlen = 1;
    char *result = NULL;
+   char *pcEnd;
 
    if(!bIsInitialized)
       return NULL;
 
    nodes = DynArray_new(ulCount);
+   if(nodes == NULL)
+      return NULL;
    (void) DT_preOrderTraversal(oNRoot, nodes, 0);
 
    DynArray_map(nodes, (void (*)(void *, void*)) DT_strlenAccumulate,
@@ -400,8 +415,9 @@ char *DT_toString(void) {
    }
    *result = '\0';
 
+   pcEnd = result;
    DynArray_map(nodes, (void (*)(void *, void*)) DT_strcatAccumulate,
-                (void *) result);
+                (void *) &pcEnd);
 
    DynArray_free(nodes);
 
@@ -0,0 +1,778 @@
+/*--------------------------------------------------------------------*/
+/* dtRadix.c                                                          */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dynarray.h"
+#include "path.h"
+#include "dt.h"
+
+
+/*
+  A path-compressed Directory Tree. Each node holds a chain of
+  directories, each the only child of the one before: the directory
+  whose absolute path is oPPath, and its ancestors down to depth
+  ulTop. So a chain of single-child directories costs one node and
+  one Path_T, not one of each per directory, and a traversal crosses
+  it in one step. Every node but the root has a parent, whose deepest
+  directory is the parent of its shallowest, and no node has exactly
+  one child, since the two would then form one chain. Insertion
+  splits a chain where a new path leaves it; removal merges a node
+  left with one child into that child.
+*/
+typedef struct node *Node_T;
+
+/* A node in a path-compressed DT */
+struct node {
+   /* the absolute path of the deepest directory of the chain */
+   Path_T oPPath;
+   /* the depth of the shallowest directory of the chain */
+   size_t ulTop;
+   /* this node's parent, or NULL for the root */
+   Node_T oNParent;
+   /* this node's children, ordered by their shallowest directory's
+      name */
+   DynArray_T oDChildren;
+};
+
+
+/*
+  The DT is represented as an AO with 4 state variables:
+*/
+
+/* 1. a flag for being in an initialized state (TRUE) or not (FALSE) */
+static boolean bIsInitialized;
+/* 2. a pointer to the root node in the hierarchy */
+static Node_T oNRoot;
+/* 3. a counter of the number of directories in the hierarchy */
+static size_t ulCount;
+/* 4. a counter of the number of nodes holding them */
+static size_t ulNodes;
+
+
+
+/* --------------------------------------------------------------------
+
+  The node functions create, link and free the chains.
+*/
+
+/* Returns the name of oNNode's directory at depth ulDepth. */
+static const char *DT_getName(Node_T oNNode, size_t ulDepth) {
+   assert(oNNode != NULL);
+   assert(ulDepth >= 1);
+
+   return Path_getComponent(oNNode->oPPath, ulDepth - 1);
+}
+
+/* Returns the depth of oNNode's deepest directory. */
+static size_t DT_getBottom(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return Path_getDepth(oNNode->oPPath);
+}
+
+/*
+  Looks for the child of oNParent whose shallowest directory is named
+  pcName. Returns TRUE and sets *pulIndex to its index if there is
+  one, or returns FALSE and sets *pulIndex to the index at which it
+  would be inserted.
+*/
+static boolean DT_findChild(Node_T oNParent, const char *pcName,
+                            size_t *pulIndex) {
+   size_t ulLo = 0;
+   size_t ulHi;
+   size_t ulDepth;
+
+   assert(oNParent != NULL);
+   assert(pcName != NULL);
+   assert(pulIndex != NULL);
+
+   ulHi = DynArray_getLength(oNParent->oDChildren);
+   ulDepth = DT_getBottom(oNParent) + 1;
+   while(ulLo < ulHi) {
+      size_t ulMid = ulLo + (ulHi - ulLo) / 2;
+      Node_T oNMid = DynArray_get(oNParent->oDChildren, ulMid);
+      int iCompare = strcmp(DT_getName(oNMid, ulDepth), pcName);
+
+      if(iCompare == 0) {
+         *pulIndex = ulMid;
+         return TRUE;
+      }
+      if(iCompare < 0)
+         ulLo = ulMid + 1;
+      else
+         ulHi = ulMid;
+   }
+   *pulIndex = ulLo;
+   return FALSE;
+}
+
+/*
+  Creates a node for the chain ending at oPPath, which it takes
+  ownership of, from depth ulTop, with no parent and room for
+  ulChildren children, to be set by the caller. Returns an int
+  SUCCESS status and sets *poNResult to the new node if successful.
+  Otherwise, sets *poNResult to NULL and returns MEMORY_ERROR, leaving
+  oPPath to the caller.
+*/
+static int DT_newNode(Path_T oPPath, size_t ulTop, size_t ulChildren,
+                      Node_T *poNResult) {
+   Node_T oNNew;
+
+   assert(oPPath != NULL);
+   assert(ulTop >= 1 && ulTop <= Path_getDepth(oPPath));
+   assert(poNResult != NULL);
+
+   oNNew = malloc(sizeof(struct node));
+   if(oNNew == NULL) {
+      *poNResult = NULL;
+      return MEMORY_ERROR;
+   }
+   oNNew->oDChildren = DynArray_new(ulChildren);
+   if(oNNew->oDChildren == NULL) {
+      free(oNNew);
+      *poNResult = NULL;
+      return MEMORY_ERROR;
+   }
+   oNNew->oPPath = oPPath;
+   oNNew->ulTop = ulTop;
+   oNNew->oNParent = NULL;
+
+   ulNodes++;
+   *poNResult = oNNew;
+   return SUCCESS;
+}
+
+/*
+  Frees oNNode and its descendants, which must already be unlinked
+  from any parent, and returns the number of directories they held.
+*/
+static size_t DT_freeSubtree(Node_T oNNode) {
+   size_t ulFreed;
+   size_t ulLength;
+
+   assert(oNNode != NULL);
+
+   ulFreed = DT_getBottom(oNNode) - oNNode->ulTop + 1;
+   /* last first, so that no removal shifts the rest */
+   while((ulLength = DynArray_getLength(oNNode->oDChildren)) != 0)
+      ulFreed += DT_freeSubtree(
+         DynArray_removeAt(oNNode->oDChildren, ulLength - 1));
+   DynArray_free(oNNode->oDChildren);
+   Path_free(oNNode->oPPath);
+   free(oNNode);
+   ulNodes--;
+   return ulFreed;
+}
+
+/*
+  Merges oNNode, which has exactly one child, with that child, so
+  that oNNode's chain runs on to the child's deepest directory and
+  takes its children.
+*/
+static void DT_mergeChild(Node_T oNNode) {
+   Node_T oNChild;
+   DynArray_T oDEmpty;
+   size_t i;
+
+   assert(oNNode != NULL);
+   assert(DynArray_getLength(oNNode->oDChildren) == 1);
+
+   oNChild = DynArray_get(oNNode->oDChildren, 0);
+   oDEmpty = oNNode->oDChildren;
+   Path_free(oNNode->oPPath);
+   oNNode->oPPath = oNChild->oPPath;
+   oNNode->oDChildren = oNChild->oDChildren;
+   for(i = 0; i < DynArray_getLength(oNNode->oDChildren); i++)
+      ((Node_T) DynArray_get(oNNode->oDChildren, i))->oNParent = oNNode;
+   DynArray_free(oDEmpty);
+   free(oNChild);
+   ulNodes--;
+}
+
+
+/* --------------------------------------------------------------------
+
+  DT_isValid checks the invariants of the representation, on every
+  operation while assertions are on.
+*/
+
+#ifndef NDEBUG
+
+/*
+  Returns TRUE if the subtree rooted at oNNode is valid, adding the
+  directories and nodes in it to *pulDirs and *pulNodes. Otherwise,
+  prints an explanation to stderr and returns FALSE.
+*/
+static boolean DT_isValidSubtree(Node_T oNNode, size_t *pulDirs,
+                                 size_t *pulNodes) {
+   size_t ulBottom;
+   size_t ulChildren;
+   size_t i;
+
+   assert(oNNode != NULL);
+   assert(pulDirs != NULL);
+   assert(pulNodes != NULL);
+
+   ulBottom = DT_getBottom(oNNode);
+   if(oNNode->ulTop < 1 || oNNode->ulTop > ulBottom) {
+      fprintf(stderr, "A chain holds no directories\n");
+      return FALSE;
+   }
+   ulChildren = DynArray_getLength(oNNode->oDChildren);
+   if(ulChildren == 1) {
+      fprintf(stderr, "A node with one child was not merged\n");
+      return FALSE;
+   }
+
+   for(i = 0; i < ulChildren; i++) {
+      Node_T oNChild = DynArray_get(oNNode->oDChildren, i);
+
+      if(oNChild == NULL || oNChild->oNParent != oNNode) {
+         fprintf(stderr, "A child does not link back to its parent\n");
+         return FALSE;
+      }
+      if(oNChild->ulTop != ulBottom + 1 ||
+         Path_getSharedPrefixDepth(oNChild->oPPath,
+                                   oNNode->oPPath) != ulBottom) {
+         fprintf(stderr, "A chain does not continue its parent's\n");
+         return FALSE;
+      }
+      if(i > 0 && strcmp(DT_getName(DynArray_get(oNNode->oDChildren,
+                                                  i - 1),
+                                    ulBottom + 1),
+                         DT_getName(oNChild, ulBottom + 1)) >= 0) {
+         fprintf(stderr, "Children are not in strictly increasing "
+                 "order\n");
+         return FALSE;
+      }
+      if(!DT_isValidSubtree(oNChild, pulDirs, pulNodes))
+         return FALSE;
+   }
+
+   *pulDirs += ulBottom - oNNode->ulTop + 1;
+   (*pulNodes)++;
+   return TRUE;
+}
+
+/*
+  Returns TRUE if the DT is in a valid state, or FALSE otherwise, in
+  which case it prints an explanation to stderr. Takes time linear in
+  the number of nodes.
+*/
+static boolean DT_isValid(void) {
+   size_t ulDirs = 0;
+   size_t ulFound = 0;
+
+   if(!bIsInitialized) {
+      if(oNRoot != NULL || ulCount != 0 || ulNodes != 0) {
+         fprintf(stderr, "Not initialized, but not empty\n");
+         return FALSE;
+      }
+      return TRUE;
+   }
+   if(oNRoot == NULL) {
+      if(ulCount != 0 || ulNodes != 0) {
+         fprintf(stderr, "No root, but a nonzero count\n");
+         return FALSE;
+      }
+      return TRUE;
+   }
+   if(oNRoot->oNParent != NULL || oNRoot->ulTop != 1) {
+      fprintf(stderr, "The root's chain does not begin the tree\n");
+      return FALSE;
+   }
+   if(!DT_isValidSubtree(oNRoot, &ulDirs, &ulFound))
+      return FALSE;
+   if(ulDirs != ulCount || ulFound != ulNodes) {
+      fprintf(stderr, "The counts do not match the tree\n");
+      return FALSE;
+   }
+   return TRUE;
+}
+#endif
+
+
+/* --------------------------------------------------------------------
+
+  The DT_traversePath and DT_findNode functions modularize the common
+  functionality of going as far as possible down an DT towards a path
+  and returning either the node of however far was reached or the
+  node if the full path was reached, respectively.
+*/
+
+/*
+  Traverses the DT starting at the root as far as possible towards
+  absolute path oPPath. If able to traverse, returns an int SUCCESS
+  status, sets *poNFurthest to the node of the deepest directory
+  reached (or NULL if the root is NULL) and *pulMatched to that
+  directory's depth, which is oPPath's depth if the whole path was
+  reached. Otherwise, sets *poNFurthest to NULL and returns
+  CONFLICTING_PATH, as the root's path is not a prefix of oPPath.
+*/
+static int DT_traversePath(Path_T oPPath, Node_T *poNFurthest,
+                           size_t *pulMatched) {
+   Node_T oNCurr;
+   size_t ulDepth;
+   size_t ulNext = 1;
+   size_t ulIndex;
+
+   assert(oPPath != NULL);
+   assert(poNFurthest != NULL);
+   assert(pulMatched != NULL);
+
+   *pulMatched = 0;
+
+   /* root is NULL -> won't find anything */
+   if(oNRoot == NULL) {
+      *poNFurthest = NULL;
+      return SUCCESS;
+   }
+
+   if(strcmp(DT_getName(oNRoot, 1), Path_getComponent(oPPath, 0))) {
+      *poNFurthest = NULL;
+      return CONFLICTING_PATH;
+   }
+
+   oNCurr = oNRoot;
+   ulDepth = Path_getDepth(oPPath);
+   for(;;) {
+      size_t ulBottom = DT_getBottom(oNCurr);
+
+      /* follow the chain for as long as it matches */
+      while(ulNext <= ulBottom && ulNext <= ulDepth &&
+            !strcmp(DT_getName(oNCurr, ulNext),
+                    Path_getComponent(oPPath, ulNext - 1)))
+         ulNext++;
+
+      /* either the path or the chain leaves off first */
+      if(ulNext <= ulBottom || ulNext > ulDepth)
+         break;
+      if(!DT_findChild(oNCurr, Path_getComponent(oPPath, ulNext - 1),
+                       &ulIndex))
+         break;
+      oNCurr = DynArray_get(oNCurr->oDChildren, ulIndex);
+   }
+
+   *poNFurthest = oNCurr;
+   *pulMatched = ulNext - 1;
+   return SUCCESS;
+}
+
+/*
+  Traverses the DT to find the node of the directory with absolute
+  path pcPath. Returns a int SUCCESS status and sets *poNResult to be
+  the node, and *pulDepth the directory's depth, if found.
+  Otherwise, sets *poNResult to NULL and returns with status:
+  * INITIALIZATION_ERROR if the DT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if no node with pcPath exists in the hierarchy
+  * MEMORY_ERROR if memory could not be allocated to complete request
+ */
+static int DT_findNode(const char *pcPath, Node_T *poNResult,
+                       size_t *pulDepth) {
+   Path_T oPPath = NULL;
+   Node_T oNFound = NULL;
+   size_t ulMatched;
+   int iStatus;
+
+   assert(pcPath != NULL);
+   assert(poNResult != NULL);
+   assert(pulDepth != NULL);
+
+   if(!bIsInitialized) {
+      *poNResult = NULL;
+      return INITIALIZATION_ERROR;
+   }
+
+   iStatus = Path_new(pcPath, &oPPath);
+   if(iStatus != SUCCESS) {
+      *poNResult = NULL;
+      return iStatus;
+   }
+
+   iStatus = DT_traversePath(oPPath, &oNFound, &ulMatched);
+   if(iStatus != SUCCESS)
+   {
+      Path_free(oPPath);
+      *poNResult = NULL;
+      return iStatus;
+   }
+
+   if(oNFound == NULL || ulMatched != Path_getDepth(oPPath)) {
+      Path_free(oPPath);
+      *poNResult = NULL;
+      return NO_SUCH_PATH;
+   }
+
+   Path_free(oPPath);
+   *poNResult = oNFound;
+   *pulDepth = ulMatched;
+   return SUCCESS;
+}
+/*--------------------------------------------------------------------*/
+
+/*
+  Splits oNNode's chain below depth ulDepth, which must be above its
+  deepest directory, into a new node that takes oNNode's place, and
+  gives it two children: the rest of the chain and oNNew. Returns
+  SUCCESS, or MEMORY_ERROR with the tree unchanged.
+*/
+static int DT_split(Node_T oNNode, size_t ulDepth, Node_T oNNew) {
+   Node_T oNUpper = NULL;
+   Path_T oPUpper = NULL;
+   size_t ulIndex = 0;
+   boolean bAfter;
+   int iStatus;
+
+   assert(oNNode != NULL);
+   assert(oNNew != NULL);
+   assert(ulDepth >= oNNode->ulTop && ulDepth < DT_getBottom(oNNode));
+
+   iStatus = Path_prefix(oNNode->oPPath, ulDepth, &oPUpper);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = DT_newNode(oPUpper, oNNode->ulTop, 2, &oNUpper);
+   if(iStatus != SUCCESS) {
+      Path_free(oPUpper);
+      return iStatus;
+   }
+
+   /* the two children, in order */
+   bAfter = strcmp(DT_getName(oNNew, ulDepth + 1),
+                   DT_getName(oNNode, ulDepth + 1)) > 0;
+   (void) DynArray_set(oNUpper->oDChildren, !bAfter, oNNode);
+   (void) DynArray_set(oNUpper->oDChildren, bAfter, oNNew);
+
+   /* oNUpper's shallowest name is oNNode's, so it keeps its place */
+   if(oNNode->oNParent != NULL) {
+      boolean bFound = DT_findChild(oNNode->oNParent,
+                                    DT_getName(oNNode, oNNode->ulTop),
+                                    &ulIndex);
+      assert(bFound);
+      (void) bFound;
+      (void) DynArray_set(oNNode->oNParent->oDChildren, ulIndex,
+                          oNUpper);
+   }
+   else
+      oNRoot = oNUpper;
+   oNUpper->oNParent = oNNode->oNParent;
+   oNNode->oNParent = oNUpper;
+   oNNode->ulTop = ulDepth + 1;
+   oNNew->oNParent = oNUpper;
+   return SUCCESS;
+}
+
+int DT_insert(const char *pcPath) {
+   int iStatus;
+   Path_T oPPath = NULL;
+   Node_T oNCurr = NULL;
+   Node_T oNNew = NULL;
+   size_t ulDepth, ulMatched, ulIndex;
+
+   assert(pcPath != NULL);
+   assert(DT_isValid());
+
+   /* validate pcPath and generate a Path_T for it */
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   iStatus = Path_new(pcPath, &oPPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   /* find the deepest directory of oPPath already in the tree */
+   iStatus = DT_traversePath(oPPath, &oNCurr, &ulMatched);
+   if(iStatus != SUCCESS) {
+      Path_free(oPPath);
+      return iStatus;
+   }
+
+   ulDepth = Path_getDepth(oPPath);
+   if(ulMatched == ulDepth) {
+      Path_free(oPPath);
+      return ALREADY_IN_TREE;
+   }
+
+   /* a chain without children just grows: oPPath becomes its path */
+   if(oNCurr != NULL && ulMatched == DT_getBottom(oNCurr) &&
+      DynArray_getLength(oNCurr->oDChildren) == 0) {
+      Path_free(oNCurr->oPPath);
+      oNCurr->oPPath = oPPath;
+      ulCount += ulDepth - ulMatched;
+      assert(DT_isValid());
+      return SUCCESS;
+   }
+
+   /* otherwise the rest of oPPath is a new chain, owning oPPath */
+   iStatus = DT_newNode(oPPath, ulMatched + 1, 0, &oNNew);
+   if(iStatus != SUCCESS) {
+      Path_free(oPPath);
+      return iStatus;
+   }
+
+   if(oNCurr == NULL) /* new root! */
+      oNRoot = oNNew;
+   else if(ulMatched < DT_getBottom(oNCurr)) {
+      /* oPPath leaves oNCurr's chain partway */
+      iStatus = DT_split(oNCurr, ulMatched, oNNew);
+      if(iStatus != SUCCESS) {
+         (void) DT_freeSubtree(oNNew);
+         assert(DT_isValid());
+         return iStatus;
+      }
+   }
+   else {
+      (void) DT_findChild(oNCurr, DT_getName(oNNew, ulMatched + 1),
+                          &ulIndex);
+      if(!DynArray_addAt(oNCurr->oDChildren, ulIndex, oNNew)) {
+         (void) DT_freeSubtree(oNNew);
+         assert(DT_isValid());
+         return MEMORY_ERROR;
+      }
+      oNNew->oNParent = oNCurr;
+   }
+
+   ulCount += ulDepth - ulMatched;
+   assert(DT_isValid());
+   return SUCCESS;
+}
+
+boolean DT_contains(const char *pcPath) {
+   int iStatus;
+   Node_T oNFound = NULL;
+   size_t ulDepth;
+
+   assert(pcPath != NULL);
+
+   iStatus = DT_findNode(pcPath, &oNFound, &ulDepth);
+   return (boolean) (iStatus == SUCCESS);
+}
+
+
+int DT_rm(const char *pcPath) {
+   int iStatus;
+   Node_T oNFound = NULL;
+   Node_T oNParent;
+   Path_T oPRest = NULL;
+   size_t ulDepth, ulIndex, ulLength;
+
+   assert(pcPath != NULL);
+   assert(DT_isValid());
+
+   iStatus = DT_findNode(pcPath, &oNFound, &ulDepth);
+
+   if(iStatus != SUCCESS)
+       return iStatus;
+
+   /* below the top of its chain: cut the chain short above it */
+   if(ulDepth > oNFound->ulTop) {
+      iStatus = Path_prefix(oNFound->oPPath, ulDepth - 1, &oPRest);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      while((ulLength = DynArray_getLength(oNFound->oDChildren)) != 0)
+         ulCount -= DT_freeSubtree(
+            DynArray_removeAt(oNFound->oDChildren, ulLength - 1));
+      ulCount -= DT_getBottom(oNFound) - ulDepth + 1;
+      Path_free(oNFound->oPPath);
+      oNFound->oPPath = oPRest;
+      assert(DT_isValid());
+      return SUCCESS;
+   }
+
+   /* at the top: the whole node goes, and a parent left with one
+      child merges with it */
+   oNParent = oNFound->oNParent;
+   if(oNParent != NULL) {
+      boolean bFound = DT_findChild(oNParent,
+                                    DT_getName(oNFound, ulDepth),
+                                    &ulIndex);
+      assert(bFound);
+      (void) bFound;
+      (void) DynArray_removeAt(oNParent->oDChildren, ulIndex);
+   }
+   ulCount -= DT_freeSubtree(oNFound);
+   if(oNParent == NULL)
+      oNRoot = NULL;
+   else if(DynArray_getLength(oNParent->oDChildren) == 1)
+      DT_mergeChild(oNParent);
+
+   assert(DT_isValid());
+   return SUCCESS;
+}
+
+int DT_init(void) {
+   assert(DT_isValid());
+
+   if(bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   bIsInitialized = TRUE;
+   oNRoot = NULL;
+   ulCount = 0;
+   ulNodes = 0;
+
+   assert(DT_isValid());
+   return SUCCESS;
+}
+
+int DT_destroy(void) {
+   assert(DT_isValid());
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   if(oNRoot) {
+      ulCount -= DT_freeSubtree(oNRoot);
+      oNRoot = NULL;
+   }
+
+   bIsInitialized = FALSE;
+
+   assert(DT_isValid());
+   return SUCCESS;
+}
+
+
+/* --------------------------------------------------------------------
+
+  The following auxiliary functions are used for generating the
+  string representation of the DT, in which every directory of a
+  chain has its own line.
+*/
+
+/*
+  Performs a pre-order traversal of the tree rooted at n,
+  inserting each node to DynArray_T d beginning at index i.
+  Returns the next unused index in d after the insertion(s).
+*/
+static size_t DT_preOrderTraversal(Node_T n, DynArray_T d, size_t i) {
+   size_t c;
+
+   assert(d != NULL);
+
+   if(n != NULL) {
+      (void) DynArray_set(d, i, n);
+      i++;
+      for(c = 0; c < DynArray_getLength(n->oDChildren); c++)
+         i = DT_preOrderTraversal(DynArray_get(n->oDChildren, c), d, i);
+   }
+   return i;
+}
+
+/*
+  Calls pfLevel once for each directory of oNNode's chain, from the
+  shallowest, with oNNode's pathname, the length of that directory's
+  path (a prefix of it) and pvExtra.
+*/
+static void DT_mapLevels(Node_T oNNode,
+                         void (*pfLevel)(const char *pcPath,
+                                         size_t ulLength,
+                                         void *pvExtra),
+                         void *pvExtra) {
+   const char *pcPath;
+   size_t ulDepth = 1;
+   size_t i;
+
+   assert(oNNode != NULL);
+   assert(pfLevel != NULL);
+
+   pcPath = Path_getPathname(oNNode->oPPath);
+   for(i = 0; pcPath[i] != '\0'; i++)
+      if(pcPath[i] == '/' && ulDepth++ >= oNNode->ulTop)
+         (*pfLevel)(pcPath, i, pvExtra);
+   (*pfLevel)(pcPath, i, pvExtra);
+}
+
+/* Adds the length of one line, ulLength plus a newline, to *pvAcc. */
+static void DT_strlenLevel(const char *pcPath, size_t ulLength,
+                           void *pvAcc) {
+   assert(pcPath != NULL);
+   assert(pvAcc != NULL);
+
+   /* only the length counts */
+   (void) pcPath;
+   *(size_t *) pvAcc += ulLength + 1;
+}
+
+/*
+  Appends the first ulLength characters of pcPath and a newline at
+  *pvEnd, the end of the string being built, and advances it past
+  them.
+*/
+static void DT_strcatLevel(const char *pcPath, size_t ulLength,
+                           void *pvEnd) {
+   char **ppcEnd = pvEnd;
+
+   assert(pcPath != NULL);
+   assert(ppcEnd != NULL);
+
+   memcpy(*ppcEnd, pcPath, ulLength);
+   (*ppcEnd)[ulLength] = '\n';
+   *ppcEnd += ulLength + 1;
+   **ppcEnd = '\0';
+}
+
+/*
+  Alternate version of strlen that uses pulAcc as an in-out parameter
+  to accumulate the length of the lines of oNNode's chain.
+*/
+static void DT_strlenAccumulate(Node_T oNNode, size_t *pulAcc) {
+   assert(pulAcc != NULL);
+
+   if(oNNode != NULL)
+      DT_mapLevels(oNNode, DT_strlenLevel, pulAcc);
+}
+
+/*
+  Alternate version of strcat that appends the lines of oNNode's
+  chain at *ppcEnd, the end of the string being built, and advances
+  *ppcEnd past them.
+*/
+static void DT_strcatAccumulate(Node_T oNNode, char **ppcEnd) {
+   assert(ppcEnd != NULL);
+
+   if(oNNode != NULL)
+      DT_mapLevels(oNNode, DT_strcatLevel, ppcEnd);
+}
+/*--------------------------------------------------------------------*/
+
+char *DT_toString(void) {
+   DynArray_T nodes;
+   size_t totalStrlen = 1;
+   char *result = NULL;
+   char *pcEnd;
+
+   if(!bIsInitialized)
+      return NULL;
+
+   nodes = DynArray_new(ulNodes);
+   if(nodes == NULL)
+      return NULL;
+   (void) DT_preOrderTraversal(oNRoot, nodes, 0);
+
+   DynArray_map(nodes, (void (*)(void *, void*)) DT_strlenAccumulate,
+                (void*) &totalStrlen);
+
+   result = malloc(totalStrlen);
+   if(result == NULL) {
+      DynArray_free(nodes);
+      return NULL;
+   }
+   *result = '\0';
+
+   pcEnd = result;
+   DynArray_map(nodes, (void (*)(void *, void*)) DT_strcatAccumulate,
+                (void *) &pcEnd);
+
+   DynArray_free(nodes);
+
+   return result;
+}
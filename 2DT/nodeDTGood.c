@@ -180,9 +180,11 @@ size_t Node_free(Node_T oNNode) {
                                   ulIndex);
    }
 
-   /* recursively remove children */
+   /* recursively remove children, last first, so that removing each
+      from the children array does not shift the rest */
    while(DynArray_getLength(oNNode->oDChildren) != 0) {
-      ulCount += Node_free(DynArray_get(oNNode->oDChildren, 0));
+      ulCount += Node_free(DynArray_get(oNNode->oDChildren,
+                     DynArray_getLength(oNNode->oDChildren) - 1));
    }
    DynArray_free(oNNode->oDChildren);
 
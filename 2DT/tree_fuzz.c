@@ -0,0 +1 @@
+../0shared/tree_fuzz.c
\ No newline at end of file
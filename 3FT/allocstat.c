@@ -0,0 +1 @@
+../0shared/allocstat.c
\ No newline at end of file
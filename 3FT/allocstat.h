@@ -0,0 +1 @@
+../0shared/allocstat.h
\ No newline at end of file
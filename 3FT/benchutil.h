@@ -0,0 +1 @@
+../0shared/benchutil.h
\ No newline at end of file
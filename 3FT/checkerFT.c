@@ -0,0 +1,584 @@
+/*--------------------------------------------------------------------*/
+/* checkerFT.c                                                        */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "checkerFT.h"
+#include "ftimage.h"
+#include "path.h"
+
+#ifndef CHECKERFT_THREADS
+#define CHECKERFT_THREADS 1
+#endif
+#ifndef CHECKERFT_FULL_INTERVAL
+#define CHECKERFT_FULL_INTERVAL 1024
+#endif
+/* The most threads CheckerFT_isValid can use */
+enum {MAX_THREADS = 64};
+
+/* How many threads CheckerFT_isValid may use, including its caller */
+static size_t ulThreads = CHECKERFT_THREADS;
+
+/* The path checks' mode, and how often scoped ones check everything */
+#if defined(CHECKERFT_SCOPED)
+static enum checkerMode eMode = CHECKER_SCOPED;
+#else
+static enum checkerMode eMode = CHECKER_FULL;
+#endif
+static size_t ulFullInterval = CHECKERFT_FULL_INTERVAL;
+/* The scoped checks made since the last full one */
+static size_t ulSinceFull;
+
+/*
+   One thread's share of the subtrees of oNRoot's children: those of
+   children ulFirst, ulFirst + ulStride, ulFirst + 2 * ulStride, ...
+   with whether they were valid and how many nodes they hold.
+*/
+struct share {
+   Node_T oNRoot;
+   size_t ulFirst;
+   size_t ulStride;
+   size_t ulCount;
+   size_t ulVisited;
+   boolean bValid;
+};
+
+/*
+   Returns TRUE if oNNode's parent, if any, is a directory with a path
+   that is the longest possible proper prefix of oNNode's path, or
+   FALSE otherwise. Prints explanation to stderr in the latter case.
+*/
+static boolean CheckerFT_parentCheck(Node_T oNNode) {
+   Node_T oNParent;
+   Path_T oPNPath;
+   Path_T oPPPath;
+   size_t ulPLength;
+
+   oNParent = Node_getParent(oNNode);
+   if(oNParent != NULL) {
+      oPNPath = Node_getPath(oNNode);
+      oPPPath = Node_getPath(oNParent);
+
+      if(Node_getType(oNParent) != DIRECTORY) {
+         fprintf(stderr, "A file has a child: (%s) (%s)\n",
+                 Path_getPathname(oPPPath), Path_getPathname(oPNPath));
+         return FALSE;
+      }
+
+      /* one component deeper, with the parent's path as a string
+         prefix up to a '/' */
+      ulPLength = Path_getStrLength(oPPPath);
+      if(Path_getDepth(oPNPath) != Path_getDepth(oPPPath) + 1 ||
+         strncmp(Path_getPathname(oPPPath), Path_getPathname(oPNPath),
+                 ulPLength) != 0 ||
+         Path_getPathname(oPNPath)[ulPLength] != '/') {
+         fprintf(stderr, "P-C nodes don't have P-C paths: (%s) (%s)\n",
+                 Path_getPathname(oPPPath), Path_getPathname(oPNPath));
+         return FALSE;
+      }
+   }
+   return TRUE;
+}
+
+/*
+   Returns TRUE if the lengths oNNode reports agree with each other,
+   or FALSE otherwise. Prints explanation to stderr in the latter case.
+*/
+static boolean CheckerFT_lengthCheck(Node_T oNNode) {
+   Path_T oPPath = Node_getPath(oNNode);
+   size_t ulRecord;
+   size_t ulChildren;
+   size_t ulSlack;
+
+   if(Path_getStrLength(oPPath) != strlen(Path_getPathname(oPPath))) {
+      fprintf(stderr, "A path's length is not its string's: (%s)\n",
+              Path_getPathname(oPPath));
+      return FALSE;
+   }
+
+   Node_getMemory(oNNode, &ulRecord, &ulChildren, &ulSlack);
+   if(ulSlack > ulChildren) {
+      fprintf(stderr, "A node has more room for children than it "
+              "allocated: (%s)\n", Path_getPathname(oPPath));
+      return FALSE;
+   }
+   if(Node_getType(oNNode) == FILE_NODE) {
+      if(ulChildren != 0) {
+         fprintf(stderr, "A file has room for children: (%s)\n",
+                 Path_getPathname(oPPath));
+         return FALSE;
+      }
+   }
+   /* the children of a stub have not been allocated yet */
+   else if(Node_getStub(oNNode) == NULL &&
+           ulChildren - ulSlack <
+           Node_getNumChildren(oNNode) * sizeof(Node_T)) {
+      fprintf(stderr, "A directory has more children than room for "
+              "them: (%s)\n", Path_getPathname(oPPath));
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+   Returns TRUE if oNNode itself is valid, as CheckerFT_Node_isValid
+   checks it but without looking at its children, or FALSE otherwise.
+   Prints explanation to stderr in the latter case.
+*/
+static boolean CheckerFT_entryCheck(Node_T oNNode) {
+   /* Sample check: a NULL pointer is not a valid node */
+   if(oNNode == NULL) {
+      fprintf(stderr, "A node is a NULL pointer\n");
+      return FALSE;
+   }
+
+   if(Node_getPath(oNNode) == NULL) {
+      fprintf(stderr, "A node has no path\n");
+      return FALSE;
+   }
+
+   /* parent must be a directory whose path is the longest possible
+      proper prefix of the node's path */
+   if(!CheckerFT_parentCheck(oNNode))
+      return FALSE;
+
+   if(!CheckerFT_lengthCheck(oNNode))
+      return FALSE;
+
+   /* files are leaves */
+   if(Node_getType(oNNode) == FILE_NODE) {
+      if(Node_getStub(oNNode) != NULL) {
+         fprintf(stderr, "A file is a stub: (%s)\n",
+                 Path_getPathname(Node_getPath(oNNode)));
+         return FALSE;
+      }
+      if(Node_getNumChildren(oNNode) != 0) {
+         fprintf(stderr, "A file has children: (%s)\n",
+                 Path_getPathname(Node_getPath(oNNode)));
+         return FALSE;
+      }
+      return TRUE;
+   }
+
+   if(Node_getStub(oNNode) != NULL &&
+      Image_getStubCount(Node_getStub(oNNode)) == 0) {
+      fprintf(stderr, "A stub stands for no nodes: (%s)\n",
+              Path_getPathname(Node_getPath(oNNode)));
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+   Returns TRUE if children ulFirst to ulLast of directory oNNode are
+   stored in strictly increasing lexicographical order, or FALSE
+   otherwise. Prints explanation to stderr in the latter case.
+*/
+static boolean CheckerFT_orderCheck(Node_T oNNode, size_t ulFirst,
+                                    size_t ulLast) {
+   size_t i;
+   Node_T prevChild = NULL;
+   Node_T currChild = NULL;
+
+   for(i = ulFirst + 1; i <= ulLast; i++)
+   {
+      int iCompare;
+
+      if(Node_getChild(oNNode, i-1, &prevChild) != SUCCESS ||
+         Node_getChild(oNNode, i, &currChild) != SUCCESS) {
+         fprintf(stderr, "getNumChildren claims more children than "
+                 "getChild returns\n");
+         return FALSE;
+      }
+      iCompare = Path_comparePath(Node_getPath(prevChild),
+                                  Node_getPath(currChild));
+      if(iCompare > 0)
+      {
+         fprintf(stderr, "Children not stored lexicographically\n");
+         return FALSE;
+      }
+      if(iCompare == 0)
+      {
+         fprintf(stderr, "Duplicate children for node: (%s)\n",
+                 Path_getPathname(Node_getPath(oNNode)));
+         return FALSE;
+      }
+   }
+   return TRUE;
+}
+
+/* see checkerFT.h for specification */
+boolean CheckerFT_Node_isValid(Node_T oNNode) {
+   if(!CheckerFT_entryCheck(oNNode))
+      return FALSE;
+
+   /* files are leaves, and looking at a stub's children would
+      materialize it */
+   if(Node_getType(oNNode) == FILE_NODE ||
+      Node_getStub(oNNode) != NULL ||
+      Node_getNumChildren(oNNode) == 0)
+      return TRUE;
+
+   /* Check that a node's children are stored in strictly increasing
+      lexicographical order, whatever their types. FT_toString lists
+      the file children and then the directory children in stored
+      order, so each of those lists is then in order too, and no name
+      can be both a file and a directory. */
+   return CheckerFT_orderCheck(oNNode, 0,
+                               Node_getNumChildren(oNNode) - 1);
+}
+
+/*
+   Returns TRUE if oNChild, child ulChildID of oNParent, links back to
+   oNParent, or FALSE otherwise. Prints explanation to stderr in the
+   latter case.
+*/
+static boolean CheckerFT_childCheck(Node_T oNParent, size_t ulChildID,
+                                    Node_T *poNChild) {
+   if(Node_getChild(oNParent, ulChildID, poNChild) != SUCCESS) {
+      fprintf(stderr, "getNumChildren claims more children than "
+              "getChild returns\n");
+      return FALSE;
+   }
+   if(Node_getParent(*poNChild) != oNParent) {
+      fprintf(stderr, "The parent of the child of a node "
+              "(getParent of getChild of the node) didn't return the "
+              "original node.\n");
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+   Performs a pre-order traversal of the tree rooted at oNNode,
+   checking each node with CheckerFT_Node_isValid and each child's
+   link back to its parent, and adding the number of nodes visited to
+   *pulVisited, counting a stub as the nodes it stands for. Returns
+   FALSE if a broken invariant is found and returns TRUE otherwise.
+   Stops once more than ulCount nodes have been visited, which the
+   caller reports as a count mismatch, so that a cycle cannot make it
+   run forever.
+*/
+static boolean CheckerFT_treeCheck(Node_T oNNode, size_t ulCount,
+                                   size_t *pulVisited) {
+   size_t ulIndex;
+
+   if(oNNode != NULL) {
+
+      if(*pulVisited > ulCount)
+         return TRUE;
+
+      if(!CheckerFT_Node_isValid(oNNode))
+         return FALSE;
+
+      if(Node_getStub(oNNode) != NULL) {
+         *pulVisited += Image_getStubCount(Node_getStub(oNNode));
+         return TRUE;
+      }
+      ++*pulVisited;
+
+      /* Recur on every child of oNNode */
+      for(ulIndex = 0; ulIndex < Node_getNumChildren(oNNode); ulIndex++)
+      {
+         Node_T oNChild = NULL;
+
+         if(!CheckerFT_childCheck(oNNode, ulIndex, &oNChild))
+            return FALSE;
+
+         if(!CheckerFT_treeCheck(oNChild, ulCount, pulVisited))
+            return FALSE;
+      }
+   }
+   return TRUE;
+}
+
+/*
+   Checks the subtrees of share pvShare (a struct share), as
+   CheckerFT_treeCheck does, and records the outcome in it. Returns
+   NULL.
+*/
+static void *CheckerFT_shareCheck(void *pvShare) {
+   struct share *psShare = pvShare;
+   size_t ulIndex;
+
+   psShare->bValid = TRUE;
+   for(ulIndex = psShare->ulFirst;
+       ulIndex < Node_getNumChildren(psShare->oNRoot) &&
+          psShare->bValid;
+       ulIndex += psShare->ulStride) {
+      Node_T oNChild = NULL;
+
+      psShare->bValid =
+         CheckerFT_childCheck(psShare->oNRoot, ulIndex, &oNChild) &&
+         CheckerFT_treeCheck(oNChild, psShare->ulCount,
+                             &psShare->ulVisited);
+   }
+   return NULL;
+}
+
+/*
+   Checks the subtrees of oNRoot's children, as CheckerFT_treeCheck
+   does, on up to ulThreads threads, adding the nodes visited to
+   *pulVisited. Nothing is changed while the threads run, as no stub
+   is materialized. A thread that cannot be created has its share
+   checked by the caller instead.
+*/
+static boolean CheckerFT_parallelCheck(Node_T oNRoot, size_t ulCount,
+                                       size_t *pulVisited) {
+   struct share asShares[MAX_THREADS];
+   pthread_t aoThreads[MAX_THREADS];
+   boolean abStarted[MAX_THREADS];
+   size_t ulShares = ulThreads;
+   size_t t;
+   boolean bValid = TRUE;
+
+   if(ulShares > MAX_THREADS)
+      ulShares = MAX_THREADS;
+   if(ulShares > Node_getNumChildren(oNRoot))
+      ulShares = Node_getNumChildren(oNRoot);
+
+   for(t = 0; t < ulShares; t++) {
+      asShares[t].oNRoot = oNRoot;
+      asShares[t].ulFirst = t;
+      asShares[t].ulStride = ulShares;
+      asShares[t].ulCount = ulCount;
+      asShares[t].ulVisited = 0;
+      asShares[t].bValid = TRUE;
+      /* the caller takes share 0 */
+      abStarted[t] = t > 0 &&
+         pthread_create(&aoThreads[t], NULL, CheckerFT_shareCheck,
+                        &asShares[t]) == 0;
+   }
+
+   for(t = 0; t < ulShares; t++) {
+      if(abStarted[t])
+         (void) pthread_join(aoThreads[t], NULL);
+      else
+         (void) CheckerFT_shareCheck(&asShares[t]);
+      bValid = bValid && asShares[t].bValid;
+      *pulVisited += asShares[t].ulVisited;
+   }
+   return bValid;
+}
+
+/*
+   Returns TRUE if the top-level invariants relating bIsInitialized,
+   oNRoot and ulCount hold, or FALSE otherwise. Prints explanation to
+   stderr in the latter case.
+*/
+static boolean CheckerFT_topCheck(boolean bIsInitialized, Node_T oNRoot,
+                                  size_t ulCount) {
+   if(!bIsInitialized){
+      if(ulCount != 0) {
+         fprintf(stderr, "Not initialized, but count is not 0\n");
+         return FALSE;
+      }
+      if(oNRoot != NULL) {
+         fprintf(stderr, "Not initialized, but root is not NULL\n");
+         return FALSE;
+      }
+   }
+
+   if((oNRoot == NULL) != (ulCount == 0)) {
+      fprintf(stderr, "Given ulCount does not match actual number of "
+          "nodes in FT.\n");
+      return FALSE;
+   }
+
+   if(oNRoot != NULL) {
+      if(Node_getParent(oNRoot) != NULL) {
+         fprintf(stderr, "The root has a parent\n");
+         return FALSE;
+      }
+      if(Node_getType(oNRoot) != DIRECTORY) {
+         fprintf(stderr, "The root is a file\n");
+         return FALSE;
+      }
+   }
+   return TRUE;
+}
+
+/*
+   Checks every node of the hierarchy, as CheckerFT_isValid does.
+*/
+static boolean CheckerFT_fullCheck(boolean bIsInitialized,
+                                   Node_T oNRoot, size_t ulCount) {
+   size_t ulVisited = 0;
+
+   ulSinceFull = 0;
+   if(!CheckerFT_topCheck(bIsInitialized, oNRoot, ulCount))
+      return FALSE;
+
+   /* Now checks invariants recursively at each node from the root,
+      counting the nodes as it goes; with more than one thread, the
+      root is checked here and its children's subtrees in parallel */
+   if(ulThreads > 1 && oNRoot != NULL && Node_getStub(oNRoot) == NULL &&
+      Node_getNumChildren(oNRoot) > 1) {
+      if(!CheckerFT_Node_isValid(oNRoot))
+         return FALSE;
+      ulVisited = 1;
+      if(!CheckerFT_parallelCheck(oNRoot, ulCount, &ulVisited))
+         return FALSE;
+   }
+   else if(!CheckerFT_treeCheck(oNRoot, ulCount, &ulVisited))
+      return FALSE;
+
+   if(ulCount != ulVisited){
+      fprintf(stderr, "Given ulCount does not match actual number of "
+          "nodes in FT.\n");
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
+/* see checkerFT.h for specification */
+boolean CheckerFT_isValid(boolean bIsInitialized, Node_T oNRoot,
+                          size_t ulCount) {
+   return CheckerFT_fullCheck(bIsInitialized, oNRoot, ulCount);
+}
+
+/*
+   Returns TRUE if the children of directory oNParent around where
+   child ulIndex is or would be (ulIndex - 2 to ulIndex + 1, so that
+   there are two even at the end) link back to it, are its children
+   by path, and are in order, or FALSE otherwise. Prints explanation
+   to stderr in the latter case.
+*/
+static boolean CheckerFT_neighbourCheck(Node_T oNParent,
+                                        size_t ulIndex) {
+   size_t ulFirst = ulIndex < 2 ? 0 : ulIndex - 2;
+   size_t ulLast = ulIndex + 1;
+   size_t i;
+
+   if(ulLast >= Node_getNumChildren(oNParent))
+      ulLast = Node_getNumChildren(oNParent) - 1;
+   for(i = ulFirst; i <= ulLast; i++) {
+      Node_T oNChild = NULL;
+
+      if(!CheckerFT_childCheck(oNParent, i, &oNChild) ||
+         !CheckerFT_parentCheck(oNChild))
+         return FALSE;
+   }
+   return CheckerFT_orderCheck(oNParent, ulFirst, ulLast);
+}
+
+/*
+   Sets *pulIndex to the position among the children of directory
+   oNParent of the one whose path is the first ulPrefix characters of
+   pcPath, or to where it would be, and returns whether it is there.
+   Compares each child's path with pcPath up to ulPrefix, so that no
+   Path_T need be made.
+*/
+static boolean CheckerFT_findChild(Node_T oNParent, const char *pcPath,
+                                   size_t ulPrefix, size_t *pulIndex) {
+   size_t ulLow = 0;
+   size_t ulHigh = Node_getNumChildren(oNParent);
+
+   while(ulLow < ulHigh) {
+      size_t ulMid = ulLow + (ulHigh - ulLow) / 2;
+      Node_T oNChild = NULL;
+      const char *pcChild;
+      int iCompare;
+
+      (void) Node_getChild(oNParent, ulMid, &oNChild);
+      pcChild = Path_getPathname(Node_getPath(oNChild));
+      iCompare = strncmp(pcChild, pcPath, ulPrefix);
+      if(iCompare == 0 && pcChild[ulPrefix] != '\0')
+         iCompare = 1;
+      if(iCompare == 0) {
+         *pulIndex = ulMid;
+         return TRUE;
+      }
+      if(iCompare < 0)
+         ulLow = ulMid + 1;
+      else
+         ulHigh = ulMid;
+   }
+   *pulIndex = ulLow;
+   return FALSE;
+}
+
+/*
+   Returns TRUE if pcPrefix, of ulLength characters, is pcPath or its
+   first components, or FALSE otherwise.
+*/
+static boolean CheckerFT_isPrefix(const char *pcPrefix, size_t ulLength,
+                                  const char *pcPath) {
+   return strncmp(pcPrefix, pcPath, ulLength) == 0 &&
+      (pcPath[ulLength] == '\0' || pcPath[ulLength] == '/');
+}
+
+/* see checkerFT.h for specification */
+boolean CheckerFT_isValidPath(boolean bIsInitialized, Node_T oNRoot,
+                              size_t ulCount, const char *pcPath) {
+   Node_T oNCurr = oNRoot;
+   size_t ulLength;
+
+   if(eMode == CHECKER_FULL ||
+      (ulFullInterval != 0 && ++ulSinceFull >= ulFullInterval))
+      return CheckerFT_fullCheck(bIsInitialized, oNRoot, ulCount);
+   if(!CheckerFT_topCheck(bIsInitialized, oNRoot, ulCount))
+      return FALSE;
+   if(oNRoot == NULL || pcPath == NULL)
+      return TRUE;
+
+   if(!CheckerFT_entryCheck(oNRoot))
+      return FALSE;
+   ulLength = Path_getStrLength(Node_getPath(oNRoot));
+   if(!CheckerFT_isPrefix(Path_getPathname(Node_getPath(oNRoot)),
+                          ulLength, pcPath))
+      return TRUE;
+
+   /* descend along pcPath one component at a time, checking each
+      node on the way and its neighbours among its parent's children,
+      until the path leaves the hierarchy or reaches a file or a stub,
+      whose children are not looked at */
+   while(pcPath[ulLength] != '\0' &&
+         Node_getType(oNCurr) == DIRECTORY &&
+         Node_getStub(oNCurr) == NULL) {
+      const char *pcEnd = strchr(pcPath + ulLength + 1, '/');
+      size_t ulPrefix = pcEnd == NULL ? strlen(pcPath) :
+         (size_t) (pcEnd - pcPath);
+      size_t ulIndex;
+      boolean bFound;
+      Node_T oNChild = NULL;
+
+      if(Node_getNumChildren(oNCurr) == 0)
+         return TRUE;
+      bFound = CheckerFT_findChild(oNCurr, pcPath, ulPrefix, &ulIndex);
+      if(!CheckerFT_neighbourCheck(oNCurr, ulIndex))
+         return FALSE;
+      if(!bFound)
+         return TRUE;
+      (void) Node_getChild(oNCurr, ulIndex, &oNChild);
+      if(!CheckerFT_entryCheck(oNChild))
+         return FALSE;
+      oNCurr = oNChild;
+      ulLength = ulPrefix;
+   }
+
+   /* the node at pcPath itself, with all its children */
+   return pcPath[ulLength] != '\0' || CheckerFT_Node_isValid(oNCurr);
+}
+
+/* see checkerFT.h for specification */
+void CheckerFT_setMode(enum checkerMode eNewMode,
+                       size_t ulNewFullInterval) {
+   assert(eNewMode == CHECKER_FULL || eNewMode == CHECKER_SCOPED);
+
+   eMode = eNewMode;
+   ulFullInterval = ulNewFullInterval;
+   ulSinceFull = 0;
+}
+
+/* see checkerFT.h for specification */
+void CheckerFT_setThreads(size_t ulNewThreads) {
+   assert(ulNewThreads > 0);
+
+   ulThreads = ulNewThreads < MAX_THREADS ? ulNewThreads : MAX_THREADS;
+}
@@ -0,0 +1,82 @@
+/*--------------------------------------------------------------------*/
+/* checkerFT.h                                                        */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef CHECKERFT_INCLUDED
+#define CHECKERFT_INCLUDED
+
+#include "nodeFT.h"
+#include "ft.h"
+
+
+/*
+   Returns TRUE if oNNode represents a file or directory entry in a
+   valid state, or FALSE otherwise. Prints explanation to stderr in
+   the latter case. The children of a directory that is still a stub
+   (see Node_getStub) are not examined, so it is never materialized.
+*/
+boolean CheckerFT_Node_isValid(Node_T oNNode);
+
+/*
+   Returns TRUE if the hierarchy is in a valid state or FALSE
+   otherwise.  Prints explanation to stderr in the latter case.
+   The data structure's validity is based on a boolean
+   bIsInitialized indicating whether the FT is in an initialized
+   state, a Node_T oNRoot representing the root of the hierarchy, and
+   a size_t ulCount representing the total number of files and
+   directories in the hierarchy, including those a stub stands for.
+   Takes time linear in the number of nodes in memory; the subtrees
+   of oNRoot's children are checked by as many threads as
+   CheckerFT_setThreads allows.
+*/
+boolean CheckerFT_isValid(boolean bIsInitialized,
+                          Node_T oNRoot,
+                          size_t ulCount);
+
+/*
+   Returns TRUE if the hierarchy is in a valid state around pcPath,
+   the path an operation is about to change or has just changed, or
+   FALSE otherwise. Prints explanation to stderr in the latter case.
+   In CHECKER_FULL mode this is CheckerFT_isValid. In CHECKER_SCOPED
+   mode only the top-level invariants, each node on the way from
+   oNRoot to pcPath with its neighbours among its parent's children,
+   and the node at pcPath with its children are checked, in time
+   O(d log n) for a path of depth d in directories of at most n
+   children (plus the children of the node at pcPath), except on the
+   periodic full checks. Stubs on the way are not materialized.
+*/
+boolean CheckerFT_isValidPath(boolean bIsInitialized,
+                              Node_T oNRoot,
+                              size_t ulCount,
+                              const char *pcPath);
+
+/* How much of the hierarchy CheckerFT_isValidPath examines */
+enum checkerMode {
+   /* every node, on every call */
+   CHECKER_FULL,
+   /* the nodes around the path, and every node once every
+      ulFullInterval calls (never if ulFullInterval is 0) */
+   CHECKER_SCOPED
+};
+
+/*
+   Sets CheckerFT_isValidPath's mode to eMode, with a full check every
+   ulFullInterval calls in CHECKER_SCOPED mode. The mode is
+   CHECKER_FULL unless checkerFT.c is compiled with
+   -D CHECKERFT_SCOPED, which selects CHECKER_SCOPED with a full check
+   every CHECKERFT_FULL_INTERVAL (by default 1024) calls.
+   CheckerFT_isValid always checks every node.
+*/
+void CheckerFT_setMode(enum checkerMode eMode, size_t ulFullInterval);
+
+/*
+   Sets CheckerFT_isValid to divide the subtrees of the root's
+   children among at most ulThreads (> 0, and at most 64) threads,
+   including its caller. It uses CHECKERFT_THREADS threads (by
+   default 1) unless this is called. More threads only help a
+   hierarchy whose root has many children of similar size.
+*/
+void CheckerFT_setThreads(size_t ulThreads);
+
+#endif
@@ -3,20 +3,31 @@
 /* Authors: Thomas Zhang and Maia Abiani                              */
 /*--------------------------------------------------------------------*/
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stddef.h>
 #include <assert.h>
+#include <limits.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef FT_LATENCY
+#include <pthread.h>
+#include <time.h>
+#endif
 
 #include "dynarray.h"
 #include "path.h"
 #include "nodeFT.h"
 #include "ft.h"
+#include "ftdisk.h"
+#include "fttar.h"
+#include "ftimage.h"
+#include "checkerFT.h"
 
 /*
   A Directory Tree is a representation of a hierarchy of directories,
-  represented as an AO with 3 state variables:
+  represented as an AO with 9 state variables:
 */
 
 /* 1. a flag for being in an initialized state (TRUE) or not (FALSE) */
@@ -25,6 +36,421 @@ static boolean bIsInitialized;
 static Node_T oNRoot;
 /* 3. a counter of the number of nodes in the hierarchy */
 static size_t ulCount;
+/* 4. the images loaded since initialization (NULL if none), which
+   must stay mapped while loaded nodes and contents may be in use */
+static DynArray_T oDImages;
+/* 5. the spill that cold directories are evicted to (NULL unless
+   FT_setResidentLimit has been called) */
+static Image_T oISpill;
+/* 6. the most nodes to keep in memory when there is a spill */
+static size_t ulMaxResident;
+/* 7. a clock that advances with every traversal, for stamping nodes
+   with when they were last used */
+static size_t ulClock;
+/* 8. in a bulk phase (see FT_beginBulk), the directories inserted
+   into since they were last sorted; NULL outside a bulk phase */
+static DynArray_T oDBulkDirs;
+/* 9. in a bulk phase, the table of the nodes inserted since then and
+   of the directories they were inserted into and those directories'
+   children, and how many slots it has and how many are used */
+static struct bulkEntry *psBulkTable;
+static size_t ulBulkSlots;
+static size_t ulBulkUsed;
+
+/* A slot of the bulk phase's table, which is keyed by path */
+struct bulkEntry {
+   /* the node, or NULL if the slot is empty */
+   Node_T oNNode;
+   /* the hash of the node's path */
+   unsigned long ulHash;
+   /* TRUE if the node is a directory whose children are all in the
+      table, and may be out of order */
+   boolean bOpen;
+};
+
+/* The fewest slots the bulk phase's table grows to */
+enum { MIN_BULK_SLOTS = 64 };
+
+/*
+  A materialized directory considered for eviction, with the key it
+  is evicted in order of: least recently used first, and among equally
+  recent ones, descendants before ancestors.
+*/
+struct victim {
+   Node_T oNDir;
+   size_t ulStamp;
+   size_t ulOrder;
+};
+
+/*
+  Compares two victims by eviction order.
+  Returns <0, 0, or >0 if pvFirst is to be evicted before, with, or
+  after pvSecond, respectively.
+*/
+static int FT_compareVictims(const void *pvFirst,
+                             const void *pvSecond) {
+   const struct victim *psFirst = pvFirst;
+   const struct victim *psSecond = pvSecond;
+
+   if(psFirst->ulStamp != psSecond->ulStamp)
+      return psFirst->ulStamp < psSecond->ulStamp ? -1 : 1;
+   if(psFirst->ulOrder != psSecond->ulOrder)
+      return psFirst->ulOrder < psSecond->ulOrder ? -1 : 1;
+   return 0;
+}
+
+/*
+  Adds every materialized directory strictly beneath oNDir to the
+  ulUsed entries of the psVictims array, of *pulSize entries, growing
+  it as needed, in post-order. Returns the new number of entries, or
+  sets *ppsVictims to NULL (after freeing it) if memory runs out.
+*/
+static size_t FT_collectVictims(Node_T oNDir,
+                                struct victim **ppsVictims,
+                                size_t ulUsed, size_t *pulSize) {
+   size_t c;
+   Node_T oNChild = NULL;
+
+   assert(oNDir != NULL);
+   assert(ppsVictims != NULL);
+   assert(pulSize != NULL);
+
+   for(c = 0; c < Node_getNumChildren(oNDir) && *ppsVictims != NULL;
+       c++) {
+      (void) Node_getChild(oNDir, c, &oNChild);
+      if(Node_getType(oNChild) != DIRECTORY ||
+         Node_getStub(oNChild) != NULL)
+         continue;
+
+      ulUsed = FT_collectVictims(oNChild, ppsVictims, ulUsed, pulSize);
+      if(*ppsVictims == NULL)
+         break;
+      if(ulUsed == *pulSize) {
+         struct victim *psGrown = realloc(*ppsVictims,
+                                 2 * *pulSize * sizeof(struct victim));
+         if(psGrown == NULL) {
+            free(*ppsVictims);
+            *ppsVictims = NULL;
+            break;
+         }
+         *ppsVictims = psGrown;
+         *pulSize *= 2;
+      }
+      (*ppsVictims)[ulUsed].oNDir = oNChild;
+      (*ppsVictims)[ulUsed].ulStamp = Node_getStamp(oNChild);
+      (*ppsVictims)[ulUsed].ulOrder = ulUsed;
+      ulUsed++;
+   }
+   return ulUsed;
+}
+
+/*
+  If more than ulMaxResident nodes are in memory, spills the least
+  recently used directories beneath the root to oISpill until no more
+  than half that many are. Since a traversal stamps every node on its
+  path, a directory is never more recently used than its parent, so
+  this evicts subtrees bottom-up. Eviction is only an optimization:
+  if it fails, the nodes simply stay in memory.
+  Must only be called between operations, while no Node_T is held.
+*/
+static void FT_evict(void) {
+   struct victim *psVictims;
+   size_t ulSize = 64;
+   size_t ulUsed;
+   size_t i;
+
+   /* the bulk phase's table points to nodes that eviction frees */
+   if(oISpill == NULL || oNRoot == NULL || oDBulkDirs != NULL ||
+      Node_getResidentCount() <= ulMaxResident)
+      return;
+
+   psVictims = malloc(ulSize * sizeof(struct victim));
+   if(psVictims == NULL)
+      return;
+   ulUsed = FT_collectVictims(oNRoot, &psVictims, 0, &ulSize);
+   if(psVictims == NULL)
+      return;
+
+   qsort(psVictims, ulUsed, sizeof(struct victim), FT_compareVictims);
+   for(i = 0; i < ulUsed &&
+          Node_getResidentCount() > ulMaxResident / 2; i++) {
+      /* descendants come before their ancestors, so no victim has
+         been freed along with an ancestor by the time it is reached */
+      if(Image_spill(oISpill, psVictims[i].oNDir) != SUCCESS)
+         break;
+   }
+   free(psVictims);
+}
+
+/* --------------------------------------------------------------------
+
+  The bulk phase functions keep the table that FT_beginBulk's inserts
+  find nodes through while their parents' children are out of order.
+*/
+
+/* Returns a 64-bit FNV-1a hash of string pcString. */
+static unsigned long FT_hashPath(const char *pcString) {
+   unsigned long ulHash = 14695981039346656037UL;
+
+   assert(pcString != NULL);
+
+   while(*pcString != '\0') {
+      ulHash ^= (unsigned char) *pcString++;
+      ulHash *= 1099511628211UL;
+   }
+   return ulHash;
+}
+
+/*
+  Returns the slot of the bulk phase's table that holds the node with
+  path pcPath, whose hash is ulHash, or the empty slot it would go in.
+  The table must have at least one empty slot.
+*/
+static struct bulkEntry *FT_bulkSlot(const char *pcPath,
+                                     unsigned long ulHash) {
+   size_t i;
+
+   assert(pcPath != NULL);
+   assert(ulBulkUsed < ulBulkSlots);
+
+   /* ulBulkSlots is a power of two, so the mask wraps the probe */
+   for(i = ulHash & (ulBulkSlots - 1);
+       psBulkTable[i].oNNode != NULL;
+       i = (i + 1) & (ulBulkSlots - 1))
+      if(psBulkTable[i].ulHash == ulHash &&
+         !strcmp(Path_getPathname(Node_getPath(psBulkTable[i].oNNode)),
+                 pcPath))
+         break;
+   return &psBulkTable[i];
+}
+
+/*
+  Returns the entry of the bulk phase's table for the node with path
+  pcPath, or NULL if there is none (or no table).
+*/
+static struct bulkEntry *FT_bulkFind(const char *pcPath) {
+   struct bulkEntry *psEntry;
+
+   assert(pcPath != NULL);
+
+   if(psBulkTable == NULL)
+      return NULL;
+   psEntry = FT_bulkSlot(pcPath, FT_hashPath(pcPath));
+   return psEntry->oNNode == NULL ? NULL : psEntry;
+}
+
+/*
+  Adds oNNode to the bulk phase's table, or updates its entry, marking
+  it open if bOpen, growing the table if needed. Returns SUCCESS, or
+  MEMORY_ERROR with the table unchanged.
+*/
+static int FT_bulkAdd(Node_T oNNode, boolean bOpen) {
+   const char *pcPath;
+   unsigned long ulHash;
+   struct bulkEntry *psEntry;
+
+   assert(oNNode != NULL);
+
+   /* keep at least half the slots empty, so probes stay short */
+   if(2 * (ulBulkUsed + 1) > ulBulkSlots) {
+      size_t ulNewSlots = ulBulkSlots < MIN_BULK_SLOTS ?
+         MIN_BULK_SLOTS : 2 * ulBulkSlots;
+      struct bulkEntry *psOld = psBulkTable;
+      size_t ulOldSlots = ulBulkSlots;
+      size_t i;
+
+      psBulkTable = calloc(ulNewSlots, sizeof(struct bulkEntry));
+      if(psBulkTable == NULL) {
+         psBulkTable = psOld;
+         return MEMORY_ERROR;
+      }
+      ulBulkSlots = ulNewSlots;
+      for(i = 0; i < ulOldSlots; i++)
+         if(psOld[i].oNNode != NULL)
+            *FT_bulkSlot(Path_getPathname(
+                            Node_getPath(psOld[i].oNNode)),
+                         psOld[i].ulHash) = psOld[i];
+      free(psOld);
+   }
+
+   pcPath = Path_getPathname(Node_getPath(oNNode));
+   ulHash = FT_hashPath(pcPath);
+   psEntry = FT_bulkSlot(pcPath, ulHash);
+   if(psEntry->oNNode == NULL) {
+      psEntry->oNNode = oNNode;
+      psEntry->ulHash = ulHash;
+      psEntry->bOpen = FALSE;
+      ulBulkUsed++;
+   }
+   if(bOpen)
+      psEntry->bOpen = TRUE;
+   return SUCCESS;
+}
+
+/*
+  Makes directory oNDir open, if it is not already, so that nodes can
+  be appended to its children: adds it and its children to the bulk
+  phase's table, and it to the directories to sort. Returns SUCCESS,
+  or with oNDir not open:
+  * IO_ERROR if the image oNDir was loaded from is corrupt
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+static int FT_bulkOpen(Node_T oNDir) {
+   struct bulkEntry *psEntry;
+   Node_T oNChild = NULL;
+   size_t c;
+   int iStatus;
+
+   assert(oNDir != NULL);
+   assert(oDBulkDirs != NULL);
+   assert(Node_getType(oNDir) == DIRECTORY);
+
+   psEntry = FT_bulkFind(Path_getPathname(Node_getPath(oNDir)));
+   if(psEntry != NULL && psEntry->bOpen)
+      return SUCCESS;
+
+   iStatus = Node_materialize(oNDir);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   for(c = 0; c < Node_getNumChildren(oNDir); c++) {
+      iStatus = Node_getChild(oNDir, c, &oNChild);
+      assert(iStatus == SUCCESS);
+      iStatus = FT_bulkAdd(oNChild, FALSE);
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   if(!DynArray_add(oDBulkDirs, oNDir))
+      return MEMORY_ERROR;
+   iStatus = FT_bulkAdd(oNDir, TRUE);
+   if(iStatus != SUCCESS) {
+      (void) DynArray_removeAt(oDBulkDirs,
+                               DynArray_getLength(oDBulkDirs) - 1);
+      return iStatus;
+   }
+   return SUCCESS;
+}
+
+/*
+  Puts the children of every directory inserted into during the bulk
+  phase back in order and empties the table, so that the FT is as it
+  would be outside a bulk phase; the bulk phase, if any, continues.
+  Takes time O(n log n) in the children of those directories.
+*/
+static void FT_bulkSort(void) {
+   size_t i;
+
+   if(oDBulkDirs == NULL)
+      return;
+
+   for(i = 0; i < DynArray_getLength(oDBulkDirs); i++) {
+      boolean bUnique = Node_sortChildren(DynArray_get(oDBulkDirs, i));
+      /* the table kept duplicates out */
+      assert(bUnique);
+      (void) bUnique;
+   }
+   while(DynArray_getLength(oDBulkDirs) > 0)
+      (void) DynArray_removeAt(oDBulkDirs,
+                               DynArray_getLength(oDBulkDirs) - 1);
+   free(psBulkTable);
+   psBulkTable = NULL;
+   ulBulkSlots = 0;
+   ulBulkUsed = 0;
+}
+
+/*
+  Returns TRUE and sets *poNChild to oNParent's child with path
+  oPPath, if it has one, and otherwise returns FALSE. In a bulk phase,
+  the child of an open directory is found in the table, since its
+  children may be out of order.
+*/
+static boolean FT_hasChild(Node_T oNParent, Path_T oPPath,
+                           Node_T *poNChild) {
+   struct bulkEntry *psEntry;
+   size_t ulChildID;
+
+   assert(oNParent != NULL);
+   assert(oPPath != NULL);
+   assert(poNChild != NULL);
+
+   psEntry = FT_bulkFind(Path_getPathname(Node_getPath(oNParent)));
+   if(psEntry != NULL && psEntry->bOpen) {
+      psEntry = FT_bulkFind(Path_getPathname(oPPath));
+      *poNChild = psEntry == NULL ? NULL : psEntry->oNNode;
+      return (boolean) (psEntry != NULL);
+   }
+
+   if(!Node_hasChild(oNParent, oPPath, &ulChildID))
+      return FALSE;
+   return (boolean) (Node_getChild(oNParent, ulChildID, poNChild) ==
+                     SUCCESS);
+}
+
+/*
+  Creates a new node as Node_new does, but in a bulk phase appends it
+  to its parent's children, after opening the parent, and adds it to
+  the table. Returns the same statuses as Node_new, with no node
+  created unless it returns SUCCESS.
+*/
+static int FT_newNode(Path_T oPPath, Node_T oNParent,
+                      Node_T *poNResult, typeNode type,
+                      void *pvContents, size_t ulLength) {
+   Path_T oPCopy = NULL;
+   int iStatus;
+
+   assert(oPPath != NULL);
+   assert(poNResult != NULL);
+
+   if(oDBulkDirs == NULL)
+      return Node_new(oPPath, oNParent, poNResult, type, pvContents,
+                      ulLength);
+
+   *poNResult = NULL;
+   /* the insert functions have found that oPPath is not in the FT,
+      and is a child of oNParent */
+   if(oNParent == NULL && type == FILE_NODE)
+      return CONFLICTING_PATH;
+   if(oNParent != NULL) {
+      iStatus = FT_bulkOpen(oNParent);
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+
+   iStatus = Path_dup(oPPath, &oPCopy);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = Node_newUnsorted(oPCopy, oNParent, poNResult, type,
+                              pvContents, ulLength);
+   if(iStatus != SUCCESS) {
+      Path_free(oPCopy);
+      return iStatus;
+   }
+
+   /* a new directory's children are all appended, so it is open */
+   if(type == DIRECTORY && !DynArray_add(oDBulkDirs, *poNResult))
+      iStatus = MEMORY_ERROR;
+   else
+      iStatus = FT_bulkAdd(*poNResult, (boolean) (type == DIRECTORY));
+   if(iStatus != SUCCESS) {
+      /* Node_free finds the node among its parent's children by
+         binary search, so they must be in order first */
+      FT_bulkSort();
+      (void) Node_free(*poNResult);
+      *poNResult = NULL;
+   }
+   return iStatus;
+}
+
+/*
+  Frees oNFirstNew, the first of the nodes an insert function created
+  before failing, if it is not NULL, putting its parent's children
+  back in order first in a bulk phase.
+*/
+static void FT_freeNew(Node_T oNFirstNew) {
+   if(oNFirstNew == NULL)
+      return;
+   FT_bulkSort();
+   (void) Node_free(oNFirstNew);
+}
 
 /* --------------------------------------------------------------------
 
@@ -50,11 +476,15 @@ static int FT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
    Node_T oNChild = NULL;
    size_t ulDepth;
    size_t i;
-   size_t ulChildID;
 
    assert(oPPath != NULL);
    assert(poNFurthest != NULL);
 
+   /* every operation starts with a traversal, and no Node_T is held
+      across operations, so this is when cold directories can go */
+   FT_evict();
+   ulClock++;
+
    /* root is NULL -> won't find anything */
    if(oNRoot == NULL) {
       *poNFurthest = NULL;
@@ -76,6 +506,7 @@ static int FT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
    oPPrefix = NULL;
 
    oNCurr = oNRoot;
+   Node_touch(oNCurr, ulClock);
    ulDepth = Path_getDepth(oPPath);
    for(i = 2; i <= ulDepth; i++) {
       iStatus = Path_prefix(oPPath, i, &oPPrefix);
@@ -83,16 +514,19 @@ static int FT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
          *poNFurthest = NULL;
          return iStatus;
       }
-      if(Node_hasChild(oNCurr, oPPrefix, &ulChildID)) {
+      /* a lazily loaded directory gets its children now */
+      iStatus = Node_materialize(oNCurr);
+      if(iStatus != SUCCESS) {
+         Path_free(oPPrefix);
+         *poNFurthest = NULL;
+         return iStatus;
+      }
+      if(FT_hasChild(oNCurr, oPPrefix, &oNChild)) {
          /* go to that child and continue with next prefix */
          Path_free(oPPrefix);
          oPPrefix = NULL;
-         iStatus = Node_getChild(oNCurr, ulChildID, &oNChild);
-         if(iStatus != SUCCESS) {
-            *poNFurthest = NULL;
-            return iStatus;
-         }
          oNCurr = oNChild;
+         Node_touch(oNCurr, ulClock);
       }
       else {
          /* oNCurr doesn't have child with path oPPrefix:
@@ -161,7 +595,8 @@ static int FT_findNode(const char *pcPath, Node_T *poNResult) {
 }
 /*--------------------------------------------------------------------*/
 
-int FT_insertDir(const char *pcPath)
+/* FT_insertDir, as in ft.h but not instrumented. */
+static int FT_insertDirUntimed(const char *pcPath)
 {
     int iStatus;
     Path_T oPPath = NULL;
@@ -191,8 +626,11 @@ int FT_insertDir(const char *pcPath)
     }
 
     /*ancestor node found: check that it is not a file (files cannot 
-    have children)*/
-    if (oNCurr != NULL && Node_getType(oNCurr) == FILE_NODE) {
+    have children); the file may be pcPath itself, which is
+    ALREADY_IN_TREE below*/
+    if (oNCurr != NULL && Node_getType(oNCurr) == FILE_NODE &&
+        Path_getDepth(Node_getPath(oNCurr)) <
+        Path_getDepth(oPPath)) {
         Path_free(oPPath);
         return NOT_A_DIRECTORY;
     } 
@@ -229,19 +667,18 @@ int FT_insertDir(const char *pcPath)
         iStatus = Path_prefix(oPPath, ulIndex, &oPPrefix);
         if(iStatus != SUCCESS) {
             Path_free(oPPath);
-            if(oNFirstNew != NULL)
-                (void) Node_free(oNFirstNew);
+            FT_freeNew(oNFirstNew);
             
             return iStatus;
         }
 
         /* insert the new node for this level */
-        iStatus = Node_new(oPPrefix, oNCurr, &oNNewNode, type, NULL, 0);
+        iStatus = FT_newNode(oPPrefix, oNCurr, &oNNewNode, type, NULL,
+                             0);
         if(iStatus != SUCCESS) {
             Path_free(oPPath);
             Path_free(oPPrefix);
-            if(oNFirstNew != NULL)
-                (void) Node_free(oNFirstNew);
+            FT_freeNew(oNFirstNew);
             return iStatus;
         }
 
@@ -264,16 +701,23 @@ int FT_insertDir(const char *pcPath)
 }
 /*--------------------------------------------------------------------*/
 
-boolean FT_containsDir(const char *pcPath)
+/*
+  FT_containsDir, as in ft.h but not instrumented. Sets *piStatus to
+  why pcPath is not a directory in the FT, or to SUCCESS.
+*/
+static boolean FT_containsDirUntimed(const char *pcPath, int *piStatus)
 {
-    int iStatus;
     Node_T oNFound = NULL;
 
     assert(pcPath != NULL);
+    assert(piStatus != NULL);
 
-    iStatus = FT_findNode(pcPath, &oNFound);
+    *piStatus = FT_findNode(pcPath, &oNFound);
 
-    if (iStatus != SUCCESS || Node_getType(oNFound) != DIRECTORY) {
+    if (*piStatus != SUCCESS)
+        return FALSE;
+    if (Node_getType(oNFound) != DIRECTORY) {
+        *piStatus = NOT_A_DIRECTORY;
         return FALSE;
     }
 
@@ -281,7 +725,8 @@ boolean FT_containsDir(const char *pcPath)
 }
 /*--------------------------------------------------------------------*/
 
-int FT_rmDir(const char *pcPath)
+/* FT_rmDir, as in ft.h but not instrumented. */
+static int FT_rmDirUntimed(const char *pcPath)
 {
     int iStatus;
     Node_T oNFound = NULL;
@@ -305,8 +750,9 @@ int FT_rmDir(const char *pcPath)
 }
 /*--------------------------------------------------------------------*/
 
-int FT_insertFile(const char *pcPath, void *pvContents,
-                  size_t ulLength)
+/* FT_insertFile, as in ft.h but not instrumented. */
+static int FT_insertFileUntimed(const char *pcPath, void *pvContents,
+                               size_t ulLength)
 {
     int iStatus;
     Path_T oPPath = NULL;
@@ -335,8 +781,11 @@ int FT_insertFile(const char *pcPath, void *pvContents,
     }
 
     /*ancestor node found: check that it is not a file (files cannot 
-    have children)*/
-    if (oNCurr != NULL && Node_getType(oNCurr) == FILE_NODE) {
+    have children); the file may be pcPath itself, which is
+    ALREADY_IN_TREE below*/
+    if (oNCurr != NULL && Node_getType(oNCurr) == FILE_NODE &&
+        Path_getDepth(Node_getPath(oNCurr)) <
+        Path_getDepth(oPPath)) {
         Path_free(oPPath);
         return NOT_A_DIRECTORY;
     } 
@@ -371,25 +820,23 @@ int FT_insertFile(const char *pcPath, void *pvContents,
         iStatus = Path_prefix(oPPath, ulIndex, &oPPrefix);
         if(iStatus != SUCCESS) {
             Path_free(oPPath);
-            if(oNFirstNew != NULL)
-                (void) Node_free(oNFirstNew);
+            FT_freeNew(oNFirstNew);
             return iStatus;
         }
 
         /* insert the new node for this level */
         if (ulIndex == ulDepth) {
-            iStatus = Node_new(oPPrefix, oNCurr, &oNNewNode, FILE_NODE, 
-                pvContents, ulLength);
+            iStatus = FT_newNode(oPPrefix, oNCurr, &oNNewNode,
+                FILE_NODE, pvContents, ulLength);
         }
         else {
-            iStatus = Node_new(oPPrefix, oNCurr, &oNNewNode, DIRECTORY,
-                 pvContents, ulLength);
+            iStatus = FT_newNode(oPPrefix, oNCurr, &oNNewNode,
+                DIRECTORY, pvContents, ulLength);
         }
         if(iStatus != SUCCESS) {
             Path_free(oPPath);
             Path_free(oPPrefix);
-            if(oNFirstNew != NULL)
-                (void) Node_free(oNFirstNew);
+            FT_freeNew(oNFirstNew);
             return iStatus;
         }
         /* set up for next level */
@@ -410,15 +857,22 @@ int FT_insertFile(const char *pcPath, void *pvContents,
 }
 /*--------------------------------------------------------------------*/
 
-boolean FT_containsFile(const char *pcPath)
+/*
+  FT_containsFile, as in ft.h but not instrumented. Sets *piStatus to
+  why pcPath is not a file in the FT, or to SUCCESS.
+*/
+static boolean FT_containsFileUntimed(const char *pcPath, int *piStatus)
 {
-    int iStatus;
     Node_T oNFound = NULL;
 
     assert(pcPath != NULL);
+    assert(piStatus != NULL);
 
-    iStatus = FT_findNode(pcPath, &oNFound);
-    if (iStatus != SUCCESS || Node_getType(oNFound) != FILE_NODE) {
+    *piStatus = FT_findNode(pcPath, &oNFound);
+    if (*piStatus != SUCCESS)
+        return FALSE;
+    if (Node_getType(oNFound) != FILE_NODE) {
+        *piStatus = NOT_A_FILE;
         return FALSE;
     }
 
@@ -426,7 +880,8 @@ boolean FT_containsFile(const char *pcPath)
 }
 /*--------------------------------------------------------------------*/
 
-int FT_rmFile(const char *pcPath)
+/* FT_rmFile, as in ft.h but not instrumented. */
+static int FT_rmFileUntimed(const char *pcPath)
 {
     int iStatus;
     Node_T oNFound = NULL;
@@ -450,40 +905,63 @@ int FT_rmFile(const char *pcPath)
 }
 /*--------------------------------------------------------------------*/
 
-void *FT_getFileContents(const char *pcPath)
+/*
+  FT_getFileContents, as in ft.h but not instrumented. Sets *piStatus
+  to why pcPath is not a file in the FT, or to SUCCESS (even if its
+  contents are NULL).
+*/
+static void *FT_getFileContentsUntimed(const char *pcPath,
+                                       int *piStatus)
 {
-    int iStatus;
     Node_T oNFound = NULL;
 
     assert(pcPath != NULL);
+    assert(piStatus != NULL);
 
-    iStatus = FT_findNode(pcPath, &oNFound);
+    *piStatus = FT_findNode(pcPath, &oNFound);
 
-    if(iStatus != SUCCESS)
+    if(*piStatus != SUCCESS)
         return NULL;
+    if(Node_getType(oNFound) != FILE_NODE) {
+        *piStatus = NOT_A_FILE;
+        return NULL;
+    }
 
     return Node_getFileContents(oNFound);   
 }
 /*--------------------------------------------------------------------*/
 
-void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
-                             size_t ulNewLength)
+/*
+  FT_replaceFileContents, as in ft.h but not instrumented. Sets
+  *piStatus to why pcPath is not a file in the FT, or to SUCCESS
+  (even if its old contents are NULL).
+*/
+static void *FT_replaceFileContentsUntimed(const char *pcPath,
+                                          void *pvNewContents,
+                                          size_t ulNewLength,
+                                          int *piStatus)
 {
-    int iStatus;
     Node_T oNFound = NULL;
 
     assert(pcPath != NULL);
+    assert(piStatus != NULL);
 
-    iStatus = FT_findNode(pcPath, &oNFound);
+    *piStatus = FT_findNode(pcPath, &oNFound);
 
-    if(iStatus != SUCCESS)
+    if(*piStatus != SUCCESS)
+        return NULL;
+    if(Node_getType(oNFound) != FILE_NODE) {
+        *piStatus = NOT_A_FILE;
         return NULL;
+    }
     
     return Node_swapFileContents(oNFound, pvNewContents, ulNewLength);
 }
 /*--------------------------------------------------------------------*/
 
-int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize)
+/* FT_stat, as in ft.h but not instrumented. */
+static int FT_statUntimed(const char *pcPath, boolean *pbIsFile,
+                         size_t *pulSize)
 {
     int iStatus;
     Node_T oNFound = NULL;
@@ -512,19 +990,32 @@ int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize)
 
 int FT_init(void)
 {
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+
    if(bIsInitialized)
       return INITIALIZATION_ERROR;
 
    bIsInitialized = TRUE;
    oNRoot = NULL;
    ulCount = 0;
+   oDImages = NULL;
+   oISpill = NULL;
+   ulMaxResident = 0;
+   ulClock = 0;
 
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
    return SUCCESS;
 }
 /*--------------------------------------------------------------------*/
 
 int FT_destroy(void)
 {
+   /* Node_free finds each node among its parent's children by binary
+      search */
+   if(oDBulkDirs != NULL)
+      (void) FT_endBulk();
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+
    if(!bIsInitialized)
       return INITIALIZATION_ERROR;
 
@@ -533,8 +1024,49 @@ int FT_destroy(void)
       oNRoot = NULL;
    }
 
+   /* nothing can point into the images any more */
+   if(oDImages != NULL) {
+      size_t i;
+      for(i = 0; i < DynArray_getLength(oDImages); i++)
+         Image_close(DynArray_get(oDImages, i));
+      DynArray_free(oDImages);
+      oDImages = NULL;
+   }
+   Image_close(oISpill);
+   oISpill = NULL;
+
    bIsInitialized = FALSE;
 
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_beginBulk(void)
+{
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+
+   if(!bIsInitialized || oDBulkDirs != NULL)
+      return INITIALIZATION_ERROR;
+
+   oDBulkDirs = DynArray_new(0);
+   if(oDBulkDirs == NULL)
+      return MEMORY_ERROR;
+   return SUCCESS;
+}
+/*--------------------------------------------------------------------*/
+
+int FT_endBulk(void)
+{
+   if(!bIsInitialized || oDBulkDirs == NULL)
+      return INITIALIZATION_ERROR;
+
+   FT_bulkSort();
+   DynArray_free(oDBulkDirs);
+   oDBulkDirs = NULL;
+
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
    return SUCCESS;
 }
 
@@ -544,6 +1076,33 @@ int FT_destroy(void)
   string representation of the File Tree.
 */
 
+/*
+  Creates the children of every lazily loaded directory in the
+  subtree rooted at oNNode (which may be NULL). Returns SUCCESS, or
+  the status of the first directory that could not be materialized.
+*/
+static int FT_materializeSubtree(Node_T oNNode) {
+   int iStatus;
+   size_t c;
+   Node_T oNChild = NULL;
+
+   if(oNNode == NULL || Node_getType(oNNode) == FILE_NODE)
+      return SUCCESS;
+
+   iStatus = Node_materialize(oNNode);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   for(c = 0; c < Node_getNumChildren(oNNode); c++) {
+      iStatus = Node_getChild(oNNode, c, &oNChild);
+      assert(iStatus == SUCCESS);
+      iStatus = FT_materializeSubtree(oNChild);
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   return SUCCESS;
+}
+
 /*
   Performs a pre-order traversal of the tree rooted at oNNode,
   inserting each payload to DynArray_T nodes beginning at index ulIndex.
@@ -600,30 +1159,53 @@ static void FT_strlenAccumulate(Node_T oNNode, size_t *pulAcc) {
 
 /*
   Alternate version of strcat that inverts the typical argument
-  order, appending oNNode's path onto pcAcc, and also always adds one
-  newline at the end of the concatenated string.
+  order, appending oNNode's path and one newline at *ppcEnd, the end
+  of the string being built, and advancing *ppcEnd past them. Keeping
+  the end, rather than finding it again, keeps building the string
+  linear in its length.
 */
-static void FT_strcatAccumulate(Node_T oNNode, char *pcAcc) {
-   assert(pcAcc != NULL);
+static void FT_strcatAccumulate(Node_T oNNode, char **ppcEnd) {
+   size_t ulLength;
+
+   assert(ppcEnd != NULL);
 
    if(oNNode != NULL) {
-      strcat(pcAcc, Path_getPathname(Node_getPath(oNNode)));
-      strcat(pcAcc, "\n");
+      ulLength = Path_getStrLength(Node_getPath(oNNode));
+      memcpy(*ppcEnd, Path_getPathname(Node_getPath(oNNode)),
+             ulLength);
+      (*ppcEnd)[ulLength] = '\n';
+      *ppcEnd += ulLength + 1;
+      **ppcEnd = '\0';
    }
 }
 
 /*--------------------------------------------------------------------*/
 
-char *FT_toString(void)
+/*
+  FT_toString, as in ft.h but not instrumented. Sets *piStatus to why
+  the string could not be made, or to SUCCESS.
+*/
+static char *FT_toStringUntimed(int *piStatus)
 {
     DynArray_T nodes;
    size_t totalStrlen = 1;
    char *result = NULL;
+   char *pcEnd;
+
+   assert(piStatus != NULL);
 
+   *piStatus = INITIALIZATION_ERROR;
    if(!bIsInitialized)
       return NULL;
 
+   *piStatus = FT_materializeSubtree(oNRoot);
+   if(*piStatus != SUCCESS)
+      return NULL;
+
+   *piStatus = MEMORY_ERROR;
    nodes = DynArray_new(ulCount);
+   if(nodes == NULL)
+      return NULL;
    (void) FT_preOrderTraversal(oNRoot, nodes, 0);
 
    DynArray_map(nodes, (void (*)(void *, void*)) FT_strlenAccumulate,
@@ -636,10 +1218,860 @@ char *FT_toString(void)
    }
    *result = '\0';
 
+   pcEnd = result;
    DynArray_map(nodes, (void (*)(void *, void*)) FT_strcatAccumulate,
-                (void *) result);
+                (void *) &pcEnd);
 
    DynArray_free(nodes);
 
+   *piStatus = SUCCESS;
    return result;
 }
+/*--------------------------------------------------------------------*/
+
+int FT_exportToDisk(const char *pcPath, const char *pcTargetDir,
+                    int iFlags)
+{
+   int iStatus;
+   Node_T oNFound = NULL;
+
+   assert(pcPath != NULL);
+   assert(pcTargetDir != NULL);
+
+   /* the export is in order */
+   FT_bulkSort();
+   iStatus = FT_findNode(pcPath, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = FT_materializeSubtree(oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   return FTDisk_export(oNFound, pcTargetDir, iFlags);
+}
+/*--------------------------------------------------------------------*/
+
+/*
+  Inserts the entries of the archive at iFd, as FT_importTar does, but
+  without a bulk phase of its own.
+*/
+static int FT_importTarEntries(int iFd)
+{
+   int iStatus;
+   char *pcPath = NULL;
+   boolean bIsFile = FALSE;
+   void *pvContents = NULL;
+   size_t ulLength = 0;
+
+   for(;;) {
+      iStatus = Tar_readEntry(iFd, &pcPath, &bIsFile, &pvContents,
+                              &ulLength);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      /* end of archive */
+      if(pcPath == NULL)
+         return SUCCESS;
+
+      if(bIsFile) {
+         iStatus = FT_insertFile(pcPath, pvContents, ulLength);
+         if(iStatus != SUCCESS)
+            free(pvContents);
+      }
+      else {
+         iStatus = FT_insertDir(pcPath);
+         /* archives commonly list a directory after its contents */
+         if(iStatus == ALREADY_IN_TREE && FT_containsDir(pcPath))
+            iStatus = SUCCESS;
+      }
+      free(pcPath);
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+}
+
+int FT_importTar(int iFd)
+{
+   int iStatus;
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   /* archives are often of wide directories, so they are imported in
+      a bulk phase, unless the caller is already in one */
+   if(oDBulkDirs != NULL)
+      return FT_importTarEntries(iFd);
+   iStatus = FT_beginBulk();
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = FT_importTarEntries(iFd);
+   (void) FT_endBulk();
+   return iStatus;
+}
+
+/*
+  Writes oNNode and then the rest of its subtree to iFd as tar
+  entries, in the same order as FT_toString: at each level, file
+  children before directory children. Returns SUCCESS or the status
+  of the first entry that could not be written.
+*/
+static int FT_exportTarNode(Node_T oNNode, int iFd) {
+   int iStatus;
+   size_t c;
+   Node_T oNChild = NULL;
+   boolean bIsFile;
+
+   assert(oNNode != NULL);
+
+   bIsFile = (boolean) (Node_getType(oNNode) == FILE_NODE);
+   iStatus = Tar_writeEntry(iFd,
+                  Path_getPathname(Node_getPath(oNNode)), bIsFile,
+                  bIsFile ? Node_getFileContents(oNNode) : NULL,
+                  bIsFile ? Node_getFileSize(oNNode) : 0);
+   if(iStatus != SUCCESS || bIsFile)
+      return iStatus;
+
+   /* first pass writes files at this depth */
+   for(c = 0; c < Node_getNumChildren(oNNode); c++) {
+      iStatus = Node_getChild(oNNode, c, &oNChild);
+      assert(iStatus == SUCCESS);
+      if(Node_getType(oNChild) == FILE_NODE) {
+         iStatus = FT_exportTarNode(oNChild, iFd);
+         if(iStatus != SUCCESS)
+            return iStatus;
+      }
+   }
+   /* second pass recurs on directories at this depth */
+   for(c = 0; c < Node_getNumChildren(oNNode); c++) {
+      iStatus = Node_getChild(oNNode, c, &oNChild);
+      assert(iStatus == SUCCESS);
+      if(Node_getType(oNChild) == DIRECTORY) {
+         iStatus = FT_exportTarNode(oNChild, iFd);
+         if(iStatus != SUCCESS)
+            return iStatus;
+      }
+   }
+   return SUCCESS;
+}
+
+int FT_exportTar(const char *pcPath, int iFd)
+{
+   int iStatus;
+   Node_T oNFound = NULL;
+
+   assert(pcPath != NULL);
+
+   /* the archive is in order */
+   FT_bulkSort();
+   iStatus = FT_findNode(pcPath, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = FT_materializeSubtree(oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = FT_exportTarNode(oNFound, iFd);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   return Tar_writeEnd(iFd);
+}
+/*--------------------------------------------------------------------*/
+
+int FT_saveImage(int iFd)
+{
+   int iStatus;
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   /* images are in order, since they are loaded without searching */
+   FT_bulkSort();
+   iStatus = FT_materializeSubtree(oNRoot);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   return Image_save(oNRoot, iFd);
+}
+/*--------------------------------------------------------------------*/
+
+int FT_loadImage(const char *pcFile, int iMode)
+{
+   int iStatus;
+   Image_T oIImage = NULL;
+   Node_T oNNewRoot = NULL;
+   size_t ulNewCount = 0;
+
+   assert(pcFile != NULL);
+   assert(iMode == FT_LOAD_EAGER || iMode == FT_LOAD_LAZY);
+   FT_bulkSort();
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   if(oNRoot != NULL)
+      return CONFLICTING_PATH;
+
+   if(oDImages == NULL) {
+      oDImages = DynArray_new(0);
+      if(oDImages == NULL)
+         return MEMORY_ERROR;
+   }
+
+   iStatus = Image_open(pcFile, &oIImage);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(!DynArray_add(oDImages, oIImage)) {
+      Image_close(oIImage);
+      return MEMORY_ERROR;
+   }
+
+   /* from here on the image stays mapped until FT_destroy */
+   iStatus = Image_loadRoot(oIImage, &oNNewRoot, &ulNewCount);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   if(iMode == FT_LOAD_EAGER) {
+      iStatus = FT_materializeSubtree(oNNewRoot);
+      if(iStatus != SUCCESS) {
+         if(oNNewRoot != NULL)
+            (void) Node_free(oNNewRoot);
+         return iStatus;
+      }
+   }
+
+   oNRoot = oNNewRoot;
+   ulCount = ulNewCount;
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return SUCCESS;
+}
+/*--------------------------------------------------------------------*/
+
+/*
+  Adds the node for line pcLine of an FT_toString image, of type
+  type, to the hierarchy being loaded: oDAncestors holds the nodes on
+  the path from the root to the previous line's node, and *poNNewRoot
+  the root (NULL before the first line). Since the image is in
+  preorder, the new node's parent is always on oDAncestors, so no
+  searching is needed; directories left behind are put back in sorted
+  order as they are popped.
+  Returns SUCCESS, or:
+  * BAD_PATH if pcLine is not a well-formatted path, or is out of order
+  * CONFLICTING_PATH if pcLine is not under the root or is a file root
+  * NO_SUCH_PATH if pcLine's parent has not been loaded
+  * NOT_A_DIRECTORY if pcLine's parent is a file
+  * ALREADY_IN_TREE if a file and directory of the same name are loaded
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+static int FT_loadLine(DynArray_T oDAncestors, const char *pcLine,
+                       typeNode type, Node_T *poNNewRoot) {
+   int iStatus;
+   Path_T oPPath = NULL;
+   Node_T oNParent = NULL;
+   Node_T oNLast = NULL;
+   Node_T oNNew = NULL;
+   size_t ulDepth;
+   size_t ulOpen;
+   size_t ulNumChildren;
+
+   assert(oDAncestors != NULL);
+   assert(pcLine != NULL);
+   assert(poNNewRoot != NULL);
+
+   iStatus = Path_new(pcLine, &oPPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   ulDepth = Path_getDepth(oPPath);
+
+   /* close the directories that cannot contain the new node */
+   while((ulOpen = DynArray_getLength(oDAncestors)) >= ulDepth) {
+      if(!Node_sortChildren(DynArray_removeAt(oDAncestors,
+                                              ulOpen - 1))) {
+         Path_free(oPPath);
+         return ALREADY_IN_TREE;
+      }
+   }
+
+   if(ulOpen == 0) {
+      iStatus = SUCCESS;
+      if(*poNNewRoot != NULL || type == FILE_NODE)
+         iStatus = CONFLICTING_PATH;
+      else if(ulDepth != 1)
+         iStatus = NO_SUCH_PATH;
+   }
+   else {
+      oNParent = DynArray_get(oDAncestors, ulOpen - 1);
+      if(Path_getSharedPrefixDepth(oPPath, Node_getPath(oNParent))
+         < ulOpen)
+         iStatus = Path_getSharedPrefixDepth(oPPath,
+            Node_getPath(*poNNewRoot)) == 0 ?
+            CONFLICTING_PATH : BAD_PATH;
+      else if(ulOpen != ulDepth - 1)
+         iStatus = NO_SUCH_PATH;
+      else if(Node_getType(oNParent) == FILE_NODE)
+         iStatus = NOT_A_DIRECTORY;
+      else {
+         /* siblings must arrive in FT_toString order: files, then
+            directories, each in increasing order */
+         ulNumChildren = Node_getNumChildren(oNParent);
+         if(ulNumChildren > 0) {
+            iStatus = Node_getChild(oNParent, ulNumChildren - 1,
+                                    &oNLast);
+            assert(iStatus == SUCCESS);
+            if(Node_getType(oNLast) == DIRECTORY && type == FILE_NODE)
+               iStatus = BAD_PATH;
+            else if(Node_getType(oNLast) == type &&
+                    Path_comparePath(Node_getPath(oNLast),
+                                     oPPath) >= 0)
+               iStatus = BAD_PATH;
+         }
+      }
+   }
+   if(iStatus != SUCCESS) {
+      Path_free(oPPath);
+      return iStatus;
+   }
+
+   iStatus = Node_newUnsorted(oPPath, oNParent, &oNNew, type, NULL, 0);
+   if(iStatus != SUCCESS) {
+      Path_free(oPPath);
+      return iStatus;
+   }
+   if(oNParent == NULL)
+      *poNNewRoot = oNNew;
+
+   if(!DynArray_add(oDAncestors, oNNew))
+      return MEMORY_ERROR;
+   return SUCCESS;
+}
+
+int FT_loadFromString(const char *pcBuffer, size_t ulLength,
+                      const char *pcTypes)
+{
+   int iStatus = SUCCESS;
+   DynArray_T oDAncestors;
+   Node_T oNNewRoot = NULL;
+   char *pcLine = NULL;
+   size_t ulLineSize = 0;
+   size_t ulLines = 0;
+   size_t ulStart = 0;
+
+   assert(pcBuffer != NULL || ulLength == 0);
+   FT_bulkSort();
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   if(oNRoot != NULL)
+      return CONFLICTING_PATH;
+
+   oDAncestors = DynArray_new(0);
+   if(oDAncestors == NULL)
+      return MEMORY_ERROR;
+
+   while(iStatus == SUCCESS && ulStart < ulLength) {
+      const char *pcEnd = memchr(pcBuffer + ulStart, '\n',
+                                 ulLength - ulStart);
+      size_t ulLineLength = pcEnd == NULL ? ulLength - ulStart :
+         (size_t) (pcEnd - (pcBuffer + ulStart));
+      typeNode type = DIRECTORY;
+
+      /* Path_new needs each line as its own string */
+      if(ulLineLength + 1 > ulLineSize) {
+         char *pcNewLine = realloc(pcLine, ulLineLength + 1);
+         if(pcNewLine == NULL) {
+            iStatus = MEMORY_ERROR;
+            break;
+         }
+         pcLine = pcNewLine;
+         ulLineSize = ulLineLength + 1;
+      }
+      memcpy(pcLine, pcBuffer + ulStart, ulLineLength);
+      pcLine[ulLineLength] = '\0';
+
+      if(pcTypes != NULL) {
+         if(pcTypes[ulLines] == 'f')
+            type = FILE_NODE;
+         else if(pcTypes[ulLines] != 'd') {
+            iStatus = BAD_PATH;
+            break;
+         }
+      }
+
+      iStatus = FT_loadLine(oDAncestors, pcLine, type, &oNNewRoot);
+      ulLines++;
+      ulStart += ulLineLength + 1;
+   }
+
+   if(iStatus == SUCCESS && pcTypes != NULL && pcTypes[ulLines] != '\0')
+      iStatus = BAD_PATH;
+
+   /* close the directories still open at the end of the image */
+   while(iStatus == SUCCESS && DynArray_getLength(oDAncestors) > 0)
+      if(!Node_sortChildren(DynArray_removeAt(oDAncestors,
+                               DynArray_getLength(oDAncestors) - 1)))
+         iStatus = ALREADY_IN_TREE;
+
+   free(pcLine);
+   DynArray_free(oDAncestors);
+
+   if(iStatus != SUCCESS) {
+      if(oNNewRoot != NULL)
+         (void) Node_free(oNNewRoot);
+      return iStatus;
+   }
+
+   oNRoot = oNNewRoot;
+   ulCount = ulLines;
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
+   return SUCCESS;
+}
+/*--------------------------------------------------------------------*/
+
+int FT_setResidentLimit(size_t ulMaxNodes, size_t ulFrames)
+{
+   int iStatus;
+
+   assert(ulFrames > 0);
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   if(oISpill == NULL) {
+      iStatus = Image_newSpill(ulFrames, &oISpill);
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   ulMaxResident = ulMaxNodes;
+   return SUCCESS;
+}
+/*--------------------------------------------------------------------*/
+
+/*
+  Adds the nodes in memory in the subtree rooted at oNNode to
+  *psStats, without materializing stubs.
+*/
+static void FT_addStats(Node_T oNNode, struct ftStats *psStats) {
+   const void *pvStub;
+   size_t ulRecord;
+   size_t ulChildren;
+   size_t ulSlack;
+   size_t ulDepth;
+   size_t c;
+
+   assert(oNNode != NULL);
+   assert(psStats != NULL);
+
+   Node_getMemory(oNNode, &ulRecord, &ulChildren, &ulSlack);
+   psStats->ulPathBytes += Path_getMemorySize(Node_getPath(oNNode));
+   psStats->ulNodeBytes += ulRecord;
+   psStats->ulChildBytes += ulChildren;
+   psStats->ulSlackBytes += ulSlack;
+   ulDepth = Path_getDepth(Node_getPath(oNNode));
+   if(ulDepth > psStats->ulMaxDepth)
+      psStats->ulMaxDepth = ulDepth;
+
+   if(Node_getType(oNNode) == FILE_NODE) {
+      psStats->ulFiles++;
+      psStats->ulContentBytes += Node_getFileSize(oNNode);
+      return;
+   }
+
+   psStats->ulDirs++;
+   pvStub = Node_getStub(oNNode);
+   if(pvStub != NULL) {
+      psStats->ulStubs++;
+      psStats->ulNonResident += Image_getStubCount(pvStub) - 1;
+      return;
+   }
+
+   if(Node_getNumChildren(oNNode) > psStats->ulMaxFanout)
+      psStats->ulMaxFanout = Node_getNumChildren(oNNode);
+   for(c = 0; c < Node_getNumChildren(oNNode); c++) {
+      Node_T oNChild = NULL;
+      int iStatus = Node_getChild(oNNode, c, &oNChild);
+      assert(iStatus == SUCCESS);
+      /* read only by the assertion */
+      (void) iStatus;
+      FT_addStats(oNChild, psStats);
+   }
+}
+
+int FT_getStats(struct ftStats *psStats)
+{
+   assert(psStats != NULL);
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   memset(psStats, 0, sizeof(struct ftStats));
+   if(oNRoot != NULL)
+      FT_addStats(oNRoot, psStats);
+   return SUCCESS;
+}
+/* --------------------------------------------------------------------
+
+  Latency instrumentation. Each public operation of enum ftOp is a
+  thin wrapper around its untimed body; with -D FT_LATENCY the wrapper
+  times the body and counts the latency in the calling thread's own
+  block of histograms, so that recording takes no lock.
+*/
+
+/* The number of statuses histograms are kept for */
+enum { FT_STATUSES = IO_ERROR + 1 };
+
+/* The most digits an unsigned long can print as (log10(2) < 3/10) */
+enum {
+   FT_ULONG_DIGITS = sizeof(unsigned long) * CHAR_BIT * 3 / 10 + 1
+};
+
+/* The names of the operations and statuses, for FT_latencyToString */
+static const char *apcOpNames[FT_OPS] = {
+   "FT_insertDir", "FT_containsDir", "FT_rmDir", "FT_insertFile",
+   "FT_containsFile", "FT_rmFile", "FT_getFileContents",
+   "FT_replaceFileContents", "FT_stat", "FT_toString"
+};
+static const char *apcStatusNames[FT_STATUSES] = {
+   "SUCCESS", "INITIALIZATION_ERROR", "ALREADY_IN_TREE",
+   "NO_SUCH_PATH", "CONFLICTING_PATH", "BAD_PATH", "NOT_A_DIRECTORY",
+   "NOT_A_FILE", "MEMORY_ERROR", "IO_ERROR"
+};
+
+#ifdef FT_LATENCY
+
+/* The histograms of one thread, linked into the list of all threads' */
+struct latencyBlock {
+   size_t aaulCounts[FT_OPS][FT_STATUSES][FT_LATENCY_BUCKETS];
+   struct latencyBlock *psNext;
+};
+
+/* The calling thread's block, or NULL before its first record */
+static __thread struct latencyBlock *psThreadBlock;
+/* Every thread's block, which outlives the thread, and the lock that
+   guards the list (but not the counts) */
+static struct latencyBlock *psBlocks;
+static pthread_mutex_t sBlocksLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Returns a monotonic timestamp in nanoseconds. */
+static unsigned long FT_latencyNow(void) {
+   struct timespec sNow;
+   (void) clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (unsigned long) sNow.tv_sec * 1000000000UL +
+      (unsigned long) sNow.tv_nsec;
+}
+
+/*
+  Counts a call to eOp that returned iStatus and started at ulStart.
+  The call goes uncounted if the thread's block cannot be allocated.
+*/
+static void FT_latencyRecord(enum ftOp eOp, int iStatus,
+                             unsigned long ulStart) {
+   unsigned long ulNs = FT_latencyNow() - ulStart;
+   size_t ulBucket = 0;
+
+   assert(eOp < FT_OPS);
+   assert(iStatus >= 0 && iStatus < FT_STATUSES);
+
+   if(psThreadBlock == NULL) {
+      psThreadBlock = calloc(1, sizeof(struct latencyBlock));
+      if(psThreadBlock == NULL)
+         return;
+      pthread_mutex_lock(&sBlocksLock);
+      psThreadBlock->psNext = psBlocks;
+      psBlocks = psThreadBlock;
+      pthread_mutex_unlock(&sBlocksLock);
+   }
+
+   while(ulNs > 1 && ulBucket < FT_LATENCY_BUCKETS - 1) {
+      ulNs >>= 1;
+      ulBucket++;
+   }
+   psThreadBlock->aaulCounts[eOp][iStatus][ulBucket]++;
+}
+
+/* A wrapper declares its start time with its other locals, so that
+   it can time only the body, after its checks */
+#define FT_LATENCY_DECLARE unsigned long ulLatencyStart;
+#define FT_LATENCY_BEGIN ulLatencyStart = FT_latencyNow()
+#define FT_LATENCY_END(eOp, iStatus) \
+   FT_latencyRecord(eOp, iStatus, ulLatencyStart)
+
+#else
+
+#define FT_LATENCY_DECLARE
+#define FT_LATENCY_BEGIN (void) 0
+#define FT_LATENCY_END(eOp, iStatus) (void) 0
+
+#endif
+
+boolean FT_getLatencyHistogram(enum ftOp eOp, int iStatus,
+                               size_t *pulCounts) {
+#ifdef FT_LATENCY
+   struct latencyBlock *psBlock;
+   size_t b;
+#endif
+
+   assert(eOp < FT_OPS);
+   assert(iStatus >= 0 && iStatus < FT_STATUSES);
+   assert(pulCounts != NULL);
+
+   memset(pulCounts, 0, FT_LATENCY_BUCKETS * sizeof(size_t));
+#ifdef FT_LATENCY
+   /* other threads' counts may still be changing as they are read */
+   pthread_mutex_lock(&sBlocksLock);
+   for(psBlock = psBlocks; psBlock != NULL; psBlock = psBlock->psNext)
+      for(b = 0; b < FT_LATENCY_BUCKETS; b++)
+         pulCounts[b] += psBlock->aaulCounts[eOp][iStatus][b];
+   pthread_mutex_unlock(&sBlocksLock);
+   return TRUE;
+#else
+   (void) eOp;
+   (void) iStatus;
+   return FALSE;
+#endif
+}
+
+/*
+  Returns the upper bound, in nanoseconds, of the bucket of
+  pulCounts (with ulCalls calls in all) that holds the call at
+  fraction dRank of the way from fastest to slowest.
+*/
+static unsigned long FT_latencyPercentile(const size_t *pulCounts,
+                                          size_t ulCalls,
+                                          double dRank) {
+   size_t ulSeen = 0;
+   size_t ulWanted = (size_t) (dRank * (double) ulCalls);
+   size_t b;
+
+   if(ulWanted == 0)
+      ulWanted = 1;
+   for(b = 0; b < FT_LATENCY_BUCKETS - 1; b++) {
+      ulSeen += pulCounts[b];
+      if(ulSeen >= ulWanted)
+         break;
+   }
+   return 2UL << b;
+}
+
+char *FT_latencyToString(void)
+{
+   size_t aulCounts[FT_LATENCY_BUCKETS];
+   size_t ulOpName = 0;
+   size_t ulStatusName = 0;
+   size_t ulLineSize;
+   char *pcResult;
+   char *pc;
+   int iOp;
+   int iStatus;
+   size_t b;
+
+   for(iOp = 0; iOp < FT_OPS; iOp++)
+      if(strlen(apcOpNames[iOp]) > ulOpName)
+         ulOpName = strlen(apcOpNames[iOp]);
+   for(iStatus = 0; iStatus < FT_STATUSES; iStatus++)
+      if(strlen(apcStatusNames[iStatus]) > ulStatusName)
+         ulStatusName = strlen(apcStatusNames[iStatus]);
+   /* the names, the text around the five numbers and the numbers,
+      and then each bucket as " b:count" */
+   ulLineSize = ulOpName + ulStatusName +
+      sizeof("  calls= p50<= p99<= p999<= max<=\n") +
+      5 * FT_ULONG_DIGITS +
+      FT_LATENCY_BUCKETS * (sizeof(" :") - 1 + 2 * FT_ULONG_DIGITS);
+
+   pcResult = malloc(FT_OPS * FT_STATUSES * ulLineSize + 1);
+   if(pcResult == NULL)
+      return NULL;
+   pc = pcResult;
+   *pc = '\0';
+
+   for(iOp = 0; iOp < FT_OPS; iOp++) {
+      for(iStatus = 0; iStatus < FT_STATUSES; iStatus++) {
+         size_t ulCalls = 0;
+         size_t ulSlowest = 0;
+
+         if(!FT_getLatencyHistogram((enum ftOp) iOp, iStatus,
+                                    aulCounts)) {
+            free(pcResult);
+            return NULL;
+         }
+         for(b = 0; b < FT_LATENCY_BUCKETS; b++) {
+            ulCalls += aulCounts[b];
+            if(aulCounts[b] != 0)
+               ulSlowest = b;
+         }
+         if(ulCalls == 0)
+            continue;
+
+         pc += sprintf(pc, "%s %s calls=%lu p50<=%lu p99<=%lu "
+                       "p999<=%lu max<=%lu", apcOpNames[iOp],
+                       apcStatusNames[iStatus], (unsigned long) ulCalls,
+                       FT_latencyPercentile(aulCounts, ulCalls, 0.5),
+                       FT_latencyPercentile(aulCounts, ulCalls, 0.99),
+                       FT_latencyPercentile(aulCounts, ulCalls, 0.999),
+                       2UL << ulSlowest);
+         for(b = 0; b < FT_LATENCY_BUCKETS; b++)
+            if(aulCounts[b] != 0)
+               pc += sprintf(pc, " %lu:%lu", (unsigned long) b,
+                             (unsigned long) aulCounts[b]);
+         pc += sprintf(pc, "\n");
+      }
+   }
+   return pcResult;
+}
+
+/*--------------------------------------------------------------------*/
+
+int FT_insertDir(const char *pcPath)
+{
+   int iStatus;
+   FT_LATENCY_DECLARE
+
+   /* in a bulk phase, children are out of order until FT_endBulk,
+      which checks the FT then */
+   assert(oDBulkDirs != NULL ||
+          CheckerFT_isValidPath(bIsInitialized, oNRoot, ulCount,
+                                pcPath));
+   FT_LATENCY_BEGIN;
+   iStatus = FT_insertDirUntimed(pcPath);
+   FT_LATENCY_END(FT_OP_INSERT_DIR, iStatus);
+   assert(oDBulkDirs != NULL ||
+          CheckerFT_isValidPath(bIsInitialized, oNRoot, ulCount,
+                                pcPath));
+   return iStatus;
+}
+
+boolean FT_containsDir(const char *pcPath)
+{
+   boolean bFound;
+   int iStatus;
+   FT_LATENCY_DECLARE
+
+   FT_LATENCY_BEGIN;
+   bFound = FT_containsDirUntimed(pcPath, &iStatus);
+   FT_LATENCY_END(FT_OP_CONTAINS_DIR, iStatus);
+   return bFound;
+}
+
+int FT_rmDir(const char *pcPath)
+{
+   int iStatus;
+   FT_LATENCY_DECLARE
+
+   /* Node_free finds a node among its parent's children by binary
+      search */
+   FT_bulkSort();
+   assert(CheckerFT_isValidPath(bIsInitialized, oNRoot, ulCount,
+                                pcPath));
+   FT_LATENCY_BEGIN;
+   iStatus = FT_rmDirUntimed(pcPath);
+   FT_LATENCY_END(FT_OP_RM_DIR, iStatus);
+   assert(CheckerFT_isValidPath(bIsInitialized, oNRoot, ulCount,
+                                pcPath));
+   return iStatus;
+}
+
+int FT_insertFile(const char *pcPath, void *pvContents,
+                  size_t ulLength)
+{
+   int iStatus;
+   FT_LATENCY_DECLARE
+
+   assert(oDBulkDirs != NULL ||
+          CheckerFT_isValidPath(bIsInitialized, oNRoot, ulCount,
+                                pcPath));
+   FT_LATENCY_BEGIN;
+   iStatus = FT_insertFileUntimed(pcPath, pvContents, ulLength);
+   FT_LATENCY_END(FT_OP_INSERT_FILE, iStatus);
+   assert(oDBulkDirs != NULL ||
+          CheckerFT_isValidPath(bIsInitialized, oNRoot, ulCount,
+                                pcPath));
+   return iStatus;
+}
+
+boolean FT_containsFile(const char *pcPath)
+{
+   boolean bFound;
+   int iStatus;
+   FT_LATENCY_DECLARE
+
+   FT_LATENCY_BEGIN;
+   bFound = FT_containsFileUntimed(pcPath, &iStatus);
+   FT_LATENCY_END(FT_OP_CONTAINS_FILE, iStatus);
+   return bFound;
+}
+
+int FT_rmFile(const char *pcPath)
+{
+   int iStatus;
+   FT_LATENCY_DECLARE
+
+   /* Node_free finds a node among its parent's children by binary
+      search */
+   FT_bulkSort();
+   assert(CheckerFT_isValidPath(bIsInitialized, oNRoot, ulCount,
+                                pcPath));
+   FT_LATENCY_BEGIN;
+   iStatus = FT_rmFileUntimed(pcPath);
+   FT_LATENCY_END(FT_OP_RM_FILE, iStatus);
+   assert(CheckerFT_isValidPath(bIsInitialized, oNRoot, ulCount,
+                                pcPath));
+   return iStatus;
+}
+
+void *FT_getFileContents(const char *pcPath)
+{
+   void *pvContents;
+   int iStatus;
+   FT_LATENCY_DECLARE
+
+   FT_LATENCY_BEGIN;
+   pvContents = FT_getFileContentsUntimed(pcPath, &iStatus);
+   FT_LATENCY_END(FT_OP_GET_CONTENTS, iStatus);
+   return pvContents;
+}
+
+void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
+                             size_t ulNewLength)
+{
+   void *pvOld;
+   int iStatus;
+   FT_LATENCY_DECLARE
+
+   assert(oDBulkDirs != NULL ||
+          CheckerFT_isValidPath(bIsInitialized, oNRoot, ulCount,
+                                pcPath));
+   FT_LATENCY_BEGIN;
+   pvOld = FT_replaceFileContentsUntimed(pcPath, pvNewContents,
+                                         ulNewLength, &iStatus);
+   FT_LATENCY_END(FT_OP_REPLACE_CONTENTS, iStatus);
+   assert(oDBulkDirs != NULL ||
+          CheckerFT_isValidPath(bIsInitialized, oNRoot, ulCount,
+                                pcPath));
+   return pvOld;
+}
+
+int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize)
+{
+   int iStatus;
+   FT_LATENCY_DECLARE
+
+   FT_LATENCY_BEGIN;
+   iStatus = FT_statUntimed(pcPath, pbIsFile, pulSize);
+   FT_LATENCY_END(FT_OP_STAT, iStatus);
+   return iStatus;
+}
+
+char *FT_toString(void)
+{
+   char *pcResult;
+   int iStatus;
+   FT_LATENCY_DECLARE
+
+   FT_bulkSort();
+   FT_LATENCY_BEGIN;
+   pcResult = FT_toStringUntimed(&iStatus);
+   FT_LATENCY_END(FT_OP_TO_STRING, iStatus);
+   return pcResult;
+}
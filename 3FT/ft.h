@@ -149,4 +149,260 @@ int FT_destroy(void);
 */
 char *FT_toString(void);
 
+/* Flags for FT_exportToDisk, which may be combined with '|' */
+enum { FT_EXPORT_SERIAL = 0x0,
+       FT_EXPORT_PARALLEL = 0x1,
+       FT_EXPORT_FSYNC = 0x2
+};
+
+/*
+  Materializes the FT file or hierarchy (subtree) at absolute path
+  pcPath as real files and directories beneath the existing local
+  directory pcTargetDir, so that the node at pcPath appears as
+  pcTargetDir/<last component of pcPath>. Directories are created
+  first, in breadth-first order so that each follows its parent;
+  file contents are then written, spread across worker threads by
+  parent directory if iFlags contains FT_EXPORT_PARALLEL. Existing
+  directories are reused and existing files are truncated. If iFlags
+  contains FT_EXPORT_FSYNC, each file is flushed to stable storage
+  before returning.
+  Returns SUCCESS if the whole hierarchy was written.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * IO_ERROR if pcTargetDir cannot be opened or some directory or
+             file could not be created or written
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_exportToDisk(const char *pcPath, const char *pcTargetDir,
+                    int iFlags);
+
+/*
+  Streams a ustar or pax archive from descriptor iFd into the FT,
+  inserting directories and files in the order they arrive (missing
+  ancestors are created as directories). Only one archive entry is
+  held in memory at a time. Each imported file's contents are newly
+  allocated and owned by the client, as with any other contents.
+  Entries that are neither directories nor regular files are skipped.
+  Returns SUCCESS if the whole archive was imported. Otherwise, stops
+  at the failing entry, leaving earlier entries in the FT, and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if an entry's name is not a well-formatted path
+  * CONFLICTING_PATH if an entry is not underneath the root, or
+                     would make a file the FT root
+  * NOT_A_DIRECTORY if a proper prefix of an entry exists as a file
+  * ALREADY_IN_TREE if a file entry is already in the FT, or a
+                    directory entry is already in the FT as a file
+  * IO_ERROR if iFd cannot be read or the archive is malformed
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_importTar(int iFd);
+
+/*
+  Streams the FT file or hierarchy (subtree) at absolute path pcPath
+  to descriptor iFd as a ustar archive (using pax headers only for
+  entries that do not fit in ustar), with entries in the same order as
+  FT_toString. File contents are written directly from the FT.
+  Returns SUCCESS if the whole archive was written.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * IO_ERROR if iFd cannot be written
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_exportTar(const char *pcPath, int iFd);
+
+/*
+  Writes the whole FT to descriptor iFd, which must be positioned at
+  the start of a file, as an image that FT_loadImage can load.
+  Returns SUCCESS if the image was written.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * IO_ERROR if iFd cannot be written
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_saveImage(int iFd);
+
+/* Modes for FT_loadImage */
+enum { FT_LOAD_EAGER, FT_LOAD_LAZY };
+
+/*
+  Replaces the empty hierarchy of the FT with the one saved in image
+  file pcFile. With FT_LOAD_EAGER every node is created immediately.
+  With FT_LOAD_LAZY only the root is created, and each directory's
+  children are created the first time an operation reaches it, so
+  the FT is usable right away and memory grows with what is touched.
+  Loaded file contents point into the mapped image rather than being
+  copied; they may be modified in place, and remain valid until
+  FT_destroy (even if removed from the FT), which also unmaps it.
+  Returns SUCCESS if the image was loaded.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * CONFLICTING_PATH if the FT already has a root
+  * IO_ERROR if pcFile cannot be read or is not a valid image
+  * MEMORY_ERROR if memory could not be allocated to complete request
+
+  Once loaded lazily, any operation that reaches a corrupt part of the
+  image fails with IO_ERROR (or NULL/FALSE, for operations that do not
+  return a status).
+*/
+int FT_loadImage(const char *pcFile, int iMode);
+
+/*
+  Replaces the empty hierarchy of the FT with the one described by
+  the first ulLength bytes of pcBuffer, which must be in the format of
+  FT_toString (or DT_toString): one absolute path per line, in
+  preorder, with each directory's files before its subdirectories.
+  pcTypes gives each line's type in order, 'f' for a file or 'd' for a
+  directory, and has exactly one character per line; if it is NULL,
+  every line is a directory. Loaded files are empty, with NULL
+  contents. The buffer's order is relied on rather than searched, so
+  loading takes time linear in its size.
+  Returns SUCCESS if the hierarchy was loaded.
+  Otherwise, leaves the FT empty and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if a line is not a well-formatted path, lines are out of
+    order, or pcTypes does not match the lines
+  * CONFLICTING_PATH if the FT already has a root, the lines do not all
+    share one root, or the root is a file
+  * NO_SUCH_PATH if a line's parent does not appear before it
+  * NOT_A_DIRECTORY if a line's parent is a file
+  * ALREADY_IN_TREE if a file and a directory have the same path
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_loadFromString(const char *pcBuffer, size_t ulLength,
+                      const char *pcTypes);
+
+/*
+  Begins a bulk phase, for inserting many directories and files at
+  once: until FT_endBulk, FT_insertDir and FT_insertFile append each
+  new node to its parent's children instead of inserting it in order,
+  and find nodes inserted so far through a temporary table of their
+  paths, so that an insert into a directory of n children takes
+  expected constant time rather than time linear in n. They return
+  the same statuses as outside a bulk phase, and FT_containsDir,
+  FT_containsFile, FT_getFileContents, FT_replaceFileContents and
+  FT_stat work as usual. Any other operation first puts the
+  directories inserted into back in order, as FT_endBulk does, and
+  the bulk phase then continues. Directories are not evicted (see
+  FT_setResidentLimit) during a bulk phase.
+  Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state or
+                         is already in a bulk phase
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_beginBulk(void);
+
+/*
+  Ends the bulk phase begun by FT_beginBulk, sorting the children of
+  each directory inserted into during it once, in time O(n log n) for
+  a directory of n children.
+  Returns SUCCESS, or INITIALIZATION_ERROR if the FT is not in an
+  initialized state or not in a bulk phase.
+*/
+int FT_endBulk(void);
+
+/*
+  Bounds the memory used by the FT's nodes, so that hierarchies larger
+  than memory can still be queried and modified: whenever more than
+  ulMaxNodes nodes are in memory at the start of an operation, the
+  least recently used directories are written to a scratch file and
+  freed, until at most half that many remain, and are read back the
+  next time an operation reaches them. The scratch file is read and
+  written through a pool of ulFrames 4 KB pages, whose size is fixed
+  by the first call; later calls only change ulMaxNodes.
+  File contents are not moved out of memory, and remain owned by the
+  client (or by a loaded image) as usual.
+  The limit bounds memory between operations, not within them:
+  FT_toString, FT_exportToDisk, FT_exportTar and FT_saveImage first
+  read back every directory of the subtree they cover, so each holds
+  that whole subtree in memory until the next operation evicts it
+  again. A hierarchy that does not fit in memory must not be given
+  to them whole.
+  Returns SUCCESS, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * IO_ERROR if the scratch file cannot be created
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_setResidentLimit(size_t ulMaxNodes, size_t ulFrames);
+
+/* A breakdown of what the FT holds, as filled in by FT_getStats */
+struct ftStats {
+   /* directories and files in memory */
+   size_t ulDirs;
+   size_t ulFiles;
+   /* directories whose children are only in an image or the spill,
+      and the nodes (of any kind) beneath them */
+   size_t ulStubs;
+   size_t ulNonResident;
+   /* bytes allocated for the nodes' paths, for their records, and for
+      their arrays of children, of which ulSlackBytes are room for
+      children not yet added */
+   size_t ulPathBytes;
+   size_t ulNodeBytes;
+   size_t ulChildBytes;
+   size_t ulSlackBytes;
+   /* bytes of file contents, which the FT does not own */
+   size_t ulContentBytes;
+   /* the depth of the deepest node, and the most children of any
+      directory, among the nodes in memory */
+   size_t ulMaxDepth;
+   size_t ulMaxFanout;
+};
+
+/*
+  Fills in *psStats for the nodes currently in memory, without
+  loading any that are not. Byte counts are of the memory requested,
+  not counting the allocator's own overhead.
+  Returns SUCCESS, or INITIALIZATION_ERROR if the FT is not in an
+  initialized state.
+*/
+int FT_getStats(struct ftStats *psStats);
+
+/* The operations whose latencies ft.c can record */
+enum ftOp {
+   FT_OP_INSERT_DIR, FT_OP_CONTAINS_DIR, FT_OP_RM_DIR,
+   FT_OP_INSERT_FILE, FT_OP_CONTAINS_FILE, FT_OP_RM_FILE,
+   FT_OP_GET_CONTENTS, FT_OP_REPLACE_CONTENTS, FT_OP_STAT,
+   FT_OP_TO_STRING, FT_OPS
+};
+
+/* The number of buckets in a latency histogram */
+enum { FT_LATENCY_BUCKETS = 40 };
+
+/*
+  When ft.c is compiled with -D FT_LATENCY, every call to an operation
+  of enum ftOp has its latency recorded, in per-thread counters, in a
+  histogram for the operation and its status. An operation that
+  returns a boolean or a pointer is counted under the status FT_stat
+  would give for its path, or NOT_A_DIRECTORY or NOT_A_FILE for a
+  node of the wrong type (so a file's NULL contents are a SUCCESS),
+  and FT_toString under INITIALIZATION_ERROR, MEMORY_ERROR or IO_ERROR
+  if it fails. Histograms cover the whole run of the program, across
+  FT_init and FT_destroy.
+  Sets pulCounts[b], for each of the FT_LATENCY_BUCKETS buckets b, to
+  the number of calls to eOp that returned status iStatus and took
+  from 2^b up to 2^(b+1) nanoseconds (bucket 0 also counts shorter
+  calls, and the last bucket longer ones), summed over all threads.
+  Returns TRUE, or sets every count to 0 and returns FALSE if ft.c was
+  compiled without FT_LATENCY.
+*/
+boolean FT_getLatencyHistogram(enum ftOp eOp, int iStatus,
+                               size_t *pulCounts);
+
+/*
+  Returns a newly allocated string with one line for each operation
+  and status that has been recorded (see FT_getLatencyHistogram):
+  the operation, the status, the number of calls, the upper bounds in
+  nanoseconds of the buckets holding the 50th, 99th and 99.9th
+  percentiles and the slowest call, and then each nonempty bucket as
+  b:count. Returns NULL if ft.c was compiled without FT_LATENCY, or
+  if memory could not be allocated.
+*/
+char *FT_latencyToString(void);
+
 #endif
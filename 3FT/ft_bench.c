@@ -0,0 +1,776 @@
+/*--------------------------------------------------------------------*/
+/* ft_bench.c                                                         */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "allocstat.h"
+#include "benchutil.h"
+#include "ft.h"
+#include "perfctr.h"
+
+/*
+  ft_bench drives the FT interface with a synthetic (or recorded)
+  workload and reports where the FT's memory goes once everything is
+  inserted, then, per operation type, throughput, latency percentiles
+  and heap allocations, frees and bytes allocated per call, followed
+  by the process's peak resident set size.
+
+  Usage: ft_bench [-w deep|wide|balanced|manifest] [-n nodes]
+                  [-d depth] [-f fanout] [-c contentsize] [-s seed]
+                  [-m manifestfile] [-b budgetfile] [-B] [-p] [-k]
+
+  Workloads:
+  * deep:     chains of -d nested directories, each ending in a file
+  * wide:     -n files directly in the root, inserted in random order
+  * balanced: a tree with -f children per directory, files as leaves
+  * manifest: the paths listed in -m, one per line (as from "find"),
+              with directories marked by a trailing '/'
+  Every workload is run in phases: insert everything; look every node
+  up (contains, stat, and contents for files) in random order; replace
+  every file's contents; render the tree with FT_toString; remove the
+  files in random order; remove the directories, deepest first.
+
+  Allocations are counted by allocstat, so ft_bench must be linked
+  with its --wrap options. With -b, each operation's allocations and
+  bytes per call are checked against the budgets in budgetfile, whose
+  lines are "label op allocs bytes", where label is the workload and
+  node count (as in "balanced-20000"); ft_bench then fails if any is
+  exceeded. -B prints the run's figures in that format instead, for
+  recording new budgets.
+
+  With -p, each call's hardware events (cycles, instructions, cache
+  and branch misses, user mode only) are counted with perfctr too, and
+  reported per call in a second table. Reading the counters takes a
+  system call before and after every call, outside the time measured;
+  if no counter can be opened, -p is ignored with a warning.
+
+  With -k, the insert phase runs as one FT_beginBulk/FT_endBulk bulk
+  phase; FT_endBulk's sort is timed as part of the last insert.
+*/
+
+/* The operations timed, and their names in the report */
+enum benchOp {
+   OP_INSERT_DIR, OP_INSERT_FILE, OP_CONTAINS_DIR, OP_CONTAINS_FILE,
+   OP_STAT, OP_GET_CONTENTS, OP_REPLACE_CONTENTS, OP_TO_STRING,
+   OP_RM_FILE, OP_RM_DIR, OP_COUNT
+};
+static const char *apcOpNames[OP_COUNT] = {
+   "insertDir", "insertFile", "containsDir", "containsFile",
+   "stat", "getFileContents", "replaceFileContents", "toString",
+   "rmFile", "rmDir"
+};
+
+/* How many times the whole tree is rendered by FT_toString */
+enum { BENCH_TO_STRINGS = 3 };
+
+/* The latencies recorded for one operation type */
+struct series {
+   /* one entry per call, in nanoseconds */
+   unsigned long *pulNs;
+   size_t ulUsed;
+   size_t ulSize;
+   /* the calls whose result was not the one expected */
+   size_t ulErrors;
+   /* the heap allocations, frees and bytes of all the calls */
+   size_t ulAllocs;
+   size_t ulFrees;
+   size_t ulBytes;
+   /* the hardware events of all the calls, with -p */
+   unsigned long aulEvents[PERF_COUNTERS];
+};
+
+/* The paths of a workload, in insertion order (parents first) */
+struct workload {
+   char **ppcPaths;
+   boolean *pbIsFile;
+   size_t ulCount;
+   size_t ulSize;
+};
+
+/* The latencies of every operation type */
+static struct series asSeries[OP_COUNT];
+
+/* The state of the workload's pseudo-random generator */
+static unsigned long ulSeed = 1;
+
+/* Whether hardware events are counted (-p) */
+static boolean bCountEvents = FALSE;
+/* Whether the insert phase is a bulk phase (-k) */
+static boolean bBulkInsert = FALSE;
+/* The event counts when the current call started */
+static struct perfCounts sStartEvents;
+
+/*--------------------------------------------------------------------*/
+
+/* Prints msg and exits the benchmark with status 2. */
+static void Bench_die(const char *pcMsg) {
+   fprintf(stderr, "ft_bench: %s\n", pcMsg);
+   exit(2);
+}
+
+/*
+  Starts counting a call's allocations (and events, with -p) and
+  returns its start time.
+*/
+static unsigned long Bench_start(void) {
+   AllocStat_reset();
+   if(bCountEvents)
+      PerfCtr_read(&sStartEvents);
+   return BenchUtil_now();
+}
+
+/*
+  Records a call of operation eOp that started at ulStart (as returned
+  by Bench_start), and counts it as an error unless bExpected.
+*/
+static void Bench_record(enum benchOp eOp, unsigned long ulStart,
+                         boolean bExpected) {
+   unsigned long ulNs = BenchUtil_now() - ulStart;
+   struct series *psSeries = &asSeries[eOp];
+   struct allocStats sStats;
+
+   if(bCountEvents) {
+      struct perfCounts sEvents;
+      int eCounter;
+
+      PerfCtr_read(&sEvents);
+      for(eCounter = 0; eCounter < PERF_COUNTERS; eCounter++)
+         psSeries->aulEvents[eCounter] += sEvents.aulCounts[eCounter] -
+            sStartEvents.aulCounts[eCounter];
+   }
+
+   /* before the series itself might grow */
+   AllocStat_get(&sStats);
+   psSeries->ulAllocs += sStats.ulAllocs + sStats.ulReallocs;
+   psSeries->ulFrees += sStats.ulFrees;
+   psSeries->ulBytes += sStats.ulBytes;
+
+   if(psSeries->ulUsed == psSeries->ulSize) {
+      psSeries->ulSize = psSeries->ulSize == 0 ? 1024 :
+         2 * psSeries->ulSize;
+      psSeries->pulNs = realloc(psSeries->pulNs,
+                           psSeries->ulSize * sizeof(unsigned long));
+      if(psSeries->pulNs == NULL)
+         Bench_die("out of memory recording latencies");
+   }
+   psSeries->pulNs[psSeries->ulUsed++] = ulNs;
+   if(!bExpected)
+      psSeries->ulErrors++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Appends a copy of pcPath, of type bIsFile, to psWork. */
+static void Bench_addPath(struct workload *psWork, const char *pcPath,
+                          boolean bIsFile) {
+   assert(psWork != NULL);
+   assert(pcPath != NULL);
+
+   if(psWork->ulCount == psWork->ulSize) {
+      psWork->ulSize = psWork->ulSize == 0 ? 1024 : 2 * psWork->ulSize;
+      psWork->ppcPaths = realloc(psWork->ppcPaths,
+                                 psWork->ulSize * sizeof(char *));
+      psWork->pbIsFile = realloc(psWork->pbIsFile,
+                                 psWork->ulSize * sizeof(boolean));
+      if(psWork->ppcPaths == NULL || psWork->pbIsFile == NULL)
+         Bench_die("out of memory generating the workload");
+   }
+   psWork->ppcPaths[psWork->ulCount] = malloc(strlen(pcPath) + 1);
+   if(psWork->ppcPaths[psWork->ulCount] == NULL)
+      Bench_die("out of memory generating the workload");
+   strcpy(psWork->ppcPaths[psWork->ulCount], pcPath);
+   psWork->pbIsFile[psWork->ulCount] = bIsFile;
+   psWork->ulCount++;
+}
+
+/*
+  Appends to psWork about ulNodes nodes in chains of ulDepth nested
+  directories beneath the root, each chain ending in a file.
+*/
+static void Bench_makeDeep(struct workload *psWork, size_t ulNodes,
+                           size_t ulDepth) {
+   char *pcPath;
+   size_t ulChains;
+   size_t c;
+   size_t d;
+
+   ulChains = ulNodes / (ulDepth + 1);
+   if(ulChains == 0)
+      ulChains = 1;
+   pcPath = malloc(32 + 2 * ulDepth + 8);
+   if(pcPath == NULL)
+      Bench_die("out of memory generating the workload");
+
+   Bench_addPath(psWork, "r", FALSE);
+   for(c = 0; c < ulChains; c++) {
+      sprintf(pcPath, "r/c%lu", (unsigned long) c);
+      for(d = 0; d < ulDepth; d++) {
+         Bench_addPath(psWork, pcPath, FALSE);
+         strcat(pcPath, "/d");
+      }
+      Bench_addPath(psWork, pcPath, TRUE);
+   }
+   free(pcPath);
+}
+
+/*
+  Appends to psWork the root and ulNodes - 1 files directly beneath
+  it, named so that they are inserted in random order.
+*/
+static void Bench_makeWide(struct workload *psWork, size_t ulNodes) {
+   char acPath[64];
+   size_t i;
+
+   Bench_addPath(psWork, "r", FALSE);
+   for(i = 1; i < ulNodes; i++) {
+      /* the counter keeps names unique, the prefix scatters them */
+      sprintf(acPath, "r/f%08lx%lu",
+              BenchUtil_random(&ulSeed) & 0xffffffffUL,
+              (unsigned long) i);
+      Bench_addPath(psWork, acPath, TRUE);
+   }
+}
+
+/*
+  Appends to psWork a tree of ulNodes nodes in which every directory
+  has ulFanout children (but the last), in breadth-first order; nodes
+  without children are files.
+*/
+static void Bench_makeBalanced(struct workload *psWork, size_t ulNodes,
+                               size_t ulFanout) {
+   size_t ulFirst = psWork->ulCount;
+   char *pcPath;
+   const char *pcParent;
+   size_t i;
+
+   Bench_addPath(psWork, "r", FALSE);
+   for(i = 1; i < ulNodes; i++) {
+      pcParent = psWork->ppcPaths[ulFirst + (i - 1) / ulFanout];
+      pcPath = malloc(strlen(pcParent) + 32);
+      if(pcPath == NULL)
+         Bench_die("out of memory generating the workload");
+      sprintf(pcPath, "%s/n%lu", pcParent, (unsigned long) i);
+      Bench_addPath(psWork, pcPath, i * ulFanout + 1 >= ulNodes);
+      free(pcPath);
+   }
+}
+
+/*
+  Appends to psWork the root "r" and, beneath it, every path listed in
+  manifest file pcFile, one per line, with any leading "./" or '/'
+  removed; lines ending in '/' are directories, others files.
+*/
+static void Bench_readManifest(struct workload *psWork,
+                               const char *pcFile) {
+   FILE *psFile;
+   char *pcLine = NULL;
+   size_t ulLineSize = 0;
+   ssize_t lLength;
+   char *pcPath;
+   char *pcName;
+   boolean bIsFile;
+
+   psFile = fopen(pcFile, "r");
+   if(psFile == NULL)
+      Bench_die("cannot open the manifest");
+
+   Bench_addPath(psWork, "r", FALSE);
+   while((lLength = getline(&pcLine, &ulLineSize, psFile)) >= 0) {
+      while(lLength > 0 && (pcLine[lLength - 1] == '\n' ||
+                            pcLine[lLength - 1] == '\r'))
+         pcLine[--lLength] = '\0';
+      bIsFile = TRUE;
+      while(lLength > 0 && pcLine[lLength - 1] == '/') {
+         pcLine[--lLength] = '\0';
+         bIsFile = FALSE;
+      }
+      pcName = pcLine;
+      while(*pcName == '/' || (pcName[0] == '.' && pcName[1] == '/'))
+         pcName += *pcName == '/' ? 1 : 2;
+      if(*pcName == '\0' || strcmp(pcName, ".") == 0)
+         continue;
+
+      pcPath = malloc(strlen(pcName) + 3);
+      if(pcPath == NULL)
+         Bench_die("out of memory reading the manifest");
+      strcpy(pcPath, "r/");
+      strcat(pcPath, pcName);
+      Bench_addPath(psWork, pcPath, bIsFile);
+      free(pcPath);
+   }
+   free(pcLine);
+   (void) fclose(psFile);
+}
+
+/*
+  Returns a newly allocated array of the indices 0..ulCount-1, in
+  random order if bShuffle.
+*/
+static size_t *Bench_order(size_t ulCount, boolean bShuffle) {
+   size_t *pulOrder;
+   size_t i;
+
+   pulOrder = malloc((ulCount + 1) * sizeof(size_t));
+   if(pulOrder == NULL)
+      Bench_die("out of memory generating the workload");
+   for(i = 0; i < ulCount; i++)
+      pulOrder[i] = i;
+   if(bShuffle) {
+      for(i = ulCount; i > 1; i--) {
+         size_t j = BenchUtil_random(&ulSeed) % i;
+         size_t ulTemp = pulOrder[i - 1];
+         pulOrder[i - 1] = pulOrder[j];
+         pulOrder[j] = ulTemp;
+      }
+   }
+   return pulOrder;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Prints where the FT's memory goes, as of the end of phase pcPhase. */
+static void Bench_printStats(const char *pcPhase) {
+   struct ftStats sStats;
+
+   if(FT_getStats(&sStats) != SUCCESS)
+      Bench_die("FT_getStats failed");
+   printf("after %s: %lu dirs, %lu files, depth %lu, fanout %lu\n",
+          pcPhase, (unsigned long) sStats.ulDirs,
+          (unsigned long) sStats.ulFiles,
+          (unsigned long) sStats.ulMaxDepth,
+          (unsigned long) sStats.ulMaxFanout);
+   printf("  bytes: paths %lu, nodes %lu, child arrays %lu "
+          "(%lu slack), contents %lu\n",
+          (unsigned long) sStats.ulPathBytes,
+          (unsigned long) sStats.ulNodeBytes,
+          (unsigned long) sStats.ulChildBytes,
+          (unsigned long) sStats.ulSlackBytes,
+          (unsigned long) sStats.ulContentBytes);
+}
+
+/*
+  Runs every phase of workload psWork against the FT, with file
+  contents of ulContents bytes.
+*/
+static void Bench_run(const struct workload *psWork,
+                      size_t ulContents) {
+   char *pcContents;
+   char *pcOther;
+   size_t *pulOrder;
+   size_t i;
+   unsigned long ulStart;
+   int iStatus;
+
+   pcContents = calloc(ulContents + 1, 2);
+   if(pcContents == NULL)
+      Bench_die("out of memory for file contents");
+   pcOther = pcContents + ulContents + 1;
+
+   if(FT_init() != SUCCESS)
+      Bench_die("FT_init failed");
+
+   /* insert: a manifest may name directories its files created */
+   if(bBulkInsert && FT_beginBulk() != SUCCESS)
+      Bench_die("FT_beginBulk failed");
+   for(i = 0; i < psWork->ulCount; i++) {
+      const char *pcPath = psWork->ppcPaths[i];
+      boolean bSucceeded;
+      enum benchOp eOp;
+      ulStart = Bench_start();
+      if(psWork->pbIsFile[i]) {
+         iStatus = FT_insertFile(pcPath, pcContents, ulContents);
+         eOp = OP_INSERT_FILE;
+         bSucceeded = iStatus == SUCCESS;
+      }
+      else {
+         iStatus = FT_insertDir(pcPath);
+         eOp = OP_INSERT_DIR;
+         bSucceeded = iStatus == SUCCESS ||
+                      iStatus == ALREADY_IN_TREE;
+      }
+      if(bBulkInsert && i + 1 == psWork->ulCount &&
+         FT_endBulk() != SUCCESS)
+         Bench_die("FT_endBulk failed");
+      Bench_record(eOp, ulStart, bSucceeded);
+   }
+   Bench_printStats("insert");
+
+   /* look up */
+   pulOrder = Bench_order(psWork->ulCount, TRUE);
+   for(i = 0; i < psWork->ulCount; i++) {
+      const char *pcPath = psWork->ppcPaths[pulOrder[i]];
+      boolean bIsFile = psWork->pbIsFile[pulOrder[i]];
+      boolean bFoundFile = FALSE;
+      size_t ulSize = 0;
+
+      ulStart = Bench_start();
+      if(bIsFile)
+         Bench_record(OP_CONTAINS_FILE, ulStart,
+                      FT_containsFile(pcPath));
+      else
+         Bench_record(OP_CONTAINS_DIR, ulStart, FT_containsDir(pcPath));
+
+      ulStart = Bench_start();
+      iStatus = FT_stat(pcPath, &bFoundFile, &ulSize);
+      Bench_record(OP_STAT, ulStart, iStatus == SUCCESS &&
+                   bFoundFile == bIsFile);
+
+      if(bIsFile) {
+         ulStart = Bench_start();
+         Bench_record(OP_GET_CONTENTS, ulStart,
+                      FT_getFileContents(pcPath) == pcContents);
+      }
+   }
+
+   /* replace */
+   for(i = 0; i < psWork->ulCount; i++) {
+      if(!psWork->pbIsFile[pulOrder[i]])
+         continue;
+      ulStart = Bench_start();
+      Bench_record(OP_REPLACE_CONTENTS, ulStart,
+                   FT_replaceFileContents(psWork->ppcPaths[pulOrder[i]],
+                                          pcOther, ulContents) ==
+                   pcContents);
+   }
+
+   /* render */
+   for(i = 0; i < BENCH_TO_STRINGS; i++) {
+      char *pcString;
+      ulStart = Bench_start();
+      pcString = FT_toString();
+      Bench_record(OP_TO_STRING, ulStart, pcString != NULL);
+      free(pcString);
+   }
+
+   /* remove the files, then the directories bottom-up */
+   for(i = 0; i < psWork->ulCount; i++) {
+      if(!psWork->pbIsFile[pulOrder[i]])
+         continue;
+      ulStart = Bench_start();
+      iStatus = FT_rmFile(psWork->ppcPaths[pulOrder[i]]);
+      Bench_record(OP_RM_FILE, ulStart, iStatus == SUCCESS);
+   }
+   for(i = psWork->ulCount; i > 0; i--) {
+      if(psWork->pbIsFile[i - 1])
+         continue;
+      ulStart = Bench_start();
+      iStatus = FT_rmDir(psWork->ppcPaths[i - 1]);
+      Bench_record(OP_RM_DIR, ulStart, iStatus == SUCCESS);
+   }
+
+   if(FT_destroy() != SUCCESS)
+      Bench_die("FT_destroy failed");
+   free(pulOrder);
+   free(pcContents);
+}
+
+/* Compares two latencies for qsort. */
+static int Bench_compareNs(const void *pvFirst, const void *pvSecond) {
+   unsigned long ulFirst = *(const unsigned long *) pvFirst;
+   unsigned long ulSecond = *(const unsigned long *) pvSecond;
+   return (ulFirst > ulSecond) - (ulFirst < ulSecond);
+}
+
+/*
+  Returns the dPercentile-th percentile of the ulCount sorted
+  latencies pulNs.
+*/
+static unsigned long Bench_percentile(const unsigned long *pulNs,
+                                      size_t ulCount,
+                                      double dPercentile) {
+   size_t ulRank;
+
+   assert(ulCount > 0);
+
+   /* nearest rank */
+   ulRank = (size_t) (dPercentile / 100.0 * (double) ulCount +
+                      0.999999);
+   if(ulRank == 0)
+      ulRank = 1;
+   if(ulRank > ulCount)
+      ulRank = ulCount;
+   return pulNs[ulRank - 1];
+}
+
+/*
+  Prints the report for every operation type that was called, and
+  returns the total number of errors.
+*/
+static size_t Bench_report(void) {
+   struct rusage sUsage;
+   size_t ulErrors = 0;
+   int eOp;
+
+   printf("%-20s %10s %12s %10s %10s %10s %7s %9s %9s %10s\n", "op",
+          "count", "ops/s", "p50 ns", "p99 ns", "p999 ns", "errors",
+          "allocs/op", "frees/op", "bytes/op");
+   for(eOp = 0; eOp < OP_COUNT; eOp++) {
+      struct series *psSeries = &asSeries[eOp];
+      double dTotal = 0.0;
+      double dCalls = (double) psSeries->ulUsed;
+      size_t i;
+
+      if(psSeries->ulUsed == 0)
+         continue;
+      for(i = 0; i < psSeries->ulUsed; i++)
+         dTotal += (double) psSeries->pulNs[i];
+      qsort(psSeries->pulNs, psSeries->ulUsed, sizeof(unsigned long),
+            Bench_compareNs);
+
+      printf("%-20s %10lu %12.0f %10lu %10lu %10lu %7lu %9.2f %9.2f "
+             "%10.1f\n", apcOpNames[eOp],
+             (unsigned long) psSeries->ulUsed,
+             dTotal > 0.0 ? dCalls * 1e9 / dTotal : 0.0,
+             Bench_percentile(psSeries->pulNs, psSeries->ulUsed, 50.0),
+             Bench_percentile(psSeries->pulNs, psSeries->ulUsed, 99.0),
+             Bench_percentile(psSeries->pulNs, psSeries->ulUsed, 99.9),
+             (unsigned long) psSeries->ulErrors,
+             (double) psSeries->ulAllocs / dCalls,
+             (double) psSeries->ulFrees / dCalls,
+             (double) psSeries->ulBytes / dCalls);
+      ulErrors += psSeries->ulErrors;
+   }
+
+   if(getrusage(RUSAGE_SELF, &sUsage) == 0)
+      printf("peak RSS: %ld KB\n", sUsage.ru_maxrss);
+   return ulErrors;
+}
+
+/*
+  Prints, per operation type that was called, the hardware events
+  counted per call with -p.
+*/
+static void Bench_reportEvents(void) {
+   struct perfCounts sTotals;
+   int eCounter;
+   int eOp;
+
+   printf("%-20s", "op");
+   for(eCounter = 0; eCounter < PERF_COUNTERS; eCounter++)
+      printf(" %15s", PerfCtr_getName((enum perfCounter) eCounter));
+   printf(" %6s\n", "IPC");
+   for(eOp = 0; eOp < OP_COUNT; eOp++) {
+      struct series *psSeries = &asSeries[eOp];
+      double dCalls = (double) psSeries->ulUsed;
+
+      if(psSeries->ulUsed == 0)
+         continue;
+      printf("%-20s", apcOpNames[eOp]);
+      for(eCounter = 0; eCounter < PERF_COUNTERS; eCounter++) {
+         if(PerfCtr_isOpen((enum perfCounter) eCounter))
+            printf(" %15.1f",
+                   (double) psSeries->aulEvents[eCounter] / dCalls);
+         else
+            printf(" %15s", "-");
+      }
+      if(PerfCtr_isOpen(PERF_CYCLES) &&
+         PerfCtr_isOpen(PERF_INSTRUCTIONS) &&
+         psSeries->aulEvents[PERF_CYCLES] > 0)
+         printf(" %6.2f\n",
+                (double) psSeries->aulEvents[PERF_INSTRUCTIONS] /
+                (double) psSeries->aulEvents[PERF_CYCLES]);
+      else
+         printf(" %6s\n", "-");
+   }
+
+   PerfCtr_read(&sTotals);
+   if(sTotals.ulRunningNs < sTotals.ulEnabledNs)
+      printf("events were multiplexed: counted %.1f%% of the time, "
+             "so the figures are underestimates\n",
+             100.0 * (double) sTotals.ulRunningNs /
+             (double) sTotals.ulEnabledNs);
+}
+
+/*
+  Prints, in budget file format with label pcLabel, the allocations
+  and bytes per call of every operation type that was called, rounded
+  up to the precision printed.
+*/
+static void Bench_printBudgets(const char *pcLabel) {
+   int eOp;
+
+   for(eOp = 0; eOp < OP_COUNT; eOp++) {
+      const struct series *psSeries = &asSeries[eOp];
+      double dCalls = (double) psSeries->ulUsed;
+
+      if(psSeries->ulUsed == 0)
+         continue;
+      printf("%s %s %.2f %.1f\n", pcLabel, apcOpNames[eOp],
+             (double) psSeries->ulAllocs / dCalls + 0.005,
+             (double) psSeries->ulBytes / dCalls + 0.05);
+   }
+}
+
+/*
+  Checks the allocations and bytes per call of every operation type
+  against the budgets labelled pcLabel in file pcFile, printing each
+  one exceeded. Returns the number exceeded.
+*/
+static size_t Bench_checkBudgets(const char *pcFile,
+                                 const char *pcLabel) {
+   FILE *psFile;
+   char acLabel[64];
+   char acOp[32];
+   double dAllocs;
+   double dBytes;
+   size_t ulChecked = 0;
+   size_t ulExceeded = 0;
+   int eOp;
+
+   psFile = fopen(pcFile, "r");
+   if(psFile == NULL)
+      Bench_die("cannot open the budget file");
+
+   while(fscanf(psFile, "%63s", acLabel) == 1) {
+      /* a comment runs to the end of its line */
+      if(acLabel[0] == '#') {
+         int iChar;
+         while((iChar = getc(psFile)) != EOF && iChar != '\n')
+            ;
+         continue;
+      }
+      if(fscanf(psFile, "%31s %lf %lf", acOp, &dAllocs, &dBytes) != 3)
+         Bench_die("malformed budget file");
+      if(strcmp(acLabel, pcLabel) != 0)
+         continue;
+
+      for(eOp = 0; eOp < OP_COUNT; eOp++)
+         if(strcmp(acOp, apcOpNames[eOp]) == 0)
+            break;
+      if(eOp == OP_COUNT)
+         Bench_die("unknown operation in budget file");
+      if(asSeries[eOp].ulUsed == 0)
+         continue;
+
+      ulChecked++;
+      if((double) asSeries[eOp].ulAllocs /
+            (double) asSeries[eOp].ulUsed > dAllocs ||
+         (double) asSeries[eOp].ulBytes /
+            (double) asSeries[eOp].ulUsed > dBytes) {
+         printf("over budget: %s %s: %.2f allocs/op (budget %.2f), "
+                "%.1f bytes/op (budget %.1f)\n", pcLabel, acOp,
+                (double) asSeries[eOp].ulAllocs /
+                   (double) asSeries[eOp].ulUsed, dAllocs,
+                (double) asSeries[eOp].ulBytes /
+                   (double) asSeries[eOp].ulUsed, dBytes);
+         ulExceeded++;
+      }
+   }
+   (void) fclose(psFile);
+
+   if(ulChecked == 0)
+      Bench_die("no budgets for this workload in the budget file");
+   printf("allocation budgets: %lu checked, %lu exceeded\n",
+          (unsigned long) ulChecked, (unsigned long) ulExceeded);
+   return ulExceeded;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Generates the workload selected by the command-line arguments argv,
+  runs it, and prints the report to stdout. Returns 0, 1 if any call
+  had an unexpected result or an allocation budget was exceeded, or 2
+  for a usage error.
+*/
+int main(int argc, char *argv[]) {
+   struct workload sWork = {NULL, NULL, 0, 0};
+   const char *pcWorkload = "balanced";
+   const char *pcManifest = NULL;
+   const char *pcBudgets = NULL;
+   boolean bPrintBudgets = FALSE;
+   char acLabel[64];
+   size_t ulFailures;
+   size_t ulNodes = 100000;
+   size_t ulDepth = 64;
+   size_t ulFanout = 8;
+   size_t ulContents = 16;
+   size_t ulFiles = 0;
+   unsigned long ulFirstSeed;
+   size_t i;
+   int iOpt;
+
+   while((iOpt = getopt(argc, argv, "w:n:d:f:c:s:m:b:Bpk")) != -1) {
+      switch(iOpt) {
+         case 'w': pcWorkload = optarg; break;
+         case 'n': ulNodes = (size_t) strtoul(optarg, NULL, 10); break;
+         case 'd': ulDepth = (size_t) strtoul(optarg, NULL, 10); break;
+         case 'f': ulFanout = (size_t) strtoul(optarg, NULL, 10); break;
+         case 'c': ulContents = (size_t) strtoul(optarg, NULL, 10);
+                   break;
+         case 's': ulSeed = strtoul(optarg, NULL, 10); break;
+         case 'm': pcManifest = optarg; pcWorkload = "manifest"; break;
+         case 'b': pcBudgets = optarg; break;
+         case 'B': bPrintBudgets = TRUE; break;
+         case 'p': bCountEvents = TRUE; break;
+         case 'k': bBulkInsert = TRUE; break;
+         default:
+            fprintf(stderr, "usage: %s [-w deep|wide|balanced|manifest]"
+                    " [-n nodes] [-d depth] [-f fanout]"
+                    " [-c contentsize] [-s seed] [-m manifestfile]"
+                    " [-b budgetfile] [-B] [-p] [-k]\n",
+                    argv[0]);
+            return 2;
+      }
+   }
+   /* a zero seed would make xorshift stick at zero */
+   if(ulSeed == 0)
+      ulSeed = 1;
+   if(ulNodes == 0 || ulDepth == 0 || ulFanout == 0)
+      Bench_die("-n, -d and -f must be positive");
+   ulFirstSeed = ulSeed;
+
+   if(strcmp(pcWorkload, "deep") == 0)
+      Bench_makeDeep(&sWork, ulNodes, ulDepth);
+   else if(strcmp(pcWorkload, "wide") == 0)
+      Bench_makeWide(&sWork, ulNodes);
+   else if(strcmp(pcWorkload, "balanced") == 0)
+      Bench_makeBalanced(&sWork, ulNodes, ulFanout);
+   else if(strcmp(pcWorkload, "manifest") == 0 && pcManifest != NULL)
+      Bench_readManifest(&sWork, pcManifest);
+   else
+      Bench_die("unknown workload, or manifest without -m");
+
+   for(i = 0; i < sWork.ulCount; i++)
+      ulFiles += sWork.pbIsFile[i];
+   printf("workload %s: %lu nodes (%lu directories, %lu files), "
+          "seed %lu\n", pcWorkload, (unsigned long) sWork.ulCount,
+          (unsigned long) (sWork.ulCount - ulFiles),
+          (unsigned long) ulFiles, ulFirstSeed);
+
+   if(bCountEvents && PerfCtr_open() != SUCCESS) {
+      fprintf(stderr, "ft_bench: no hardware counters (%s), "
+              "ignoring -p\n", strerror(errno));
+      bCountEvents = FALSE;
+   }
+
+   Bench_run(&sWork, ulContents);
+
+   for(i = 0; i < sWork.ulCount; i++)
+      free(sWork.ppcPaths[i]);
+   free(sWork.ppcPaths);
+   free(sWork.pbIsFile);
+
+   ulFailures = Bench_report();
+   if(bCountEvents) {
+      Bench_reportEvents();
+      PerfCtr_close();
+   }
+   sprintf(acLabel, "%.40s-%lu", pcWorkload,
+           (unsigned long) sWork.ulCount);
+   if(bPrintBudgets)
+      Bench_printBudgets(acLabel);
+   if(pcBudgets != NULL)
+      ulFailures += Bench_checkBudgets(pcBudgets, acLabel);
+   return ulFailures == 0 ? 0 : 1;
+}
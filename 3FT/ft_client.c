@@ -133,6 +133,15 @@ int main(void) {
          NOT_A_DIRECTORY);
   assert(FT_containsFile("1root/2third/3nopeF") == FALSE);
 
+  /* but inserting at the file's own path is a duplicate: only a
+     proper prefix that is a file makes a path NOT_A_DIRECTORY */
+  assert(FT_insertDir("1root/2third") == ALREADY_IN_TREE);
+  assert(FT_insertFile("1root/2third", NULL, 0) == ALREADY_IN_TREE);
+  assert(FT_containsFile("1root/2third") == TRUE);
+  assert(FT_insertFile("1root/2second/3gfile", NULL, 0) ==
+         ALREADY_IN_TREE);
+  assert(FT_insertDir("1root/2second/3gfile") == ALREADY_IN_TREE);
+
 
   /* calling rm* on a path that doesn't exist should return
      NO_SUCH_PATH, but on a path that does exist with the right
@@ -193,6 +202,11 @@ int main(void) {
   assert(l == ARRLEN);
   assert(FT_rmFile("1root/H") == SUCCESS);
   assert(FT_insertDir("1root/2d") == SUCCESS);
+  /* a directory has no contents to get or replace */
+  assert(FT_getFileContents("1root/2d") == NULL);
+  assert(FT_replaceFileContents("1root/2d", "Kernighan",
+                                strlen("Kernighan")+1) == NULL);
+  assert(FT_getFileContents("1root") == NULL);
   assert(FT_stat("1root/2d", &bIsFile, &l) == SUCCESS);
   assert(bIsFile == FALSE);
   assert(l == ARRLEN);
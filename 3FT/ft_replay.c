@@ -0,0 +1,294 @@
+/*--------------------------------------------------------------------*/
+/* ft_replay.c                                                        */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ft.h"
+#include "fttrace.h"
+
+/*
+  ft_replay replays a trace recorded by ftrecord against the FT
+  implementation it is linked with, and reports, per op, how long the
+  calls took when recorded and when replayed, and how many of them
+  diverged: returned a different result than was recorded.
+
+  Usage: ft_replay [-v shown] tracefile
+
+  The whole trace is read before the first call is made, so reading
+  it is not timed. File contents are not recorded, only their lengths
+  and whether they were NULL, so every file with contents is given (a
+  prefix of) one zero-filled buffer. The first -v divergences (10 by
+  default) are described on stderr; once one has occurred, later ones
+  may only be its consequences.
+  Exits with status 0 if nothing diverged, 1 if something did, or 2
+  if the trace cannot be read.
+*/
+
+/* A recorded call, with its path kept in the trace's path bytes */
+struct call {
+   struct traceRecord sRecord;
+   size_t ulPath;
+};
+
+/* The whole trace, as read */
+struct replay {
+   struct call *psCalls;
+   size_t ulCount;
+   size_t ulSize;
+   char *pcPaths;
+   size_t ulPathsUsed;
+   size_t ulPathsSize;
+   /* the longest file contents recorded */
+   size_t ulMaxLength;
+};
+
+/* The totals of one op */
+struct opTotals {
+   size_t ulCalls;
+   unsigned long ulRecordedNs;
+   unsigned long ulReplayedNs;
+   size_t ulDiverged;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Prints msg and exits the replay with status 2. */
+static void Replay_die(const char *pcMsg) {
+   fprintf(stderr, "ft_replay: %s\n", pcMsg);
+   exit(2);
+}
+
+/* Reads the whole trace file pcFile into *psReplay. */
+static void Replay_read(const char *pcFile, struct replay *psReplay) {
+   struct traceRecord sRecord;
+   Trace_T oTTrace;
+   int iFd;
+   int iStatus;
+
+   iFd = open(pcFile, O_RDONLY);
+   if(iFd < 0)
+      Replay_die("cannot open the trace");
+   if(Trace_newReader(iFd, &oTTrace) != SUCCESS)
+      Replay_die("not a trace file");
+
+   while((iStatus = Trace_read(oTTrace, &sRecord)) == SUCCESS) {
+      size_t ulPathLength = strlen(sRecord.pcPath) + 1;
+      struct call *psCall;
+
+      if(psReplay->ulCount == psReplay->ulSize) {
+         psReplay->ulSize = psReplay->ulSize * 2 + 1024;
+         psReplay->psCalls = realloc(psReplay->psCalls,
+            psReplay->ulSize * sizeof(struct call));
+         if(psReplay->psCalls == NULL)
+            Replay_die("out of memory reading the trace");
+      }
+      while(psReplay->ulPathsUsed + ulPathLength >
+            psReplay->ulPathsSize) {
+         psReplay->ulPathsSize = psReplay->ulPathsSize * 2 + 65536;
+         psReplay->pcPaths = realloc(psReplay->pcPaths,
+                                     psReplay->ulPathsSize);
+         if(psReplay->pcPaths == NULL)
+            Replay_die("out of memory reading the trace");
+      }
+
+      psCall = &psReplay->psCalls[psReplay->ulCount++];
+      psCall->sRecord = sRecord;
+      psCall->ulPath = psReplay->ulPathsUsed;
+      memcpy(psReplay->pcPaths + psReplay->ulPathsUsed, sRecord.pcPath,
+             ulPathLength);
+      psReplay->ulPathsUsed += ulPathLength;
+      if((sRecord.eOp == TRACE_INSERT_FILE ||
+          sRecord.eOp == TRACE_REPLACE_CONTENTS) &&
+         sRecord.ulLength > psReplay->ulMaxLength)
+         psReplay->ulMaxLength = sRecord.ulLength;
+   }
+   if(iStatus != NO_SUCH_PATH)
+      Replay_die("the trace is truncated or corrupt");
+
+   (void) Trace_free(oTTrace);
+   (void) close(iFd);
+}
+
+/*
+  Makes the call *psRecord records, with path pcPath and file contents
+  pvContents, and sets *pulLength and *pulResult to what it produced
+  (as struct traceRecord defines them). Returns how long the call
+  took, in nanoseconds.
+*/
+static unsigned long Replay_call(const struct traceRecord *psRecord,
+                                 const char *pcPath, void *pvContents,
+                                 size_t *pulLength,
+                                 unsigned long *pulResult) {
+   unsigned long ulStart;
+   unsigned long ulEnd;
+   boolean bIsFile = FALSE;
+   size_t ulSize = 0;
+   char *pcString;
+   int iStatus;
+
+   *pulLength = 0;
+   ulStart = Trace_now();
+   switch(psRecord->eOp) {
+      case TRACE_INIT:
+         *pulResult = (unsigned long) FT_init();
+         break;
+      case TRACE_DESTROY:
+         *pulResult = (unsigned long) FT_destroy();
+         break;
+      case TRACE_INSERT_DIR:
+         *pulResult = (unsigned long) FT_insertDir(pcPath);
+         break;
+      case TRACE_CONTAINS_DIR:
+         *pulResult = (unsigned long) FT_containsDir(pcPath);
+         break;
+      case TRACE_RM_DIR:
+         *pulResult = (unsigned long) FT_rmDir(pcPath);
+         break;
+      case TRACE_INSERT_FILE:
+         *pulLength = psRecord->ulLength;
+         *pulResult = (unsigned long) FT_insertFile(pcPath,
+            psRecord->bNullContents ? NULL : pvContents,
+            psRecord->ulLength);
+         break;
+      case TRACE_CONTAINS_FILE:
+         *pulResult = (unsigned long) FT_containsFile(pcPath);
+         break;
+      case TRACE_RM_FILE:
+         *pulResult = (unsigned long) FT_rmFile(pcPath);
+         break;
+      case TRACE_GET_CONTENTS:
+         *pulResult = FT_getFileContents(pcPath) != NULL;
+         break;
+      case TRACE_REPLACE_CONTENTS:
+         *pulLength = psRecord->ulLength;
+         *pulResult = NULL != FT_replaceFileContents(pcPath,
+            psRecord->bNullContents ? NULL : pvContents,
+            psRecord->ulLength);
+         break;
+      case TRACE_STAT:
+         iStatus = FT_stat(pcPath, &bIsFile, &ulSize);
+         bIsFile = iStatus == SUCCESS && bIsFile;
+         *pulLength = bIsFile ? ulSize : 0;
+         *pulResult = (unsigned long) iStatus * 2 +
+            (unsigned long) bIsFile;
+         break;
+      default:
+         pcString = FT_toString();
+         ulEnd = Trace_now();
+         *pulResult = 0;
+         if(pcString != NULL) {
+            *pulLength = strlen(pcString);
+            *pulResult = Trace_hash(pcString);
+            free(pcString);
+         }
+         /* the string is hashed outside of the time replayed, as it
+            was when recorded */
+         return ulEnd - ulStart;
+   }
+   return Trace_now() - ulStart;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Replays the trace named by the command-line arguments argv and
+  prints the report to stdout. Returns 0 if nothing diverged, 1 if
+  something did, or 2 for a usage error or unreadable trace.
+*/
+int main(int argc, char *argv[]) {
+   struct replay sReplay;
+   struct opTotals asTotals[TRACE_OPS];
+   struct opTotals sAll;
+   void *pvContents;
+   size_t ulShown = 10;
+   size_t i;
+   int iOpt;
+
+   while((iOpt = getopt(argc, argv, "v:")) != -1) {
+      switch(iOpt) {
+         case 'v': ulShown = (size_t) strtoul(optarg, NULL, 10); break;
+         default:
+            fprintf(stderr, "usage: %s [-v shown] tracefile\n",
+                    argv[0]);
+            return 2;
+      }
+   }
+   if(optind + 1 != argc) {
+      fprintf(stderr, "usage: %s [-v shown] tracefile\n", argv[0]);
+      return 2;
+   }
+
+   memset(&sReplay, 0, sizeof(sReplay));
+   Replay_read(argv[optind], &sReplay);
+   pvContents = calloc(sReplay.ulMaxLength + 1, 1);
+   if(pvContents == NULL)
+      Replay_die("out of memory for file contents");
+
+   memset(asTotals, 0, sizeof(asTotals));
+   memset(&sAll, 0, sizeof(sAll));
+   for(i = 0; i < sReplay.ulCount; i++) {
+      const struct call *psCall = &sReplay.psCalls[i];
+      const struct traceRecord *psRecord = &psCall->sRecord;
+      const char *pcPath = sReplay.pcPaths + psCall->ulPath;
+      struct opTotals *psTotals = &asTotals[psRecord->eOp];
+      size_t ulLength;
+      unsigned long ulResult;
+
+      psTotals->ulCalls++;
+      psTotals->ulRecordedNs += psRecord->ulDuration;
+      psTotals->ulReplayedNs += Replay_call(psRecord, pcPath,
+                                            pvContents, &ulLength,
+                                            &ulResult);
+      if(ulLength == psRecord->ulLength &&
+         ulResult == psRecord->ulResult)
+         continue;
+
+      psTotals->ulDiverged++;
+      if(sAll.ulDiverged++ < ulShown)
+         fprintf(stderr, "call %lu: %s(\"%s\") recorded %lu/%lu, "
+                 "replayed %lu/%lu (length/result)\n",
+                 (unsigned long) i, Trace_getOpName(psRecord->eOp),
+                 pcPath, (unsigned long) psRecord->ulLength,
+                 psRecord->ulResult, (unsigned long) ulLength,
+                 ulResult);
+   }
+
+   printf("%-24s %10s %14s %14s %10s\n", "op", "calls",
+          "recorded ns/op", "replayed ns/op", "diverged");
+   for(i = 0; i < TRACE_OPS; i++) {
+      const struct opTotals *psTotals = &asTotals[i];
+      if(psTotals->ulCalls == 0)
+         continue;
+      printf("%-24s %10lu %14.1f %14.1f %10lu\n",
+             Trace_getOpName((enum traceOp) i),
+             (unsigned long) psTotals->ulCalls,
+             (double) psTotals->ulRecordedNs /
+                (double) psTotals->ulCalls,
+             (double) psTotals->ulReplayedNs /
+                (double) psTotals->ulCalls,
+             (unsigned long) psTotals->ulDiverged);
+      sAll.ulCalls += psTotals->ulCalls;
+      sAll.ulRecordedNs += psTotals->ulRecordedNs;
+      sAll.ulReplayedNs += psTotals->ulReplayedNs;
+   }
+   printf("%-24s %10lu %14.3f %14.3f %10lu  (total ms)\n", "all",
+          (unsigned long) sAll.ulCalls,
+          (double) sAll.ulRecordedNs / 1e6,
+          (double) sAll.ulReplayedNs / 1e6,
+          (unsigned long) sAll.ulDiverged);
+
+   /* the FT may still hold pointers into pvContents */
+   (void) FT_destroy();
+   free(pvContents);
+   free(sReplay.psCalls);
+   free(sReplay.pcPaths);
+
+   return sAll.ulDiverged == 0 ? 0 : 1;
+}
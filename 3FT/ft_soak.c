@@ -0,0 +1,431 @@
+/*--------------------------------------------------------------------*/
+/* ft_soak.c                                                          */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "allocstat.h"
+#include "benchutil.h"
+#include "ft.h"
+
+/*
+  ft_soak churns the FT with a long run of random operations on a
+  fixed set of file paths, checking every result against a model of
+  what the FT should hold, and samples the process's resident set
+  size, the heap blocks it holds, the FT's own statistics and the
+  operations' latency at regular intervals. It fails if a result is
+  wrong, if memory keeps growing, or if latency drifts upwards, as
+  fragmentation or slack building up with churn would make them do.
+
+  Usage: ft_soak [-o ops] [-i interval] [-k files] [-f perdir]
+                 [-s seed] [-g growth%] [-l drift%]
+
+  The -k file paths are spread -f to a directory. Each operation is,
+  at random, a file insertion (35%), removal (30%), contents
+  replacement (20%) or lookup (14%), or the removal of a whole
+  directory (1%), so that the tree settles at about half full and then
+  only churns. A line is printed every -i operations. The first
+  quarter of the samples (at least 2) is a warm-up; the figures of the
+  last quarter are then compared with those of the quarter after the
+  warm-up. ft_soak fails if resident memory, or heap blocks or FT
+  bytes per node, grew by more than -g percent (20 by default), or if
+  the typical mean latency grew by more than -l percent (50 by
+  default).
+
+  Heap blocks are counted by allocstat, so ft_soak must be linked with
+  its --wrap options.
+  Exits with status 0 if the run passed, 1 if it failed, or 2 for a
+  usage error.
+*/
+
+/* The longest file contents used; the FT keeps only the pointer */
+enum { SOAK_MAX_CONTENTS = 256 };
+
+/* The leaf directories under each directory of the root */
+enum { SOAK_DIRS_PER_GROUP = 32 };
+
+/* What is sampled every interval */
+struct sample {
+   /* operations run so far */
+   unsigned long ulOps;
+   /* files and directories in the FT */
+   size_t ulNodes;
+   /* resident set size, in KB */
+   unsigned long ulRssKB;
+   /* heap blocks allocated and not yet freed */
+   size_t ulBlocks;
+   /* bytes of the FT's paths, node records and child arrays, and how
+      much of the latter is slack */
+   size_t ulFtBytes;
+   size_t ulSlackBytes;
+   /* the interval's mean and 99th percentile latency */
+   double dMeanNs;
+   unsigned long ulP99Ns;
+};
+
+/* The model of what the FT should hold */
+struct model {
+   /* whether each file is in the FT */
+   boolean *pbFiles;
+   size_t ulFiles;
+   /* whether each leaf directory is in the FT */
+   boolean *pbDirs;
+   size_t ulPerDir;
+};
+
+/* The state of the pseudo-random generator */
+static unsigned long ulSeed = 1;
+
+/* The contents given to every file, at various lengths */
+static char acContents[SOAK_MAX_CONTENTS];
+
+/*--------------------------------------------------------------------*/
+
+/* Prints msg and exits the soak with status 2. */
+static void Soak_die(const char *pcMsg) {
+   fprintf(stderr, "ft_soak: %s\n", pcMsg);
+   exit(2);
+}
+
+/* Returns the current resident set size in KB, or 0 if unknown. */
+static unsigned long Soak_getRssKB(void) {
+   FILE *psFile;
+   unsigned long ulSize = 0;
+   unsigned long ulResident = 0;
+
+   /* unlike getrusage's ru_maxrss, the current size, which can fall */
+   psFile = fopen("/proc/self/statm", "r");
+   if(psFile == NULL)
+      return 0;
+   if(fscanf(psFile, "%lu %lu", &ulSize, &ulResident) != 2)
+      ulResident = 0;
+   (void) fclose(psFile);
+   return ulResident * (unsigned long) (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* Writes the path of leaf directory ulDir into pcPath. */
+static void Soak_dirPath(char *pcPath, size_t ulDir) {
+   sprintf(pcPath, "s/g%lu/d%lu",
+           (unsigned long) (ulDir / SOAK_DIRS_PER_GROUP),
+           (unsigned long) ulDir);
+}
+
+/* Writes the path of file ulFile of model psModel into pcPath. */
+static void Soak_filePath(char *pcPath, const struct model *psModel,
+                          size_t ulFile) {
+   Soak_dirPath(pcPath, ulFile / psModel->ulPerDir);
+   sprintf(pcPath + strlen(pcPath), "/f%lu", (unsigned long) ulFile);
+}
+
+/*
+  Runs one random operation against the FT and model psModel, and
+  returns whether its result was the one the model expects.
+*/
+static boolean Soak_step(struct model *psModel) {
+   char acPath[96];
+   unsigned long ulDice = BenchUtil_random(&ulSeed) % 100;
+   size_t ulFile = BenchUtil_random(&ulSeed) % psModel->ulFiles;
+   size_t ulDir = ulFile / psModel->ulPerDir;
+   boolean bPresent = psModel->pbFiles[ulFile];
+   size_t ulLength;
+   size_t i;
+   int iStatus;
+
+   if(ulDice < 1) {
+      /* a whole leaf directory, with the files in it */
+      Soak_dirPath(acPath, ulDir);
+      iStatus = FT_rmDir(acPath);
+      if(iStatus != (psModel->pbDirs[ulDir] ? SUCCESS : NO_SUCH_PATH))
+         return FALSE;
+      psModel->pbDirs[ulDir] = FALSE;
+      for(i = ulDir * psModel->ulPerDir;
+          i < (ulDir + 1) * psModel->ulPerDir && i < psModel->ulFiles;
+          i++)
+         psModel->pbFiles[i] = FALSE;
+      return TRUE;
+   }
+
+   Soak_filePath(acPath, psModel, ulFile);
+   ulLength = BenchUtil_random(&ulSeed) % SOAK_MAX_CONTENTS;
+   if(ulDice < 36) {
+      iStatus = FT_insertFile(acPath, acContents, ulLength);
+      psModel->pbFiles[ulFile] = TRUE;
+      psModel->pbDirs[ulDir] = TRUE;
+      return iStatus == (bPresent ? ALREADY_IN_TREE : SUCCESS);
+   }
+   if(ulDice < 66) {
+      iStatus = FT_rmFile(acPath);
+      psModel->pbFiles[ulFile] = FALSE;
+      return iStatus == (bPresent ? SUCCESS : NO_SUCH_PATH);
+   }
+   if(ulDice < 86)
+      return bPresent == (FT_replaceFileContents(acPath, acContents,
+                                                 ulLength) != NULL);
+   return bPresent == FT_containsFile(acPath);
+}
+
+/* Compares two latencies for qsort. */
+static int Soak_compareNs(const void *pvFirst, const void *pvSecond) {
+   unsigned long ulFirst = *(const unsigned long *) pvFirst;
+   unsigned long ulSecond = *(const unsigned long *) pvSecond;
+   return (ulFirst > ulSecond) - (ulFirst < ulSecond);
+}
+
+/* Compares two doubles for qsort. */
+static int Soak_compareDouble(const void *pvFirst,
+                              const void *pvSecond) {
+   double dFirst = *(const double *) pvFirst;
+   double dSecond = *(const double *) pvSecond;
+   return (dFirst > dSecond) - (dFirst < dSecond);
+}
+
+/*
+  Fills in *psSample after ulOps operations, from the ulCount
+  latencies pulNs of the interval, which it sorts.
+*/
+static void Soak_sample(struct sample *psSample, unsigned long ulOps,
+                        unsigned long *pulNs, size_t ulCount) {
+   struct allocStats sAllocs;
+   struct ftStats sStats;
+   double dTotal = 0.0;
+   size_t i;
+
+   assert(ulCount > 0);
+
+   if(FT_getStats(&sStats) != SUCCESS)
+      Soak_die("FT_getStats failed");
+   AllocStat_get(&sAllocs);
+   for(i = 0; i < ulCount; i++)
+      dTotal += (double) pulNs[i];
+   qsort(pulNs, ulCount, sizeof(unsigned long), Soak_compareNs);
+
+   psSample->ulOps = ulOps;
+   psSample->ulNodes = sStats.ulDirs + sStats.ulFiles;
+   psSample->ulRssKB = Soak_getRssKB();
+   psSample->ulBlocks = sAllocs.ulAllocs - sAllocs.ulFrees;
+   psSample->ulFtBytes = sStats.ulPathBytes + sStats.ulNodeBytes +
+      sStats.ulChildBytes;
+   psSample->ulSlackBytes = sStats.ulSlackBytes;
+   psSample->dMeanNs = dTotal / (double) ulCount;
+   psSample->ulP99Ns = pulNs[(ulCount * 99) / 100];
+}
+
+/*
+  Returns the median of pdValues[0..ulCount-1], which it sorts.
+*/
+static double Soak_median(double *pdValues, size_t ulCount) {
+   assert(ulCount > 0);
+
+   qsort(pdValues, ulCount, sizeof(double), Soak_compareDouble);
+   return pdValues[ulCount / 2];
+}
+
+/*
+  Returns the largest of the ulCount samples psSamples as measured by
+  measure pfMeasure.
+*/
+static double Soak_max(const struct sample *psSamples, size_t ulCount,
+                       double (*pfMeasure)(const struct sample *)) {
+   double dMax = 0.0;
+   size_t i;
+
+   for(i = 0; i < ulCount; i++)
+      if(pfMeasure(&psSamples[i]) > dMax)
+         dMax = pfMeasure(&psSamples[i]);
+   return dMax;
+}
+
+/* Returns the resident set size of sample psSample. */
+static double Soak_rss(const struct sample *psSample) {
+   return (double) psSample->ulRssKB;
+}
+
+/* Returns the heap blocks per FT node of sample psSample. */
+static double Soak_blocksPerNode(const struct sample *psSample) {
+   return (double) psSample->ulBlocks /
+      (double) (psSample->ulNodes + 1);
+}
+
+/* Returns the FT bytes per FT node of sample psSample. */
+static double Soak_bytesPerNode(const struct sample *psSample) {
+   return (double) psSample->ulFtBytes /
+      (double) (psSample->ulNodes + 1);
+}
+
+/*
+  Compares the ulCount samples psBefore with the as many samples
+  psAfter, and prints and returns the number of ways in which memory
+  grew by more than dGrowth percent or latency by more than dDrift
+  percent.
+*/
+static size_t Soak_judge(const struct sample *psBefore,
+                         const struct sample *psAfter, size_t ulCount,
+                         double dGrowth, double dDrift) {
+   static const char *apcNames[] = {
+      "resident KB", "heap blocks/node", "FT bytes/node"
+   };
+   double (*apfMeasures[])(const struct sample *) = {
+      Soak_rss, Soak_blocksPerNode, Soak_bytesPerNode
+   };
+   double *pdMeans;
+   double dBefore;
+   double dAfter;
+   size_t ulFailures = 0;
+   size_t m;
+   size_t i;
+
+   for(m = 0; m < sizeof(apfMeasures) / sizeof(apfMeasures[0]); m++) {
+      dBefore = Soak_max(psBefore, ulCount, apfMeasures[m]);
+      dAfter = Soak_max(psAfter, ulCount, apfMeasures[m]);
+      printf("%-18s %12.2f -> %12.2f", apcNames[m], dBefore, dAfter);
+      if(dAfter > dBefore * (1.0 + dGrowth / 100.0)) {
+         printf("  GREW\n");
+         ulFailures++;
+      }
+      else
+         printf("\n");
+   }
+
+   /* the median interval, so that one noisy interval is not drift */
+   pdMeans = malloc(ulCount * sizeof(double));
+   if(pdMeans == NULL)
+      Soak_die("out of memory judging the run");
+   for(i = 0; i < ulCount; i++)
+      pdMeans[i] = psBefore[i].dMeanNs;
+   dBefore = Soak_median(pdMeans, ulCount);
+   for(i = 0; i < ulCount; i++)
+      pdMeans[i] = psAfter[i].dMeanNs;
+   dAfter = Soak_median(pdMeans, ulCount);
+   free(pdMeans);
+   printf("%-18s %12.2f -> %12.2f", "mean ns", dBefore, dAfter);
+   if(dAfter > dBefore * (1.0 + dDrift / 100.0)) {
+      printf("  DRIFTED\n");
+      ulFailures++;
+   }
+   else
+      printf("\n");
+   return ulFailures;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Runs the soak selected by the command-line arguments argv and prints
+  its samples and verdict to stdout. Returns 0 if it passed, 1 if it
+  failed, or 2 for a usage error.
+*/
+int main(int argc, char *argv[]) {
+   struct model sModel;
+   struct sample *psSamples;
+   unsigned long *pulNs;
+   unsigned long ulOps = 200000000UL;
+   unsigned long ulInterval = 1000000UL;
+   unsigned long ulDone;
+   size_t ulSamples;
+   size_t ulUsed = 0;
+   size_t ulWarmup;
+   size_t ulQuarter;
+   size_t ulErrors = 0;
+   size_t ulFailures;
+   double dGrowth = 20.0;
+   double dDrift = 50.0;
+   int iOpt;
+
+   sModel.ulFiles = 100000;
+   sModel.ulPerDir = 16;
+   while((iOpt = getopt(argc, argv, "o:i:k:f:s:g:l:")) != -1) {
+      switch(iOpt) {
+         case 'o': ulOps = strtoul(optarg, NULL, 10); break;
+         case 'i': ulInterval = strtoul(optarg, NULL, 10); break;
+         case 'k': sModel.ulFiles = (size_t) strtoul(optarg, NULL, 10);
+                   break;
+         case 'f': sModel.ulPerDir = (size_t) strtoul(optarg, NULL, 10);
+                   break;
+         case 's': ulSeed = strtoul(optarg, NULL, 10); break;
+         case 'g': dGrowth = strtod(optarg, NULL); break;
+         case 'l': dDrift = strtod(optarg, NULL); break;
+         default:
+            fprintf(stderr, "usage: %s [-o ops] [-i interval] "
+                    "[-k files] [-f perdir] [-s seed] [-g growth%%] "
+                    "[-l drift%%]\n", argv[0]);
+            return 2;
+      }
+   }
+   /* a zero seed would make xorshift stick at zero */
+   if(ulSeed == 0)
+      ulSeed = 1;
+   if(ulInterval == 0 || sModel.ulFiles == 0 || sModel.ulPerDir == 0)
+      Soak_die("-i, -k and -f must be positive");
+   ulSamples = (size_t) (ulOps / ulInterval);
+   if(ulSamples < 8)
+      Soak_die("-o must be at least 8 intervals of -i");
+
+   sModel.pbFiles = calloc(sModel.ulFiles, sizeof(boolean));
+   sModel.pbDirs = calloc(sModel.ulFiles / sModel.ulPerDir + 1,
+                          sizeof(boolean));
+   psSamples = malloc(ulSamples * sizeof(struct sample));
+   pulNs = malloc(ulInterval * sizeof(unsigned long));
+   if(sModel.pbFiles == NULL || sModel.pbDirs == NULL ||
+      psSamples == NULL || pulNs == NULL)
+      Soak_die("out of memory");
+   memset(acContents, 's', sizeof(acContents));
+
+   if(FT_init() != SUCCESS)
+      Soak_die("FT_init failed");
+   printf("%12s %9s %10s %10s %12s %10s %9s %9s %7s\n", "ops", "nodes",
+          "rss KB", "blocks", "FT bytes", "slack", "mean ns",
+          "p99 ns", "errors");
+   for(ulDone = 0; ulUsed < ulSamples; ) {
+      unsigned long ulStart = BenchUtil_now();
+      unsigned long ulEnd;
+      size_t i;
+
+      for(i = 0; i < ulInterval; i++) {
+         if(!Soak_step(&sModel))
+            ulErrors++;
+         ulEnd = BenchUtil_now();
+         pulNs[i] = ulEnd - ulStart;
+         ulStart = ulEnd;
+      }
+      ulDone += ulInterval;
+
+      Soak_sample(&psSamples[ulUsed], ulDone, pulNs, ulInterval);
+      printf("%12lu %9lu %10lu %10lu %12lu %10lu %9.1f %9lu %7lu\n",
+             ulDone, (unsigned long) psSamples[ulUsed].ulNodes,
+             psSamples[ulUsed].ulRssKB,
+             (unsigned long) psSamples[ulUsed].ulBlocks,
+             (unsigned long) psSamples[ulUsed].ulFtBytes,
+             (unsigned long) psSamples[ulUsed].ulSlackBytes,
+             psSamples[ulUsed].dMeanNs, psSamples[ulUsed].ulP99Ns,
+             (unsigned long) ulErrors);
+      (void) fflush(stdout);
+      ulUsed++;
+   }
+   if(FT_destroy() != SUCCESS)
+      Soak_die("FT_destroy failed");
+
+   ulQuarter = ulSamples / 4;
+   ulWarmup = ulQuarter < 2 ? 2 : ulQuarter;
+   if(ulQuarter > ulSamples - ulWarmup - ulQuarter)
+      ulQuarter = (ulSamples - ulWarmup) / 2;
+   ulFailures = Soak_judge(&psSamples[ulWarmup],
+                           &psSamples[ulSamples - ulQuarter], ulQuarter,
+                           dGrowth, dDrift);
+   if(ulErrors > 0)
+      printf("%lu operations returned the wrong result\n",
+             (unsigned long) ulErrors);
+   printf("%s\n", ulFailures == 0 && ulErrors == 0 ? "PASS" : "FAIL");
+
+   free(sModel.pbFiles);
+   free(sModel.pbDirs);
+   free(psSamples);
+   free(pulNs);
+   return ulFailures == 0 && ulErrors == 0 ? 0 : 1;
+}
@@ -0,0 +1,330 @@
+/*--------------------------------------------------------------------*/
+/* ftbulk_client.c                                                    */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "benchutil.h"
+#include "ft.h"
+
+/*
+  ftbulk_client checks FT_beginBulk and FT_endBulk: the same random
+  stream of operations, run once without a bulk phase and once with
+  most of it inside bulk phases, must give the same result for every
+  operation, the same FT_getStats after every operation, and the same
+  final FT_toString. The stream includes the operations that put the
+  children back in order in the middle of a bulk phase (removals,
+  FT_toString, FT_exportTar, FT_saveImage and FT_exportToDisk), and
+  directories wide enough to need the bulk phase's table to grow.
+  Like ft_client, it checks with assert, so it must be built without
+  NDEBUG.
+*/
+
+/* The length of the stream, and the seed it is generated from */
+enum { OPS = 6000, SEED = 20261018 };
+
+/* The names at each level beneath the root r: many at the first, so
+   that its directories grow wide, and few below */
+enum { WIDE_NAMES = 48, NARROW_NAMES = 5, MAX_DEPTH = 3 };
+
+/* The longest path, and the contents files are given */
+enum { MAX_PATH = 64, CONTENTS = 16 };
+
+/* The operations of the stream */
+enum bulkOp {
+   OP_INSERT_DIR, OP_INSERT_FILE, OP_CONTAINS_DIR, OP_CONTAINS_FILE,
+   OP_GET_CONTENTS, OP_REPLACE_CONTENTS, OP_STAT, OP_RM_DIR,
+   OP_RM_FILE, OP_TO_STRING, OP_EXPORT_TAR, OP_SAVE_IMAGE,
+   OP_EXPORT_DISK, OP_COUNT
+};
+
+/* Each operation's share of the stream, out of 1000 */
+static const size_t aulShares[OP_COUNT] = {
+   300, 280, 60, 60, 50, 50, 50, 30, 60, 30, 20, 20, 50
+};
+
+/* The bytes every file's contents are taken from: contents k are the
+   k bytes at offset k. The FT never copies them. */
+static char acContents[2 * CONTENTS];
+
+/* What one run of the stream returned */
+struct run {
+   /* each operation's status, or a digest of what it returned */
+   unsigned long aulResults[OPS];
+   /* a digest of FT_getStats after each operation */
+   unsigned long aulStats[OPS];
+   /* the final FT_toString output, owned by the run */
+   char *pcTree;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Returns ulDigest with the ulLength bytes of pvData added (FNV-1a). */
+static unsigned long Client_digest(unsigned long ulDigest,
+                                   const void *pvData,
+                                   size_t ulLength) {
+   const unsigned char *puc = pvData;
+
+   while(ulLength-- > 0) {
+      ulDigest ^= *puc++;
+      ulDigest *= 16777619UL;
+   }
+   return ulDigest;
+}
+
+/* Returns a digest of the bytes of psFile, which is then closed. */
+static unsigned long Client_digestFile(FILE *psFile) {
+   char acBuffer[4096];
+   unsigned long ulDigest = 2166136261UL;
+   size_t ulRead;
+
+   assert(fflush(psFile) == 0);
+   assert(fseek(psFile, 0L, SEEK_SET) == 0);
+   while((ulRead = fread(acBuffer, 1, sizeof(acBuffer), psFile)) > 0)
+      ulDigest = Client_digest(ulDigest, acBuffer, ulRead);
+   (void) fclose(psFile);
+   return ulDigest;
+}
+
+/* Returns a digest of what FT_getStats reports now. */
+static unsigned long Client_digestStats(void) {
+   struct ftStats sStats;
+
+   assert(FT_getStats(&sStats) == SUCCESS);
+   return Client_digest(2166136261UL, &sStats, sizeof(sStats));
+}
+
+/* Returns a digest of pcString, which it frees, or of NULL. */
+static unsigned long Client_digestString(char *pcString) {
+   unsigned long ulDigest;
+
+   if(pcString == NULL)
+      return 0;
+   ulDigest = Client_digest(2166136261UL, pcString, strlen(pcString));
+   free(pcString);
+   return ulDigest;
+}
+
+/* Returns which of acContents pvContents is, or OPS if it is NULL. */
+static unsigned long Client_contentsIndex(void *pvContents) {
+   if(pvContents == NULL)
+      return OPS;
+   assert((char *) pvContents >= acContents &&
+          (char *) pvContents < acContents + CONTENTS);
+   return (unsigned long) ((char *) pvContents - acContents);
+}
+
+/* Removes pcName, relative to iDirFd, and everything beneath it. */
+static void Client_removeTree(int iDirFd, const char *pcName) {
+   struct stat sStat;
+   DIR *psDir;
+   struct dirent *psEntry;
+   int iSubFd;
+
+   assert(fstatat(iDirFd, pcName, &sStat, AT_SYMLINK_NOFOLLOW) == 0);
+   if(!S_ISDIR(sStat.st_mode)) {
+      assert(unlinkat(iDirFd, pcName, 0) == 0);
+      return;
+   }
+
+   iSubFd = openat(iDirFd, pcName, O_RDONLY | O_DIRECTORY);
+   assert(iSubFd >= 0);
+   psDir = fdopendir(iSubFd);
+   assert(psDir != NULL);
+   while((psEntry = readdir(psDir)) != NULL)
+      if(strcmp(psEntry->d_name, ".") != 0 &&
+         strcmp(psEntry->d_name, "..") != 0)
+         Client_removeTree(iSubFd, psEntry->d_name);
+   (void) closedir(psDir);
+   assert(unlinkat(iDirFd, pcName, AT_REMOVEDIR) == 0);
+}
+
+/*
+  Writes to acPath a random path beneath root r, of 1 to MAX_DEPTH
+  components, drawn with *pulSeed. Rarely, the path is the root
+  itself, or not beneath it.
+*/
+static void Client_makePath(char *acPath, unsigned long *pulSeed) {
+   size_t ulDepth = 1 + BenchUtil_random(pulSeed) % MAX_DEPTH;
+   size_t ulRoll = BenchUtil_random(pulSeed) % 1000;
+   size_t d;
+
+   if(ulRoll == 0) {
+      strcpy(acPath, "r");
+      return;
+   }
+   strcpy(acPath, ulRoll == 1 ? "s" : "r");
+   for(d = 0; d < ulDepth; d++)
+      sprintf(acPath + strlen(acPath), "/%c%lu", (char) ('a' + d),
+              (unsigned long) (BenchUtil_random(pulSeed) %
+                               (d == 0 ? WIDE_NAMES : NARROW_NAMES)));
+}
+
+/* Returns the operation that share ulRoll (< 1000) falls on. */
+static enum bulkOp Client_pickOp(size_t ulRoll) {
+   size_t ulTotal = 0;
+   int iOp;
+
+   for(iOp = 0; iOp < OP_COUNT - 1; iOp++) {
+      ulTotal += aulShares[iOp];
+      if(ulRoll < ulTotal)
+         break;
+   }
+   return (enum bulkOp) iOp;
+}
+
+/*
+  Runs operation eOp on pcPath, with file contents index ulIndex, and
+  returns its status or a digest of what it returned. Exports go to
+  descriptors of scratch files or to directory pcScratch.
+*/
+static unsigned long Client_runOp(enum bulkOp eOp, const char *pcPath,
+                                  size_t ulIndex,
+                                  const char *pcScratch) {
+   boolean bIsFile = FALSE;
+   size_t ulSize = 0;
+   FILE *psFile;
+   int iStatus;
+
+   switch(eOp) {
+      case OP_INSERT_DIR:
+         return (unsigned long) FT_insertDir(pcPath);
+      case OP_INSERT_FILE:
+         return (unsigned long) FT_insertFile(pcPath,
+                                              acContents + ulIndex,
+                                              ulIndex);
+      case OP_CONTAINS_DIR:
+         return (unsigned long) FT_containsDir(pcPath);
+      case OP_CONTAINS_FILE:
+         return (unsigned long) FT_containsFile(pcPath);
+      case OP_GET_CONTENTS:
+         return Client_contentsIndex(FT_getFileContents(pcPath));
+      case OP_REPLACE_CONTENTS:
+         return Client_contentsIndex(
+            FT_replaceFileContents(pcPath, acContents + ulIndex,
+                                   ulIndex));
+      case OP_STAT:
+         iStatus = FT_stat(pcPath, &bIsFile, &ulSize);
+         return (unsigned long) iStatus * 1000UL +
+            (unsigned long) bIsFile * 100UL + (unsigned long) ulSize;
+      case OP_RM_DIR:
+         return (unsigned long) FT_rmDir(pcPath);
+      case OP_RM_FILE:
+         return (unsigned long) FT_rmFile(pcPath);
+      case OP_TO_STRING:
+         return Client_digestString(FT_toString());
+      case OP_EXPORT_TAR:
+         psFile = tmpfile();
+         assert(psFile != NULL);
+         iStatus = FT_exportTar(pcPath, fileno(psFile));
+         return Client_digestFile(psFile) + (unsigned long) iStatus;
+      case OP_SAVE_IMAGE:
+         psFile = tmpfile();
+         assert(psFile != NULL);
+         iStatus = FT_saveImage(fileno(psFile));
+         return Client_digestFile(psFile) + (unsigned long) iStatus;
+      case OP_EXPORT_DISK:
+         return (unsigned long) FT_exportToDisk(pcPath, pcScratch,
+                                                FT_EXPORT_SERIAL);
+      default:
+         assert(FALSE);
+         return 0;
+   }
+}
+
+/*
+  Runs the stream into *psRun, in bulk phases from operation
+  OPS / 12 to OPS / 3 and from OPS / 2 to 5 * OPS / 6 if bBulk, with
+  exports to disk beneath a new directory pcName in directory pcBase,
+  which is removed afterwards.
+*/
+static void Client_run(struct run *psRun, boolean bBulk,
+                       const char *pcBase, const char *pcName) {
+   unsigned long ulSeed = SEED;
+   char acScratch[2 * MAX_PATH];
+   char acPath[MAX_PATH];
+   size_t i;
+
+   sprintf(acScratch, "%s/%s", pcBase, pcName);
+   assert(mkdir(acScratch, 0700) == 0);
+   assert(FT_init() == SUCCESS);
+   assert(FT_endBulk() == INITIALIZATION_ERROR);
+   for(i = 0; i < OPS; i++) {
+      enum bulkOp eOp =
+         Client_pickOp(BenchUtil_random(&ulSeed) % 1000);
+      size_t ulIndex = BenchUtil_random(&ulSeed) % CONTENTS;
+
+      if(bBulk && (i == OPS / 12 || i == OPS / 2)) {
+         assert(FT_beginBulk() == SUCCESS);
+         assert(FT_beginBulk() == INITIALIZATION_ERROR);
+      }
+      if(bBulk && (i == OPS / 3 || i == 5 * OPS / 6)) {
+         assert(FT_endBulk() == SUCCESS);
+         assert(FT_endBulk() == INITIALIZATION_ERROR);
+      }
+
+      Client_makePath(acPath, &ulSeed);
+      psRun->aulResults[i] =
+         Client_runOp(eOp, acPath, ulIndex, acScratch);
+      psRun->aulStats[i] = Client_digestStats();
+   }
+   assert((psRun->pcTree = FT_toString()) != NULL);
+   assert(FT_destroy() == SUCCESS);
+   Client_removeTree(AT_FDCWD, acScratch);
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Runs the stream with and without bulk phases, exporting to disk
+  beneath a new scratch directory in $TMPDIR (or /tmp), which is
+  removed afterwards, and compares the runs. Returns 0; a failed
+  check aborts.
+*/
+int main(void) {
+   static struct run sPlain;
+   static struct run sBulk;
+   char acBase[MAX_PATH];
+   const char *pcTmp;
+   size_t ulNodes = 0;
+   size_t i;
+
+   assert(FT_beginBulk() == INITIALIZATION_ERROR);
+
+   pcTmp = getenv("TMPDIR");
+   if(pcTmp == NULL || strlen(pcTmp) + 20 > sizeof(acBase))
+      pcTmp = "/tmp";
+   sprintf(acBase, "%s/ftbulk_XXXXXX", pcTmp);
+   assert(mkdtemp(acBase) != NULL);
+
+   Client_run(&sPlain, FALSE, acBase, "plain");
+   Client_run(&sBulk, TRUE, acBase, "bulk");
+   for(i = 0; i < OPS; i++) {
+      if(sPlain.aulResults[i] != sBulk.aulResults[i] ||
+         sPlain.aulStats[i] != sBulk.aulStats[i])
+         fprintf(stderr, "ftbulk_client: operation %lu differs\n",
+                 (unsigned long) i);
+      assert(sPlain.aulResults[i] == sBulk.aulResults[i]);
+      assert(sPlain.aulStats[i] == sBulk.aulStats[i]);
+   }
+   assert(strcmp(sPlain.pcTree, sBulk.pcTree) == 0);
+
+   for(i = 0; sPlain.pcTree[i] != '\0'; i++)
+      ulNodes += sPlain.pcTree[i] == '\n';
+   free(sPlain.pcTree);
+   free(sBulk.pcTree);
+   assert(rmdir(acBase) == 0);
+   fprintf(stderr, "ftbulk_client: %lu operations, %lu final nodes, "
+           "all checks passed\n", (unsigned long) OPS,
+           (unsigned long) ulNodes);
+   return 0;
+}
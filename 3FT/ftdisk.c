@@ -0,0 +1,283 @@
+/*--------------------------------------------------------------------*/
+/* ftdisk.c                                                           */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "dynarray.h"
+#include "path.h"
+#include "ft.h"
+#include "ftdisk.h"
+
+/* The most worker threads a single export will start */
+enum { FTDISK_MAX_THREADS = 16 };
+
+/* The shared state of one export, handed to every worker thread */
+struct exportJob {
+   /* the directories being exported, parents before children */
+   DynArray_T oDDirs;
+   /* the index in oDDirs of the next directory to hand out */
+   size_t ulNext;
+   /* guards ulNext and iStatus */
+   pthread_mutex_t mutex;
+   /* an open descriptor for the target directory */
+   int iDirFd;
+   /* how many leading bytes of an FT pathname to drop on disk */
+   size_t ulOffset;
+   /* the FT_EXPORT_* flags of the request */
+   int iFlags;
+   /* SUCCESS, or the first failure status any worker ran into */
+   int iStatus;
+};
+
+/*
+  Returns the on-disk name, relative to the target directory, of
+  oNNode in the export described by psJob.
+*/
+static const char *FTDisk_relativeName(struct exportJob *psJob,
+                                       Node_T oNNode) {
+   assert(psJob != NULL);
+   assert(oNNode != NULL);
+
+   return Path_getPathname(Node_getPath(oNNode)) + psJob->ulOffset;
+}
+
+/*
+  Creates (or truncates) file node oNFile on disk and writes its
+  contents. Returns SUCCESS or IO_ERROR.
+*/
+static int FTDisk_writeFile(struct exportJob *psJob, Node_T oNFile) {
+   int iFd;
+   const char *pcContents;
+   size_t ulLeft;
+   ssize_t lWritten;
+
+   assert(psJob != NULL);
+   assert(oNFile != NULL);
+
+   iFd = openat(psJob->iDirFd, FTDisk_relativeName(psJob, oNFile),
+                O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   if(iFd < 0)
+      return IO_ERROR;
+
+   /* files with NULL contents are exported as empty files */
+   pcContents = Node_getFileContents(oNFile);
+   ulLeft = pcContents == NULL ? 0 : Node_getFileSize(oNFile);
+   while(ulLeft > 0) {
+      lWritten = write(iFd, pcContents, ulLeft);
+      if(lWritten < 0) {
+         if(errno == EINTR)
+            continue;
+         (void) close(iFd);
+         return IO_ERROR;
+      }
+      pcContents += lWritten;
+      ulLeft -= (size_t) lWritten;
+   }
+
+   if((psJob->iFlags & FT_EXPORT_FSYNC) && fsync(iFd) != 0) {
+      (void) close(iFd);
+      return IO_ERROR;
+   }
+   if(close(iFd) != 0)
+      return IO_ERROR;
+   return SUCCESS;
+}
+
+/*
+  Worker loop: repeatedly claims the next unclaimed directory of the
+  export pvJob and writes all of its file children, until every
+  directory has been claimed or some worker has failed. Returns NULL.
+*/
+static void *FTDisk_worker(void *pvJob) {
+   struct exportJob *psJob = pvJob;
+   Node_T oNDir;
+   Node_T oNChild = NULL;
+   size_t ulIndex;
+   size_t c;
+   int iStatus;
+
+   assert(psJob != NULL);
+
+   for(;;) {
+      (void) pthread_mutex_lock(&psJob->mutex);
+      if(psJob->iStatus != SUCCESS ||
+         psJob->ulNext == DynArray_getLength(psJob->oDDirs)) {
+         (void) pthread_mutex_unlock(&psJob->mutex);
+         return NULL;
+      }
+      ulIndex = psJob->ulNext++;
+      (void) pthread_mutex_unlock(&psJob->mutex);
+
+      oNDir = DynArray_get(psJob->oDDirs, ulIndex);
+      for(c = 0; c < Node_getNumChildren(oNDir); c++) {
+         iStatus = Node_getChild(oNDir, c, &oNChild);
+         assert(iStatus == SUCCESS);
+         if(Node_getType(oNChild) != FILE_NODE)
+            continue;
+
+         iStatus = FTDisk_writeFile(psJob, oNChild);
+         if(iStatus != SUCCESS) {
+            (void) pthread_mutex_lock(&psJob->mutex);
+            psJob->iStatus = iStatus;
+            (void) pthread_mutex_unlock(&psJob->mutex);
+            return NULL;
+         }
+      }
+   }
+}
+
+/*
+  Fills psJob->oDDirs with every directory in the subtree rooted at
+  oNDir in breadth-first order, so that each directory follows its
+  parent. Returns SUCCESS or MEMORY_ERROR.
+*/
+static int FTDisk_collectDirs(struct exportJob *psJob, Node_T oNDir) {
+   Node_T oNCurr;
+   Node_T oNChild = NULL;
+   size_t ulIndex;
+   size_t c;
+   int iStatus;
+
+   assert(psJob != NULL);
+   assert(oNDir != NULL);
+
+   if(!DynArray_add(psJob->oDDirs, oNDir))
+      return MEMORY_ERROR;
+
+   /* oDDirs doubles as the breadth-first work queue */
+   for(ulIndex = 0; ulIndex < DynArray_getLength(psJob->oDDirs);
+       ulIndex++) {
+      oNCurr = DynArray_get(psJob->oDDirs, ulIndex);
+      for(c = 0; c < Node_getNumChildren(oNCurr); c++) {
+         iStatus = Node_getChild(oNCurr, c, &oNChild);
+         assert(iStatus == SUCCESS);
+         /* read only by the assertion */
+         (void) iStatus;
+         if(Node_getType(oNChild) == DIRECTORY &&
+            !DynArray_add(psJob->oDDirs, oNChild))
+            return MEMORY_ERROR;
+      }
+   }
+   return SUCCESS;
+}
+
+/*
+  Creates every directory of psJob on disk, in order, tolerating
+  directories that already exist. Returns SUCCESS or IO_ERROR.
+*/
+static int FTDisk_makeDirs(struct exportJob *psJob) {
+   size_t ulIndex;
+
+   assert(psJob != NULL);
+
+   for(ulIndex = 0; ulIndex < DynArray_getLength(psJob->oDDirs);
+       ulIndex++) {
+      const char *pcName = FTDisk_relativeName(psJob,
+                              DynArray_get(psJob->oDDirs, ulIndex));
+      if(mkdirat(psJob->iDirFd, pcName, 0777) != 0) {
+         struct stat sStat;
+         if(errno != EEXIST ||
+            fstatat(psJob->iDirFd, pcName, &sStat, 0) != 0 ||
+            !S_ISDIR(sStat.st_mode))
+            return IO_ERROR;
+      }
+   }
+   return SUCCESS;
+}
+
+/*
+  Writes the file children of every directory of psJob, using up to
+  FTDISK_MAX_THREADS threads (including the calling thread) if
+  FT_EXPORT_PARALLEL was requested. Returns the job's final status.
+*/
+static int FTDisk_writeFiles(struct exportJob *psJob) {
+   pthread_t aThreads[FTDISK_MAX_THREADS];
+   size_t ulThreads = 0;
+   size_t ulWanted = 1;
+   long lCpus;
+
+   assert(psJob != NULL);
+
+   if(psJob->iFlags & FT_EXPORT_PARALLEL) {
+      lCpus = sysconf(_SC_NPROCESSORS_ONLN);
+      if(lCpus > 1)
+         ulWanted = (size_t) lCpus;
+      if(ulWanted > FTDISK_MAX_THREADS)
+         ulWanted = FTDISK_MAX_THREADS;
+      if(ulWanted > DynArray_getLength(psJob->oDDirs))
+         ulWanted = DynArray_getLength(psJob->oDDirs);
+   }
+
+   /* the calling thread is always one of the workers, so failing to
+      start extra threads only costs parallelism */
+   while(ulThreads + 1 < ulWanted &&
+         pthread_create(&aThreads[ulThreads], NULL, FTDisk_worker,
+                        psJob) == 0)
+      ulThreads++;
+
+   (void) FTDisk_worker(psJob);
+
+   while(ulThreads > 0)
+      (void) pthread_join(aThreads[--ulThreads], NULL);
+
+   return psJob->iStatus;
+}
+
+int FTDisk_export(Node_T oNNode, const char *pcTargetDir, int iFlags) {
+   struct exportJob sJob;
+   Path_T oPPath;
+   int iStatus;
+
+   assert(oNNode != NULL);
+   assert(pcTargetDir != NULL);
+
+   /* on disk, names start at oNNode's own (last) component */
+   oPPath = Node_getPath(oNNode);
+   sJob.ulOffset = Path_getStrLength(oPPath) -
+      strlen(Path_getComponent(oPPath, Path_getDepth(oPPath) - 1));
+   sJob.ulNext = 0;
+   sJob.iFlags = iFlags;
+   sJob.iStatus = SUCCESS;
+
+   sJob.iDirFd = open(pcTargetDir, O_RDONLY | O_DIRECTORY);
+   if(sJob.iDirFd < 0)
+      return IO_ERROR;
+
+   if(Node_getType(oNNode) == FILE_NODE) {
+      iStatus = FTDisk_writeFile(&sJob, oNNode);
+      (void) close(sJob.iDirFd);
+      return iStatus;
+   }
+
+   sJob.oDDirs = DynArray_new(0);
+   if(sJob.oDDirs == NULL) {
+      (void) close(sJob.iDirFd);
+      return MEMORY_ERROR;
+   }
+
+   iStatus = FTDisk_collectDirs(&sJob, oNNode);
+   if(iStatus == SUCCESS)
+      iStatus = FTDisk_makeDirs(&sJob);
+   if(iStatus == SUCCESS) {
+      if(pthread_mutex_init(&sJob.mutex, NULL) != 0)
+         iStatus = MEMORY_ERROR;
+      else {
+         iStatus = FTDisk_writeFiles(&sJob);
+         (void) pthread_mutex_destroy(&sJob.mutex);
+      }
+   }
+
+   DynArray_free(sJob.oDDirs);
+   if(close(sJob.iDirFd) != 0 && iStatus == SUCCESS)
+      iStatus = IO_ERROR;
+   return iStatus;
+}
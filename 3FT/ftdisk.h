@@ -0,0 +1,20 @@
+/*--------------------------------------------------------------------*/
+/* ftdisk.h                                                           */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef FTDISK_INCLUDED
+#define FTDISK_INCLUDED
+
+#include "a4def.h"
+#include "nodeFT.h"
+
+/*
+  Writes the file or hierarchy rooted at oNNode beneath the existing
+  local directory pcTargetDir, as specified for FT_exportToDisk with
+  flags iFlags. Returns SUCCESS, or IO_ERROR or MEMORY_ERROR as
+  specified there.
+*/
+int FTDisk_export(Node_T oNNode, const char *pcTargetDir, int iFlags);
+
+#endif
@@ -0,0 +1,353 @@
+/*--------------------------------------------------------------------*/
+/* ftdisk_client.c                                                    */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ft.h"
+
+/*
+  ftdisk_client checks FT_exportToDisk: it exports a small hierarchy
+  serially and with FT_EXPORT_PARALLEL into a scratch directory,
+  checks that both copies match each other and the FT, and checks
+  re-exporting over an existing copy, exporting a subtree and a
+  single file, and each error status. Like ft_client, it checks with
+  assert, so it must be built without NDEBUG.
+*/
+
+/* The directories and files of the generated part of the hierarchy */
+enum { WIDE_DIRS = 8, WIDE_FILES = 6, MAX_CONTENTS = 64 };
+
+/* The longest path or file read back from disk */
+enum { MAX_NAME = 256, MAX_READ = 1024 };
+
+/* The contents of the generated files, which the FT does not copy */
+static char aacContents[WIDE_DIRS * WIDE_FILES][MAX_CONTENTS];
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Builds the hierarchy exported by every check: a few hand-written
+  directories and files, including an empty file and a deep chain,
+  and WIDE_DIRS directories of WIDE_FILES files each, so that a
+  parallel export has work for several threads.
+*/
+static void Client_makeTree(void) {
+   char acPath[MAX_NAME];
+   size_t ulDir;
+   size_t ulFile;
+
+   assert(FT_init() == SUCCESS);
+   assert(FT_insertDir("r") == SUCCESS);
+   assert(FT_insertFile("r/a/f1", "alpha", strlen("alpha")) ==
+          SUCCESS);
+   assert(FT_insertFile("r/a/f2", NULL, 0) == SUCCESS);
+   assert(FT_insertFile("r/a/b/c/deep", "deep contents",
+                        strlen("deep contents")) == SUCCESS);
+   assert(FT_insertDir("r/empty") == SUCCESS);
+   assert(FT_insertFile("r/z", "zed", strlen("zed")) == SUCCESS);
+
+   for(ulDir = 0; ulDir < WIDE_DIRS; ulDir++)
+      for(ulFile = 0; ulFile < WIDE_FILES; ulFile++) {
+         char *pcContents = aacContents[ulDir * WIDE_FILES + ulFile];
+         sprintf(pcContents, "file %lu of directory %lu",
+                 (unsigned long) ulFile, (unsigned long) ulDir);
+         sprintf(acPath, "r/w/d%lu/f%lu", (unsigned long) ulDir,
+                 (unsigned long) ulFile);
+         assert(FT_insertFile(acPath, pcContents, strlen(pcContents))
+                == SUCCESS);
+      }
+}
+
+/*
+  Reads file pcName, relative to directory descriptor iDirFd, into
+  pcBuffer, which has room for MAX_READ bytes. Returns its length.
+*/
+static size_t Client_readFile(int iDirFd, const char *pcName,
+                              char *pcBuffer) {
+   int iFd;
+   ssize_t lRead;
+   size_t ulLength = 0;
+
+   iFd = openat(iDirFd, pcName, O_RDONLY);
+   assert(iFd >= 0);
+   while((lRead = read(iFd, pcBuffer + ulLength,
+                       MAX_READ - ulLength)) > 0)
+      ulLength += (size_t) lRead;
+   assert(lRead == 0);
+   assert(ulLength < MAX_READ);
+   (void) close(iFd);
+   return ulLength;
+}
+
+/* Returns the number of entries, other than . and .., of iDirFd. */
+static size_t Client_countEntries(int iDirFd) {
+   DIR *psDir;
+   struct dirent *psEntry;
+   size_t ulCount = 0;
+
+   /* a duplicate shares iDirFd's offset, so start from the top */
+   psDir = fdopendir(dup(iDirFd));
+   assert(psDir != NULL);
+   rewinddir(psDir);
+   while((psEntry = readdir(psDir)) != NULL)
+      if(strcmp(psEntry->d_name, ".") != 0 &&
+         strcmp(psEntry->d_name, "..") != 0)
+         ulCount++;
+   (void) closedir(psDir);
+   return ulCount;
+}
+
+/*
+  Checks that directories iFirstFd and iSecondFd hold the same names,
+  with the same types and file contents, all the way down. Returns
+  how many entries were compared.
+*/
+static size_t Client_compareDirs(int iFirstFd, int iSecondFd) {
+   DIR *psDir;
+   struct dirent *psEntry;
+   size_t ulCount = 0;
+
+   assert(Client_countEntries(iFirstFd) ==
+          Client_countEntries(iSecondFd));
+
+   psDir = fdopendir(dup(iFirstFd));
+   assert(psDir != NULL);
+   rewinddir(psDir);
+   while((psEntry = readdir(psDir)) != NULL) {
+      const char *pcName = psEntry->d_name;
+      struct stat sFirst;
+      struct stat sSecond;
+
+      if(strcmp(pcName, ".") == 0 || strcmp(pcName, "..") == 0)
+         continue;
+      assert(fstatat(iFirstFd, pcName, &sFirst,
+                     AT_SYMLINK_NOFOLLOW) == 0);
+      assert(fstatat(iSecondFd, pcName, &sSecond,
+                     AT_SYMLINK_NOFOLLOW) == 0);
+      assert(S_ISDIR(sFirst.st_mode) == S_ISDIR(sSecond.st_mode));
+      if(S_ISDIR(sFirst.st_mode)) {
+         int iFirstSub = openat(iFirstFd, pcName,
+                                O_RDONLY | O_DIRECTORY);
+         int iSecondSub = openat(iSecondFd, pcName,
+                                 O_RDONLY | O_DIRECTORY);
+         assert(iFirstSub >= 0 && iSecondSub >= 0);
+         ulCount += Client_compareDirs(iFirstSub, iSecondSub);
+         (void) close(iFirstSub);
+         (void) close(iSecondSub);
+      }
+      else {
+         char acFirst[MAX_READ];
+         char acSecond[MAX_READ];
+         size_t ulLength = Client_readFile(iFirstFd, pcName, acFirst);
+         assert(S_ISREG(sFirst.st_mode));
+         assert(Client_readFile(iSecondFd, pcName, acSecond) ==
+                ulLength);
+         assert(memcmp(acFirst, acSecond, ulLength) == 0);
+      }
+      ulCount++;
+   }
+   (void) closedir(psDir);
+   return ulCount;
+}
+
+/*
+  Checks that every node of the FT at or beneath pcPath is on disk
+  beneath directory iDirFd, with its type and contents, as
+  FT_exportToDisk(pcPath, <iDirFd's directory>, ...) puts it. Returns
+  how many nodes were checked.
+*/
+static size_t Client_checkExport(const char *pcPath, int iDirFd) {
+   char *pcTree;
+   char *pcLine;
+   char *pcNext;
+   size_t ulPrefix = strlen(pcPath);
+   size_t ulOffset;
+   size_t ulCount = 0;
+
+   /* on disk, names start at pcPath's last component */
+   ulOffset = strrchr(pcPath, '/') == NULL ? 0 :
+      (size_t) (strrchr(pcPath, '/') - pcPath) + 1;
+
+   pcTree = FT_toString();
+   assert(pcTree != NULL);
+   for(pcLine = pcTree; *pcLine != '\0'; pcLine = pcNext + 1) {
+      boolean bIsFile;
+      size_t ulSize = 0;
+      struct stat sStat;
+
+      pcNext = strchr(pcLine, '\n');
+      assert(pcNext != NULL);
+      *pcNext = '\0';
+      if(strncmp(pcLine, pcPath, ulPrefix) != 0 ||
+         (pcLine[ulPrefix] != '\0' && pcLine[ulPrefix] != '/'))
+         continue;
+
+      assert(FT_stat(pcLine, &bIsFile, &ulSize) == SUCCESS);
+      assert(fstatat(iDirFd, pcLine + ulOffset, &sStat,
+                     AT_SYMLINK_NOFOLLOW) == 0);
+      if(bIsFile) {
+         char acRead[MAX_READ];
+         assert(S_ISREG(sStat.st_mode));
+         assert(Client_readFile(iDirFd, pcLine + ulOffset, acRead) ==
+                ulSize);
+         assert(ulSize == 0 ||
+                memcmp(acRead, FT_getFileContents(pcLine), ulSize)
+                == 0);
+      }
+      else
+         assert(S_ISDIR(sStat.st_mode));
+      ulCount++;
+   }
+   free(pcTree);
+   return ulCount;
+}
+
+/* Removes pcName, relative to iDirFd, and everything beneath it. */
+static void Client_removeTree(int iDirFd, const char *pcName) {
+   struct stat sStat;
+   DIR *psDir;
+   struct dirent *psEntry;
+   int iSubFd;
+
+   assert(fstatat(iDirFd, pcName, &sStat, AT_SYMLINK_NOFOLLOW) == 0);
+   if(!S_ISDIR(sStat.st_mode)) {
+      assert(unlinkat(iDirFd, pcName, 0) == 0);
+      return;
+   }
+
+   iSubFd = openat(iDirFd, pcName, O_RDONLY | O_DIRECTORY);
+   assert(iSubFd >= 0);
+   psDir = fdopendir(iSubFd);
+   assert(psDir != NULL);
+   while((psEntry = readdir(psDir)) != NULL)
+      if(strcmp(psEntry->d_name, ".") != 0 &&
+         strcmp(psEntry->d_name, "..") != 0)
+         Client_removeTree(iSubFd, psEntry->d_name);
+   (void) closedir(psDir);
+   assert(unlinkat(iDirFd, pcName, AT_REMOVEDIR) == 0);
+}
+
+/* Returns a new descriptor for directory pcName beneath iDirFd. */
+static int Client_openDir(int iDirFd, const char *pcName) {
+   int iFd = openat(iDirFd, pcName, O_RDONLY | O_DIRECTORY);
+   assert(iFd >= 0);
+   return iFd;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Runs every check in a new scratch directory beneath $TMPDIR (or
+  /tmp), which is removed afterwards. Returns 0; a failed check
+  aborts.
+*/
+int main(void) {
+   char acBase[MAX_NAME];
+   char acTarget[MAX_NAME];
+   const char *pcTmp;
+   int iBaseFd;
+   int iSerialFd;
+   int iParallelFd;
+   int iFd;
+   size_t ulNodes;
+
+   /* before the FT is initialized */
+   assert(FT_exportToDisk("r", ".", FT_EXPORT_SERIAL) ==
+          INITIALIZATION_ERROR);
+
+   pcTmp = getenv("TMPDIR");
+   if(pcTmp == NULL || *pcTmp == '\0')
+      pcTmp = "/tmp";
+   sprintf(acBase, "%.200s/ftdisk_client.XXXXXX", pcTmp);
+   assert(mkdtemp(acBase) != NULL);
+   iBaseFd = open(acBase, O_RDONLY | O_DIRECTORY);
+   assert(iBaseFd >= 0);
+   assert(mkdirat(iBaseFd, "serial", 0777) == 0);
+   assert(mkdirat(iBaseFd, "parallel", 0777) == 0);
+   assert(mkdirat(iBaseFd, "sub", 0777) == 0);
+   assert(mkdirat(iBaseFd, "conflict", 0777) == 0);
+
+   Client_makeTree();
+
+   /* the whole hierarchy, serially and in parallel, agree with each
+      other and with the FT */
+   sprintf(acTarget, "%.200s/serial", acBase);
+   assert(FT_exportToDisk("r", acTarget, FT_EXPORT_SERIAL) == SUCCESS);
+   sprintf(acTarget, "%.200s/parallel", acBase);
+   assert(FT_exportToDisk("r", acTarget,
+                          FT_EXPORT_PARALLEL | FT_EXPORT_FSYNC) ==
+          SUCCESS);
+   iSerialFd = Client_openDir(iBaseFd, "serial");
+   iParallelFd = Client_openDir(iBaseFd, "parallel");
+   ulNodes = Client_checkExport("r", iSerialFd);
+   assert(ulNodes == 10 + WIDE_DIRS * (WIDE_FILES + 1));
+   assert(Client_compareDirs(iSerialFd, iParallelFd) == ulNodes);
+
+   /* exporting again reuses the directories and truncates the files */
+   assert(FT_replaceFileContents("r/a/f1", "a", 1) != NULL);
+   assert(FT_replaceFileContents("r/w/d3/f2", NULL, 0) != NULL);
+   sprintf(acTarget, "%.200s/parallel", acBase);
+   assert(FT_exportToDisk("r", acTarget, FT_EXPORT_PARALLEL) ==
+          SUCCESS);
+   assert(Client_checkExport("r", iParallelFd) == ulNodes);
+
+   /* a subtree, and a single file, land under their own names */
+   sprintf(acTarget, "%.200s/sub", acBase);
+   assert(FT_exportToDisk("r/a/b", acTarget, FT_EXPORT_PARALLEL) ==
+          SUCCESS);
+   assert(FT_exportToDisk("r/z", acTarget, FT_EXPORT_SERIAL) ==
+          SUCCESS);
+   iFd = Client_openDir(iBaseFd, "sub");
+   assert(Client_checkExport("r/a/b", iFd) == 3);
+   assert(Client_checkExport("r/z", iFd) == 1);
+   assert(Client_countEntries(iFd) == 2);
+   (void) close(iFd);
+
+   /* the statuses of paths that cannot be exported */
+   assert(FT_exportToDisk("r//a", acBase, FT_EXPORT_SERIAL) ==
+          BAD_PATH);
+   assert(FT_exportToDisk("q/a", acBase, FT_EXPORT_SERIAL) ==
+          CONFLICTING_PATH);
+   assert(FT_exportToDisk("r/nope", acBase, FT_EXPORT_SERIAL) ==
+          NO_SUCH_PATH);
+   assert(FT_exportToDisk("r/a/f1/x", acBase, FT_EXPORT_SERIAL) ==
+          NO_SUCH_PATH);
+
+   /* IO_ERROR: a missing target, a file where a directory goes, and
+      a directory where a file goes */
+   sprintf(acTarget, "%.200s/missing", acBase);
+   assert(FT_exportToDisk("r", acTarget, FT_EXPORT_PARALLEL) ==
+          IO_ERROR);
+   iFd = Client_openDir(iBaseFd, "conflict");
+   (void) close(openat(iFd, "r", O_WRONLY | O_CREAT, 0666));
+   sprintf(acTarget, "%.200s/conflict", acBase);
+   assert(FT_exportToDisk("r", acTarget, FT_EXPORT_SERIAL) ==
+          IO_ERROR);
+   assert(FT_exportToDisk("r", acTarget, FT_EXPORT_PARALLEL) ==
+          IO_ERROR);
+   assert(unlinkat(iFd, "r", 0) == 0);
+   assert(mkdirat(iFd, "z", 0777) == 0);
+   assert(FT_exportToDisk("r/z", acTarget, FT_EXPORT_SERIAL) ==
+          IO_ERROR);
+   (void) close(iFd);
+
+   assert(FT_destroy() == SUCCESS);
+   (void) close(iSerialFd);
+   (void) close(iParallelFd);
+   (void) close(iBaseFd);
+   Client_removeTree(AT_FDCWD, acBase);
+
+   fprintf(stderr, "ftdisk_client: %lu nodes exported, all checks "
+           "passed\n", (unsigned long) ulNodes);
+   return 0;
+}
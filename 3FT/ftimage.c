@@ -0,0 +1,864 @@
+/*--------------------------------------------------------------------*/
+/* ftimage.c                                                          */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "path.h"
+#include "ftpager.h"
+#include "ftimage.h"
+
+/*
+  Image layout (all integers little-endian):
+    "FTIMAGE1"
+    file contents and directory records, children before parents
+    the root entry
+    u64 offset of the root entry (0 for an empty tree), "FTIMAGE1"
+  A directory record is
+    u64 number of nodes in the subtree, u32 number of children,
+    then one entry per child in sorted order.
+  An entry is
+    u8 'd' or 'f', u32 name length, the name (last path component),
+    then for 'd': u64 offset of the directory's record
+    and for 'f':  u8 has-contents, u64 contents offset, u64 length.
+
+  A spill is an image that only ever lives in an unlinked scratch file
+  of this process and is read and written through a Pager_T. It has no
+  header or trailer, and its entries refer to memory rather than to
+  offsets: a directory entry is followed by u64 Image_T holding its
+  record, u64 record offset, u64 record length, and u64 number of
+  nodes in its subtree; a file entry by u8 has-contents, u64 contents
+  address, u64 length. The contents themselves are never copied.
+*/
+static const char acMagic[] = "FTIMAGE1";
+enum { IMAGE_MAGIC_LEN = 8, IMAGE_TRAILER_LEN = 16 };
+enum { IMAGE_DIR = 'd', IMAGE_FILE = 'f' };
+
+/* Size of the write buffer used by Image_save */
+enum { IMAGE_BUFSIZE = 65536 };
+
+/* A mapped image, or a spill */
+struct image {
+   /* the start of the mapping (NULL for a spill) */
+   unsigned char *pucBase;
+   /* the length of the mapping */
+   size_t ulSize;
+   /* the pager over a spill's scratch file (NULL for a mapping) */
+   Pager_T oPPager;
+};
+
+/* A directory whose children have not been loaded yet */
+struct stub {
+   /* the image holding the directory's record */
+   Image_T oIImage;
+   /* the offset of the directory's record in the image */
+   size_t ulRecord;
+   /* the length of the record, if in a spill */
+   size_t ulLength;
+   /* the number of nodes in the saved subtree, including itself */
+   size_t ulCount;
+};
+
+/* A bounds-checked cursor over part of a mapped image */
+struct cursor {
+   const unsigned char *pucCurr;
+   const unsigned char *pucEnd;
+};
+
+/* A buffered writer that tracks its offset from the image start */
+struct writer {
+   int iFd;
+   size_t ulOffset;
+   size_t ulUsed;
+   unsigned char aucBuf[IMAGE_BUFSIZE];
+};
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Writes out and empties the buffer of psWriter.
+  Returns SUCCESS or IO_ERROR.
+*/
+static int Image_flush(struct writer *psWriter) {
+   const unsigned char *pucBuf = psWriter->aucBuf;
+   ssize_t lWritten;
+
+   assert(psWriter != NULL);
+
+   while(psWriter->ulUsed > 0) {
+      lWritten = write(psWriter->iFd, pucBuf, psWriter->ulUsed);
+      if(lWritten < 0) {
+         if(errno == EINTR)
+            continue;
+         return IO_ERROR;
+      }
+      pucBuf += lWritten;
+      psWriter->ulUsed -= (size_t) lWritten;
+   }
+   return SUCCESS;
+}
+
+/*
+  Appends ulSize bytes of pvData to the image being written by
+  psWriter. Returns SUCCESS or IO_ERROR.
+*/
+static int Image_put(struct writer *psWriter, const void *pvData,
+                     size_t ulSize) {
+   const unsigned char *pucData = pvData;
+   size_t ulChunk;
+
+   assert(psWriter != NULL);
+   assert(pvData != NULL || ulSize == 0);
+
+   psWriter->ulOffset += ulSize;
+   while(ulSize > 0) {
+      if(psWriter->ulUsed == IMAGE_BUFSIZE &&
+         Image_flush(psWriter) != SUCCESS)
+         return IO_ERROR;
+      ulChunk = IMAGE_BUFSIZE - psWriter->ulUsed;
+      if(ulChunk > ulSize)
+         ulChunk = ulSize;
+      memcpy(psWriter->aucBuf + psWriter->ulUsed, pucData, ulChunk);
+      psWriter->ulUsed += ulChunk;
+      pucData += ulChunk;
+      ulSize -= ulChunk;
+   }
+   return SUCCESS;
+}
+
+/*
+  Stores the ulBytes-byte little-endian encoding of ulValue at pucOut.
+  Returns the address just past it.
+*/
+static unsigned char *Image_encodeNumber(unsigned char *pucOut,
+                                         size_t ulValue,
+                                         size_t ulBytes) {
+   assert(pucOut != NULL);
+
+   while(ulBytes-- > 0) {
+      *pucOut++ = (unsigned char) (ulValue & 0xff);
+      ulValue >>= 8;
+   }
+   return pucOut;
+}
+
+/*
+  Appends the ulBytes-byte little-endian encoding of ulValue.
+  Returns SUCCESS or IO_ERROR.
+*/
+static int Image_putNumber(struct writer *psWriter, size_t ulValue,
+                           size_t ulBytes) {
+   unsigned char aucBytes[8];
+
+   assert(ulBytes <= sizeof(aucBytes));
+
+   (void) Image_encodeNumber(aucBytes, ulValue, ulBytes);
+   return Image_put(psWriter, aucBytes, ulBytes);
+}
+
+/*
+  Appends the entry for oNNode, whose body (contents or record) is at
+  ulOffset. Returns SUCCESS or IO_ERROR.
+*/
+static int Image_putEntry(struct writer *psWriter, Node_T oNNode,
+                          size_t ulOffset) {
+   Path_T oPPath;
+   const char *pcName;
+   size_t ulNameLength;
+   unsigned char ucType;
+   int iStatus;
+
+   assert(psWriter != NULL);
+   assert(oNNode != NULL);
+
+   oPPath = Node_getPath(oNNode);
+   pcName = Path_getComponent(oPPath, Path_getDepth(oPPath) - 1);
+   ulNameLength = strlen(pcName);
+   ucType = Node_getType(oNNode) == FILE_NODE ? IMAGE_FILE : IMAGE_DIR;
+
+   iStatus = Image_put(psWriter, &ucType, 1);
+   if(iStatus == SUCCESS)
+      iStatus = Image_putNumber(psWriter, ulNameLength, 4);
+   if(iStatus == SUCCESS)
+      iStatus = Image_put(psWriter, pcName, ulNameLength);
+   if(iStatus == SUCCESS && ucType == IMAGE_FILE) {
+      unsigned char ucHasContents =
+         Node_getFileContents(oNNode) != NULL;
+      iStatus = Image_put(psWriter, &ucHasContents, 1);
+      if(iStatus == SUCCESS)
+         iStatus = Image_putNumber(psWriter, ulOffset, 8);
+      if(iStatus == SUCCESS)
+         iStatus = Image_putNumber(psWriter,
+                                   Node_getFileSize(oNNode), 8);
+   }
+   else if(iStatus == SUCCESS)
+      iStatus = Image_putNumber(psWriter, ulOffset, 8);
+   return iStatus;
+}
+
+/*
+  Writes the contents and records of everything beneath directory
+  oNDir, then oNDir's own record, storing its offset in *pulRecord
+  and its subtree node count in *pulCount.
+  Returns SUCCESS, IO_ERROR, or MEMORY_ERROR.
+*/
+static int Image_saveDir(struct writer *psWriter, Node_T oNDir,
+                         size_t *pulRecord, size_t *pulCount) {
+   size_t *pulOffsets;
+   size_t ulChildren;
+   size_t ulCount = 1;
+   size_t c;
+   Node_T oNChild = NULL;
+   int iStatus = SUCCESS;
+
+   assert(psWriter != NULL);
+   assert(oNDir != NULL);
+   assert(pulRecord != NULL);
+   assert(pulCount != NULL);
+
+   ulChildren = Node_getNumChildren(oNDir);
+   pulOffsets = malloc((ulChildren + 1) * sizeof(size_t));
+   if(pulOffsets == NULL)
+      return MEMORY_ERROR;
+
+   /* children's bodies come before this directory's record */
+   for(c = 0; c < ulChildren && iStatus == SUCCESS; c++) {
+      (void) Node_getChild(oNDir, c, &oNChild);
+      if(Node_getType(oNChild) == FILE_NODE) {
+         void *pvContents = Node_getFileContents(oNChild);
+         pulOffsets[c] = psWriter->ulOffset;
+         ulCount++;
+         if(pvContents != NULL)
+            iStatus = Image_put(psWriter, pvContents,
+                                Node_getFileSize(oNChild));
+      }
+      else {
+         size_t ulChildCount = 0;
+         iStatus = Image_saveDir(psWriter, oNChild, &pulOffsets[c],
+                                 &ulChildCount);
+         ulCount += ulChildCount;
+      }
+   }
+
+   *pulRecord = psWriter->ulOffset;
+   if(iStatus == SUCCESS)
+      iStatus = Image_putNumber(psWriter, ulCount, 8);
+   if(iStatus == SUCCESS)
+      iStatus = Image_putNumber(psWriter, ulChildren, 4);
+   for(c = 0; c < ulChildren && iStatus == SUCCESS; c++) {
+      (void) Node_getChild(oNDir, c, &oNChild);
+      iStatus = Image_putEntry(psWriter, oNChild, pulOffsets[c]);
+   }
+
+   free(pulOffsets);
+   *pulCount = ulCount;
+   return iStatus;
+}
+
+int Image_save(Node_T oNRoot, int iFd) {
+   struct writer *psWriter;
+   size_t ulRoot = 0;
+   size_t ulRecord;
+   size_t ulCount;
+   int iStatus;
+
+   psWriter = malloc(sizeof(struct writer));
+   if(psWriter == NULL)
+      return MEMORY_ERROR;
+   psWriter->iFd = iFd;
+   psWriter->ulOffset = 0;
+   psWriter->ulUsed = 0;
+
+   iStatus = Image_put(psWriter, acMagic, IMAGE_MAGIC_LEN);
+   if(iStatus == SUCCESS && oNRoot != NULL) {
+      iStatus = Image_saveDir(psWriter, oNRoot, &ulRecord, &ulCount);
+      ulRoot = psWriter->ulOffset;
+      if(iStatus == SUCCESS)
+         iStatus = Image_putEntry(psWriter, oNRoot, ulRecord);
+   }
+   if(iStatus == SUCCESS)
+      iStatus = Image_putNumber(psWriter, ulRoot, 8);
+   if(iStatus == SUCCESS)
+      iStatus = Image_put(psWriter, acMagic, IMAGE_MAGIC_LEN);
+   if(iStatus == SUCCESS)
+      iStatus = Image_flush(psWriter);
+
+   free(psWriter);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Image_open(const char *pcFile, Image_T *poIImage) {
+   struct image *psImage;
+   struct stat sStat;
+   void *pvMap;
+   int iFd;
+
+   assert(pcFile != NULL);
+   assert(poIImage != NULL);
+
+   *poIImage = NULL;
+
+   iFd = open(pcFile, O_RDONLY);
+   if(iFd < 0)
+      return IO_ERROR;
+   if(fstat(iFd, &sStat) != 0 ||
+      (size_t) sStat.st_size < IMAGE_MAGIC_LEN + IMAGE_TRAILER_LEN) {
+      (void) close(iFd);
+      return IO_ERROR;
+   }
+
+   /* a private writable mapping lets clients modify loaded contents
+      without touching the file */
+   pvMap = mmap(NULL, (size_t) sStat.st_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE, iFd, 0);
+   (void) close(iFd);
+   if(pvMap == MAP_FAILED)
+      return IO_ERROR;
+
+   psImage = malloc(sizeof(struct image));
+   if(psImage == NULL) {
+      (void) munmap(pvMap, (size_t) sStat.st_size);
+      return MEMORY_ERROR;
+   }
+   psImage->pucBase = pvMap;
+   psImage->ulSize = (size_t) sStat.st_size;
+   psImage->oPPager = NULL;
+
+   if(memcmp(psImage->pucBase, acMagic, IMAGE_MAGIC_LEN) ||
+      memcmp(psImage->pucBase + psImage->ulSize - IMAGE_MAGIC_LEN,
+             acMagic, IMAGE_MAGIC_LEN)) {
+      Image_close(psImage);
+      return IO_ERROR;
+   }
+
+   *poIImage = psImage;
+   return SUCCESS;
+}
+
+int Image_newSpill(size_t ulFrames, Image_T *poIImage) {
+   struct image *psImage;
+   const char *pcDir;
+   char *pcTemplate;
+   int iFd;
+   int iStatus;
+
+   assert(ulFrames > 0);
+   assert(poIImage != NULL);
+
+   *poIImage = NULL;
+
+   pcDir = getenv("TMPDIR");
+   if(pcDir == NULL || *pcDir == '\0')
+      pcDir = "/tmp";
+   pcTemplate = malloc(strlen(pcDir) + sizeof("/ftspillXXXXXX"));
+   if(pcTemplate == NULL)
+      return MEMORY_ERROR;
+   strcpy(pcTemplate, pcDir);
+   strcat(pcTemplate, "/ftspillXXXXXX");
+
+   /* the scratch file disappears with the last descriptor to it */
+   iFd = mkstemp(pcTemplate);
+   if(iFd >= 0)
+      (void) unlink(pcTemplate);
+   free(pcTemplate);
+   if(iFd < 0)
+      return IO_ERROR;
+
+   psImage = malloc(sizeof(struct image));
+   if(psImage == NULL) {
+      (void) close(iFd);
+      return MEMORY_ERROR;
+   }
+   psImage->pucBase = NULL;
+   psImage->ulSize = 0;
+   iStatus = Pager_new(iFd, 0, ulFrames, &psImage->oPPager);
+   if(iStatus != SUCCESS) {
+      free(psImage);
+      return iStatus;
+   }
+
+   *poIImage = psImage;
+   return SUCCESS;
+}
+
+void Image_close(Image_T oIImage) {
+   if(oIImage != NULL) {
+      if(oIImage->oPPager != NULL)
+         Pager_free(oIImage->oPPager);
+      else
+         (void) munmap(oIImage->pucBase, oIImage->ulSize);
+      free(oIImage);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Positions psCursor at offset ulOffset of oIImage, bounded by the
+  start of the trailer. Returns TRUE if the offset is in bounds.
+*/
+static boolean Image_seek(Image_T oIImage, size_t ulOffset,
+                          struct cursor *psCursor) {
+   size_t ulLimit;
+
+   assert(oIImage != NULL);
+   assert(psCursor != NULL);
+
+   ulLimit = oIImage->ulSize - IMAGE_TRAILER_LEN;
+   if(ulOffset < IMAGE_MAGIC_LEN || ulOffset > ulLimit)
+      return FALSE;
+   psCursor->pucCurr = oIImage->pucBase + ulOffset;
+   psCursor->pucEnd = oIImage->pucBase + ulLimit;
+   return TRUE;
+}
+
+/*
+  Reads a ulBytes-byte little-endian number at psCursor into
+  *pulValue and advances. Returns FALSE if it would run off the end.
+*/
+static boolean Image_getNumber(struct cursor *psCursor, size_t ulBytes,
+                               size_t *pulValue) {
+   size_t ulValue = 0;
+   const unsigned char *pucStart;
+
+   assert(psCursor != NULL);
+   assert(pulValue != NULL);
+
+   if((size_t) (psCursor->pucEnd - psCursor->pucCurr) < ulBytes)
+      return FALSE;
+   pucStart = psCursor->pucCurr;
+   psCursor->pucCurr += ulBytes;
+   while(ulBytes > 0)
+      ulValue = (ulValue << 8) | pucStart[--ulBytes];
+   *pulValue = ulValue;
+   return TRUE;
+}
+
+/* An entry decoded from an image or a spill */
+struct entry {
+   boolean bIsFile;
+   const char *pcName;
+   size_t ulNameLength;
+   /* for a file: its contents (NULL if none) and their length */
+   void *pvContents;
+   size_t ulLength;
+   /* for a directory: the image holding its record, the record's
+      offset and length (0 unless in a spill), and its subtree count */
+   Image_T oIImage;
+   size_t ulRecord;
+   size_t ulRecordLength;
+   size_t ulCount;
+};
+
+/*
+  Decodes the type and name that start every entry at psCursor into
+  *psEntry and advances. Returns FALSE if they are malformed.
+*/
+static boolean Image_getName(struct cursor *psCursor,
+                             struct entry *psEntry) {
+   assert(psCursor != NULL);
+   assert(psEntry != NULL);
+
+   if(psCursor->pucCurr == psCursor->pucEnd)
+      return FALSE;
+   if(*psCursor->pucCurr != IMAGE_FILE &&
+      *psCursor->pucCurr != IMAGE_DIR)
+      return FALSE;
+   psEntry->bIsFile = (boolean) (*psCursor->pucCurr++ == IMAGE_FILE);
+
+   if(!Image_getNumber(psCursor, 4, &psEntry->ulNameLength))
+      return FALSE;
+   if(psEntry->ulNameLength == 0 || (size_t) (psCursor->pucEnd -
+         psCursor->pucCurr) < psEntry->ulNameLength)
+      return FALSE;
+   psEntry->pcName = (const char *) psCursor->pucCurr;
+   psCursor->pucCurr += psEntry->ulNameLength;
+
+   psEntry->pvContents = NULL;
+   psEntry->ulLength = 0;
+   psEntry->oIImage = NULL;
+   psEntry->ulRecord = 0;
+   psEntry->ulRecordLength = 0;
+   psEntry->ulCount = 1;
+   return TRUE;
+}
+
+/*
+  Decodes the entry at psCursor of mapped image oIImage into *psEntry
+  and advances. Returns FALSE if the entry is malformed.
+*/
+static boolean Image_getEntry(Image_T oIImage, struct cursor *psCursor,
+                              struct entry *psEntry) {
+   struct cursor sRecord;
+   size_t ulHasContents = 0;
+   size_t ulOffset;
+   size_t ulLimit;
+
+   assert(oIImage != NULL);
+   assert(psCursor != NULL);
+   assert(psEntry != NULL);
+
+   if(!Image_getName(psCursor, psEntry))
+      return FALSE;
+
+   if(psEntry->bIsFile && !Image_getNumber(psCursor, 1, &ulHasContents))
+      return FALSE;
+   if(!Image_getNumber(psCursor, 8, &ulOffset))
+      return FALSE;
+
+   if(psEntry->bIsFile) {
+      if(!Image_getNumber(psCursor, 8, &psEntry->ulLength))
+         return FALSE;
+      /* contents must lie within the image */
+      ulLimit = oIImage->ulSize - IMAGE_TRAILER_LEN;
+      if(ulHasContents != 0) {
+         if(ulOffset > ulLimit ||
+            psEntry->ulLength > ulLimit - ulOffset)
+            return FALSE;
+         psEntry->pvContents = oIImage->pucBase + ulOffset;
+      }
+   }
+   else {
+      psEntry->oIImage = oIImage;
+      psEntry->ulRecord = ulOffset;
+      if(!Image_seek(oIImage, ulOffset, &sRecord) ||
+         !Image_getNumber(&sRecord, 8, &psEntry->ulCount) ||
+         psEntry->ulCount == 0)
+         return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+  Decodes the spill entry at psCursor into *psEntry and advances.
+  Returns FALSE if the entry is malformed.
+*/
+static boolean Image_getSpillEntry(struct cursor *psCursor,
+                                   struct entry *psEntry) {
+   size_t ulValue = 0;
+
+   assert(psCursor != NULL);
+   assert(psEntry != NULL);
+
+   if(!Image_getName(psCursor, psEntry))
+      return FALSE;
+
+   if(psEntry->bIsFile) {
+      size_t ulHasContents = 0;
+      if(!Image_getNumber(psCursor, 1, &ulHasContents) ||
+         !Image_getNumber(psCursor, 8, &ulValue) ||
+         !Image_getNumber(psCursor, 8, &psEntry->ulLength))
+         return FALSE;
+      if(ulHasContents != 0)
+         psEntry->pvContents = (void *) (uintptr_t) ulValue;
+      return TRUE;
+   }
+
+   if(!Image_getNumber(psCursor, 8, &ulValue) ||
+      !Image_getNumber(psCursor, 8, &psEntry->ulRecord) ||
+      !Image_getNumber(psCursor, 8, &psEntry->ulRecordLength) ||
+      !Image_getNumber(psCursor, 8, &psEntry->ulCount) ||
+      ulValue == 0 || psEntry->ulCount == 0)
+      return FALSE;
+   psEntry->oIImage = (Image_T) (uintptr_t) ulValue;
+   return TRUE;
+}
+
+/*
+  Creates the node for psEntry beneath oNParent (or as an unlinked
+  root if oNParent is NULL) and sets *poNResult to it, turning
+  directories into stubs, and sets *pulCount to the number of saved
+  nodes it stands for. Returns SUCCESS, IO_ERROR, or MEMORY_ERROR.
+*/
+static int Image_makeNode(Node_T oNParent, const struct entry *psEntry,
+                          Node_T *poNResult, size_t *pulCount) {
+   Path_T oPPath = NULL;
+   struct stub *psStub = NULL;
+   char *pcPath;
+   size_t ulParentLength = 0;
+   int iStatus;
+
+   assert(psEntry != NULL);
+   assert(poNResult != NULL);
+   assert(pulCount != NULL);
+
+   *poNResult = NULL;
+   *pulCount = 1;
+
+   if(memchr(psEntry->pcName, '/', psEntry->ulNameLength) != NULL ||
+      memchr(psEntry->pcName, '\0', psEntry->ulNameLength) != NULL)
+      return IO_ERROR;
+
+   if(!psEntry->bIsFile) {
+      psStub = malloc(sizeof(struct stub));
+      if(psStub == NULL)
+         return MEMORY_ERROR;
+      psStub->oIImage = psEntry->oIImage;
+      psStub->ulRecord = psEntry->ulRecord;
+      psStub->ulLength = psEntry->ulRecordLength;
+      psStub->ulCount = psEntry->ulCount;
+   }
+
+   /* the child's path is its parent's path plus its name */
+   if(oNParent != NULL)
+      ulParentLength = Path_getStrLength(Node_getPath(oNParent)) + 1;
+   pcPath = malloc(ulParentLength + psEntry->ulNameLength + 1);
+   if(pcPath == NULL) {
+      free(psStub);
+      return MEMORY_ERROR;
+   }
+   if(oNParent != NULL) {
+      strcpy(pcPath, Path_getPathname(Node_getPath(oNParent)));
+      pcPath[ulParentLength - 1] = '/';
+   }
+   memcpy(pcPath + ulParentLength, psEntry->pcName,
+          psEntry->ulNameLength);
+   pcPath[ulParentLength + psEntry->ulNameLength] = '\0';
+
+   iStatus = Path_new(pcPath, &oPPath);
+   free(pcPath);
+   if(iStatus == SUCCESS) {
+      iStatus = Node_new(oPPath, oNParent, poNResult,
+                  psEntry->bIsFile ? FILE_NODE : DIRECTORY,
+                  psEntry->pvContents, psEntry->ulLength);
+      Path_free(oPPath);
+   }
+   if(iStatus != SUCCESS) {
+      free(psStub);
+      /* anything but running out of memory means a corrupt image */
+      return iStatus == MEMORY_ERROR ? MEMORY_ERROR : IO_ERROR;
+   }
+
+   if(psStub != NULL) {
+      *pulCount = psStub->ulCount;
+      Node_setStub(*poNResult, psStub);
+   }
+   return SUCCESS;
+}
+
+int Image_loadRoot(Image_T oIImage, Node_T *poNRoot, size_t *pulCount) {
+   struct cursor sCursor;
+   struct entry sEntry;
+   size_t ulRoot;
+
+   assert(oIImage != NULL);
+   assert(oIImage->oPPager == NULL);
+   assert(poNRoot != NULL);
+   assert(pulCount != NULL);
+
+   *poNRoot = NULL;
+   *pulCount = 0;
+
+   sCursor.pucCurr = oIImage->pucBase + oIImage->ulSize -
+      IMAGE_TRAILER_LEN;
+   sCursor.pucEnd = sCursor.pucCurr + 8;
+   (void) Image_getNumber(&sCursor, 8, &ulRoot);
+   if(ulRoot == 0)
+      return SUCCESS;
+
+   if(!Image_seek(oIImage, ulRoot, &sCursor) ||
+      !Image_getEntry(oIImage, &sCursor, &sEntry) || sEntry.bIsFile)
+      return IO_ERROR;
+
+   return Image_makeNode(NULL, &sEntry, poNRoot, pulCount);
+}
+
+size_t Image_getStubCount(const void *pvStub) {
+   assert(pvStub != NULL);
+
+   return ((const struct stub *) pvStub)->ulCount;
+}
+
+int Image_loadChildren(Node_T oNDir, const void *pvStub) {
+   const struct stub *psStub = pvStub;
+   Image_T oIImage;
+   unsigned char *pucRecord = NULL;
+   struct cursor sCursor;
+   struct entry sEntry;
+   size_t ulChildren;
+   size_t ulCount;
+   size_t ulChildCount;
+   size_t ulLoaded = 1;
+   size_t c;
+   Node_T oNChild = NULL;
+   int iStatus = SUCCESS;
+   boolean bValid;
+
+   assert(oNDir != NULL);
+   assert(psStub != NULL);
+
+   oIImage = psStub->oIImage;
+   if(oIImage->oPPager != NULL) {
+      /* a spilled record is copied out of the pool in one piece */
+      pucRecord = malloc(psStub->ulLength);
+      if(pucRecord == NULL)
+         return MEMORY_ERROR;
+      iStatus = Pager_read(oIImage->oPPager, psStub->ulRecord,
+                           pucRecord, psStub->ulLength);
+      if(iStatus != SUCCESS) {
+         free(pucRecord);
+         return iStatus;
+      }
+      sCursor.pucCurr = pucRecord;
+      sCursor.pucEnd = pucRecord + psStub->ulLength;
+   }
+   else if(!Image_seek(oIImage, psStub->ulRecord, &sCursor))
+      return IO_ERROR;
+
+   if(!Image_getNumber(&sCursor, 8, &ulCount) ||
+      !Image_getNumber(&sCursor, 4, &ulChildren)) {
+      free(pucRecord);
+      return IO_ERROR;
+   }
+
+   for(c = 0; c < ulChildren; c++) {
+      if(pucRecord != NULL)
+         bValid = Image_getSpillEntry(&sCursor, &sEntry);
+      else
+         bValid = Image_getEntry(oIImage, &sCursor, &sEntry);
+      if(!bValid) {
+         iStatus = IO_ERROR;
+         break;
+      }
+      iStatus = Image_makeNode(oNDir, &sEntry, &oNChild, &ulChildCount);
+      if(iStatus != SUCCESS)
+         break;
+      ulLoaded += ulChildCount;
+   }
+   free(pucRecord);
+
+   /* the children must add up to the count the parent promised */
+   if(iStatus == SUCCESS && ulLoaded != ulCount)
+      iStatus = IO_ERROR;
+
+   if(iStatus != SUCCESS) {
+      while(Node_getNumChildren(oNDir) != 0) {
+         (void) Node_getChild(oNDir, 0, &oNChild);
+         (void) Node_free(oNChild);
+      }
+   }
+   return iStatus;
+}
+
+int Image_spill(Image_T oISpill, Node_T oNDir) {
+   struct stub *psStub;
+   const struct stub *psChildStub;
+   unsigned char *pucRecord;
+   unsigned char *pucOut;
+   const char *pcName;
+   size_t ulChildren;
+   size_t ulLength = 12;
+   size_t ulCount = 1;
+   size_t c;
+   Node_T oNChild = NULL;
+   int iStatus;
+
+   assert(oISpill != NULL);
+   assert(oISpill->oPPager != NULL);
+   assert(oNDir != NULL);
+   assert(Node_getType(oNDir) == DIRECTORY);
+   assert(Node_getStub(oNDir) == NULL);
+
+   /* spill created subdirectories first, so that every child is then
+      either a file or a stub */
+   ulChildren = Node_getNumChildren(oNDir);
+   for(c = 0; c < ulChildren; c++) {
+      (void) Node_getChild(oNDir, c, &oNChild);
+      if(Node_getType(oNChild) == DIRECTORY &&
+         Node_getStub(oNChild) == NULL) {
+         iStatus = Image_spill(oISpill, oNChild);
+         if(iStatus != SUCCESS)
+            return iStatus;
+      }
+   }
+
+   for(c = 0; c < ulChildren; c++) {
+      (void) Node_getChild(oNDir, c, &oNChild);
+      pcName = Path_getComponent(Node_getPath(oNChild),
+                  Path_getDepth(Node_getPath(oNChild)) - 1);
+      ulLength += 1 + 4 + strlen(pcName) +
+         (Node_getType(oNChild) == FILE_NODE ? 1 + 8 + 8 : 4 * 8);
+   }
+
+   pucRecord = malloc(ulLength);
+   if(pucRecord == NULL)
+      return MEMORY_ERROR;
+
+   pucOut = pucRecord + 12;
+   for(c = 0; c < ulChildren; c++) {
+      size_t ulNameLength;
+      (void) Node_getChild(oNDir, c, &oNChild);
+      pcName = Path_getComponent(Node_getPath(oNChild),
+                  Path_getDepth(Node_getPath(oNChild)) - 1);
+      ulNameLength = strlen(pcName);
+      if(Node_getType(oNChild) == FILE_NODE) {
+         void *pvContents = Node_getFileContents(oNChild);
+         *pucOut++ = IMAGE_FILE;
+         pucOut = Image_encodeNumber(pucOut, ulNameLength, 4);
+         memcpy(pucOut, pcName, ulNameLength);
+         pucOut += ulNameLength;
+         *pucOut++ = (unsigned char) (pvContents != NULL);
+         pucOut = Image_encodeNumber(pucOut,
+                     (size_t) (uintptr_t) pvContents, 8);
+         pucOut = Image_encodeNumber(pucOut,
+                     Node_getFileSize(oNChild), 8);
+         ulCount++;
+      }
+      else {
+         psChildStub = Node_getStub(oNChild);
+         *pucOut++ = IMAGE_DIR;
+         pucOut = Image_encodeNumber(pucOut, ulNameLength, 4);
+         memcpy(pucOut, pcName, ulNameLength);
+         pucOut += ulNameLength;
+         pucOut = Image_encodeNumber(pucOut,
+                     (size_t) (uintptr_t) psChildStub->oIImage, 8);
+         pucOut = Image_encodeNumber(pucOut, psChildStub->ulRecord, 8);
+         pucOut = Image_encodeNumber(pucOut, psChildStub->ulLength, 8);
+         pucOut = Image_encodeNumber(pucOut, psChildStub->ulCount, 8);
+         ulCount += psChildStub->ulCount;
+      }
+   }
+   pucOut = Image_encodeNumber(pucRecord, ulCount, 8);
+   (void) Image_encodeNumber(pucOut, ulChildren, 4);
+
+   psStub = malloc(sizeof(struct stub));
+   if(psStub == NULL) {
+      free(pucRecord);
+      return MEMORY_ERROR;
+   }
+   iStatus = Pager_append(oISpill->oPPager, pucRecord, ulLength,
+                          &psStub->ulRecord);
+   free(pucRecord);
+   if(iStatus != SUCCESS) {
+      free(psStub);
+      return iStatus;
+   }
+   psStub->oIImage = oISpill;
+   psStub->ulLength = ulLength;
+   psStub->ulCount = ulCount;
+
+   /* the record now stands for the children; removing the last child
+      each time keeps this linear */
+   while(ulChildren > 0) {
+      (void) Node_getChild(oNDir, --ulChildren, &oNChild);
+      (void) Node_free(oNChild);
+   }
+   Node_setStub(oNDir, psStub);
+   return SUCCESS;
+}
+
+void Image_freeStub(void *pvStub) {
+   free(pvStub);
+}
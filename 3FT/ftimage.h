@@ -0,0 +1,91 @@
+/*--------------------------------------------------------------------*/
+/* ftimage.h                                                          */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef FTIMAGE_INCLUDED
+#define FTIMAGE_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+#include "nodeFT.h"
+
+/*
+  An Image_T is a saved File Tree image mapped into memory. File
+  contents loaded from an image point into the mapping, so an image
+  must stay open for as long as any of its contents may be used.
+*/
+typedef struct image *Image_T;
+
+/*
+  Writes the hierarchy rooted at oNRoot (which may be NULL for an
+  empty tree) to iFd as an image, starting at the current offset,
+  which must be the start of the file. Every directory of the
+  hierarchy must already be materialized.
+  Returns SUCCESS, IO_ERROR if iFd cannot be written, or MEMORY_ERROR.
+*/
+int Image_save(Node_T oNRoot, int iFd);
+
+/*
+  Maps the image file pcFile and sets *poIImage to it.
+  Returns SUCCESS, or sets *poIImage to NULL and returns:
+  * IO_ERROR if pcFile cannot be opened or mapped, or is not an image
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Image_open(const char *pcFile, Image_T *poIImage);
+
+/*
+  Creates the root of oIImage as an unlinked stub directory and sets
+  *poNRoot to it (NULL for an empty image) and *pulCount to the number
+  of nodes in the whole saved hierarchy.
+  Returns SUCCESS, or sets *poNRoot to NULL and returns IO_ERROR if
+  the image is corrupt or MEMORY_ERROR.
+*/
+int Image_loadRoot(Image_T oIImage, Node_T *poNRoot, size_t *pulCount);
+
+/*
+  Creates an empty spill, an image kept in an unlinked scratch file
+  (in $TMPDIR, or /tmp) whose records are cached in a pool of ulFrames
+  pages, and sets *poIImage to it. Spills hold directories evicted from
+  memory by Image_spill; Image_loadRoot does not apply to them.
+  Returns SUCCESS, or sets *poIImage to NULL and returns:
+  * IO_ERROR if the scratch file cannot be created
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Image_newSpill(size_t ulFrames, Image_T *poIImage);
+
+/*
+  Writes the hierarchy beneath materialized directory oNDir to spill
+  oISpill, frees every node beneath oNDir, and makes oNDir a stub for
+  what was written, to be recreated the next time it is materialized.
+  File contents are recorded by address, not copied, so they must stay
+  valid for as long as the stub may be materialized.
+  Returns SUCCESS, or leaves some of oNDir's subdirectories spilled (but
+  oNDir itself materialized) and returns:
+  * IO_ERROR if the scratch file cannot be written
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Image_spill(Image_T oISpill, Node_T oNDir);
+
+/* Unmaps or closes oIImage and frees all memory allocated for it. */
+void Image_close(Image_T oIImage);
+
+/*
+  Returns the number of nodes, including the stub directory itself,
+  in the saved hierarchy that stub pvStub stands for.
+*/
+size_t Image_getStubCount(const void *pvStub);
+
+/*
+  Creates, as children of directory oNDir, the saved children that
+  stub pvStub stands for; child directories become stubs in turn.
+  Returns SUCCESS, or removes any children it created and returns:
+  * IO_ERROR if the image is corrupt
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Image_loadChildren(Node_T oNDir, const void *pvStub);
+
+/* Frees stub pvStub. */
+void Image_freeStub(void *pvStub);
+
+#endif
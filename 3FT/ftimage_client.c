@@ -0,0 +1,346 @@
+/*--------------------------------------------------------------------*/
+/* ftimage_client.c                                                   */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ft.h"
+
+/*
+  ftimage_client checks FT_saveImage and FT_loadImage: an image loaded
+  eagerly or lazily must give back the saved hierarchy and contents;
+  a lazy load must create directories only as they are reached; and a
+  missing, foreign or corrupt image must fail with IO_ERROR, eagerly
+  at load time and lazily when the corrupt part is reached. It
+  corrupts saved images at offsets found from the layout documented
+  in ftimage.c. Like ft_client, it checks with assert, so it must be
+  built without NDEBUG.
+*/
+
+/* The image trailer: the root entry's offset, then the magic */
+enum { TRAILER = 16, MAGIC_LEN = 8 };
+
+/* The directories and files of the generated part of the hierarchy */
+enum { WIDE_DIRS = 8, WIDE_FILES = 4, MAX_NAME = 256 };
+
+/* The hand-written files of the hierarchy, and their contents */
+static const char *apcFiles[] = {
+   "r/a/f1", "r/a/f2", "r/a/bin", "r/b/c/deep", "r/z"
+};
+static const char *apcContents[] = {
+   "alpha", "", "x\0y", "deep contents", "zed"
+};
+static const size_t aulLengths[] = { 5, 0, 3, 13, 3 };
+enum { FILES = sizeof(apcFiles) / sizeof(apcFiles[0]) };
+
+/* The nodes of the hierarchy: r, a, b, b/c, b/c/e, empty, w, the
+   files, and the generated directories and files */
+enum { NODES = 7 + FILES + WIDE_DIRS * (WIDE_FILES + 1) };
+
+/*--------------------------------------------------------------------*/
+
+/* Builds the hierarchy that every image is saved from. */
+static void Client_makeTree(void) {
+   char acPath[MAX_NAME];
+   size_t ulFile;
+   size_t ulDir;
+
+   assert(FT_init() == SUCCESS);
+   for(ulFile = 0; ulFile < FILES; ulFile++)
+      assert(FT_insertFile(apcFiles[ulFile],
+                           aulLengths[ulFile] == 0 ? NULL :
+                           (void *) apcContents[ulFile],
+                           aulLengths[ulFile]) == SUCCESS);
+   assert(FT_insertDir("r/b/c/e") == SUCCESS);
+   assert(FT_insertDir("r/empty") == SUCCESS);
+   for(ulDir = 0; ulDir < WIDE_DIRS; ulDir++)
+      for(ulFile = 0; ulFile < WIDE_FILES; ulFile++) {
+         sprintf(acPath, "r/w/d%lu/f%lu", (unsigned long) ulDir,
+                 (unsigned long) ulFile);
+         assert(FT_insertFile(acPath, "wide", 4) == SUCCESS);
+      }
+}
+
+/*
+  Checks that every hand-written file is in the FT with its contents,
+  which are loaded from the image and so are at a new address.
+*/
+static void Client_checkContents(void) {
+   size_t ulFile;
+
+   for(ulFile = 0; ulFile < FILES; ulFile++) {
+      boolean bIsFile = FALSE;
+      size_t ulSize = 0;
+      void *pvContents = FT_getFileContents(apcFiles[ulFile]);
+      assert(FT_stat(apcFiles[ulFile], &bIsFile, &ulSize) == SUCCESS);
+      assert(bIsFile && ulSize == aulLengths[ulFile]);
+      assert(ulSize == 0 ? pvContents == NULL :
+             pvContents != apcContents[ulFile] &&
+             memcmp(pvContents, apcContents[ulFile], ulSize) == 0);
+   }
+}
+
+/* Returns the number of nodes the FT has in memory. */
+static size_t Client_countResident(void) {
+   struct ftStats sStats;
+
+   assert(FT_getStats(&sStats) == SUCCESS);
+   return sStats.ulDirs + sStats.ulFiles;
+}
+
+/* Reads the ulBytes-byte little-endian number at ulOffset of iFd. */
+static size_t Client_getNumber(int iFd, size_t ulOffset,
+                               size_t ulBytes) {
+   unsigned char aucBytes[8];
+   size_t ulValue = 0;
+
+   assert(pread(iFd, aucBytes, ulBytes, (off_t) ulOffset) ==
+          (ssize_t) ulBytes);
+   while(ulBytes > 0)
+      ulValue = (ulValue << 8) | aucBytes[--ulBytes];
+   return ulValue;
+}
+
+/* Writes ulValue as a ulBytes-byte little-endian number at ulOffset. */
+static void Client_putNumber(int iFd, size_t ulOffset, size_t ulValue,
+                             size_t ulBytes) {
+   unsigned char aucBytes[8];
+   size_t i;
+
+   for(i = 0; i < ulBytes; i++) {
+      aucBytes[i] = (unsigned char) (ulValue & 0xff);
+      ulValue >>= 8;
+   }
+   assert(pwrite(iFd, aucBytes, ulBytes, (off_t) ulOffset) ==
+          (ssize_t) ulBytes);
+}
+
+/*
+  Returns the offset, in image iFd of ulSize bytes, of the record of
+  the root directory: the u64 at the end of the root entry, which
+  is 'd', a u32 name length, and the name.
+*/
+static size_t Client_rootRecord(int iFd, size_t ulSize) {
+   size_t ulEntry = Client_getNumber(iFd, ulSize - TRAILER, 8);
+   size_t ulName = Client_getNumber(iFd, ulEntry + 1, 4);
+   return Client_getNumber(iFd, ulEntry + 5 + ulName, 8);
+}
+
+/*
+  Returns the offset, in image iFd, of the u64 record offset in the
+  entry for child directory pcName of the directory whose record is
+  at ulRecord: a u64 node count, a u32 child count, then the entries.
+*/
+static size_t Client_childRecordField(int iFd, size_t ulRecord,
+                                      const char *pcName) {
+   size_t ulChildren = Client_getNumber(iFd, ulRecord + 8, 4);
+   size_t ulEntry = ulRecord + 12;
+   size_t c;
+
+   for(c = 0; c < ulChildren; c++) {
+      char acName[MAX_NAME];
+      unsigned char ucType;
+      size_t ulName = Client_getNumber(iFd, ulEntry + 1, 4);
+      assert(ulName < MAX_NAME);
+      assert(pread(iFd, &ucType, 1, (off_t) ulEntry) == 1);
+      assert(pread(iFd, acName, ulName, (off_t) (ulEntry + 5)) ==
+             (ssize_t) ulName);
+      acName[ulName] = '\0';
+      if(ucType == 'd' && strcmp(acName, pcName) == 0)
+         return ulEntry + 5 + ulName;
+      /* a directory entry ends with an offset, a file entry with a
+         flag, an offset and a length */
+      ulEntry += 5 + ulName + (ucType == 'd' ? 8 : 17);
+   }
+   assert(FALSE);
+   return 0;
+}
+
+/*
+  Copies image pcFrom to a new file pcTo, of ulSize bytes, and returns
+  a descriptor for it, open for reading and writing.
+*/
+static int Client_copyImage(const char *pcFrom, const char *pcTo,
+                            size_t ulSize) {
+   FILE *psFrom;
+   FILE *psTo;
+   char *pcBytes;
+   int iFd;
+
+   pcBytes = malloc(ulSize);
+   assert(pcBytes != NULL);
+   psFrom = fopen(pcFrom, "rb");
+   psTo = fopen(pcTo, "wb");
+   assert(psFrom != NULL && psTo != NULL);
+   assert(fread(pcBytes, 1, ulSize, psFrom) == ulSize);
+   assert(fwrite(pcBytes, 1, ulSize, psTo) == ulSize);
+   (void) fclose(psFrom);
+   assert(fclose(psTo) == 0);
+   free(pcBytes);
+
+   iFd = open(pcTo, O_RDWR);
+   assert(iFd >= 0);
+   return iFd;
+}
+
+/*
+  Checks that loading image pcFile fails with IO_ERROR in both modes
+  and leaves the FT empty and usable.
+*/
+static void Client_expectCorrupt(const char *pcFile) {
+   char *pcTree;
+   int iMode;
+
+   for(iMode = FT_LOAD_EAGER; iMode <= FT_LOAD_LAZY; iMode++) {
+      assert(FT_init() == SUCCESS);
+      assert(FT_loadImage(pcFile, iMode) == IO_ERROR);
+      assert((pcTree = FT_toString()) != NULL);
+      assert(strcmp(pcTree, "") == 0);
+      free(pcTree);
+      assert(FT_insertDir("r") == SUCCESS);
+      assert(FT_destroy() == SUCCESS);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Runs every check with images in a new scratch directory beneath
+  $TMPDIR (or /tmp), which is removed afterwards. Returns 0; a failed
+  check aborts.
+*/
+int main(void) {
+   char acDir[MAX_NAME];
+   char acImage[MAX_NAME + 16];
+   char acCopy[MAX_NAME + 16];
+   const char *pcTmp;
+   char *pcTree;
+   char *pcLoaded;
+   size_t ulSize;
+   size_t ulRecord;
+   int iFd;
+
+   pcTmp = getenv("TMPDIR");
+   if(pcTmp == NULL || *pcTmp == '\0')
+      pcTmp = "/tmp";
+   sprintf(acDir, "%.200s/ftimage_client.XXXXXX", pcTmp);
+   assert(mkdtemp(acDir) != NULL);
+   sprintf(acImage, "%s/image", acDir);
+   sprintf(acCopy, "%s/copy", acDir);
+
+   /* save */
+   assert(FT_saveImage(1) == INITIALIZATION_ERROR);
+   assert(FT_loadImage(acImage, FT_LOAD_EAGER) == INITIALIZATION_ERROR);
+   Client_makeTree();
+   iFd = open(acImage, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   assert(iFd >= 0);
+   assert(FT_saveImage(iFd) == SUCCESS);
+   ulSize = (size_t) lseek(iFd, 0, SEEK_END);
+   (void) close(iFd);
+   assert((pcTree = FT_toString()) != NULL);
+   assert(FT_loadImage(acImage, FT_LOAD_EAGER) == CONFLICTING_PATH);
+   assert(FT_destroy() == SUCCESS);
+
+   /* an eager load creates everything at once */
+   assert(FT_init() == SUCCESS);
+   assert(FT_loadImage(acImage, FT_LOAD_EAGER) == SUCCESS);
+   assert(Client_countResident() == NODES);
+   assert((pcLoaded = FT_toString()) != NULL);
+   assert(strcmp(pcLoaded, pcTree) == 0);
+   free(pcLoaded);
+   Client_checkContents();
+   assert(FT_destroy() == SUCCESS);
+
+   /* a lazy load creates the root, then what each operation reaches */
+   assert(FT_init() == SUCCESS);
+   assert(FT_loadImage(acImage, FT_LOAD_LAZY) == SUCCESS);
+   assert(Client_countResident() == 1);
+   assert(FT_containsFile("r/b/c/deep"));
+   assert(Client_countResident() < NODES / 2);
+   assert(FT_insertFile("r/b/c/new", "new", 3) == SUCCESS);
+   assert(FT_rmFile("r/b/c/new") == SUCCESS);
+   assert((pcLoaded = FT_toString()) != NULL);
+   assert(strcmp(pcLoaded, pcTree) == 0);
+   free(pcLoaded);
+   assert(Client_countResident() == NODES);
+   Client_checkContents();
+   assert(FT_destroy() == SUCCESS);
+
+   /* loaded contents may be modified in place */
+   assert(FT_init() == SUCCESS);
+   assert(FT_loadImage(acImage, FT_LOAD_LAZY) == SUCCESS);
+   ((char *) FT_getFileContents("r/z"))[0] = 'Z';
+   assert(memcmp(FT_getFileContents("r/z"), "Zed", 3) == 0);
+   assert(FT_destroy() == SUCCESS);
+
+   /* images that cannot be read at all */
+   sprintf(acCopy, "%s/missing", acDir);
+   Client_expectCorrupt(acCopy);
+   sprintf(acCopy, "%s/copy", acDir);
+   iFd = Client_copyImage(acImage, acCopy, ulSize);
+   assert(pwrite(iFd, "NOTANIMG", MAGIC_LEN, 0) == MAGIC_LEN);
+   (void) close(iFd);
+   Client_expectCorrupt(acCopy);
+
+   /* a root entry offset past the end of the image */
+   iFd = Client_copyImage(acImage, acCopy, ulSize);
+   Client_putNumber(iFd, ulSize - TRAILER, ulSize + 100, 8);
+   (void) close(iFd);
+   Client_expectCorrupt(acCopy);
+
+   /* a root record with far more children than the image holds:
+      eagerly a load error, lazily an error of the first operation
+      that needs the root's children */
+   iFd = Client_copyImage(acImage, acCopy, ulSize);
+   ulRecord = Client_rootRecord(iFd, ulSize);
+   Client_putNumber(iFd, ulRecord + 8, 0xffffffffUL, 4);
+   (void) close(iFd);
+   assert(FT_init() == SUCCESS);
+   assert(FT_loadImage(acCopy, FT_LOAD_EAGER) == IO_ERROR);
+   assert(FT_destroy() == SUCCESS);
+   assert(FT_init() == SUCCESS);
+   assert(FT_loadImage(acCopy, FT_LOAD_LAZY) == SUCCESS);
+   assert(FT_containsDir("r"));
+   assert(!FT_containsDir("r/a"));
+   assert(FT_insertDir("r/new") == IO_ERROR);
+   assert(FT_toString() == NULL);
+   assert(FT_destroy() == SUCCESS);
+
+   /* the same corruption in the record of r/b: a lazy load fails
+      only within that branch */
+   iFd = Client_copyImage(acImage, acCopy, ulSize);
+   ulRecord = Client_rootRecord(iFd, ulSize);
+   ulRecord = Client_getNumber(iFd, Client_childRecordField(iFd,
+                               ulRecord, "b"), 8);
+   Client_putNumber(iFd, ulRecord + 8, 0xffffffffUL, 4);
+   (void) close(iFd);
+   assert(FT_init() == SUCCESS);
+   assert(FT_loadImage(acCopy, FT_LOAD_EAGER) == IO_ERROR);
+   assert(FT_destroy() == SUCCESS);
+   assert(FT_init() == SUCCESS);
+   assert(FT_loadImage(acCopy, FT_LOAD_LAZY) == SUCCESS);
+   assert(FT_containsFile("r/a/f1"));
+   assert(memcmp(FT_getFileContents("r/z"), "zed", 3) == 0);
+   assert(FT_containsDir("r/b"));
+   assert(!FT_containsDir("r/b/c"));
+   assert(FT_getFileContents("r/b/c/deep") == NULL);
+   assert(FT_insertDir("r/b/new") == IO_ERROR);
+   assert(FT_rmDir("r/b/c") == IO_ERROR);
+   assert(FT_toString() == NULL);
+   assert(FT_destroy() == SUCCESS);
+
+   free(pcTree);
+   assert(unlink(acImage) == 0);
+   assert(unlink(acCopy) == 0);
+   assert(rmdir(acDir) == 0);
+   fprintf(stderr, "ftimage_client: %lu-node image loaded and "
+           "corrupted, all checks passed\n", (unsigned long) NODES);
+   return 0;
+}
@@ -0,0 +1,285 @@
+/*--------------------------------------------------------------------*/
+/* ftlatency_client.c                                                 */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/*
+  ftlatency_client checks the latency histograms of an FT compiled
+  with -D FT_LATENCY: each call must be counted once, under the
+  operation and the status it really had, including the operations
+  that return a boolean or a pointer; calls on other threads must be
+  summed in; and FT_latencyToString must have one consistent line for
+  each operation and status called. Like ft_client, it checks with
+  assert, so it must be built without NDEBUG.
+*/
+
+/* The number of statuses, the calls each thread makes, and the
+   longest name in FT_latencyToString's lines */
+enum { STATUSES = IO_ERROR + 1, THREAD_CALLS = 100, MAX_NAME = 32 };
+
+/* The names FT_latencyToString gives the operations and statuses */
+static const char *apcOpNames[FT_OPS] = {
+   "FT_insertDir", "FT_containsDir", "FT_rmDir", "FT_insertFile",
+   "FT_containsFile", "FT_rmFile", "FT_getFileContents",
+   "FT_replaceFileContents", "FT_stat", "FT_toString"
+};
+static const char *apcStatusNames[STATUSES] = {
+   "SUCCESS", "INITIALIZATION_ERROR", "ALREADY_IN_TREE",
+   "NO_SUCH_PATH", "CONFLICTING_PATH", "BAD_PATH", "NOT_A_DIRECTORY",
+   "NOT_A_FILE", "MEMORY_ERROR", "IO_ERROR"
+};
+
+/* The calls made so far, by operation and the status expected */
+static size_t aaulExpected[FT_OPS][STATUSES];
+
+/* The contents of the one file given contents */
+static char acContents[] = "contents";
+
+/*--------------------------------------------------------------------*/
+
+/* Counts a call to eOp expected to have status iStatus. */
+static void Client_expect(enum ftOp eOp, int iStatus) {
+   assert(eOp < FT_OPS);
+   assert(iStatus >= 0 && iStatus < STATUSES);
+
+   aaulExpected[eOp][iStatus]++;
+}
+
+/* Asserts that FT_containsDir(pcPath) has status iStatus. */
+static void Client_containsDir(const char *pcPath, int iStatus) {
+   assert(FT_containsDir(pcPath) == (iStatus == SUCCESS));
+   Client_expect(FT_OP_CONTAINS_DIR, iStatus);
+}
+
+/* Asserts that FT_containsFile(pcPath) has status iStatus. */
+static void Client_containsFile(const char *pcPath, int iStatus) {
+   assert(FT_containsFile(pcPath) == (iStatus == SUCCESS));
+   Client_expect(FT_OP_CONTAINS_FILE, iStatus);
+}
+
+/*
+  Asserts that FT_getFileContents(pcPath) returns pvContents, with
+  status iStatus.
+*/
+static void Client_getContents(const char *pcPath, void *pvContents,
+                               int iStatus) {
+   assert(FT_getFileContents(pcPath) == pvContents);
+   Client_expect(FT_OP_GET_CONTENTS, iStatus);
+}
+
+/*
+  Asserts that FT_replaceFileContents(pcPath, pvNew, ...) returns
+  pvOld, with status iStatus.
+*/
+static void Client_replace(const char *pcPath, void *pvNew,
+                           void *pvOld, int iStatus) {
+   assert(FT_replaceFileContents(pcPath, pvNew, 0) == pvOld);
+   Client_expect(FT_OP_REPLACE_CONTENTS, iStatus);
+}
+
+/*
+  Asserts that FT_toString returns NULL exactly if iStatus is not
+  SUCCESS, with status iStatus.
+*/
+static void Client_toString(int iStatus) {
+   char *pcResult = FT_toString();
+
+   assert((pcResult != NULL) == (iStatus == SUCCESS));
+   free(pcResult);
+   Client_expect(FT_OP_TO_STRING, iStatus);
+}
+
+/* Looks up directory r THREAD_CALLS times, on its own thread. */
+static void *Client_lookUp(void *pvUnused) {
+   size_t i;
+
+   (void) pvUnused;
+   for(i = 0; i < THREAD_CALLS; i++)
+      assert(FT_containsDir("r"));
+   return NULL;
+}
+
+/*
+  Runs Client_lookUp on a new thread, and waits for it, so that the
+  FT is never used by two threads at once.
+*/
+static void Client_runThread(void) {
+   pthread_t sThread;
+
+   assert(pthread_create(&sThread, NULL, Client_lookUp, NULL) == 0);
+   assert(pthread_join(sThread, NULL) == 0);
+   aaulExpected[FT_OP_CONTAINS_DIR][SUCCESS] += THREAD_CALLS;
+}
+
+/*
+  Asserts that every histogram holds the calls expected of it, and
+  returns the number of histograms that hold any.
+*/
+static size_t Client_checkHistograms(void) {
+   size_t aulCounts[FT_LATENCY_BUCKETS];
+   size_t ulUsed = 0;
+   int iOp;
+   int iStatus;
+   size_t b;
+
+   for(iOp = 0; iOp < FT_OPS; iOp++)
+      for(iStatus = 0; iStatus < STATUSES; iStatus++) {
+         size_t ulCalls = 0;
+         assert(FT_getLatencyHistogram((enum ftOp) iOp, iStatus,
+                                       aulCounts));
+         for(b = 0; b < FT_LATENCY_BUCKETS; b++)
+            ulCalls += aulCounts[b];
+         assert(ulCalls == aaulExpected[iOp][iStatus]);
+         if(ulCalls != 0)
+            ulUsed++;
+      }
+   return ulUsed;
+}
+
+/* Returns the index of pcName among the iNames names apcNames. */
+static int Client_index(const char *pcName, const char **apcNames,
+                        int iNames) {
+   int i;
+
+   for(i = 0; i < iNames; i++)
+      if(strcmp(pcName, apcNames[i]) == 0)
+         return i;
+   assert(FALSE);
+   return 0;
+}
+
+/*
+  Asserts that FT_latencyToString has ulUsed lines, each of which
+  names an operation and status with the calls expected of it, has
+  percentiles in order, and has buckets that add up to the calls.
+*/
+static void Client_checkString(size_t ulUsed) {
+   char *pcResult = FT_latencyToString();
+   char *pcLine;
+   size_t ulLines = 0;
+
+   assert(pcResult != NULL);
+   for(pcLine = strtok(pcResult, "\n"); pcLine != NULL;
+       pcLine = strtok(NULL, "\n")) {
+      char acOp[MAX_NAME];
+      char acStatus[MAX_NAME];
+      unsigned long aulBounds[4];
+      unsigned long ulCalls;
+      unsigned long ulBucket;
+      unsigned long ulCount;
+      unsigned long ulSum = 0;
+      int iOp;
+      int iStatus;
+      int iRead;
+      char *pc;
+
+      assert(sscanf(pcLine, "%31s %31s calls=%lu p50<=%lu p99<=%lu "
+                    "p999<=%lu max<=%lu%n", acOp, acStatus, &ulCalls,
+                    &aulBounds[0], &aulBounds[1], &aulBounds[2],
+                    &aulBounds[3], &iRead) == 7);
+      iOp = Client_index(acOp, apcOpNames, FT_OPS);
+      iStatus = Client_index(acStatus, apcStatusNames, STATUSES);
+      assert(ulCalls == aaulExpected[iOp][iStatus]);
+      assert(aulBounds[0] <= aulBounds[1]);
+      assert(aulBounds[1] <= aulBounds[2]);
+      assert(aulBounds[2] <= aulBounds[3]);
+
+      for(pc = pcLine + iRead; *pc != '\0'; pc += iRead) {
+         assert(sscanf(pc, " %lu:%lu%n", &ulBucket, &ulCount,
+                       &iRead) == 2);
+         assert(ulBucket < FT_LATENCY_BUCKETS && ulCount != 0);
+         ulSum += ulCount;
+      }
+      assert(ulSum == ulCalls);
+      ulLines++;
+   }
+   assert(ulLines == ulUsed);
+   free(pcResult);
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Makes calls with as many statuses as each operation can give, then
+  checks the histograms and the string. Returns 0; a failed check
+  aborts.
+*/
+int main(void) {
+   boolean bIsFile;
+   size_t ulSize;
+
+   /* before FT_init */
+   Client_containsDir("r", INITIALIZATION_ERROR);
+   Client_containsFile("r/f", INITIALIZATION_ERROR);
+   Client_getContents("r/f", NULL, INITIALIZATION_ERROR);
+   Client_replace("r/f", acContents, NULL, INITIALIZATION_ERROR);
+   Client_toString(INITIALIZATION_ERROR);
+   assert(FT_insertDir("r") == INITIALIZATION_ERROR);
+   Client_expect(FT_OP_INSERT_DIR, INITIALIZATION_ERROR);
+
+   assert(FT_init() == SUCCESS);
+   Client_toString(SUCCESS);
+   assert(FT_insertDir("r/d") == SUCCESS);
+   Client_expect(FT_OP_INSERT_DIR, SUCCESS);
+   assert(FT_insertDir("r/d") == ALREADY_IN_TREE);
+   Client_expect(FT_OP_INSERT_DIR, ALREADY_IN_TREE);
+   assert(FT_insertFile("r/f", NULL, 0) == SUCCESS);
+   Client_expect(FT_OP_INSERT_FILE, SUCCESS);
+   assert(FT_insertFile("r/f/g", NULL, 0) == NOT_A_DIRECTORY);
+   Client_expect(FT_OP_INSERT_FILE, NOT_A_DIRECTORY);
+   assert(FT_insertFile("s/g", NULL, 0) == CONFLICTING_PATH);
+   Client_expect(FT_OP_INSERT_FILE, CONFLICTING_PATH);
+
+   Client_containsDir("r/d", SUCCESS);
+   Client_containsDir("r/f", NOT_A_DIRECTORY);
+   Client_containsDir("r/x", NO_SUCH_PATH);
+   Client_containsDir("r//d", BAD_PATH);
+   Client_containsDir("s", CONFLICTING_PATH);
+   Client_containsFile("r/f", SUCCESS);
+   Client_containsFile("r/d", NOT_A_FILE);
+   Client_containsFile("r/x", NO_SUCH_PATH);
+
+   /* a file's NULL contents are a success, not a missing path */
+   Client_getContents("r/f", NULL, SUCCESS);
+   Client_getContents("r/d", NULL, NOT_A_FILE);
+   Client_getContents("r/x", NULL, NO_SUCH_PATH);
+   Client_replace("r/f", acContents, NULL, SUCCESS);
+   Client_replace("r/f", NULL, acContents, SUCCESS);
+   Client_replace("r/d", acContents, NULL, NOT_A_FILE);
+   Client_replace("r/x", acContents, NULL, NO_SUCH_PATH);
+
+   assert(FT_stat("r/f", &bIsFile, &ulSize) == SUCCESS);
+   Client_expect(FT_OP_STAT, SUCCESS);
+   assert(FT_stat("r/x", &bIsFile, &ulSize) == NO_SUCH_PATH);
+   Client_expect(FT_OP_STAT, NO_SUCH_PATH);
+   Client_toString(SUCCESS);
+
+   /* each thread counts in its own block */
+   Client_runThread();
+   Client_runThread();
+
+   assert(FT_rmFile("r/d") == NOT_A_FILE);
+   Client_expect(FT_OP_RM_FILE, NOT_A_FILE);
+   assert(FT_rmFile("r/f") == SUCCESS);
+   Client_expect(FT_OP_RM_FILE, SUCCESS);
+   assert(FT_rmDir("r/x") == NO_SUCH_PATH);
+   Client_expect(FT_OP_RM_DIR, NO_SUCH_PATH);
+   assert(FT_rmDir("r") == SUCCESS);
+   Client_expect(FT_OP_RM_DIR, SUCCESS);
+   assert(FT_destroy() == SUCCESS);
+
+   Client_checkString(Client_checkHistograms());
+   fprintf(stderr, "ftlatency_client: %lu histograms, "
+           "all checks passed\n",
+           (unsigned long) Client_checkHistograms());
+   return 0;
+}
@@ -0,0 +1,173 @@
+/*--------------------------------------------------------------------*/
+/* ftload_client.c                                                    */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/*
+  ftload_client checks FT_loadFromString: the output of FT_toString
+  must load back into the same hierarchy, and each malformed buffer
+  must fail with the status ft.h documents for it and leave the FT
+  empty and usable. Some of the buffers fail after directories have
+  been loaded but not yet put in order, which is when freeing the
+  partial hierarchy must not rely on their order. MEMORY_ERROR is not
+  checked. Like ft_client, it checks with assert, so it must be built
+  without NDEBUG.
+*/
+
+/* A buffer to load, its types, and the status loading it returns */
+struct load {
+   const char *pcBuffer;
+   const char *pcTypes;
+   int iStatus;
+};
+
+/* The malformed buffers, at least one for each documented status */
+static const struct load asBad[] = {
+   /* lines that are not paths, or are out of order */
+   { "a\n\n", NULL, BAD_PATH },
+   { "a\na/b/\n", NULL, BAD_PATH },
+   { "a\na/c\na/b\n", NULL, BAD_PATH },
+   { "a\na/b\na/b\n", "dff", BAD_PATH },
+   { "a\na/d\na/f\n", "ddf", BAD_PATH },
+   { "a\na/b\na/b/c\na/a\n", NULL, BAD_PATH },
+   /* types that do not match the lines */
+   { "a\na/f\n", "dx", BAD_PATH },
+   { "a\na/f\n", "dfd", BAD_PATH },
+   { "a\na/f\na/b\na/b/x\n", "dfd", BAD_PATH },
+   /* more than one root, or a file root */
+   { "a\nb\n", NULL, CONFLICTING_PATH },
+   { "a\nb/c\n", NULL, CONFLICTING_PATH },
+   { "a\n", "f", CONFLICTING_PATH },
+   /* lines whose parent has not appeared */
+   { "a/b\n", NULL, NO_SUCH_PATH },
+   { "a\na/b/c\n", NULL, NO_SUCH_PATH },
+   { "a\na/b\na/b/c/d\n", NULL, NO_SUCH_PATH },
+   /* lines beneath a file */
+   { "a\na/f\na/f/g\n", "dfd", NOT_A_DIRECTORY },
+   /* a file and a directory of the same path */
+   { "a\na/x\na/x\n", "dfd", ALREADY_IN_TREE },
+   { "a\na/w\na/x\na/x\na/x/y\na/y\n", "dffddd", ALREADY_IN_TREE },
+   { "a\na/b\na/b/x\na/b/x\na/c\n", "ddfdd", ALREADY_IN_TREE }
+};
+enum { BAD = sizeof(asBad) / sizeof(asBad[0]) };
+
+/*--------------------------------------------------------------------*/
+
+/* Checks that the FT is empty, then that it can still be used. */
+static void Client_checkEmpty(void) {
+   char *pcTree = FT_toString();
+
+   assert(pcTree != NULL);
+   assert(strcmp(pcTree, "") == 0);
+   free(pcTree);
+   assert(FT_insertDir("a/b") == SUCCESS);
+   assert(FT_rmDir("a") == SUCCESS);
+}
+
+/*
+  Builds a hierarchy of directories and files beneath root r, loads
+  its FT_toString output into a new FT, and checks that the two
+  agree, that loaded files are empty, and that the loaded directories
+  are in order for later operations.
+*/
+static void Client_checkRoundTrip(void) {
+   static const char *apcDirs[] = {
+      "r/m", "r/b/c", "r/b/a", "r/z/y/x", "r/m/n"
+   };
+   static const char *apcFiles[] = {
+      "r/f", "r/a", "r/m/g", "r/b/c/k", "r/z/y/x/q", "r/z/0"
+   };
+   enum { DIRS = sizeof(apcDirs) / sizeof(apcDirs[0]),
+          FILES = sizeof(apcFiles) / sizeof(apcFiles[0]) };
+   char acTypes[64];
+   char *pcTree;
+   char *pcLoaded;
+   char *pcLine;
+   size_t ulLines = 0;
+   size_t i;
+
+   assert(FT_init() == SUCCESS);
+   for(i = 0; i < DIRS; i++)
+      assert(FT_insertDir(apcDirs[i]) == SUCCESS);
+   for(i = 0; i < FILES; i++)
+      assert(FT_insertFile(apcFiles[i], "c", 1) == SUCCESS);
+   assert((pcTree = FT_toString()) != NULL);
+
+   /* each line's type, from the FT it came from */
+   for(pcLine = pcTree; *pcLine != '\0';
+       pcLine = strchr(pcLine, '\n') + 1) {
+      char acPath[64];
+      size_t ulLength = (size_t) (strchr(pcLine, '\n') - pcLine);
+      assert(ulLength < sizeof(acPath));
+      assert(ulLines + 1 < sizeof(acTypes));
+      memcpy(acPath, pcLine, ulLength);
+      acPath[ulLength] = '\0';
+      acTypes[ulLines++] = FT_containsFile(acPath) ? 'f' : 'd';
+   }
+   acTypes[ulLines] = '\0';
+   assert(FT_loadFromString(pcTree, strlen(pcTree), acTypes) ==
+          CONFLICTING_PATH);
+   assert(FT_destroy() == SUCCESS);
+
+   assert(FT_init() == SUCCESS);
+   assert(FT_loadFromString(pcTree, strlen(pcTree), acTypes) ==
+          SUCCESS);
+   assert((pcLoaded = FT_toString()) != NULL);
+   assert(strcmp(pcLoaded, pcTree) == 0);
+   free(pcLoaded);
+   for(i = 0; i < FILES; i++)
+      assert(FT_getFileContents(apcFiles[i]) == NULL);
+   assert(FT_insertFile("r/b/b", "c", 1) == SUCCESS);
+   assert(FT_insertDir("r/b/b") == ALREADY_IN_TREE);
+   assert(FT_rmDir("r/z/y") == SUCCESS);
+   assert(FT_containsDir("r/m/n"));
+   assert(FT_destroy() == SUCCESS);
+
+   /* without the final newline, only up to ulLength, and untyped */
+   assert(FT_init() == SUCCESS);
+   assert(FT_loadFromString("r\nr/a\nr/b\nr/b/c\nr/d", 16, NULL) ==
+          SUCCESS);
+   assert(FT_containsDir("r/b/c") && !FT_containsDir("r/d"));
+   assert(FT_insertDir("r/d") == SUCCESS);
+   assert(FT_destroy() == SUCCESS);
+
+   /* an empty buffer loads an empty hierarchy */
+   assert(FT_init() == SUCCESS);
+   assert(FT_loadFromString(NULL, 0, NULL) == SUCCESS);
+   Client_checkEmpty();
+   assert(FT_destroy() == SUCCESS);
+
+   free(pcTree);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Runs every check. Returns 0; a failed check aborts. */
+int main(void) {
+   size_t i;
+
+   assert(FT_loadFromString("a\n", 2, NULL) == INITIALIZATION_ERROR);
+
+   Client_checkRoundTrip();
+
+   for(i = 0; i < BAD; i++) {
+      assert(FT_init() == SUCCESS);
+      assert(FT_loadFromString(asBad[i].pcBuffer,
+                               strlen(asBad[i].pcBuffer),
+                               asBad[i].pcTypes) == asBad[i].iStatus);
+      Client_checkEmpty();
+      assert(FT_destroy() == SUCCESS);
+   }
+
+   fprintf(stderr, "ftload_client: %lu malformed buffers rejected, "
+           "all checks passed\n", (unsigned long) BAD);
+   return 0;
+}
@@ -0,0 +1,295 @@
+/*--------------------------------------------------------------------*/
+/* ftnode_client.c                                                    */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nodeFT.h"
+#include "path.h"
+
+/*
+  ftnode_client checks nodeFT's child tags directly: lookups among
+  tagged children, including a tag that matches a child whose name
+  differs; a directory growing past the number of children tags are
+  kept for and shrinking back, so that its tags are rebuilt lazily;
+  and Node_sortChildren, both merging two sorted runs and sorting
+  arbitrary ones, followed by lookups that rebuild the tags. Like
+  ft_client, it checks with assert, so it must be built without
+  NDEBUG.
+*/
+
+/* The most children nodeFT keeps tags for, and how far past it the
+   wide directory grows */
+enum { MAX_TAGGED = 16, WIDE = 40 };
+
+/* The longest name and path, and how many names are tried to find
+   collisions */
+enum { MAX_NAME = 16, MAX_PATH = 64, TRIES = 100000 };
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Returns the tag nodeFT gives a child whose last component is
+  pcName, as Node_tag computes it, so that colliding names can be
+  chosen.
+*/
+static unsigned char Client_tag(const char *pcName) {
+   const unsigned char *pucChar;
+   unsigned long ulHash = 2166136261UL;
+
+   for(pucChar = (const unsigned char *) pcName; *pucChar != '\0';
+       pucChar++)
+      ulHash = ((ulHash ^ *pucChar) * 16777619UL) & 0xffffffffUL;
+   return (unsigned char) (ulHash ^ (ulHash >> 8) ^ (ulHash >> 16) ^
+                           (ulHash >> 24));
+}
+
+/*
+  Writes to acName a name, other than pcName, with the same tag as
+  pcName, and of the form xN.
+*/
+static void Client_collide(const char *pcName, char *acName) {
+   size_t i;
+
+   for(i = 0; i < TRIES; i++) {
+      sprintf(acName, "x%lu", (unsigned long) i);
+      if(strcmp(acName, pcName) != 0 &&
+         Client_tag(acName) == Client_tag(pcName))
+         return;
+   }
+   assert(FALSE);
+}
+
+/* Returns a new path for pcPath, which must be well formed. */
+static Path_T Client_path(const char *pcPath) {
+   Path_T oPPath = NULL;
+
+   assert(Path_new(pcPath, &oPPath) == SUCCESS);
+   return oPPath;
+}
+
+/*
+  Returns the index of oNParent's child with path pcPath, asserting
+  that Node_hasChild finds it and that it is at that index, or
+  returns the number of children if Node_hasChild does not find it.
+*/
+static size_t Client_find(Node_T oNParent, const char *pcPath) {
+   Path_T oPPath = Client_path(pcPath);
+   Node_T oNChild = NULL;
+   size_t ulIndex = 0;
+   boolean bFound;
+
+   bFound = Node_hasChild(oNParent, oPPath, &ulIndex);
+   Path_free(oPPath);
+   if(!bFound)
+      return Node_getNumChildren(oNParent);
+   assert(Node_getChild(oNParent, ulIndex, &oNChild) == SUCCESS);
+   assert(strcmp(Path_getPathname(Node_getPath(oNChild)), pcPath) ==
+          0);
+   return ulIndex;
+}
+
+/* Creates child pcPath of oNParent in order, and returns it. */
+static Node_T Client_add(Node_T oNParent, const char *pcPath,
+                         typeNode type) {
+   Path_T oPPath = Client_path(pcPath);
+   Node_T oNNew = NULL;
+
+   assert(Node_new(oPPath, oNParent, &oNNew, type, NULL, 0) ==
+          SUCCESS);
+   Path_free(oPPath);
+   return oNNew;
+}
+
+/* Appends child pcPath to oNParent's children, and returns it. */
+static Node_T Client_append(Node_T oNParent, const char *pcPath) {
+   Node_T oNNew = NULL;
+
+   /* Node_newUnsorted keeps the path */
+   assert(Node_newUnsorted(Client_path(pcPath), oNParent, &oNNew,
+                           DIRECTORY, NULL, 0) == SUCCESS);
+   return oNNew;
+}
+
+/* Asserts that oNParent's children are in order. */
+static void Client_checkOrder(Node_T oNParent) {
+   Node_T oNPrevious = NULL;
+   Node_T oNChild = NULL;
+   size_t i;
+
+   for(i = 0; i < Node_getNumChildren(oNParent); i++) {
+      assert(Node_getChild(oNParent, i, &oNChild) == SUCCESS);
+      if(oNPrevious != NULL)
+         assert(Node_compare(oNPrevious, oNChild) < 0);
+      oNPrevious = oNChild;
+   }
+}
+
+/*
+  Asserts that each of oNParent's children is found at its index, and
+  that name pcMissing beneath it, which must have the same tag as one
+  of its children, is not found.
+*/
+static void Client_checkLookups(Node_T oNParent,
+                                const char *pcMissing) {
+   char acPath[MAX_PATH];
+   Node_T oNChild = NULL;
+   size_t i;
+
+   for(i = 0; i < Node_getNumChildren(oNParent); i++) {
+      assert(Node_getChild(oNParent, i, &oNChild) == SUCCESS);
+      assert(Client_find(oNParent,
+                         Path_getPathname(Node_getPath(oNChild))) == i);
+   }
+   sprintf(acPath, "%s/%s", Path_getPathname(Node_getPath(oNParent)),
+           pcMissing);
+   assert(Client_find(oNParent, acPath) ==
+          Node_getNumChildren(oNParent));
+}
+
+/*
+  Checks lookups in directory r/w as it grows from empty to WIDE
+  children, past MAX_TAGGED, and shrinks back to none, with a file
+  among them and a missing name whose tag matches a child's.
+*/
+static void Client_checkGrowth(Node_T oNRoot) {
+   char acPath[MAX_PATH];
+   char acMissing[MAX_NAME];
+   Node_T oNWide = Client_add(oNRoot, "r/w", DIRECTORY);
+   Node_T oNFile;
+   size_t i;
+
+   /* every child's name collides with a name that is never added */
+   Client_collide("c0", acMissing);
+   for(i = 0; i < WIDE; i++) {
+      sprintf(acPath, "r/w/c%lu", (unsigned long) i);
+      (void) Client_add(oNWide, acPath, DIRECTORY);
+      Client_checkLookups(oNWide, acMissing);
+   }
+   assert(Node_getNumChildren(oNWide) == WIDE);
+
+   /* a file among them keeps its contents whatever the tags do */
+   oNFile = Client_add(oNWide, "r/w/file", FILE_NODE);
+   assert(Node_swapFileContents(oNFile, acMissing, 3) == NULL);
+   Client_checkLookups(oNWide, acMissing);
+
+   /* shrink back past MAX_TAGGED, removing from both ends and the
+      middle, so that the tags are rebuilt lazily on a lookup */
+   for(i = 0; Node_getNumChildren(oNWide) > 1; i++) {
+      Node_T oNChild = NULL;
+      size_t ulCount = Node_getNumChildren(oNWide);
+      size_t ulIndex = i % 3 == 0 ? 0 :
+         i % 3 == 1 ? ulCount - 1 : ulCount / 2;
+      assert(Node_getChild(oNWide, ulIndex, &oNChild) == SUCCESS);
+      if(oNChild == oNFile)
+         assert(Node_getChild(oNWide, (ulIndex + 1) % ulCount,
+                              &oNChild) == SUCCESS);
+      assert(Node_free(oNChild) == 1);
+      Client_checkLookups(oNWide, acMissing);
+   }
+   assert(Node_getFileContents(oNFile) == acMissing);
+   assert(Node_getFileSize(oNFile) == 3);
+   assert(Node_free(oNWide) == 2);
+}
+
+/*
+  Checks lookups among tagged children two of which have the same
+  tag, and then a missing name with that tag too.
+*/
+static void Client_checkCollisions(Node_T oNRoot) {
+   char acName[MAX_NAME];
+   char acPath[MAX_PATH];
+   char acMissing[MAX_NAME];
+   Node_T oNDir = Client_add(oNRoot, "r/t", DIRECTORY);
+   size_t i;
+
+   Client_collide("k", acName);
+   /* another name with the same tag, not the one just found */
+   for(i = 0; i < TRIES; i++) {
+      sprintf(acMissing, "y%lu", (unsigned long) i);
+      if(Client_tag(acMissing) == Client_tag("k"))
+         break;
+   }
+   assert(i < TRIES);
+
+   (void) Client_add(oNDir, "r/t/k", DIRECTORY);
+   sprintf(acPath, "r/t/%s", acName);
+   (void) Client_add(oNDir, acPath, FILE_NODE);
+   for(i = 0; i < MAX_TAGGED - 2; i++) {
+      sprintf(acPath, "r/t/n%lu", (unsigned long) i);
+      (void) Client_add(oNDir, acPath, DIRECTORY);
+   }
+   assert(Node_getNumChildren(oNDir) == MAX_TAGGED);
+   Client_checkLookups(oNDir, acMissing);
+   /* a prefix of a child's path, and a path beneath a child */
+   assert(Client_find(oNDir, "r/t/n") == MAX_TAGGED);
+   assert(Client_find(oNDir, "r/t/k/k") == MAX_TAGGED);
+   (void) Node_free(oNDir);
+}
+
+/*
+  Checks Node_sortChildren on ulCount appended children: two sorted
+  runs, which it merges, if bTwoRuns, or else an arbitrary order; then
+  that lookups find each child at its new index. Finally appends a
+  duplicate, which Node_sortChildren must report.
+*/
+static void Client_checkSort(Node_T oNRoot, size_t ulCount,
+                             boolean bTwoRuns) {
+   char acPath[MAX_PATH];
+   char acMissing[MAX_NAME];
+   Node_T oNDir = Client_add(oNRoot, "r/s", DIRECTORY);
+   Node_T oNDuplicate;
+   size_t ulHalf = (ulCount + 1) / 2;
+   size_t i;
+
+   Client_collide("e0", acMissing);
+   for(i = 0; i < ulCount; i++) {
+      /* runs: the even names, then the odd; otherwise scattered */
+      size_t ulName = bTwoRuns ?
+         (i < ulHalf ? 2 * i : 2 * (i - ulHalf) + 1) :
+         (i * 7 + 3) % ulCount;
+      sprintf(acPath, "r/s/e%02lu", (unsigned long) ulName);
+      (void) Client_append(oNDir, acPath);
+   }
+   /* any tags were of the appended order, and must be dropped */
+   assert(Node_sortChildren(oNDir));
+   Client_checkOrder(oNDir);
+   Client_checkLookups(oNDir, acMissing);
+
+   /* sorting sorted children changes nothing */
+   assert(Node_sortChildren(oNDir));
+   Client_checkLookups(oNDir, acMissing);
+
+   oNDuplicate = Client_append(oNDir, "r/s/e00");
+   assert(!Node_sortChildren(oNDir));
+   (void) oNDuplicate;
+   (void) Node_free(oNDir);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Runs every check. Returns 0; a failed check aborts. */
+int main(void) {
+   Node_T oNRoot;
+   Path_T oPRoot = Client_path("r");
+
+   assert(Node_new(oPRoot, NULL, &oNRoot, DIRECTORY, NULL, 0) ==
+          SUCCESS);
+   Path_free(oPRoot);
+
+   Client_checkCollisions(oNRoot);
+   Client_checkGrowth(oNRoot);
+   Client_checkSort(oNRoot, 10, TRUE);
+   Client_checkSort(oNRoot, 10, FALSE);
+   Client_checkSort(oNRoot, WIDE, TRUE);
+   Client_checkSort(oNRoot, WIDE, FALSE);
+
+   assert(Node_getNumChildren(oNRoot) == 0);
+   assert(Node_free(oNRoot) == 1);
+   assert(Node_getResidentCount() == 0);
+   fprintf(stderr, "ftnode_client: all checks passed\n");
+   return 0;
+}
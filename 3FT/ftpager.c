@@ -0,0 +1,337 @@
+/*--------------------------------------------------------------------*/
+/* ftpager.c                                                          */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ftpager.h"
+
+/* The index that ends a list of frames, or marks an empty frame */
+#define PAGER_NONE ((size_t) -1)
+
+/* One page-sized slot of the pool */
+struct frame {
+   /* the number of the page held, or PAGER_NONE if empty */
+   size_t ulPage;
+   /* whether the page was modified since it was read */
+   boolean bDirty;
+   /* the neighbouring frames in recency order (more, less recent) */
+   size_t ulPrev;
+   size_t ulNext;
+   /* the next frame in the same hash bucket */
+   size_t ulHashNext;
+   /* the page's bytes */
+   unsigned char *pucData;
+};
+
+/* A pool of frames over one file */
+struct pager {
+   /* the file being paged */
+   int iFd;
+   /* the number of bytes of the file in use */
+   size_t ulSize;
+   /* the frames, and the memory holding all of their pages */
+   struct frame *psFrames;
+   size_t ulFrames;
+   unsigned char *pucPool;
+   /* the first frame of each hash bucket, by page number */
+   size_t *pulBuckets;
+   size_t ulBuckets;
+   /* the most and least recently used frames */
+   size_t ulHead;
+   size_t ulTail;
+   /* lookup counts */
+   size_t ulHits;
+   size_t ulMisses;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Unlinks frame ulFrame from the recency list of oPager. */
+static void Pager_unlink(Pager_T oPager, size_t ulFrame) {
+   struct frame *psFrame = &oPager->psFrames[ulFrame];
+
+   if(psFrame->ulPrev != PAGER_NONE)
+      oPager->psFrames[psFrame->ulPrev].ulNext = psFrame->ulNext;
+   else
+      oPager->ulHead = psFrame->ulNext;
+   if(psFrame->ulNext != PAGER_NONE)
+      oPager->psFrames[psFrame->ulNext].ulPrev = psFrame->ulPrev;
+   else
+      oPager->ulTail = psFrame->ulPrev;
+}
+
+/* Links frame ulFrame in as the most recently used frame of oPager. */
+static void Pager_pushFront(Pager_T oPager, size_t ulFrame) {
+   struct frame *psFrame = &oPager->psFrames[ulFrame];
+
+   psFrame->ulPrev = PAGER_NONE;
+   psFrame->ulNext = oPager->ulHead;
+   if(oPager->ulHead != PAGER_NONE)
+      oPager->psFrames[oPager->ulHead].ulPrev = ulFrame;
+   else
+      oPager->ulTail = ulFrame;
+   oPager->ulHead = ulFrame;
+}
+
+/* Removes frame ulFrame from its hash bucket in oPager. */
+static void Pager_unhash(Pager_T oPager, size_t ulFrame) {
+   size_t *pulLink;
+
+   pulLink = &oPager->pulBuckets[oPager->psFrames[ulFrame].ulPage &
+                                 (oPager->ulBuckets - 1)];
+   while(*pulLink != ulFrame)
+      pulLink = &oPager->psFrames[*pulLink].ulHashNext;
+   *pulLink = oPager->psFrames[ulFrame].ulHashNext;
+}
+
+/*
+  Writes the page in frame psFrame of oPager back to the file.
+  Returns SUCCESS or IO_ERROR.
+*/
+static int Pager_writeBack(Pager_T oPager, struct frame *psFrame) {
+   size_t ulDone = 0;
+   ssize_t lWritten;
+
+   while(ulDone < PAGER_PAGE_SIZE) {
+      lWritten = pwrite(oPager->iFd, psFrame->pucData + ulDone,
+                        PAGER_PAGE_SIZE - ulDone,
+                        (off_t) (psFrame->ulPage * PAGER_PAGE_SIZE +
+                                 ulDone));
+      if(lWritten < 0) {
+         if(errno == EINTR)
+            continue;
+         return IO_ERROR;
+      }
+      ulDone += (size_t) lWritten;
+   }
+   psFrame->bDirty = FALSE;
+   return SUCCESS;
+}
+
+/*
+  Reads page ulPage of oPager's file into psFrame, zero-filling
+  whatever lies past the end of the file. Returns SUCCESS or IO_ERROR.
+*/
+static int Pager_readIn(Pager_T oPager, struct frame *psFrame,
+                        size_t ulPage) {
+   size_t ulDone = 0;
+   ssize_t lRead;
+
+   while(ulDone < PAGER_PAGE_SIZE) {
+      lRead = pread(oPager->iFd, psFrame->pucData + ulDone,
+                    PAGER_PAGE_SIZE - ulDone,
+                    (off_t) (ulPage * PAGER_PAGE_SIZE + ulDone));
+      if(lRead < 0) {
+         if(errno == EINTR)
+            continue;
+         return IO_ERROR;
+      }
+      if(lRead == 0)
+         break;
+      ulDone += (size_t) lRead;
+   }
+   memset(psFrame->pucData + ulDone, 0, PAGER_PAGE_SIZE - ulDone);
+   return SUCCESS;
+}
+
+/*
+  Finds page ulPage in oPager's pool, reading it into the least
+  recently used frame (after writing that frame back, if dirty) if it
+  is not there, and marks it most recently used. Sets *ppsFrame to the
+  frame holding it. Returns SUCCESS or IO_ERROR.
+*/
+static int Pager_getFrame(Pager_T oPager, size_t ulPage,
+                          struct frame **ppsFrame) {
+   size_t ulBucket = ulPage & (oPager->ulBuckets - 1);
+   size_t ulFrame;
+   struct frame *psFrame;
+   int iStatus;
+
+   assert(oPager != NULL);
+   assert(ppsFrame != NULL);
+
+   for(ulFrame = oPager->pulBuckets[ulBucket]; ulFrame != PAGER_NONE;
+       ulFrame = oPager->psFrames[ulFrame].ulHashNext)
+      if(oPager->psFrames[ulFrame].ulPage == ulPage)
+         break;
+
+   if(ulFrame != PAGER_NONE)
+      oPager->ulHits++;
+   else {
+      oPager->ulMisses++;
+      ulFrame = oPager->ulTail;
+      psFrame = &oPager->psFrames[ulFrame];
+      if(psFrame->ulPage != PAGER_NONE) {
+         if(psFrame->bDirty) {
+            iStatus = Pager_writeBack(oPager, psFrame);
+            if(iStatus != SUCCESS)
+               return iStatus;
+         }
+         Pager_unhash(oPager, ulFrame);
+         psFrame->ulPage = PAGER_NONE;
+      }
+
+      iStatus = Pager_readIn(oPager, psFrame, ulPage);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      psFrame->ulPage = ulPage;
+      psFrame->ulHashNext = oPager->pulBuckets[ulBucket];
+      oPager->pulBuckets[ulBucket] = ulFrame;
+   }
+
+   if(oPager->ulHead != ulFrame) {
+      Pager_unlink(oPager, ulFrame);
+      Pager_pushFront(oPager, ulFrame);
+   }
+   *ppsFrame = &oPager->psFrames[ulFrame];
+   return SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+int Pager_new(int iFd, size_t ulSize, size_t ulFrames,
+              Pager_T *poPager) {
+   struct pager *psPager;
+   size_t i;
+
+   assert(ulFrames > 0);
+   assert(poPager != NULL);
+
+   *poPager = NULL;
+
+   psPager = calloc(1, sizeof(struct pager));
+   if(psPager == NULL) {
+      (void) close(iFd);
+      return MEMORY_ERROR;
+   }
+   psPager->iFd = iFd;
+   psPager->ulSize = ulSize;
+   psPager->ulFrames = ulFrames;
+
+   /* a power of two buckets, about two per frame */
+   psPager->ulBuckets = 1;
+   while(psPager->ulBuckets < 2 * ulFrames)
+      psPager->ulBuckets <<= 1;
+
+   psPager->psFrames = malloc(ulFrames * sizeof(struct frame));
+   psPager->pucPool = malloc(ulFrames * PAGER_PAGE_SIZE);
+   psPager->pulBuckets = malloc(psPager->ulBuckets * sizeof(size_t));
+   if(psPager->psFrames == NULL || psPager->pucPool == NULL ||
+      psPager->pulBuckets == NULL) {
+      Pager_free(psPager);
+      return MEMORY_ERROR;
+   }
+
+   for(i = 0; i < psPager->ulBuckets; i++)
+      psPager->pulBuckets[i] = PAGER_NONE;
+
+   /* every frame starts empty, in one recency list */
+   psPager->ulHead = PAGER_NONE;
+   psPager->ulTail = PAGER_NONE;
+   for(i = 0; i < ulFrames; i++) {
+      psPager->psFrames[i].ulPage = PAGER_NONE;
+      psPager->psFrames[i].bDirty = FALSE;
+      psPager->psFrames[i].ulHashNext = PAGER_NONE;
+      psPager->psFrames[i].pucData =
+         psPager->pucPool + i * PAGER_PAGE_SIZE;
+      Pager_pushFront(psPager, i);
+   }
+
+   *poPager = psPager;
+   return SUCCESS;
+}
+
+int Pager_read(Pager_T oPager, size_t ulOffset, void *pvBuf,
+               size_t ulLength) {
+   unsigned char *pucBuf = pvBuf;
+   struct frame *psFrame = NULL;
+   size_t ulInPage;
+   size_t ulChunk;
+   int iStatus;
+
+   assert(oPager != NULL);
+   assert(pvBuf != NULL || ulLength == 0);
+
+   if(ulOffset > oPager->ulSize || ulLength > oPager->ulSize - ulOffset)
+      return IO_ERROR;
+
+   while(ulLength > 0) {
+      iStatus = Pager_getFrame(oPager, ulOffset / PAGER_PAGE_SIZE,
+                               &psFrame);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      ulInPage = ulOffset % PAGER_PAGE_SIZE;
+      ulChunk = PAGER_PAGE_SIZE - ulInPage;
+      if(ulChunk > ulLength)
+         ulChunk = ulLength;
+      memcpy(pucBuf, psFrame->pucData + ulInPage, ulChunk);
+      pucBuf += ulChunk;
+      ulOffset += ulChunk;
+      ulLength -= ulChunk;
+   }
+   return SUCCESS;
+}
+
+int Pager_append(Pager_T oPager, const void *pvData, size_t ulLength,
+                 size_t *pulOffset) {
+   const unsigned char *pucData = pvData;
+   struct frame *psFrame = NULL;
+   size_t ulInPage;
+   size_t ulChunk;
+   int iStatus;
+
+   assert(oPager != NULL);
+   assert(pvData != NULL || ulLength == 0);
+   assert(pulOffset != NULL);
+
+   *pulOffset = oPager->ulSize;
+   while(ulLength > 0) {
+      iStatus = Pager_getFrame(oPager, oPager->ulSize / PAGER_PAGE_SIZE,
+                               &psFrame);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      ulInPage = oPager->ulSize % PAGER_PAGE_SIZE;
+      ulChunk = PAGER_PAGE_SIZE - ulInPage;
+      if(ulChunk > ulLength)
+         ulChunk = ulLength;
+      memcpy(psFrame->pucData + ulInPage, pucData, ulChunk);
+      psFrame->bDirty = TRUE;
+      pucData += ulChunk;
+      oPager->ulSize += ulChunk;
+      ulLength -= ulChunk;
+   }
+   return SUCCESS;
+}
+
+size_t Pager_getSize(Pager_T oPager) {
+   assert(oPager != NULL);
+
+   return oPager->ulSize;
+}
+
+void Pager_getStats(Pager_T oPager, size_t *pulHits,
+                    size_t *pulMisses) {
+   assert(oPager != NULL);
+   assert(pulHits != NULL);
+   assert(pulMisses != NULL);
+
+   *pulHits = oPager->ulHits;
+   *pulMisses = oPager->ulMisses;
+}
+
+void Pager_free(Pager_T oPager) {
+   if(oPager != NULL) {
+      (void) close(oPager->iFd);
+      free(oPager->psFrames);
+      free(oPager->pucPool);
+      free(oPager->pulBuckets);
+      free(oPager);
+   }
+}
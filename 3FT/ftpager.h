@@ -0,0 +1,66 @@
+/*--------------------------------------------------------------------*/
+/* ftpager.h                                                          */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef FTPAGER_INCLUDED
+#define FTPAGER_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  A Pager_T caches the fixed-size pages of one file in a pool of page
+  frames, evicting the least recently used page when a frame is
+  needed and writing it back first if it was modified.
+*/
+typedef struct pager *Pager_T;
+
+/* The size of a page, and of each frame in the pool */
+enum { PAGER_PAGE_SIZE = 4096 };
+
+/*
+  Creates a pager for the file open for reading and writing on iFd,
+  whose first ulSize bytes are in use, with a pool of ulFrames frames
+  (at least 1), and sets *poPager to it. The pager owns iFd from then
+  on, even if creation fails.
+  Returns SUCCESS, or sets *poPager to NULL and returns MEMORY_ERROR.
+*/
+int Pager_new(int iFd, size_t ulSize, size_t ulFrames,
+              Pager_T *poPager);
+
+/*
+  Copies the ulLength bytes at offset ulOffset of oPager's file into
+  pvBuf. Returns SUCCESS, or IO_ERROR if the bytes are not all in use
+  or a page could not be read or written back.
+*/
+int Pager_read(Pager_T oPager, size_t ulOffset, void *pvBuf,
+               size_t ulLength);
+
+/*
+  Appends the ulLength bytes of pvData to the end of oPager's file and
+  sets *pulOffset to where they start. The new bytes may stay only in
+  the pool until their page is evicted.
+  Returns SUCCESS, or IO_ERROR if a page could not be read or written
+  back.
+*/
+int Pager_append(Pager_T oPager, const void *pvData, size_t ulLength,
+                 size_t *pulOffset);
+
+/* Returns the number of bytes of oPager's file in use. */
+size_t Pager_getSize(Pager_T oPager);
+
+/*
+  Sets *pulHits and *pulMisses to the number of page lookups oPager
+  has served from the pool and from the file, respectively.
+*/
+void Pager_getStats(Pager_T oPager, size_t *pulHits,
+                    size_t *pulMisses);
+
+/*
+  Closes oPager's file and frees all memory allocated for oPager,
+  discarding any pages that were never written back.
+*/
+void Pager_free(Pager_T oPager);
+
+#endif
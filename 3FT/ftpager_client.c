@@ -0,0 +1,169 @@
+/*--------------------------------------------------------------------*/
+/* ftpager_client.c                                                   */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ft.h"
+
+/*
+  ftpager_client checks FT_setResidentLimit: the same operations, run
+  once without a limit and once with a limit far smaller than the
+  hierarchy and a pool of few pages, must give the same results and
+  the same FT_toString output, and the limited run must actually
+  spill directories and read them back. Like ft_client, it checks
+  with assert, so it must be built without NDEBUG.
+*/
+
+/* The shape of the hierarchy: r/dK/eJ/fI, and r/dK/gJ files */
+enum { DIRS = 12, SUBDIRS = 4, FILES = 3, MAX_PATH = 64 };
+
+/* The resident limit and page pool of the limited run */
+enum { LIMIT = 24, FRAMES = 2 };
+
+/* The contents every file starts with, and the one some get instead */
+static char acOld[] = "old";
+static char acNew[] = "new";
+
+/*--------------------------------------------------------------------*/
+
+/* Returns the number of nodes now out of memory. */
+static size_t Client_countSpilled(void) {
+   struct ftStats sStats;
+
+   assert(FT_getStats(&sStats) == SUCCESS);
+   return sStats.ulNonResident;
+}
+
+/*
+  Asserts that file pcPath is in the FT, with contents pvContents of
+  ulSize bytes: the client's own, since the FT never copies them.
+*/
+static void Client_checkFile(const char *pcPath, void *pvContents,
+                             size_t ulSize) {
+   boolean bIsFile = FALSE;
+   size_t ulFound = 0;
+
+   assert(FT_containsFile(pcPath));
+   assert(!FT_containsDir(pcPath));
+   assert(FT_stat(pcPath, &bIsFile, &ulFound) == SUCCESS);
+   assert(bIsFile && ulFound == ulSize);
+   assert(FT_getFileContents(pcPath) == pvContents);
+}
+
+/*
+  Runs the operations, with resident limit ulLimit if it is not 0,
+  and returns the final FT_toString output, which the caller owns.
+  *pulSpilled is set to the most nodes that were out of memory at
+  once.
+*/
+static char *Client_run(size_t ulLimit, size_t *pulSpilled) {
+   char acPath[MAX_PATH];
+   size_t ulSpilled = 0;
+   size_t k, j, i;
+   char *pcTree;
+
+   assert(FT_init() == SUCCESS);
+   if(ulLimit != 0)
+      assert(FT_setResidentLimit(ulLimit, FRAMES) == SUCCESS);
+
+   /* build, depth first, so early directories go cold */
+   for(k = 0; k < DIRS; k++)
+      for(j = 0; j < SUBDIRS; j++) {
+         for(i = 0; i < FILES; i++) {
+            sprintf(acPath, "r/d%lu/e%lu/f%lu", (unsigned long) k,
+                    (unsigned long) j, (unsigned long) i);
+            assert(FT_insertFile(acPath, acOld, sizeof(acOld)) ==
+                   SUCCESS);
+         }
+         sprintf(acPath, "r/d%lu/g%lu", (unsigned long) k,
+                 (unsigned long) j);
+         assert(FT_insertFile(acPath, acOld, sizeof(acOld)) ==
+                SUCCESS);
+      }
+   if(Client_countSpilled() > ulSpilled)
+      ulSpilled = Client_countSpilled();
+
+   /* touch every node, in an order unlike the build's */
+   for(j = 0; j < SUBDIRS; j++)
+      for(k = DIRS; k-- > 0; ) {
+         sprintf(acPath, "r/d%lu/e%lu", (unsigned long) k,
+                 (unsigned long) j);
+         assert(FT_containsDir(acPath) && !FT_containsFile(acPath));
+         for(i = 0; i < FILES; i++) {
+            sprintf(acPath, "r/d%lu/e%lu/f%lu", (unsigned long) k,
+                    (unsigned long) j, (unsigned long) i);
+            Client_checkFile(acPath, acOld, sizeof(acOld));
+         }
+         sprintf(acPath, "r/d%lu/g%lu", (unsigned long) k,
+                 (unsigned long) j);
+         Client_checkFile(acPath, acOld, sizeof(acOld));
+         if(Client_countSpilled() > ulSpilled)
+            ulSpilled = Client_countSpilled();
+      }
+
+   /* mutate: replace, remove and insert throughout */
+   for(k = 0; k < DIRS; k++) {
+      sprintf(acPath, "r/d%lu/e%lu/f%lu", (unsigned long) k,
+              (unsigned long) (k % SUBDIRS),
+              (unsigned long) (k % FILES));
+      assert(FT_replaceFileContents(acPath, acNew, 2) == acOld);
+      sprintf(acPath, "r/d%lu/g%lu", (unsigned long) k,
+              (unsigned long) ((k + 1) % SUBDIRS));
+      assert(FT_rmFile(acPath) == SUCCESS);
+      assert(FT_rmFile(acPath) == NO_SUCH_PATH);
+      sprintf(acPath, "r/d%lu/e%lu/new", (unsigned long) k,
+              (unsigned long) ((k + 2) % SUBDIRS));
+      assert(FT_insertDir(acPath) == SUCCESS);
+      assert(FT_insertDir(acPath) == ALREADY_IN_TREE);
+      if(k % 3 == 0) {
+         sprintf(acPath, "r/d%lu/e%lu", (unsigned long) k,
+                 (unsigned long) ((k + 3) % SUBDIRS));
+         assert(FT_rmDir(acPath) == SUCCESS);
+         assert(FT_containsDir(acPath) == FALSE);
+      }
+   }
+   if(ulLimit != 0)
+      assert(FT_setResidentLimit(ulLimit / 2, FRAMES) == SUCCESS);
+   for(k = 0; k < DIRS; k++) {
+      sprintf(acPath, "r/d%lu/e%lu/f%lu", (unsigned long) k,
+              (unsigned long) (k % SUBDIRS),
+              (unsigned long) (k % FILES));
+      Client_checkFile(acPath, acNew, 2);
+      if(Client_countSpilled() > ulSpilled)
+         ulSpilled = Client_countSpilled();
+   }
+
+   assert((pcTree = FT_toString()) != NULL);
+   assert(FT_destroy() == SUCCESS);
+   *pulSpilled = ulSpilled;
+   return pcTree;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Runs every check. Returns 0; a failed check aborts. */
+int main(void) {
+   char *pcUnbounded;
+   char *pcBounded;
+   size_t ulSpilled = 0;
+
+   assert(FT_setResidentLimit(LIMIT, FRAMES) == INITIALIZATION_ERROR);
+
+   pcUnbounded = Client_run(0, &ulSpilled);
+   assert(ulSpilled == 0);
+   pcBounded = Client_run(LIMIT, &ulSpilled);
+   assert(ulSpilled > LIMIT);
+   assert(strcmp(pcUnbounded, pcBounded) == 0);
+
+   free(pcUnbounded);
+   free(pcBounded);
+   fprintf(stderr, "ftpager_client: up to %lu nodes spilled, "
+           "all checks passed\n", (unsigned long) ulSpilled);
+   return 0;
+}
@@ -0,0 +1,325 @@
+/*--------------------------------------------------------------------*/
+/* ftrecord.c                                                         */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ft.h"
+#include "fttrace.h"
+
+/*
+  ftrecord records the FT interface calls of a program linked with
+    -Wl,--wrap=FT_init,--wrap=FT_destroy,--wrap=FT_insertDir,...
+  (one --wrap for each op of enum traceOp), which routes every such
+  call in the program's own objects through it, whatever FT
+  implementation the program is linked with. Recording is opt in: a
+  trace is written to the file named by environment variable FT_TRACE
+  when the program first calls the FT, and calls are only forwarded
+  when FT_TRACE is not set. Calls the implementation makes to itself
+  are not seen, nor are calls outside the traced interface, so a
+  program that also loads images or bulk-loads strings produces a
+  trace that does not replay faithfully. Recording is not
+  synchronized, so it is only exact for single-threaded programs.
+*/
+
+/* The real FT, as renamed by the linker's --wrap option */
+int __real_FT_init(void);
+int __real_FT_destroy(void);
+int __real_FT_insertDir(const char *pcPath);
+boolean __real_FT_containsDir(const char *pcPath);
+int __real_FT_rmDir(const char *pcPath);
+int __real_FT_insertFile(const char *pcPath, void *pvContents,
+                         size_t ulLength);
+boolean __real_FT_containsFile(const char *pcPath);
+int __real_FT_rmFile(const char *pcPath);
+void *__real_FT_getFileContents(const char *pcPath);
+void *__real_FT_replaceFileContents(const char *pcPath,
+                                    void *pvNewContents,
+                                    size_t ulNewLength);
+int __real_FT_stat(const char *pcPath, boolean *pbIsFile,
+                   size_t *pulSize);
+char *__real_FT_toString(void);
+
+/* The wrappers the linker substitutes for the FT */
+int __wrap_FT_init(void);
+int __wrap_FT_destroy(void);
+int __wrap_FT_insertDir(const char *pcPath);
+boolean __wrap_FT_containsDir(const char *pcPath);
+int __wrap_FT_rmDir(const char *pcPath);
+int __wrap_FT_insertFile(const char *pcPath, void *pvContents,
+                         size_t ulLength);
+boolean __wrap_FT_containsFile(const char *pcPath);
+int __wrap_FT_rmFile(const char *pcPath);
+void *__wrap_FT_getFileContents(const char *pcPath);
+void *__wrap_FT_replaceFileContents(const char *pcPath,
+                                    void *pvNewContents,
+                                    size_t ulNewLength);
+int __wrap_FT_stat(const char *pcPath, boolean *pbIsFile,
+                   size_t *pulSize);
+char *__wrap_FT_toString(void);
+
+/* The trace being written, or NULL if not recording */
+static Trace_T oTTrace;
+/* The trace file's descriptor */
+static int iTraceFd = -1;
+/* Whether FT_TRACE has been looked at yet */
+static boolean bStarted;
+/* Whether the call being recorded was given NULL contents */
+static boolean bNullContents;
+
+/*--------------------------------------------------------------------*/
+
+/* Writes out and closes the trace, if any, and stops recording. */
+static void Record_stop(void) {
+   if(oTTrace == NULL)
+      return;
+   if(Trace_free(oTTrace) != SUCCESS)
+      fprintf(stderr, "ftrecord: cannot write the trace\n");
+   (void) close(iTraceFd);
+   oTTrace = NULL;
+   iTraceFd = -1;
+}
+
+/*
+  Returns whether calls are being recorded, starting to record to the
+  file named by FT_TRACE on the first call.
+*/
+static boolean Record_isOn(void) {
+   const char *pcFile;
+
+   if(bStarted)
+      return oTTrace != NULL;
+   bStarted = TRUE;
+
+   pcFile = getenv("FT_TRACE");
+   if(pcFile == NULL || *pcFile == '\0')
+      return FALSE;
+   iTraceFd = open(pcFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if(iTraceFd < 0 || Trace_newWriter(iTraceFd, &oTTrace) != SUCCESS) {
+      fprintf(stderr, "ftrecord: cannot write a trace to %s\n",
+              pcFile);
+      if(iTraceFd >= 0)
+         (void) close(iTraceFd);
+      iTraceFd = -1;
+      return FALSE;
+   }
+   (void) atexit(Record_stop);
+   return TRUE;
+}
+
+/*
+  Records a call to eOp with path pcPath (NULL for none) that ran from
+  ulStart to ulEnd and produced ulLength and ulResult (as struct
+  traceRecord defines them). Stops recording if the trace cannot be
+  written.
+*/
+static void Record_addSpan(enum traceOp eOp, const char *pcPath,
+                           size_t ulLength, unsigned long ulResult,
+                           unsigned long ulStart, unsigned long ulEnd) {
+   struct traceRecord sRecord;
+
+   sRecord.eOp = eOp;
+   sRecord.pcPath = pcPath == NULL ? "" : pcPath;
+   sRecord.bNullContents = bNullContents;
+   bNullContents = FALSE;
+   sRecord.ulLength = ulLength;
+   sRecord.ulResult = ulResult;
+   sRecord.ulStart = ulStart;
+   sRecord.ulDuration = ulEnd - ulStart;
+   if(Trace_write(oTTrace, &sRecord) != SUCCESS)
+      Record_stop();
+}
+
+/* Records, like Record_addSpan, a call that ran from ulStart to now. */
+static void Record_add(enum traceOp eOp, const char *pcPath,
+                       size_t ulLength, unsigned long ulResult,
+                       unsigned long ulStart) {
+   Record_addSpan(eOp, pcPath, ulLength, ulResult, ulStart,
+                  Trace_now());
+}
+
+/*--------------------------------------------------------------------*/
+
+int __wrap_FT_init(void) {
+   unsigned long ulStart;
+   int iStatus;
+
+   if(!Record_isOn())
+      return __real_FT_init();
+   ulStart = Trace_now();
+   iStatus = __real_FT_init();
+   Record_add(TRACE_INIT, NULL, 0, (unsigned long) iStatus, ulStart);
+   return iStatus;
+}
+
+int __wrap_FT_destroy(void) {
+   unsigned long ulStart;
+   int iStatus;
+
+   if(!Record_isOn())
+      return __real_FT_destroy();
+   ulStart = Trace_now();
+   iStatus = __real_FT_destroy();
+   Record_add(TRACE_DESTROY, NULL, 0, (unsigned long) iStatus,
+              ulStart);
+   /* a session is over, so keep what has been recorded safe */
+   if(oTTrace != NULL && Trace_flush(oTTrace) != SUCCESS)
+      Record_stop();
+   return iStatus;
+}
+
+int __wrap_FT_insertDir(const char *pcPath) {
+   unsigned long ulStart;
+   int iStatus;
+
+   if(!Record_isOn())
+      return __real_FT_insertDir(pcPath);
+   ulStart = Trace_now();
+   iStatus = __real_FT_insertDir(pcPath);
+   Record_add(TRACE_INSERT_DIR, pcPath, 0, (unsigned long) iStatus,
+              ulStart);
+   return iStatus;
+}
+
+boolean __wrap_FT_containsDir(const char *pcPath) {
+   unsigned long ulStart;
+   boolean bFound;
+
+   if(!Record_isOn())
+      return __real_FT_containsDir(pcPath);
+   ulStart = Trace_now();
+   bFound = __real_FT_containsDir(pcPath);
+   Record_add(TRACE_CONTAINS_DIR, pcPath, 0, (unsigned long) bFound,
+              ulStart);
+   return bFound;
+}
+
+int __wrap_FT_rmDir(const char *pcPath) {
+   unsigned long ulStart;
+   int iStatus;
+
+   if(!Record_isOn())
+      return __real_FT_rmDir(pcPath);
+   ulStart = Trace_now();
+   iStatus = __real_FT_rmDir(pcPath);
+   Record_add(TRACE_RM_DIR, pcPath, 0, (unsigned long) iStatus,
+              ulStart);
+   return iStatus;
+}
+
+int __wrap_FT_insertFile(const char *pcPath, void *pvContents,
+                         size_t ulLength) {
+   unsigned long ulStart;
+   int iStatus;
+
+   if(!Record_isOn())
+      return __real_FT_insertFile(pcPath, pvContents, ulLength);
+   ulStart = Trace_now();
+   iStatus = __real_FT_insertFile(pcPath, pvContents, ulLength);
+   bNullContents = pvContents == NULL;
+   Record_add(TRACE_INSERT_FILE, pcPath, ulLength,
+              (unsigned long) iStatus, ulStart);
+   return iStatus;
+}
+
+boolean __wrap_FT_containsFile(const char *pcPath) {
+   unsigned long ulStart;
+   boolean bFound;
+
+   if(!Record_isOn())
+      return __real_FT_containsFile(pcPath);
+   ulStart = Trace_now();
+   bFound = __real_FT_containsFile(pcPath);
+   Record_add(TRACE_CONTAINS_FILE, pcPath, 0, (unsigned long) bFound,
+              ulStart);
+   return bFound;
+}
+
+int __wrap_FT_rmFile(const char *pcPath) {
+   unsigned long ulStart;
+   int iStatus;
+
+   if(!Record_isOn())
+      return __real_FT_rmFile(pcPath);
+   ulStart = Trace_now();
+   iStatus = __real_FT_rmFile(pcPath);
+   Record_add(TRACE_RM_FILE, pcPath, 0, (unsigned long) iStatus,
+              ulStart);
+   return iStatus;
+}
+
+void *__wrap_FT_getFileContents(const char *pcPath) {
+   unsigned long ulStart;
+   void *pvContents;
+
+   if(!Record_isOn())
+      return __real_FT_getFileContents(pcPath);
+   ulStart = Trace_now();
+   pvContents = __real_FT_getFileContents(pcPath);
+   Record_add(TRACE_GET_CONTENTS, pcPath, 0,
+              (unsigned long) (pvContents != NULL), ulStart);
+   return pvContents;
+}
+
+void *__wrap_FT_replaceFileContents(const char *pcPath,
+                                    void *pvNewContents,
+                                    size_t ulNewLength) {
+   unsigned long ulStart;
+   void *pvOld;
+
+   if(!Record_isOn())
+      return __real_FT_replaceFileContents(pcPath, pvNewContents,
+                                           ulNewLength);
+   ulStart = Trace_now();
+   pvOld = __real_FT_replaceFileContents(pcPath, pvNewContents,
+                                         ulNewLength);
+   bNullContents = pvNewContents == NULL;
+   Record_add(TRACE_REPLACE_CONTENTS, pcPath, ulNewLength,
+              (unsigned long) (pvOld != NULL), ulStart);
+   return pvOld;
+}
+
+int __wrap_FT_stat(const char *pcPath, boolean *pbIsFile,
+                   size_t *pulSize) {
+   unsigned long ulStart;
+   boolean bIsFile;
+   size_t ulSize = 0;
+   int iStatus;
+
+   if(!Record_isOn())
+      return __real_FT_stat(pcPath, pbIsFile, pulSize);
+   ulStart = Trace_now();
+   iStatus = __real_FT_stat(pcPath, pbIsFile, pulSize);
+   bIsFile = iStatus == SUCCESS && *pbIsFile;
+   if(bIsFile)
+      ulSize = *pulSize;
+   Record_add(TRACE_STAT, pcPath, ulSize,
+              (unsigned long) iStatus * 2 + (unsigned long) bIsFile,
+              ulStart);
+   return iStatus;
+}
+
+char *__wrap_FT_toString(void) {
+   unsigned long ulStart;
+   unsigned long ulEnd;
+   char *pcResult;
+
+   if(!Record_isOn())
+      return __real_FT_toString();
+   ulStart = Trace_now();
+   pcResult = __real_FT_toString();
+   ulEnd = Trace_now();
+   /* the string is hashed outside of the time recorded */
+   if(pcResult == NULL)
+      Record_addSpan(TRACE_TO_STRING, NULL, 0, 0, ulStart, ulEnd);
+   else
+      Record_addSpan(TRACE_TO_STRING, NULL, strlen(pcResult),
+                     Trace_hash(pcResult), ulStart, ulEnd);
+   return pcResult;
+}
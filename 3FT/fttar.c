@@ -0,0 +1,669 @@
+/*--------------------------------------------------------------------*/
+/* fttar.c                                                            */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "fttar.h"
+
+/* Archives are a sequence of TAR_BLOCK-byte blocks */
+enum { TAR_BLOCK = 512 };
+
+/* Offsets and widths of the ustar header fields used here */
+enum { TAR_NAME = 0, TAR_NAME_LEN = 100,
+       TAR_MODE = 100, TAR_UID = 108, TAR_GID = 116, TAR_ID_LEN = 8,
+       TAR_SIZE = 124, TAR_SIZE_LEN = 12,
+       TAR_MTIME = 136,
+       TAR_CHKSUM = 148, TAR_CHKSUM_LEN = 8,
+       TAR_TYPE = 156,
+       TAR_MAGIC = 257,
+       TAR_PREFIX = 345, TAR_PREFIX_LEN = 155
+};
+
+/* Header type flags recognized by this module */
+enum { TAR_FILE = '0', TAR_OLDFILE = '\0', TAR_CONTIGUOUS = '7',
+       TAR_DIR = '5', TAR_PAX = 'x', TAR_GNULONGNAME = 'L'
+};
+
+/*
+  Reads up to ulSize bytes from iFd into pvBuf, retrying short reads
+  until ulSize bytes or end of file. Returns the number of bytes read,
+  or -1 on a read error.
+*/
+static long Tar_readFull(int iFd, void *pvBuf, size_t ulSize) {
+   char *pcBuf = pvBuf;
+   size_t ulDone = 0;
+   ssize_t lRead;
+
+   assert(pvBuf != NULL);
+
+   while(ulDone < ulSize) {
+      lRead = read(iFd, pcBuf + ulDone, ulSize - ulDone);
+      if(lRead < 0) {
+         if(errno == EINTR)
+            continue;
+         return -1;
+      }
+      if(lRead == 0)
+         break;
+      ulDone += (size_t) lRead;
+   }
+   return (long) ulDone;
+}
+
+/*
+  Writes all ulSize bytes of pvBuf to iFd.
+  Returns SUCCESS or IO_ERROR.
+*/
+static int Tar_writeFull(int iFd, const void *pvBuf, size_t ulSize) {
+   const char *pcBuf = pvBuf;
+   ssize_t lWritten;
+
+   assert(pvBuf != NULL || ulSize == 0);
+
+   while(ulSize > 0) {
+      lWritten = write(iFd, pcBuf, ulSize);
+      if(lWritten < 0) {
+         if(errno == EINTR)
+            continue;
+         return IO_ERROR;
+      }
+      pcBuf += lWritten;
+      ulSize -= (size_t) lWritten;
+   }
+   return SUCCESS;
+}
+
+/* Returns the number of zero bytes that pad ulSize to a block. */
+static size_t Tar_padding(size_t ulSize) {
+   return (TAR_BLOCK - ulSize % TAR_BLOCK) % TAR_BLOCK;
+}
+
+/*
+  Reads and discards ulSize bytes from iFd, which may be a pipe.
+  Returns SUCCESS or IO_ERROR.
+*/
+static int Tar_skip(int iFd, size_t ulSize) {
+   char acScratch[TAR_BLOCK];
+   size_t ulChunk;
+
+   while(ulSize > 0) {
+      ulChunk = ulSize < TAR_BLOCK ? ulSize : TAR_BLOCK;
+      if(Tar_readFull(iFd, acScratch, ulChunk) != (long) ulChunk)
+         return IO_ERROR;
+      ulSize -= ulChunk;
+   }
+   return SUCCESS;
+}
+
+/*
+  Reads an entry body of ulSize bytes plus its padding from iFd into a
+  newly allocated buffer with one extra trailing '\0', stored in
+  *ppcBody. Returns SUCCESS, IO_ERROR, or MEMORY_ERROR.
+*/
+static int Tar_readBody(int iFd, size_t ulSize, char **ppcBody) {
+   char *pcBody;
+   long lRead;
+
+   assert(ppcBody != NULL);
+   /* sizes are checked as they are parsed, so this cannot wrap */
+   assert(ulSize <= SSIZE_MAX);
+
+   pcBody = malloc(ulSize + 1);
+   if(pcBody == NULL) {
+      *ppcBody = NULL;
+      return MEMORY_ERROR;
+   }
+   lRead = Tar_readFull(iFd, pcBody, ulSize);
+   if(lRead < 0 || (size_t) lRead != ulSize ||
+      Tar_skip(iFd, Tar_padding(ulSize)) != SUCCESS) {
+      free(pcBody);
+      *ppcBody = NULL;
+      return IO_ERROR;
+   }
+   pcBody[ulSize] = '\0';
+   *ppcBody = pcBody;
+   return SUCCESS;
+}
+
+/*
+  Parses the numeric header field pcField of width ulWidth, which is
+  either octal text or (if its high bit is set) base-256, into
+  *pulValue.
+  Returns TRUE if the field is well-formed, FALSE otherwise,
+  including for a negative base-256 value or one above SSIZE_MAX, so
+  that a size can always be read and padded without overflow.
+*/
+static boolean Tar_parseNumber(const char *pcField, size_t ulWidth,
+                               size_t *pulValue) {
+   const unsigned char *pucField = (const unsigned char *) pcField;
+   size_t ulValue = 0;
+   size_t i = 0;
+
+   assert(pcField != NULL);
+   assert(pulValue != NULL);
+
+   if(pucField[0] & 0x80) {
+      /* 0x40 is the sign bit of a base-256 number */
+      if(pucField[0] & 0x40)
+         return FALSE;
+      ulValue = pucField[0] & 0x3f;
+      for(i = 1; i < ulWidth; i++) {
+         if(ulValue > (size_t) SSIZE_MAX >> 8)
+            return FALSE;
+         ulValue = (ulValue << 8) | pucField[i];
+      }
+      *pulValue = ulValue;
+      return TRUE;
+   }
+
+   while(i < ulWidth && pcField[i] == ' ')
+      i++;
+   for(; i < ulWidth && pcField[i] >= '0' && pcField[i] <= '7'; i++) {
+      size_t ulDigit = (size_t) (pcField[i] - '0');
+      if(ulValue > ((size_t) SSIZE_MAX - ulDigit) / 8)
+         return FALSE;
+      ulValue = ulValue * 8 + ulDigit;
+   }
+   if(i < ulWidth && pcField[i] != ' ' && pcField[i] != '\0')
+      return FALSE;
+
+   *pulValue = ulValue;
+   return TRUE;
+}
+
+/*
+  Returns the header checksum of pcBlock: the sum of its bytes with
+  the checksum field itself counted as spaces.
+*/
+static size_t Tar_checksum(const char *pcBlock) {
+   const unsigned char *pucBlock = (const unsigned char *) pcBlock;
+   size_t ulSum = 0;
+   size_t i;
+
+   assert(pcBlock != NULL);
+
+   for(i = 0; i < TAR_BLOCK; i++) {
+      if(i >= TAR_CHKSUM && i < TAR_CHKSUM + TAR_CHKSUM_LEN)
+         ulSum += ' ';
+      else
+         ulSum += pucBlock[i];
+   }
+   return ulSum;
+}
+
+/* Returns TRUE if every byte of pcBlock is zero. */
+static boolean Tar_isZeroBlock(const char *pcBlock) {
+   size_t i;
+
+   assert(pcBlock != NULL);
+
+   for(i = 0; i < TAR_BLOCK; i++)
+      if(pcBlock[i] != '\0')
+         return FALSE;
+   return TRUE;
+}
+
+/*
+  Applies the "path" and "size" records of the pax extended header
+  pcRecords (ulSize bytes) by replacing *ppcPath and setting
+  *pulSize and *pbHaveSize. Other records are ignored.
+  Returns SUCCESS, IO_ERROR if a record is malformed (including a
+  size that is empty or above SSIZE_MAX), or MEMORY_ERROR.
+*/
+static int Tar_applyPax(const char *pcRecords, size_t ulSize,
+                        char **ppcPath, size_t *pulSize,
+                        boolean *pbHaveSize) {
+   const char *pcRecord = pcRecords;
+   const char *pcEnd = pcRecords + ulSize;
+
+   assert(pcRecords != NULL);
+   assert(ppcPath != NULL);
+   assert(pulSize != NULL);
+   assert(pbHaveSize != NULL);
+
+   while(pcRecord < pcEnd) {
+      size_t ulLength = 0;
+      const char *pcKey = pcRecord;
+      const char *pcValue;
+      size_t ulValueLength;
+
+      /* each record is "<length> <key>=<value>\n" */
+      while(pcKey < pcEnd && *pcKey >= '0' && *pcKey <= '9')
+         ulLength = ulLength * 10 + (size_t) (*pcKey++ - '0');
+      if(pcKey == pcRecord || pcKey >= pcEnd || *pcKey != ' ' ||
+         ulLength == 0 || ulLength > (size_t) (pcEnd - pcRecord) ||
+         pcRecord[ulLength - 1] != '\n')
+         return IO_ERROR;
+      pcKey++;
+      pcValue = memchr(pcKey, '=',
+                       (size_t) (pcRecord + ulLength - pcKey));
+      if(pcValue == NULL)
+         return IO_ERROR;
+      pcValue++;
+      ulValueLength = (size_t) (pcRecord + ulLength - 1 - pcValue);
+
+      if(pcValue - pcKey == 5 && !strncmp(pcKey, "path", 4)) {
+         char *pcPath = malloc(ulValueLength + 1);
+         if(pcPath == NULL)
+            return MEMORY_ERROR;
+         memcpy(pcPath, pcValue, ulValueLength);
+         pcPath[ulValueLength] = '\0';
+         free(*ppcPath);
+         *ppcPath = pcPath;
+      }
+      else if(pcValue - pcKey == 5 && !strncmp(pcKey, "size", 4)) {
+         size_t i;
+         if(ulValueLength == 0)
+            return IO_ERROR;
+         *pulSize = 0;
+         for(i = 0; i < ulValueLength; i++) {
+            size_t ulDigit = (size_t) (pcValue[i] - '0');
+            if(pcValue[i] < '0' || pcValue[i] > '9' ||
+               *pulSize > ((size_t) SSIZE_MAX - ulDigit) / 10)
+               return IO_ERROR;
+            *pulSize = *pulSize * 10 + ulDigit;
+         }
+         *pbHaveSize = TRUE;
+      }
+      pcRecord += ulLength;
+   }
+   return SUCCESS;
+}
+
+/*
+  Returns a newly allocated copy of the name in header pcBlock,
+  joining the ustar prefix and name fields, or NULL if there is not
+  enough memory.
+*/
+static char *Tar_headerName(const char *pcBlock) {
+   size_t ulPrefix = 0;
+   size_t ulName = 0;
+   char *pcName;
+
+   assert(pcBlock != NULL);
+
+   if(!strncmp(pcBlock + TAR_MAGIC, "ustar", 5))
+      while(ulPrefix < TAR_PREFIX_LEN &&
+            pcBlock[TAR_PREFIX + ulPrefix] != '\0')
+         ulPrefix++;
+   while(ulName < TAR_NAME_LEN && pcBlock[TAR_NAME + ulName] != '\0')
+      ulName++;
+
+   pcName = malloc(ulPrefix + ulName + 2);
+   if(pcName == NULL)
+      return NULL;
+   memcpy(pcName, pcBlock + TAR_PREFIX, ulPrefix);
+   if(ulPrefix > 0)
+      pcName[ulPrefix++] = '/';
+   memcpy(pcName + ulPrefix, pcBlock + TAR_NAME, ulName);
+   pcName[ulPrefix + ulName] = '\0';
+   return pcName;
+}
+
+/*
+  Normalizes pcName in place by dropping leading "./" and '/'
+  components and trailing '/' characters. Returns pcName.
+*/
+static char *Tar_normalize(char *pcName) {
+   char *pcStart = pcName;
+   size_t ulLength;
+
+   assert(pcName != NULL);
+
+   for(;;) {
+      if(pcStart[0] == '/')
+         pcStart++;
+      else if(pcStart[0] == '.' && pcStart[1] == '/')
+         pcStart += 2;
+      else
+         break;
+   }
+   if(!strcmp(pcStart, "."))
+      pcStart++;
+
+   ulLength = strlen(pcStart);
+   while(ulLength > 0 && pcStart[ulLength - 1] == '/')
+      ulLength--;
+   memmove(pcName, pcStart, ulLength);
+   pcName[ulLength] = '\0';
+   return pcName;
+}
+
+int Tar_readEntry(int iFd, char **ppcPath, boolean *pbIsFile,
+                  void **ppvContents, size_t *pulLength) {
+   char acBlock[TAR_BLOCK];
+   char *pcLongName = NULL;
+   char *pcBody;
+   size_t ulPaxSize = 0;
+   boolean bHaveSize = FALSE;
+   int iStatus;
+
+   assert(ppcPath != NULL);
+   assert(pbIsFile != NULL);
+   assert(ppvContents != NULL);
+   assert(pulLength != NULL);
+
+   *ppcPath = NULL;
+   *ppvContents = NULL;
+
+   for(;;) {
+      long lRead;
+      size_t ulSize;
+      size_t ulSum;
+      char cType;
+      char *pcName;
+
+      lRead = Tar_readFull(iFd, acBlock, TAR_BLOCK);
+      /* a missing or zero block ends the archive, unless an extended
+         header was left without the entry it describes */
+      if(lRead == 0 ||
+         (lRead == TAR_BLOCK && Tar_isZeroBlock(acBlock))) {
+         iStatus = pcLongName != NULL || bHaveSize ? IO_ERROR : SUCCESS;
+         free(pcLongName);
+         return iStatus;
+      }
+      if(lRead != TAR_BLOCK ||
+         !Tar_parseNumber(acBlock + TAR_SIZE, TAR_SIZE_LEN, &ulSize) ||
+         !Tar_parseNumber(acBlock + TAR_CHKSUM, TAR_CHKSUM_LEN,
+                          &ulSum) ||
+         ulSum != Tar_checksum(acBlock)) {
+         free(pcLongName);
+         return IO_ERROR;
+      }
+      cType = acBlock[TAR_TYPE];
+
+      /* extended headers describe the entry that follows them */
+      if(cType == TAR_PAX || cType == TAR_GNULONGNAME) {
+         iStatus = Tar_readBody(iFd, ulSize, &pcBody);
+         if(iStatus == SUCCESS && cType == TAR_PAX)
+            iStatus = Tar_applyPax(pcBody, ulSize, &pcLongName,
+                                   &ulPaxSize, &bHaveSize);
+         if(iStatus == SUCCESS && cType == TAR_GNULONGNAME) {
+            free(pcLongName);
+            pcLongName = pcBody;
+            pcBody = NULL;
+         }
+         free(pcBody);
+         if(iStatus != SUCCESS) {
+            free(pcLongName);
+            return iStatus;
+         }
+         continue;
+      }
+
+      if(bHaveSize)
+         ulSize = ulPaxSize;
+
+      if(pcLongName != NULL) {
+         pcName = pcLongName;
+         pcLongName = NULL;
+      }
+      else {
+         pcName = Tar_headerName(acBlock);
+         if(pcName == NULL)
+            return MEMORY_ERROR;
+      }
+
+      if(cType == TAR_DIR || ((cType == TAR_FILE ||
+            cType == TAR_OLDFILE) && *pcName != '\0' &&
+            pcName[strlen(pcName) - 1] == '/'))
+         *pbIsFile = FALSE;
+      else if(cType == TAR_FILE || cType == TAR_OLDFILE ||
+              cType == TAR_CONTIGUOUS)
+         *pbIsFile = TRUE;
+      else {
+         /* links, devices, global headers, ...: not representable */
+         free(pcName);
+         bHaveSize = FALSE;
+         iStatus = Tar_skip(iFd, ulSize + Tar_padding(ulSize));
+         if(iStatus != SUCCESS)
+            return iStatus;
+         continue;
+      }
+
+      if(*Tar_normalize(pcName) == '\0') {
+         /* the archive's own "./" entry */
+         free(pcName);
+         bHaveSize = FALSE;
+         iStatus = Tar_skip(iFd, ulSize + Tar_padding(ulSize));
+         if(iStatus != SUCCESS)
+            return iStatus;
+         continue;
+      }
+
+      if(!*pbIsFile) {
+         iStatus = Tar_skip(iFd, ulSize + Tar_padding(ulSize));
+         ulSize = 0;
+      }
+      else if(ulSize == 0)
+         iStatus = SUCCESS;
+      else {
+         iStatus = Tar_readBody(iFd, ulSize, &pcBody);
+         *ppvContents = pcBody;
+      }
+      if(iStatus != SUCCESS) {
+         free(pcName);
+         return iStatus;
+      }
+
+      *ppcPath = pcName;
+      *pulLength = ulSize;
+      return SUCCESS;
+   }
+}
+
+/*
+  Writes ulValue into the ulWidth-byte numeric field pcField as
+  zero-padded octal text, or as base-256 if it does not fit.
+*/
+static void Tar_formatNumber(char *pcField, size_t ulWidth,
+                             size_t ulValue) {
+   size_t i;
+
+   assert(pcField != NULL);
+
+   /* ulWidth-1 octal digits plus a terminating '\0' */
+   if((ulValue >> (3 * (ulWidth - 1))) == 0) {
+      pcField[ulWidth - 1] = '\0';
+      for(i = ulWidth - 1; i > 0; i--) {
+         pcField[i - 1] = (char) ('0' + (ulValue & 7));
+         ulValue >>= 3;
+      }
+      return;
+   }
+
+   for(i = ulWidth; i > 1; i--) {
+      pcField[i - 1] = (char) (ulValue & 0xff);
+      ulValue >>= 8;
+   }
+   pcField[0] = (char) 0x80;
+}
+
+/*
+  Fills pcBlock with a complete ustar header for an entry with name
+  field pcName (at most TAR_NAME_LEN bytes are used), prefix field
+  pcPrefix of ulPrefix bytes, type cType, and body size ulSize.
+*/
+static void Tar_fillHeader(char *pcBlock, const char *pcName,
+                           const char *pcPrefix, size_t ulPrefix,
+                           char cType, size_t ulSize) {
+   size_t ulName;
+
+   assert(pcBlock != NULL);
+   assert(pcName != NULL);
+   assert(ulPrefix <= TAR_PREFIX_LEN);
+
+   memset(pcBlock, 0, TAR_BLOCK);
+   ulName = strlen(pcName);
+   memcpy(pcBlock + TAR_NAME, pcName,
+          ulName < TAR_NAME_LEN ? ulName : TAR_NAME_LEN);
+   memcpy(pcBlock + TAR_PREFIX, pcPrefix, ulPrefix);
+   Tar_formatNumber(pcBlock + TAR_MODE, TAR_ID_LEN,
+                    cType == TAR_DIR ? 0755 : 0644);
+   Tar_formatNumber(pcBlock + TAR_UID, TAR_ID_LEN, 0);
+   Tar_formatNumber(pcBlock + TAR_GID, TAR_ID_LEN, 0);
+   Tar_formatNumber(pcBlock + TAR_SIZE, TAR_SIZE_LEN, ulSize);
+   Tar_formatNumber(pcBlock + TAR_MTIME, TAR_SIZE_LEN, 0);
+   pcBlock[TAR_TYPE] = cType;
+   memcpy(pcBlock + TAR_MAGIC, "ustar\0" "00", 8);
+   (void) sprintf(pcBlock + TAR_CHKSUM, "%06lo",
+                  (unsigned long) Tar_checksum(pcBlock));
+   pcBlock[TAR_CHKSUM + 7] = ' ';
+}
+
+/*
+  Finds a '/' in pcName, of ulLength bytes, that splits it into a
+  ustar prefix and name that both fit. Returns the prefix length, 0 if
+  pcName fits in the name field alone, or ulLength if it cannot be
+  split at all.
+*/
+static size_t Tar_splitName(const char *pcName, size_t ulLength) {
+   size_t i;
+
+   assert(pcName != NULL);
+
+   if(ulLength <= TAR_NAME_LEN)
+      return 0;
+   for(i = ulLength - 1; i > 0; i--) {
+      if(ulLength - i - 1 > TAR_NAME_LEN)
+         break;
+      if(pcName[i] == '/' && i <= TAR_PREFIX_LEN && i + 1 < ulLength)
+         return i;
+   }
+   return ulLength;
+}
+
+/*
+  Writes a pax extended header carrying a "path" record for pcName
+  if bPath and a "size" record for ulSize if bSize.
+  Returns SUCCESS, IO_ERROR, or MEMORY_ERROR.
+*/
+static int Tar_writePax(int iFd, const char *pcName, boolean bPath,
+                        size_t ulSize, boolean bSize) {
+   char acBlock[TAR_BLOCK];
+   char acSize[32];
+   char *pcRecords;
+   size_t ulRecords = 0;
+   size_t ulPathRecord = 0;
+   size_t ulDigits;
+   int iStatus;
+
+   assert(pcName != NULL);
+
+   /* a record's length prefix counts its own digits */
+   if(bPath) {
+      ulPathRecord = strlen(" path=\n") + strlen(pcName);
+      for(ulDigits = 1; ; ulDigits++) {
+         size_t ulPower = 1;
+         size_t i;
+         for(i = 0; i < ulDigits; i++)
+            ulPower *= 10;
+         if(ulPathRecord + ulDigits < ulPower)
+            break;
+      }
+      ulPathRecord += ulDigits;
+   }
+   if(bSize)
+      (void) sprintf(acSize, "%lu", (unsigned long) ulSize);
+
+   pcRecords = malloc(ulPathRecord + 64);
+   if(pcRecords == NULL)
+      return MEMORY_ERROR;
+   if(bPath)
+      ulRecords += (size_t) sprintf(pcRecords, "%lu path=%s\n",
+                                    (unsigned long) ulPathRecord,
+                                    pcName);
+   if(bSize) {
+      /* " size=" and '\n' plus at most two length digits */
+      size_t ulSizeRecord = strlen(acSize) + 7;
+      ulSizeRecord += ulSizeRecord + 1 < 10 ? 1 : 2;
+      ulRecords += (size_t) sprintf(pcRecords + ulRecords,
+                                    "%lu size=%s\n",
+                                    (unsigned long) ulSizeRecord,
+                                    acSize);
+   }
+
+   Tar_fillHeader(acBlock, "././@PaxHeader", "", 0, TAR_PAX,
+                  ulRecords);
+   iStatus = Tar_writeFull(iFd, acBlock, TAR_BLOCK);
+   if(iStatus == SUCCESS)
+      iStatus = Tar_writeFull(iFd, pcRecords, ulRecords);
+   memset(acBlock, 0, TAR_BLOCK);
+   if(iStatus == SUCCESS)
+      iStatus = Tar_writeFull(iFd, acBlock, Tar_padding(ulRecords));
+   free(pcRecords);
+   return iStatus;
+}
+
+int Tar_writeEntry(int iFd, const char *pcPath, boolean bIsFile,
+                   const void *pvContents, size_t ulLength) {
+   char acBlock[TAR_BLOCK];
+   char *pcName;
+   size_t ulName;
+   size_t ulPrefix;
+   boolean bPaxPath;
+   boolean bPaxSize;
+   int iStatus = SUCCESS;
+
+   assert(pcPath != NULL);
+
+   if(!bIsFile || pvContents == NULL)
+      ulLength = 0;
+
+   /* directories are named with a trailing '/' */
+   ulName = strlen(pcPath) + (bIsFile ? 0 : 1);
+   pcName = malloc(ulName + 1);
+   if(pcName == NULL)
+      return MEMORY_ERROR;
+   strcpy(pcName, pcPath);
+   if(!bIsFile)
+      strcat(pcName, "/");
+
+   ulPrefix = Tar_splitName(pcName, ulName);
+   bPaxPath = (boolean) (ulPrefix == ulName);
+   bPaxSize = (boolean) ((ulLength >> 33) != 0);
+   if(bPaxPath || bPaxSize)
+      iStatus = Tar_writePax(iFd, pcName, bPaxPath, ulLength, bPaxSize);
+
+   if(iStatus == SUCCESS) {
+      /* with a pax path, the name field is only a truncated hint */
+      if(bPaxPath || ulPrefix == 0)
+         Tar_fillHeader(acBlock, pcName, "", 0,
+                        bIsFile ? TAR_FILE : TAR_DIR, ulLength);
+      else
+         Tar_fillHeader(acBlock, pcName + ulPrefix + 1, pcName,
+                        ulPrefix, bIsFile ? TAR_FILE : TAR_DIR,
+                        ulLength);
+      iStatus = Tar_writeFull(iFd, acBlock, TAR_BLOCK);
+   }
+   free(pcName);
+
+   /* stream the contents straight from the caller's buffer */
+   if(iStatus == SUCCESS && ulLength > 0) {
+      iStatus = Tar_writeFull(iFd, pvContents, ulLength);
+      memset(acBlock, 0, TAR_BLOCK);
+      if(iStatus == SUCCESS)
+         iStatus = Tar_writeFull(iFd, acBlock, Tar_padding(ulLength));
+   }
+   return iStatus;
+}
+
+int Tar_writeEnd(int iFd) {
+   char acBlock[TAR_BLOCK];
+   int iStatus;
+
+   memset(acBlock, 0, TAR_BLOCK);
+   iStatus = Tar_writeFull(iFd, acBlock, TAR_BLOCK);
+   if(iStatus == SUCCESS)
+      iStatus = Tar_writeFull(iFd, acBlock, TAR_BLOCK);
+   return iStatus;
+}
@@ -0,0 +1,42 @@
+/*--------------------------------------------------------------------*/
+/* fttar.h                                                            */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef FTTAR_INCLUDED
+#define FTTAR_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  Reads the next directory or regular file entry of the ustar/pax
+  archive being streamed from iFd, skipping any other entry types.
+  On SUCCESS, sets *ppcPath to a newly allocated, normalized pathname
+  (no leading "./" or '/', no trailing '/'), sets *pbIsFile, and for
+  files sets *ppvContents to newly allocated contents (NULL if empty)
+  of *pulLength bytes; the caller owns both allocations. At the end of
+  the archive, returns SUCCESS with *ppcPath set to NULL.
+  Otherwise, returns:
+  * IO_ERROR if iFd cannot be read or the archive is malformed
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Tar_readEntry(int iFd, char **ppcPath, boolean *pbIsFile,
+                  void **ppvContents, size_t *pulLength);
+
+/*
+  Writes one entry for the directory or file pcPath (with contents
+  pvContents of ulLength bytes, if a file) to iFd, using a pax header
+  only when the path or size does not fit in plain ustar.
+  Returns SUCCESS, or IO_ERROR if iFd cannot be written.
+*/
+int Tar_writeEntry(int iFd, const char *pcPath, boolean bIsFile,
+                   const void *pvContents, size_t ulLength);
+
+/*
+  Writes the end-of-archive marker to iFd.
+  Returns SUCCESS, or IO_ERROR if iFd cannot be written.
+*/
+int Tar_writeEnd(int iFd);
+
+#endif
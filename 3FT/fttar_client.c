@@ -0,0 +1,451 @@
+/*--------------------------------------------------------------------*/
+/* fttar_client.c                                                     */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ft.h"
+
+/*
+  fttar_client checks FT_exportTar and FT_importTar: a hierarchy
+  exported and imported again must come back the same, with the same
+  file contents; every truncation of that archive must either import
+  a part of it or fail with IO_ERROR; and each malformed archive must
+  fail with IO_ERROR, without reading or writing out of bounds (build
+  it with -fsanitize=address to be sure of the latter), leaving the
+  entries before the bad one in the FT. Like ft_client, it checks
+  with assert, so it must be built without NDEBUG.
+*/
+
+/* Archives are a sequence of TAR_BLOCK-byte blocks */
+enum { TAR_BLOCK = 512 };
+
+/* Offsets of the ustar header fields that the archives here set */
+enum { TAR_NAME = 0, TAR_MODE = 100, TAR_SIZE = 124, TAR_SIZE_LEN = 12,
+       TAR_CHKSUM = 148, TAR_CHKSUM_LEN = 8, TAR_TYPE = 156,
+       TAR_MAGIC = 257
+};
+
+/* The most blocks an archive built here has */
+enum { MAX_BLOCKS = 16 };
+
+/* An archive being built, and its length in bytes */
+static char acArchive[MAX_BLOCKS * TAR_BLOCK];
+static size_t ulArchive;
+
+/* The length of the long names in the exported hierarchy, and the
+   longest line of its FT_toString */
+enum { LONG_NAME = 120, MAX_LINE = 512 };
+
+/* The files of the exported hierarchy, and their contents */
+static const char *apcFiles[] = {
+   "r/a/plain", "r/a/empty", "r/a/binary", "r/b/c/deep",
+   "r/a/a-file-name-that-is-much-too-long-for-the-one-hundred-bytes-"
+   "of-a-ustar-name-field-so-it-needs-a-pax-header-to-travel"
+};
+static const char *apcContents[] = {
+   "plain text\n", "", "bin\0ary\0", "deep", "long"
+};
+static const size_t aulLengths[] = { 11, 0, 9, 4, 4 };
+enum { FILES = sizeof(apcFiles) / sizeof(apcFiles[0]) };
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Appends a ustar header for pcName, of type cType, with size field
+  pcSize (TAR_SIZE_LEN bytes, not necessarily text) to the archive,
+  and returns it so that the caller can spoil it before it is
+  imported. The checksum is computed, so a spoiled header must call
+  Client_sum again.
+*/
+static char *Client_addHeader(const char *pcName, char cType,
+                              const char *pcSize) {
+   char *pcBlock;
+
+   assert(ulArchive + TAR_BLOCK <= sizeof(acArchive));
+
+   pcBlock = acArchive + ulArchive;
+   memset(pcBlock, 0, TAR_BLOCK);
+   strncpy(pcBlock + TAR_NAME, pcName, 100);
+   memcpy(pcBlock + TAR_MODE, "0000644", 8);
+   memcpy(pcBlock + TAR_SIZE, pcSize, TAR_SIZE_LEN);
+   pcBlock[TAR_TYPE] = cType;
+   memcpy(pcBlock + TAR_MAGIC, "ustar\0" "00", 8);
+   ulArchive += TAR_BLOCK;
+   return pcBlock;
+}
+
+/* Recomputes the checksum of header pcBlock. */
+static void Client_sum(char *pcBlock) {
+   unsigned long ulSum = 0;
+   size_t i;
+
+   memset(pcBlock + TAR_CHKSUM, ' ', TAR_CHKSUM_LEN);
+   for(i = 0; i < TAR_BLOCK; i++)
+      ulSum += (unsigned char) pcBlock[i];
+   sprintf(pcBlock + TAR_CHKSUM, "%06lo", ulSum);
+}
+
+/*
+  Appends a ustar header and ulLength bytes of body pcBody, padded to
+  a block, to the archive. Returns the header.
+*/
+static char *Client_addEntry(const char *pcName, char cType,
+                             const char *pcBody, size_t ulLength) {
+   char acSize[TAR_SIZE_LEN];
+   char *pcBlock;
+
+   sprintf(acSize, "%011lo", (unsigned long) ulLength);
+   pcBlock = Client_addHeader(pcName, cType, acSize);
+   Client_sum(pcBlock);
+   assert(ulArchive + ulLength + TAR_BLOCK <= sizeof(acArchive));
+   memset(acArchive + ulArchive, 0,
+          (ulLength + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK);
+   if(ulLength > 0)
+      memcpy(acArchive + ulArchive, pcBody, ulLength);
+   ulArchive += (ulLength + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+   return pcBlock;
+}
+
+/*
+  Appends a pax extended header holding the single record
+  "<length> pcRecord\n" to the archive.
+*/
+static void Client_addPax(const char *pcRecord) {
+   char acRecord[TAR_BLOCK];
+   size_t ulBase = strlen(pcRecord) + 2;
+   size_t ulLength = ulBase + 1;
+
+   /* the record's length counts its own digits */
+   while(ulLength != ulBase +
+            (size_t) sprintf(acRecord, "%lu", (unsigned long) ulLength))
+      ulLength++;
+   sprintf(acRecord, "%lu %s\n", (unsigned long) ulLength, pcRecord);
+   (void) Client_addEntry("pax", 'x', acRecord, strlen(acRecord));
+}
+
+/*
+  Imports the ulLength bytes of pcBytes, as an archive, into a new FT
+  whose root r already exists, and returns FT_importTar's status. The
+  FT is left initialized for the caller to inspect and destroy.
+*/
+static int Client_importBytes(const char *pcBytes, size_t ulLength) {
+   FILE *psFile;
+   int iStatus;
+
+   psFile = tmpfile();
+   assert(psFile != NULL);
+   assert(fwrite(pcBytes, 1, ulLength, psFile) == ulLength);
+   assert(fflush(psFile) == 0);
+   assert(lseek(fileno(psFile), 0, SEEK_SET) == 0);
+
+   assert(FT_init() == SUCCESS);
+   assert(FT_insertDir("r") == SUCCESS);
+   iStatus = FT_importTar(fileno(psFile));
+   (void) fclose(psFile);
+   return iStatus;
+}
+
+/* Imports the first ulLength bytes of the archive being built. */
+static int Client_import(size_t ulLength) {
+   return Client_importBytes(acArchive, ulLength);
+}
+
+/*
+  Frees the contents of every file in the FT, all of which were
+  imported and so belong to the client, and destroys the FT.
+*/
+static void Client_destroy(void) {
+   char *pcTree;
+   char *pcLine;
+   char *pcNext;
+
+   pcTree = FT_toString();
+   assert(pcTree != NULL);
+   for(pcLine = pcTree; *pcLine != '\0'; pcLine = pcNext + 1) {
+      pcNext = strchr(pcLine, '\n');
+      *pcNext = '\0';
+      if(FT_containsFile(pcLine))
+         free(FT_getFileContents(pcLine));
+   }
+   free(pcTree);
+   assert(FT_destroy() == SUCCESS);
+}
+
+/*
+  Starts a new archive with one good directory and file, which every
+  failed import must leave in the FT.
+*/
+static void Client_startArchive(void) {
+   ulArchive = 0;
+   (void) Client_addEntry("r/ok/", '5', NULL, 0);
+   (void) Client_addEntry("r/ok/f", '0', "good", 4);
+}
+
+/*
+  Imports the archive, which must fail with IO_ERROR after importing
+  its good entries, and destroys the FT.
+*/
+static void Client_expectMalformed(void) {
+   assert(Client_import(ulArchive) == IO_ERROR);
+   assert(FT_containsDir("r/ok"));
+   assert(memcmp(FT_getFileContents("r/ok/f"), "good", 4) == 0);
+   Client_destroy();
+}
+
+/*
+  Checks that every file of apcFiles that is in the FT has its
+  contents. Returns how many are.
+*/
+static size_t Client_checkContents(void) {
+   size_t ulFile;
+   size_t ulFound = 0;
+
+   for(ulFile = 0; ulFile < FILES; ulFile++) {
+      boolean bIsFile;
+      size_t ulSize;
+      if(!FT_containsFile(apcFiles[ulFile]))
+         continue;
+      assert(FT_stat(apcFiles[ulFile], &bIsFile, &ulSize) == SUCCESS);
+      assert(ulSize == aulLengths[ulFile]);
+      assert(ulSize == 0 ? FT_getFileContents(apcFiles[ulFile]) == NULL
+             : memcmp(FT_getFileContents(apcFiles[ulFile]),
+                      apcContents[ulFile], ulSize) == 0);
+      ulFound++;
+   }
+   return ulFound;
+}
+
+/*
+  Returns TRUE if every line of FT_toString result pcPart is also a
+  line of pcWhole, an FT_toString result with a newline put in front.
+*/
+static boolean Client_isPart(const char *pcPart, const char *pcWhole) {
+   char acLine[MAX_LINE + 2];
+   const char *pcLine;
+   const char *pcNext;
+
+   for(pcLine = pcPart; *pcLine != '\0'; pcLine = pcNext + 1) {
+      pcNext = strchr(pcLine, '\n');
+      assert(pcNext - pcLine < MAX_LINE);
+      sprintf(acLine, "\n%.*s\n", (int) (pcNext - pcLine), pcLine);
+      if(strstr(pcWhole, acLine) == NULL)
+         return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+  Exports a hierarchy with an empty file and directory, binary
+  contents and names too long for plain ustar, and imports it into a
+  new FT, which must have the same FT_toString and contents. Then
+  imports truncations of the archive, at every block boundary and
+  inside every block: each must import a part of the hierarchy, and
+  one that ends inside an entry must fail with IO_ERROR. Returns how
+  many truncations were imported.
+*/
+static size_t Client_checkRoundTrip(void) {
+   char acLong[8 + 3 * (LONG_NAME + 1)];
+   FILE *psFile;
+   char *pcTar;
+   char *pcTree;
+   char *pcWhole;
+   long lLength;
+   size_t ulLength;
+   size_t ulCut;
+   size_t ulFile;
+   size_t ulCuts = 0;
+
+   assert(FT_init() == SUCCESS);
+   for(ulFile = 0; ulFile < FILES; ulFile++)
+      assert(FT_insertFile(apcFiles[ulFile],
+                           aulLengths[ulFile] == 0 ? NULL :
+                           (void *) apcContents[ulFile],
+                           aulLengths[ulFile]) == SUCCESS);
+   assert(FT_insertDir("r/emptydir") == SUCCESS);
+   /* a deep path too long for the ustar prefix and name together */
+   strcpy(acLong, "r/b/c");
+   for(ulFile = 0; ulFile < 3; ulFile++) {
+      size_t ulEnd = strlen(acLong);
+      acLong[ulEnd] = '/';
+      memset(acLong + ulEnd + 1, 'd', LONG_NAME);
+      acLong[ulEnd + 1 + LONG_NAME] = '\0';
+   }
+   assert(FT_insertDir(acLong) == SUCCESS);
+
+   psFile = tmpfile();
+   assert(psFile != NULL);
+   assert(FT_exportTar("r/nope", fileno(psFile)) == NO_SUCH_PATH);
+   assert(FT_exportTar("r", fileno(psFile)) == SUCCESS);
+   pcTree = FT_toString();
+   assert(pcTree != NULL);
+   assert(FT_destroy() == SUCCESS);
+   pcWhole = malloc(strlen(pcTree) + 2);
+   assert(pcWhole != NULL);
+   pcWhole[0] = '\n';
+   strcpy(pcWhole + 1, pcTree);
+
+   lLength = lseek(fileno(psFile), 0, SEEK_END);
+   assert(lLength > 0 && lLength % TAR_BLOCK == 0);
+   ulLength = (size_t) lLength;
+   pcTar = malloc(ulLength);
+   assert(pcTar != NULL);
+   assert(pread(fileno(psFile), pcTar, ulLength, 0) == lLength);
+   (void) fclose(psFile);
+
+   /* the whole archive */
+   assert(Client_importBytes(pcTar, ulLength) == SUCCESS);
+   {
+      char *pcImported = FT_toString();
+      assert(pcImported != NULL);
+      assert(strcmp(pcImported, pcTree) == 0);
+      free(pcImported);
+   }
+   assert(Client_checkContents() == FILES);
+   Client_destroy();
+
+   /* every truncation, at odd offsets and at block boundaries */
+   for(ulCut = 0; ulCut < ulLength; ulCut += ulCut % TAR_BLOCK == 0 ?
+          TAR_BLOCK / 4 + 1 : TAR_BLOCK - ulCut % TAR_BLOCK) {
+      char *pcPart;
+      int iStatus = Client_importBytes(pcTar, ulCut);
+      assert(iStatus == SUCCESS || iStatus == IO_ERROR);
+      pcPart = FT_toString();
+      assert(pcPart != NULL);
+      assert(Client_isPart(pcPart, pcWhole));
+      /* only the end-of-archive blocks may be cut inside a block */
+      assert(ulCut % TAR_BLOCK == 0 || iStatus == IO_ERROR ||
+             strcmp(pcPart, pcTree) == 0);
+      (void) Client_checkContents();
+      free(pcPart);
+      Client_destroy();
+      ulCuts++;
+   }
+
+   free(pcWhole);
+   free(pcTree);
+   free(pcTar);
+   return ulCuts;
+}
+
+/*
+  Imports each malformed archive, which must fail with IO_ERROR.
+  Returns how many there were.
+*/
+static size_t Client_checkMalformed(void) {
+   char acSize[TAR_SIZE_LEN];
+   char *pcBlock;
+   size_t ulChecks = 0;
+
+   /* a well-formed archive imports, as a control */
+   Client_startArchive();
+   (void) Client_addEntry("r/ok/g", '0', "more", 4);
+   assert(Client_import(ulArchive) == SUCCESS);
+   assert(FT_containsFile("r/ok/g"));
+   Client_destroy();
+
+   /* a base-256 size of all ones: negative, and SIZE_MAX if read as
+      unsigned, which once wrapped the body's allocation */
+   Client_startArchive();
+   memset(acSize, 0xff, TAR_SIZE_LEN);
+   Client_sum(Client_addHeader("r/big", '0', acSize));
+   Client_expectMalformed();
+   ulChecks++;
+
+   /* a positive base-256 size above SSIZE_MAX */
+   Client_startArchive();
+   memset(acSize, 0xff, TAR_SIZE_LEN);
+   acSize[0] = (char) 0xbf;
+   Client_sum(Client_addHeader("r/big", '0', acSize));
+   Client_expectMalformed();
+   ulChecks++;
+
+   /* the same sizes on an entry that is skipped, not read */
+   Client_startArchive();
+   memset(acSize, 0xff, TAR_SIZE_LEN);
+   Client_sum(Client_addHeader("r/link", '2', acSize));
+   Client_expectMalformed();
+   ulChecks++;
+
+   /* a size that is not octal */
+   Client_startArchive();
+   Client_sum(Client_addHeader("r/bad", '0', "0000000009\0"));
+   Client_expectMalformed();
+   ulChecks++;
+
+   /* a wrong checksum */
+   Client_startArchive();
+   pcBlock = Client_addEntry("r/bad", '0', "x", 1);
+   pcBlock[TAR_NAME + 2] = 'c';
+   Client_expectMalformed();
+   ulChecks++;
+
+   /* a header cut short */
+   Client_startArchive();
+   (void) Client_addEntry("r/bad", '0', NULL, 0);
+   ulArchive -= TAR_BLOCK / 2;
+   Client_expectMalformed();
+   ulChecks++;
+
+   /* pax sizes that are too large, overflow, or are empty */
+   Client_startArchive();
+   Client_addPax("size=18446744073709551615");
+   (void) Client_addEntry("r/big", '0', NULL, 0);
+   Client_expectMalformed();
+   ulChecks++;
+
+   Client_startArchive();
+   Client_addPax("size=999999999999999999999999999999");
+   (void) Client_addEntry("r/big", '0', NULL, 0);
+   Client_expectMalformed();
+   ulChecks++;
+
+   Client_startArchive();
+   Client_addPax("size=");
+   (void) Client_addEntry("r/big", '0', NULL, 0);
+   Client_expectMalformed();
+   ulChecks++;
+
+   /* a pax record whose length runs past its header */
+   Client_startArchive();
+   (void) Client_addEntry("pax", 'x', "99 path=r/bad\n", 14);
+   (void) Client_addEntry("r/bad", '0', NULL, 0);
+   Client_expectMalformed();
+   ulChecks++;
+
+   /* an extended header with no entry after it */
+   Client_startArchive();
+   Client_addPax("path=r/orphan");
+   Client_expectMalformed();
+   ulChecks++;
+
+   /* a body cut short */
+   Client_startArchive();
+   (void) Client_addEntry("r/bad", '0', "body", 4);
+   ulArchive -= TAR_BLOCK - 2;
+   Client_expectMalformed();
+   ulChecks++;
+
+   return ulChecks;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Runs every check. Returns 0; a failed check aborts. */
+int main(void) {
+   size_t ulCuts;
+   size_t ulMalformed;
+
+   ulCuts = Client_checkRoundTrip();
+   ulMalformed = Client_checkMalformed();
+   fprintf(stderr, "fttar_client: %lu truncations and %lu malformed "
+           "archives imported, all checks passed\n",
+           (unsigned long) ulCuts, (unsigned long) ulMalformed);
+   return 0;
+}
@@ -0,0 +1,383 @@
+/*--------------------------------------------------------------------*/
+/* fttrace.c                                                          */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "fttrace.h"
+
+/* The bytes every trace file starts with */
+static const char acMagic[8] = {
+   'F', 'T', 'T', 'R', 'A', 'C', 'E', '1'
+};
+
+/* The size of a trace's buffer */
+enum { TRACE_BUFFER = 65536 };
+
+/* The bit of a record's op byte that is set for NULL contents */
+enum { TRACE_NULL_CONTENTS = 0x80 };
+
+/* The most bytes a varint may take */
+enum { TRACE_VARINT = 10 };
+
+/*
+  A trace is a file descriptor and a buffer of records waiting to be
+  written to it or read from it.
+*/
+struct trace {
+   int iFd;
+   /* TRUE for a writer, FALSE for a reader */
+   boolean bWriter;
+   char *pcBuffer;
+   /* the bytes of pcBuffer in use, and (for a reader) how many of
+      them have been consumed */
+   size_t ulUsed;
+   size_t ulNext;
+   /* a reader's copy of the last path read */
+   char *pcPath;
+   size_t ulPathSize;
+   /* whether a reader's file has no more bytes */
+   boolean bAtEnd;
+   /* whether a writer has written a record yet */
+   boolean bStarted;
+   /* the start of the last record, which the next start is
+      encoded relative to */
+   unsigned long ulLastStart;
+};
+
+/* The names of the ops, in enum traceOp order */
+static const char *apcOpNames[TRACE_OPS] = {
+   "FT_init", "FT_destroy", "FT_insertDir", "FT_containsDir",
+   "FT_rmDir", "FT_insertFile", "FT_containsFile", "FT_rmFile",
+   "FT_getFileContents", "FT_replaceFileContents", "FT_stat",
+   "FT_toString"
+};
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Writes the ulLength bytes of pvData to iFd, retrying short writes.
+  Returns SUCCESS or IO_ERROR.
+*/
+static int Trace_writeAll(int iFd, const void *pvData,
+                          size_t ulLength) {
+   const char *pc = pvData;
+
+   while(ulLength > 0) {
+      ssize_t lWritten = write(iFd, pc, ulLength);
+      if(lWritten < 0) {
+         if(errno == EINTR)
+            continue;
+         return IO_ERROR;
+      }
+      pc += lWritten;
+      ulLength -= (size_t) lWritten;
+   }
+   return SUCCESS;
+}
+
+/*
+  Encodes ulValue as a varint at pc, which must have room for
+  TRACE_VARINT bytes. Returns the number of bytes written.
+*/
+static size_t Trace_putVarint(char *pc, unsigned long ulValue) {
+   size_t ulUsed = 0;
+
+   while(ulValue >= 0x80) {
+      pc[ulUsed++] = (char) ((ulValue & 0x7f) | 0x80);
+      ulValue >>= 7;
+   }
+   pc[ulUsed++] = (char) ulValue;
+   return ulUsed;
+}
+
+/*
+  Makes at least ulLength bytes available to consume from reader
+  oTTrace's buffer, unless its file ends first.
+  Returns SUCCESS, or IO_ERROR if the file cannot be read.
+*/
+static int Trace_fill(Trace_T oTTrace, size_t ulLength) {
+   assert(ulLength <= TRACE_BUFFER);
+
+   if(oTTrace->ulUsed - oTTrace->ulNext >= ulLength)
+      return SUCCESS;
+
+   /* move the unconsumed bytes to the front, then read after them */
+   memmove(oTTrace->pcBuffer, oTTrace->pcBuffer + oTTrace->ulNext,
+           oTTrace->ulUsed - oTTrace->ulNext);
+   oTTrace->ulUsed -= oTTrace->ulNext;
+   oTTrace->ulNext = 0;
+   while(!oTTrace->bAtEnd && oTTrace->ulUsed < ulLength) {
+      ssize_t lRead = read(oTTrace->iFd,
+                           oTTrace->pcBuffer + oTTrace->ulUsed,
+                           TRACE_BUFFER - oTTrace->ulUsed);
+      if(lRead < 0) {
+         if(errno == EINTR)
+            continue;
+         return IO_ERROR;
+      }
+      if(lRead == 0)
+         oTTrace->bAtEnd = TRUE;
+      oTTrace->ulUsed += (size_t) lRead;
+   }
+   return SUCCESS;
+}
+
+/*
+  Decodes a varint from reader oTTrace into *pulValue.
+  Returns SUCCESS, or IO_ERROR if the trace ends or is corrupt.
+*/
+static int Trace_getVarint(Trace_T oTTrace, unsigned long *pulValue) {
+   unsigned long ulValue = 0;
+   size_t ulShift = 0;
+   int iStatus;
+
+   iStatus = Trace_fill(oTTrace, TRACE_VARINT);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   while(oTTrace->ulNext < oTTrace->ulUsed && ulShift < 64) {
+      unsigned char uc =
+         (unsigned char) oTTrace->pcBuffer[oTTrace->ulNext++];
+      ulValue |= (unsigned long) (uc & 0x7f) << ulShift;
+      if((uc & 0x80) == 0) {
+         *pulValue = ulValue;
+         return SUCCESS;
+      }
+      ulShift += 7;
+   }
+   return IO_ERROR;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Returns a new trace of iFd, a writer if bWriter, or NULL if memory
+  could not be allocated.
+*/
+static Trace_T Trace_new(int iFd, boolean bWriter) {
+   Trace_T oTTrace;
+
+   oTTrace = calloc(1, sizeof(struct trace));
+   if(oTTrace == NULL)
+      return NULL;
+   oTTrace->pcBuffer = malloc(TRACE_BUFFER);
+   if(oTTrace->pcBuffer == NULL) {
+      free(oTTrace);
+      return NULL;
+   }
+   oTTrace->iFd = iFd;
+   oTTrace->bWriter = bWriter;
+   return oTTrace;
+}
+
+int Trace_newWriter(int iFd, Trace_T *poTTrace) {
+   Trace_T oTTrace;
+
+   assert(poTTrace != NULL);
+
+   *poTTrace = NULL;
+   oTTrace = Trace_new(iFd, TRUE);
+   if(oTTrace == NULL)
+      return MEMORY_ERROR;
+   if(Trace_writeAll(iFd, acMagic, sizeof(acMagic)) != SUCCESS) {
+      (void) Trace_free(oTTrace);
+      return IO_ERROR;
+   }
+   *poTTrace = oTTrace;
+   return SUCCESS;
+}
+
+int Trace_newReader(int iFd, Trace_T *poTTrace) {
+   Trace_T oTTrace;
+
+   assert(poTTrace != NULL);
+
+   *poTTrace = NULL;
+   oTTrace = Trace_new(iFd, FALSE);
+   if(oTTrace == NULL)
+      return MEMORY_ERROR;
+   if(Trace_fill(oTTrace, sizeof(acMagic)) != SUCCESS ||
+      oTTrace->ulUsed < sizeof(acMagic) ||
+      memcmp(oTTrace->pcBuffer, acMagic, sizeof(acMagic)) != 0) {
+      (void) Trace_free(oTTrace);
+      return IO_ERROR;
+   }
+   oTTrace->ulNext = sizeof(acMagic);
+   *poTTrace = oTTrace;
+   return SUCCESS;
+}
+
+int Trace_write(Trace_T oTTrace, const struct traceRecord *psRecord) {
+   size_t ulPathLength;
+   unsigned long ulStart;
+   char *pc;
+
+   assert(oTTrace != NULL);
+   assert(oTTrace->bWriter);
+   assert(psRecord != NULL);
+   assert(psRecord->pcPath != NULL);
+
+   ulPathLength = strlen(psRecord->pcPath);
+   if(oTTrace->ulUsed + 1 + 5 * TRACE_VARINT + ulPathLength >
+      TRACE_BUFFER) {
+      int iStatus = Trace_flush(oTTrace);
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+
+   /* a path longer than the whole buffer is written straight out */
+   pc = oTTrace->pcBuffer + oTTrace->ulUsed;
+   *pc++ = (char) (psRecord->eOp |
+                   (psRecord->bNullContents ? TRACE_NULL_CONTENTS : 0));
+   pc += Trace_putVarint(pc, ulPathLength);
+   if(ulPathLength > TRACE_BUFFER - 1 - 5 * TRACE_VARINT) {
+      oTTrace->ulUsed = (size_t) (pc - oTTrace->pcBuffer);
+      if(Trace_flush(oTTrace) != SUCCESS ||
+         Trace_writeAll(oTTrace->iFd, psRecord->pcPath,
+                        ulPathLength) != SUCCESS)
+         return IO_ERROR;
+      pc = oTTrace->pcBuffer;
+   }
+   else {
+      memcpy(pc, psRecord->pcPath, ulPathLength);
+      pc += ulPathLength;
+   }
+
+   if(!oTTrace->bStarted) {
+      oTTrace->bStarted = TRUE;
+      oTTrace->ulLastStart = psRecord->ulStart;
+   }
+   ulStart = psRecord->ulStart >= oTTrace->ulLastStart ?
+      psRecord->ulStart - oTTrace->ulLastStart : 0;
+   oTTrace->ulLastStart += ulStart;
+
+   pc += Trace_putVarint(pc, psRecord->ulLength);
+   pc += Trace_putVarint(pc, psRecord->ulResult);
+   pc += Trace_putVarint(pc, ulStart);
+   pc += Trace_putVarint(pc, psRecord->ulDuration);
+   oTTrace->ulUsed = (size_t) (pc - oTTrace->pcBuffer);
+   return SUCCESS;
+}
+
+int Trace_read(Trace_T oTTrace, struct traceRecord *psRecord) {
+   unsigned long ulOp;
+   unsigned long ulPathLength;
+   unsigned long ulLength;
+   unsigned long ulStart;
+   int iStatus;
+
+   assert(oTTrace != NULL);
+   assert(!oTTrace->bWriter);
+   assert(psRecord != NULL);
+
+   iStatus = Trace_fill(oTTrace, 1);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(oTTrace->ulNext == oTTrace->ulUsed)
+      return NO_SUCH_PATH;
+
+   ulOp = (unsigned char) oTTrace->pcBuffer[oTTrace->ulNext++];
+   psRecord->bNullContents = (ulOp & TRACE_NULL_CONTENTS) != 0;
+   ulOp &= ~(unsigned long) TRACE_NULL_CONTENTS;
+   if(ulOp >= TRACE_OPS ||
+      Trace_getVarint(oTTrace, &ulPathLength) != SUCCESS)
+      return IO_ERROR;
+
+   if(ulPathLength + 1 > oTTrace->ulPathSize) {
+      char *pcPath = realloc(oTTrace->pcPath, ulPathLength + 1);
+      if(pcPath == NULL)
+         return MEMORY_ERROR;
+      oTTrace->pcPath = pcPath;
+      oTTrace->ulPathSize = ulPathLength + 1;
+   }
+   /* copy the path through the buffer a buffer's worth at a time */
+   {
+      size_t ulCopied = 0;
+      while(ulCopied < ulPathLength) {
+         size_t ulChunk = ulPathLength - ulCopied;
+         if(ulChunk > TRACE_BUFFER)
+            ulChunk = TRACE_BUFFER;
+         if(Trace_fill(oTTrace, ulChunk) != SUCCESS ||
+            oTTrace->ulUsed - oTTrace->ulNext < ulChunk)
+            return IO_ERROR;
+         memcpy(oTTrace->pcPath + ulCopied,
+                oTTrace->pcBuffer + oTTrace->ulNext, ulChunk);
+         oTTrace->ulNext += ulChunk;
+         ulCopied += ulChunk;
+      }
+   }
+   oTTrace->pcPath[ulPathLength] = '\0';
+
+   psRecord->eOp = (enum traceOp) ulOp;
+   psRecord->pcPath = oTTrace->pcPath;
+   if(Trace_getVarint(oTTrace, &ulLength) != SUCCESS ||
+      Trace_getVarint(oTTrace, &psRecord->ulResult) != SUCCESS ||
+      Trace_getVarint(oTTrace, &ulStart) != SUCCESS ||
+      Trace_getVarint(oTTrace, &psRecord->ulDuration) != SUCCESS)
+      return IO_ERROR;
+   psRecord->ulLength = (size_t) ulLength;
+   oTTrace->ulLastStart += ulStart;
+   psRecord->ulStart = oTTrace->ulLastStart;
+   return SUCCESS;
+}
+
+int Trace_flush(Trace_T oTTrace) {
+   int iStatus;
+
+   assert(oTTrace != NULL);
+   assert(oTTrace->bWriter);
+
+   iStatus = Trace_writeAll(oTTrace->iFd, oTTrace->pcBuffer,
+                            oTTrace->ulUsed);
+   oTTrace->ulUsed = 0;
+   return iStatus;
+}
+
+int Trace_free(Trace_T oTTrace) {
+   int iStatus = SUCCESS;
+
+   if(oTTrace == NULL)
+      return SUCCESS;
+
+   if(oTTrace->bWriter)
+      iStatus = Trace_flush(oTTrace);
+   free(oTTrace->pcBuffer);
+   free(oTTrace->pcPath);
+   free(oTTrace);
+   return iStatus;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *Trace_getOpName(enum traceOp eOp) {
+   assert(eOp < TRACE_OPS);
+
+   return apcOpNames[eOp];
+}
+
+unsigned long Trace_hash(const char *pcString) {
+   unsigned long ulHash = 14695981039346656037UL;
+
+   assert(pcString != NULL);
+
+   while(*pcString != '\0') {
+      ulHash ^= (unsigned char) *pcString++;
+      ulHash *= 1099511628211UL;
+   }
+   return ulHash;
+}
+
+unsigned long Trace_now(void) {
+   struct timespec sNow;
+   (void) clock_gettime(CLOCK_MONOTONIC, &sNow);
+   return (unsigned long) sNow.tv_sec * 1000000000UL +
+      (unsigned long) sNow.tv_nsec;
+}
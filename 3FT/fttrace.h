@@ -0,0 +1,111 @@
+/*--------------------------------------------------------------------*/
+/* fttrace.h                                                          */
+/* Authors: Thomas Zhang and Maia Abiani                              */
+/*--------------------------------------------------------------------*/
+
+#ifndef FTTRACE_INCLUDED
+#define FTTRACE_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  A Trace_T reads or writes a trace file: the sequence of calls a
+  program made to the FT interface, in the order it made them. A trace
+  file is the 8 bytes "FTTRACE1" followed by one record per call:
+  the op as 1 byte (with its high bit set if bNullContents), then the
+  path length, the path's bytes, and the length, result, start and
+  duration fields of struct traceRecord, each number but the op
+  encoded as a little-endian base-128 varint.
+*/
+typedef struct trace *Trace_T;
+
+/* The FT interface calls a trace records */
+enum traceOp {
+   TRACE_INIT, TRACE_DESTROY, TRACE_INSERT_DIR, TRACE_CONTAINS_DIR,
+   TRACE_RM_DIR, TRACE_INSERT_FILE, TRACE_CONTAINS_FILE, TRACE_RM_FILE,
+   TRACE_GET_CONTENTS, TRACE_REPLACE_CONTENTS, TRACE_STAT,
+   TRACE_TO_STRING, TRACE_OPS
+};
+
+/*
+  One recorded call. What ulLength and ulResult hold depends on eOp:
+  * TRACE_INSERT_FILE and TRACE_REPLACE_CONTENTS: the length of the
+    new contents, and the status returned or whether the old contents
+    returned were non-NULL, respectively
+  * TRACE_GET_CONTENTS: 0, and whether the contents returned were
+    non-NULL
+  * TRACE_STAT: the size set (0 unless a file was found), and twice
+    the status returned, plus 1 if a file was found
+  * TRACE_TO_STRING: the length of the string returned, and its
+    Trace_hash (0 if NULL was returned)
+  * otherwise: 0, and the status or boolean returned
+*/
+struct traceRecord {
+   enum traceOp eOp;
+   /* the path argument ("" for the calls that take none), valid only
+      until the next Trace_read */
+   const char *pcPath;
+   /* whether the contents argument of TRACE_INSERT_FILE or
+      TRACE_REPLACE_CONTENTS was NULL (FALSE for other ops) */
+   boolean bNullContents;
+   size_t ulLength;
+   unsigned long ulResult;
+   /* when the call started, in nanoseconds since the first call */
+   unsigned long ulStart;
+   /* how long the call took, in nanoseconds */
+   unsigned long ulDuration;
+};
+
+/*
+  Starts writing a trace to iFd, open for writing, and sets *poTTrace
+  to the writer. The writer does not close iFd.
+  Returns SUCCESS, or sets *poTTrace to NULL and returns IO_ERROR if
+  iFd cannot be written or MEMORY_ERROR.
+*/
+int Trace_newWriter(int iFd, Trace_T *poTTrace);
+
+/*
+  Starts reading a trace from iFd, open for reading, and sets
+  *poTTrace to the reader. The reader does not close iFd.
+  Returns SUCCESS, or sets *poTTrace to NULL and returns IO_ERROR if
+  iFd does not start with a trace header or MEMORY_ERROR.
+*/
+int Trace_newReader(int iFd, Trace_T *poTTrace);
+
+/*
+  Appends *psRecord to writer oTTrace; records may stay buffered
+  until Trace_flush or Trace_free.
+  Returns SUCCESS, or IO_ERROR if the buffer could not be written.
+*/
+int Trace_write(Trace_T oTTrace, const struct traceRecord *psRecord);
+
+/*
+  Reads the next record of reader oTTrace into *psRecord.
+  Returns SUCCESS, NO_SUCH_PATH at the end of the trace, or IO_ERROR
+  if the trace is truncated or corrupt.
+*/
+int Trace_read(Trace_T oTTrace, struct traceRecord *psRecord);
+
+/*
+  Writes the records buffered in writer oTTrace to its file.
+  Returns SUCCESS, or IO_ERROR if they could not all be written.
+*/
+int Trace_flush(Trace_T oTTrace);
+
+/*
+  Flushes oTTrace if it is a writer, and frees all memory allocated
+  for it. Returns SUCCESS, or IO_ERROR if the flush failed.
+*/
+int Trace_free(Trace_T oTTrace);
+
+/* Returns the name of eOp, as the FT function it records. */
+const char *Trace_getOpName(enum traceOp eOp);
+
+/* Returns a 64-bit FNV-1a hash of string pcString. */
+unsigned long Trace_hash(const char *pcString);
+
+/* Returns a monotonic timestamp in nanoseconds. */
+unsigned long Trace_now(void);
+
+#endif
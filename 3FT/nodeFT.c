@@ -8,6 +8,13 @@
 #include <string.h>
 #include "dynarray.h"
 #include "nodeFT.h"
+#include "ftimage.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* The most children a directory keeps tags for */
+enum { MAX_TAGGED = 16 };
 
 /* A node in a DT */
 struct node {
@@ -19,26 +26,186 @@ struct node {
    DynArray_T oDChildren;
    /*indicator of a node's type (file or directory)*/
    typeNode type;
-   /*contents of a file node*/
-   void *fileContents;
-   /*length of the contents of a file node*/
-   size_t fileLength;
+   /*for a directory, whether aucTags holds its children's tags*/
+   boolean bTagged;
+   union {
+      struct {
+         /*contents of a file node*/
+         void *fileContents;
+         /*length of the contents of a file node*/
+         size_t fileLength;
+      } sFile;
+      /*for a directory of at most MAX_TAGGED children, each child's
+      tag (see Node_tag), in the order of oDChildren*/
+      unsigned char aucTags[MAX_TAGGED];
+   } u;
+   /*for a directory loaded lazily from an image whose children have
+   not been created yet, its stub (see ftimage.h); otherwise NULL*/
+   void *pvStub;
+   /*when this node was last used, as set by Node_touch*/
+   size_t ulStamp;
 };
 
+/* The number of nodes currently allocated, for Node_getResidentCount */
+static size_t ulResident;
+
+#ifndef NDEBUG
+
+/*
+  Returns TRUE if oNNode is a file whose fields are consistent with
+  one, or FALSE otherwise. A file's contents share their storage with
+  a directory's tags, so treating either as the other corrupts both.
+*/
+static boolean Node_isFile(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return (boolean) (oNNode->type == FILE_NODE && !oNNode->bTagged &&
+                     oNNode->oDChildren == NULL &&
+                     oNNode->pvStub == NULL);
+}
+
+#endif
+
+/*
+  Returns the tag of the last component of pcPath, the absolute path
+  of a child of a directory whose path is ulParentLength characters
+  long: a one-byte hash of the component's characters and length, so
+  that children with a common prefix still differ.
+*/
+static unsigned char Node_tag(const char *pcPath,
+                              size_t ulParentLength) {
+   const unsigned char *pucChar;
+   unsigned long ulHash = 2166136261UL;
+
+   assert(pcPath != NULL);
+
+   for(pucChar = (const unsigned char *) pcPath + ulParentLength + 1;
+       *pucChar != '\0'; pucChar++)
+      ulHash = ((ulHash ^ *pucChar) * 16777619UL) & 0xffffffffUL;
+   return (unsigned char) (ulHash ^ (ulHash >> 8) ^ (ulHash >> 16) ^
+                           (ulHash >> 24));
+}
+
+/*
+  Recomputes the tags of oNParent's children, if it has few enough of
+  them to keep tags for.
+*/
+static void Node_retag(Node_T oNParent) {
+   size_t ulLength;
+   size_t ulParentLength;
+   size_t i;
+
+   assert(oNParent != NULL);
+   assert(oNParent->type == DIRECTORY);
+
+   ulLength = DynArray_getLength(oNParent->oDChildren);
+   oNParent->bTagged = ulLength <= MAX_TAGGED;
+   if(!oNParent->bTagged)
+      return;
+   ulParentLength = Path_getStrLength(oNParent->oPPath);
+   for(i = 0; i < ulLength; i++) {
+      Node_T oNChild = DynArray_get(oNParent->oDChildren, i);
+      oNParent->u.aucTags[i] =
+         Node_tag(Path_getPathname(oNChild->oPPath), ulParentLength);
+   }
+}
+
+/*
+  Returns a mask with bit i set for each of the first ulLength tags of
+  tagged directory oNParent that equals ucTag, comparing all of them
+  at once where SSE2 is available.
+*/
+static unsigned int Node_matchTags(Node_T oNParent,
+                                   unsigned char ucTag,
+                                   size_t ulLength) {
+   unsigned int uiMask = 0;
+#ifdef __SSE2__
+   __m128i vTags;
+#else
+   size_t i;
+#endif
+
+   assert(oNParent != NULL);
+   assert(oNParent->type == DIRECTORY);
+   assert(oNParent->bTagged);
+   assert(ulLength <= MAX_TAGGED);
+
+#ifdef __SSE2__
+   vTags = _mm_loadu_si128((const __m128i *) oNParent->u.aucTags);
+   uiMask = (unsigned int) _mm_movemask_epi8(
+      _mm_cmpeq_epi8(vTags, _mm_set1_epi8((char) ucTag)));
+#else
+   for(i = 0; i < ulLength; i++)
+      if(oNParent->u.aucTags[i] == ucTag)
+         uiMask |= 1U << i;
+#endif
+   return uiMask & ((1U << ulLength) - 1);
+}
+
+/*
+  Looks for a child with path oPPath among the children of tagged
+  directory oNParent, comparing whole paths only for the children
+  whose tags match. Returns TRUE and stores its index in *pulChildID
+  if found, or returns FALSE.
+*/
+static boolean Node_findTagged(Node_T oNParent, Path_T oPPath,
+                               size_t *pulChildID) {
+   const char *pcPath;
+   size_t ulParentLength;
+   unsigned int uiMask;
+   size_t i;
+
+   assert(oNParent != NULL);
+   assert(oPPath != NULL);
+   assert(pulChildID != NULL);
+
+   ulParentLength = Path_getStrLength(oNParent->oPPath);
+   if(Path_getStrLength(oPPath) <= ulParentLength + 1)
+      return FALSE;
+   pcPath = Path_getPathname(oPPath);
+   uiMask = Node_matchTags(oNParent, Node_tag(pcPath, ulParentLength),
+                  DynArray_getLength(oNParent->oDChildren));
+   for(i = 0; uiMask != 0; i++, uiMask >>= 1) {
+      Node_T oNChild;
+      if((uiMask & 1U) == 0)
+         continue;
+      oNChild = DynArray_get(oNParent->oDChildren, i);
+      if(Path_compareString(oNChild->oPPath, pcPath) == 0) {
+         *pulChildID = i;
+         return TRUE;
+      }
+   }
+   return FALSE;
+}
+
 /*
   Links new child oNChild into oNParent's children array at index
-  ulIndex. Returns SUCCESS if the new child was added successfully,
-  or  MEMORY_ERROR if allocation fails adding oNChild to the array.
+  ulIndex, keeping oNParent's tags in step. Returns SUCCESS if the new
+  child was added successfully, or  MEMORY_ERROR if allocation fails
+  adding oNChild to the array.
 */
 static int Node_addChild(Node_T oNParent, Node_T oNChild,
                          size_t ulIndex) {
+   size_t ulLength;
+
    assert(oNParent != NULL);
+   assert(oNParent->type == DIRECTORY);
    assert(oNChild != NULL);
 
-   if(DynArray_addAt(oNParent->oDChildren, ulIndex, oNChild))
-      return SUCCESS;
-   else
+   if(!DynArray_addAt(oNParent->oDChildren, ulIndex, oNChild))
       return MEMORY_ERROR;
+
+   ulLength = DynArray_getLength(oNParent->oDChildren);
+   if(oNParent->bTagged && ulLength > MAX_TAGGED)
+      oNParent->bTagged = FALSE;
+   else if(oNParent->bTagged) {
+      memmove(oNParent->u.aucTags + ulIndex + 1,
+              oNParent->u.aucTags + ulIndex, ulLength - 1 - ulIndex);
+      oNParent->u.aucTags[ulIndex] =
+         Node_tag(Path_getPathname(oNChild->oPPath),
+                  Path_getStrLength(oNParent->oPPath));
+   }
+   return SUCCESS;
 }
 
 /*
@@ -137,18 +304,21 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult,
       
    }
    psNew->oNParent = oNParent;
+   psNew->pvStub = NULL;
+   /* a new node is as recently used as its parent */
+   psNew->ulStamp = oNParent == NULL ? 0 : oNParent->ulStamp;
 
    /* Initialize the new node. */
    if(type == FILE_NODE)
    {
-      psNew->fileContents= oPFileContents;
+      psNew->u.sFile.fileContents= oPFileContents;
       psNew->oDChildren = NULL;
-      psNew->fileLength = fileLength;
+      psNew->u.sFile.fileLength = fileLength;
+      psNew->bTagged = FALSE;
    }
    else if (type == DIRECTORY){
-      psNew->fileContents = NULL;
       psNew->oDChildren = DynArray_new(0);
-      psNew->fileLength = 0;
+      psNew->bTagged = TRUE;
       if(psNew->oDChildren == NULL) {
          Path_free(psNew->oPPath);
          free(psNew);
@@ -175,6 +345,7 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult,
    /* set the Node's type*/
    psNew->type = type;
    
+   ulResident++;
    *poNResult = psNew;
    return SUCCESS;
 }
@@ -193,15 +364,35 @@ size_t Node_free(Node_T oNNode) {
             oNNode, &ulIndex,
             (int (*)(const void *, const void *)) Node_compare)
         )
-         (void) DynArray_removeAt(oNNode->oNParent->oDChildren,
-                                  ulIndex);
+      {
+         Node_T oNParent = oNNode->oNParent;
+         (void) DynArray_removeAt(oNParent->oDChildren, ulIndex);
+         if(oNParent->bTagged)
+            memmove(oNParent->u.aucTags + ulIndex,
+                    oNParent->u.aucTags + ulIndex + 1,
+                    DynArray_getLength(oNParent->oDChildren) -
+                       ulIndex);
+      }
+   }
+
+   /* a stub's saved subtree was never created, but still counts */
+   if(oNNode->pvStub != NULL) {
+      ulCount += Image_getStubCount(oNNode->pvStub) - 1;
+      Image_freeStub(oNNode->pvStub);
    }
 
-   /* Recursively remove children if node if a directory */
+   /* Recursively remove children if node if a directory, last
+      first, so that removing each from the children array does not
+      shift the rest. Each is taken out by position rather than
+      searched for, since the children of a directory still being
+      loaded are not yet in order. */
    if(oNNode->type == DIRECTORY){
       while(DynArray_getLength(oNNode->oDChildren) != 0) 
       {
-         ulCount += Node_free(DynArray_get(oNNode->oDChildren, 0));
+         Node_T oNChild = DynArray_removeAt(oNNode->oDChildren,
+                        DynArray_getLength(oNNode->oDChildren) - 1);
+         oNChild->oNParent = NULL;
+         ulCount += Node_free(oNChild);
       }
       DynArray_free(oNNode->oDChildren);
    }
@@ -211,6 +402,7 @@ size_t Node_free(Node_T oNNode) {
 
    /* finally, free the struct node */
    free(oNNode);
+   ulResident--;
    ulCount++;
    return ulCount;
 }
@@ -223,6 +415,8 @@ Path_T Node_getPath(Node_T oNNode) {
 
 boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
                          size_t *pulChildID) {
+   boolean bFound;
+
    assert(oNParent != NULL);
    assert(oPPath != NULL);
    assert(pulChildID != NULL);
@@ -230,10 +424,24 @@ boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
    if(oNParent->type == FILE_NODE)
       return FALSE;
 
+   (void) Node_materialize(oNParent);
+
+   /* a small directory is scanned by tag; its tags are rebuilt here
+      if it has just shrunk back to MAX_TAGGED or been reordered */
+   if(!oNParent->bTagged &&
+      DynArray_getLength(oNParent->oDChildren) <= MAX_TAGGED)
+      Node_retag(oNParent);
+   if(oNParent->bTagged &&
+      Node_findTagged(oNParent, oPPath, pulChildID))
+      return TRUE;
+
    /* *pulChildID is the index into oNParent->oDChildren */
-   return DynArray_bsearch(oNParent->oDChildren,
+   bFound = DynArray_bsearch(oNParent->oDChildren,
             (char*) Path_getPathname(oPPath), pulChildID,
             (int (*)(const void*,const void*)) Node_compareString);
+   /* a child missed by its tag means the tags are stale */
+   assert(!bFound || !oNParent->bTagged);
+   return bFound;
 }
 
 size_t Node_getNumChildren(Node_T oNParent) {
@@ -242,6 +450,8 @@ size_t Node_getNumChildren(Node_T oNParent) {
    if(oNParent->type == FILE_NODE)
       return 0;
 
+   (void) Node_materialize(oNParent);
+
    return DynArray_getLength(oNParent->oDChildren);
 }
 
@@ -292,9 +502,11 @@ char *Node_toString(Node_T oNNode) {
 
 void *Node_getFileContents(Node_T oNNode){
    assert(oNNode!= NULL);
-   assert(oNNode->type == FILE_NODE);
+   assert(Node_isFile(oNNode));
 
-   return oNNode->fileContents;
+   if(oNNode->type != FILE_NODE)
+      return NULL;
+   return oNNode->u.sFile.fileContents;
 }
 
 void *Node_swapFileContents(Node_T oNNode, void *newContents,
@@ -302,19 +514,24 @@ void *Node_swapFileContents(Node_T oNNode, void *newContents,
    void *oldContents;
    
    assert(oNNode!= NULL);
-   assert(oNNode->type == FILE_NODE);
+   assert(Node_isFile(oNNode));
 
-   oldContents = oNNode->fileContents;
-   oNNode->fileContents = newContents;
-   oNNode->fileLength = newLength;
+   /* a directory's tags must never be overwritten with contents */
+   if(oNNode->type != FILE_NODE)
+      return NULL;
+   oldContents = oNNode->u.sFile.fileContents;
+   oNNode->u.sFile.fileContents = newContents;
+   oNNode->u.sFile.fileLength = newLength;
    return oldContents;
 }
 
 size_t Node_getFileSize(Node_T oNNode){
    assert(oNNode!= NULL);
-   assert(oNNode->type == FILE_NODE);
+   assert(Node_isFile(oNNode));
 
-   return oNNode->fileLength;
+   if(oNNode->type != FILE_NODE)
+      return 0;
+   return oNNode->u.sFile.fileLength;
 }
 
 typeNode Node_getType(Node_T oNNode){
@@ -322,3 +539,190 @@ typeNode Node_getType(Node_T oNNode){
 
    return oNNode->type;
 }
+
+void Node_setStub(Node_T oNNode, void *pvStub){
+   assert(oNNode != NULL);
+   assert(oNNode->type == DIRECTORY);
+   assert(DynArray_getLength(oNNode->oDChildren) == 0);
+   assert(pvStub != NULL);
+
+   oNNode->pvStub = pvStub;
+}
+
+int Node_materialize(Node_T oNNode){
+   void *pvStub;
+   int iStatus;
+
+   assert(oNNode != NULL);
+
+   if(oNNode->pvStub == NULL)
+      return SUCCESS;
+
+   /* clear the stub first: creating the children links them in
+      through the normal (non-stub) child operations */
+   pvStub = oNNode->pvStub;
+   oNNode->pvStub = NULL;
+   iStatus = Image_loadChildren(oNNode, pvStub);
+   if(iStatus != SUCCESS) {
+      oNNode->pvStub = pvStub;
+      return iStatus;
+   }
+   Image_freeStub(pvStub);
+   return SUCCESS;
+}
+
+const void *Node_getStub(Node_T oNNode){
+   assert(oNNode != NULL);
+
+   return oNNode->pvStub;
+}
+
+void Node_touch(Node_T oNNode, size_t ulStamp){
+   assert(oNNode != NULL);
+
+   oNNode->ulStamp = ulStamp;
+}
+
+size_t Node_getStamp(Node_T oNNode){
+   assert(oNNode != NULL);
+
+   return oNNode->ulStamp;
+}
+
+size_t Node_getResidentCount(void){
+   return ulResident;
+}
+
+void Node_getMemory(Node_T oNNode, size_t *pulRecord,
+                    size_t *pulChildren, size_t *pulSlack){
+   size_t ulPhysLength;
+
+   assert(oNNode != NULL);
+   assert(pulRecord != NULL);
+   assert(pulChildren != NULL);
+   assert(pulSlack != NULL);
+
+   *pulRecord = sizeof(struct node);
+   *pulChildren = 0;
+   *pulSlack = 0;
+   if(oNNode->oDChildren != NULL) {
+      ulPhysLength = DynArray_getPhysLength(oNNode->oDChildren);
+      *pulChildren = DynArray_getMemorySize(oNNode->oDChildren);
+      *pulSlack = (ulPhysLength -
+                   DynArray_getLength(oNNode->oDChildren)) *
+         sizeof(void *);
+   }
+}
+
+int Node_newUnsorted(Path_T oPPath, Node_T oNParent, Node_T *poNResult,
+   typeNode type, void *oPFileContents, size_t fileLength){
+   struct node *psNew;
+
+   assert(oPPath != NULL);
+   assert(type == FILE_NODE || type == DIRECTORY);
+   assert(poNResult != NULL);
+   assert(oNParent == NULL || oNParent->type == DIRECTORY);
+   assert(oNParent == NULL || oNParent->pvStub == NULL);
+   assert(oNParent != NULL || type == DIRECTORY);
+
+   psNew = malloc(sizeof(struct node));
+   if(psNew == NULL) {
+      *poNResult = NULL;
+      return MEMORY_ERROR;
+   }
+
+   psNew->oPPath = oPPath;
+   psNew->oNParent = oNParent;
+   psNew->type = type;
+   psNew->pvStub = NULL;
+   psNew->ulStamp = oNParent == NULL ? 0 : oNParent->ulStamp;
+   psNew->oDChildren = NULL;
+   psNew->bTagged = type == DIRECTORY;
+   if(type == FILE_NODE) {
+      psNew->u.sFile.fileContents = oPFileContents;
+      psNew->u.sFile.fileLength = fileLength;
+   }
+   else {
+      psNew->oDChildren = DynArray_new(0);
+      if(psNew->oDChildren == NULL) {
+         free(psNew);
+         *poNResult = NULL;
+         return MEMORY_ERROR;
+      }
+   }
+
+   /* append: the caller sorts the parent's children afterwards */
+   if(oNParent != NULL && Node_addChild(oNParent, psNew,
+         DynArray_getLength(oNParent->oDChildren)) != SUCCESS) {
+      if(psNew->oDChildren != NULL)
+         DynArray_free(psNew->oDChildren);
+      free(psNew);
+      *poNResult = NULL;
+      return MEMORY_ERROR;
+   }
+
+   ulResident++;
+   *poNResult = psNew;
+   return SUCCESS;
+}
+
+boolean Node_sortChildren(Node_T oNParent){
+   DynArray_T oDChildren;
+   size_t ulLength;
+   size_t ulSplit = 0;
+   size_t i;
+
+   assert(oNParent != NULL);
+
+   if(oNParent->type == FILE_NODE)
+      return TRUE;
+
+   oDChildren = oNParent->oDChildren;
+   ulLength = DynArray_getLength(oDChildren);
+
+   /* find where the children stop being in order, if anywhere */
+   for(i = 1; i < ulLength; i++) {
+      if(Node_compare(DynArray_get(oDChildren, i - 1),
+                      DynArray_get(oDChildren, i)) > 0) {
+         if(ulSplit != 0)
+            break;
+         ulSplit = i;
+      }
+   }
+
+   /* reordering leaves the tags to be rebuilt by Node_hasChild */
+   if(ulSplit != 0)
+      oNParent->bTagged = FALSE;
+
+   if(ulSplit != 0 && i == ulLength) {
+      /* exactly two sorted runs (such as files, then directories):
+         merge them in linear time */
+      Node_T *poNRuns = malloc(ulLength * sizeof(Node_T));
+      if(poNRuns != NULL) {
+         size_t ulLeft = 0;
+         size_t ulRight = ulSplit;
+         DynArray_toArray(oDChildren, (void **) poNRuns);
+         for(i = 0; i < ulLength; i++) {
+            if(ulRight == ulLength || (ulLeft < ulSplit &&
+                  Node_compare(poNRuns[ulLeft], poNRuns[ulRight]) < 0))
+               (void) DynArray_set(oDChildren, i, poNRuns[ulLeft++]);
+            else
+               (void) DynArray_set(oDChildren, i, poNRuns[ulRight++]);
+         }
+         free(poNRuns);
+      }
+      else
+         DynArray_sort(oDChildren,
+            (int (*)(const void *, const void *)) Node_compare);
+   }
+   else if(ulSplit != 0)
+      DynArray_sort(oDChildren,
+         (int (*)(const void *, const void *)) Node_compare);
+
+   /* sorted children are unique iff no neighbours are equal */
+   for(i = 1; i < ulLength; i++)
+      if(Node_compare(DynArray_get(oDChildren, i - 1),
+                      DynArray_get(oDChildren, i)) == 0)
+         return FALSE;
+   return TRUE;
+}
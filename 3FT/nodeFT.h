@@ -93,18 +93,94 @@ int Node_compare(Node_T oNFirst, Node_T oNSecond);
 */
 char *Node_toString(Node_T oNNode);
 
-/*Returns the contents of oNNode.Should only be called for file nodes.*/
+/*Returns the contents of oNNode.Should only be called for file nodes;
+for a directory, returns NULL.*/
 void *Node_getFileContents(Node_T oNNode);
 
 /*Swaps the contents of file oNNode with newContents and updates 
-oNNode's length to newLength. Returns oNNodes previous contents.*/
+oNNode's length to newLength. Returns oNNodes previous contents.
+Should only be called for file nodes; for a directory, changes nothing
+and returns NULL.*/
 void *Node_swapFileContents(Node_T oNNode, void *newContents, 
                               size_t newLength);
 
-/*Returns the length of oNNode file*/
+/*Returns the length of oNNode file, or 0 for a directory*/
 size_t Node_getFileSize(Node_T oNNode);
 
 /*Returns the type of oNNode (file or directory)*/
 typeNode Node_getType(Node_T oNNode);
 
+/*
+  Makes the newly created, childless directory oNNode a stub whose
+  children are created from pvStub (see ftimage.h) the first time they
+  are needed. oNNode takes ownership of pvStub.
+*/
+void Node_setStub(Node_T oNNode, void *pvStub);
+
+/*
+  Creates the children of oNNode if it is a stub, so that it no
+  longer is. Node_hasChild, Node_getNumChildren and Node_getChild do
+  this implicitly but cannot report failure (a stub that fails to load
+  appears childless), so callers that must distinguish call this first.
+  Returns SUCCESS (also for files and non-stub directories), or
+  leaves oNNode a stub and returns:
+  * IO_ERROR if the image oNNode was loaded from is corrupt
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Node_materialize(Node_T oNNode);
+
+/*
+  Returns the stub of oNNode if it is a directory whose children have
+  not been created yet (see Node_setStub), or NULL otherwise. Unlike
+  the child operations, does not materialize oNNode.
+*/
+const void *Node_getStub(Node_T oNNode);
+
+/*
+  Records ulStamp as the time oNNode was last used. A new node starts
+  with its parent's stamp.
+*/
+void Node_touch(Node_T oNNode, size_t ulStamp);
+
+/* Returns the stamp oNNode was last touched with. */
+size_t Node_getStamp(Node_T oNNode);
+
+/*
+  Returns the number of nodes currently allocated in memory, across
+  all hierarchies; nodes that only exist in a stub do not count.
+*/
+size_t Node_getResidentCount(void);
+
+/*
+  Sets *pulRecord to the bytes of oNNode's own record, *pulChildren to
+  the bytes allocated for its array of children (0 for a file), and
+  *pulSlack to how many of those are room for children not yet added.
+  Its path and contents are not included.
+*/
+void Node_getMemory(Node_T oNNode, size_t *pulRecord,
+                    size_t *pulChildren, size_t *pulSlack);
+
+/*
+  Like Node_new, but for bulk construction by a caller that has
+  already validated oPPath against oNParent: the new node takes
+  ownership of oPPath (rather than copying it) and is appended to the
+  end of oNParent's children without searching them, so they may be
+  out of order or contain duplicates until Node_sortChildren(oNParent)
+  is called. oNParent must be a materialized directory, or NULL for a
+  new root directory.
+  Returns SUCCESS and sets *poNResult to the new node, or sets
+  *poNResult to NULL and returns MEMORY_ERROR (oPPath is then still
+  owned by the caller).
+*/
+int Node_newUnsorted(Path_T oPPath, Node_T oNParent, Node_T *poNResult,
+                     typeNode type, void *oPFileContents,
+                     size_t fileLength);
+
+/*
+  Restores the sorted order of oNParent's children after
+  Node_newUnsorted, in linear time if they form at most two sorted
+  runs. Returns TRUE, or FALSE if two children have the same path.
+*/
+boolean Node_sortChildren(Node_T oNParent);
+
 #endif
\ No newline at end of file
@@ -0,0 +1 @@
+../0shared/perfctr.c
\ No newline at end of file
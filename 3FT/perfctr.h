@@ -0,0 +1 @@
+../0shared/perfctr.h
\ No newline at end of file